@@ -37,6 +37,69 @@ static FILE * stdout_file = NULL;
 
 static	COORD4	objset[9] ;
 
+/* Subtrees this many levels down (81 of them) are each output as a task,
+   which may run on a thread of its own with "-j" */
+#define TASK_LEVEL	2
+
+static int task_depth;
+
+/* With instancing, the unit sphere every sphere is an instance of (if they
+   are tessellated), or the nine smallest spheres around a sphere of radius
+   1 growing along +Z, which every set of them is an instance of */
+static long sphere_obj = 0;
+static long leaves_obj = 0;
+
+/* A subtree for output_subtree */
+typedef struct {
+    int depth;
+    COORD4 center, direction;
+} subtree;
+
+static void output_object();
+static void place_instance();
+
+/* Rotation taking the +Z axis to direction */
+static void
+rotate_to_direction(ax, direction)
+AFFINE ax;
+COORD4 direction;
+{
+    double  angle;
+    COORD4  axis, z_axis;
+    MATRIX  mx;
+	
+    /* If direction is (almost) identical to the Z axis, no rotation needed. */
+    /* We test with an epsilon built in here because child_dir, below, 
+       may be slightly less than 1.0 in length. */
+    if ( direction[Z] >= 0.9999 ) {
+		/* identity matrix */
+		lib_create_identity_affine(ax);
+    }
+    /* If direction is (almost) identical to the -Z axis, rotate 180 degrees. */
+    else if ( direction[Z] <= -0.9999 ) {
+		lib_create_rotate_matrix(mx, Y_AXIS, PI);
+		lib_matrix_to_affine(ax, mx);
+    }
+    else {
+		SET_COORD3(z_axis, 0.0, 0.0, 1.0);
+		CROSS(axis, z_axis, direction);
+		lib_normalize_vector(axis);
+		angle = acos((double)DOT_PRODUCT(z_axis, direction));
+		lib_create_axis_rotate_matrix(mx, axis, angle);
+		lib_matrix_to_affine(ax, mx);
+    }
+}
+
+/* Output a subtree of spheres, as a task */
+static void
+output_subtree(data)
+void *data;
+{
+    subtree *st = (subtree *)data;
+
+    output_object(st->depth, st->center, st->direction);
+}
+
 /*
  * Output the parent sphere, then output the children of the sphere.
  * Uses global 'objset'.
@@ -46,40 +109,32 @@ output_object(depth, center, direction)
 int depth;
 COORD4 center, direction;
 {
-    double  angle;
-    COORD4  axis, z_axis;
     COORD4  child_pt, child_dir;
-    MATRIX  mx;
+    AFFINE  ax;
     long    num_vert;
     double  scale;
+    subtree st;
 	
     PLATFORM_MULTITASK();
 	
     /* output sphere at location & radius defined by center */
-    lib_output_sphere(center, output_format);
+    if (sphere_obj) {
+		lib_create_identity_affine(ax);
+		place_instance(sphere_obj, ax, center);
+    } else {
+		lib_output_sphere(center, output_format);
+    }
 	
     /* check if children should be generated */
     if (depth > 0) {
 		--depth ;
 		
 		/* rotation matrix to new axis from +Z axis */
-		/* If direction is (almost) identical to the Z axis, no rotation needed. */
-		/* We test with an epsilon built in here because child_dir, below, 
-		   may be slightly less than 1.0 in length. */
-		if ( direction[Z] >= 0.9999 ) {
-			/* identity matrix */
-			lib_create_identity_matrix(mx);
-		}
-		/* If direction is (almost) identical to the -Z axis, rotate 180 degrees. */
-		else if ( direction[Z] <= -0.9999 ) {
-			lib_create_rotate_matrix(mx, Y_AXIS, PI);
-		}
-		else {
-			SET_COORD3(z_axis, 0.0, 0.0, 1.0);
-			CROSS(axis, z_axis, direction);
-			lib_normalize_vector(axis);
-			angle = acos((double)DOT_PRODUCT(z_axis, direction));
-			lib_create_axis_rotate_matrix(mx, axis, angle);
+		rotate_to_direction(ax, direction);
+		
+		if ((depth == 0) && leaves_obj) {
+			place_instance(leaves_obj, ax, center);
+			return;
 		}
 		
 		/* scale down location of new spheres */
@@ -89,7 +144,7 @@ COORD4 center, direction;
 			/* only do progress for top-level objects of recursion */
 			if (depth==size_factor-1)
 				PLATFORM_PROGRESS(0, num_vert, 8);
-			lib_transform_coord(child_pt, objset[num_vert], mx);
+			lib_transform_affine_vector(child_pt, objset[num_vert], ax);
 			child_pt[X] = child_pt[X] * scale + center[X];
 			child_pt[Y] = child_pt[Y] * scale + center[Y];
 			child_pt[Z] = child_pt[Z] * scale + center[Z];
@@ -100,8 +155,76 @@ COORD4 center, direction;
 			child_dir[Y] /= scale;
 			child_dir[Z] /= scale;
 			child_dir[W] = direction[W];
-			output_object(depth, child_pt, child_dir);
+			if (depth == task_depth) {
+				st.depth = depth;
+				COPY_COORD4(st.center, child_pt);
+				COPY_COORD4(st.direction, child_dir);
+				lib_task_spawn(output_subtree, &st, sizeof(subtree));
+			} else {
+				output_object(depth, child_pt, child_dir);
+			}
+		}
+    }
+}
+
+/*
+ * Place an instance of something of radius 1 at the origin: turned by ax,
+ * then scaled by center[W] and moved to center.
+ */
+static void
+place_instance(object, ax, center)
+long object;
+AFFINE ax;
+COORD4 center;
+{
+    MATRIX  mx;
+    AFFINE  tx;
+    int     i, j;
+	
+    for (i = 0; i < 3; i++) {
+		for (j = 0; j < 3; j++)
+			tx[i][j] = ax[i][j] * center[W];
+    }
+    COPY_COORD3(tx[3], center);
+    lib_affine_to_matrix(mx, tx);
+	
+    lib_tx_push();
+    lib_set_current_tx(mx);
+    lib_output_instance(object);
+    lib_tx_pop();
+}
+
+/*
+ * Define the objects for instancing.  Spheres tessellated for output are
+ * each an instance of one tessellated unit sphere, moved and scaled, which
+ * gives the same polygons.  Otherwise the smallest spheres, nine around
+ * each sphere of the next to last level, are defined once and placed by
+ * the same rotation output_object uses.  (Larger parts of the sphereflake
+ * aren't the same shape: each sphere's children are turned by the
+ * rotation to its own direction, not by its parent's turned again.)
+ */
+static void
+define_objects(direction)
+COORD4 direction;
+{
+    COORD4  child_pt;
+    long    num_vert;
+	
+    if (output_format == OUTPUT_PATCHES) {
+		SET_COORD4(child_pt, 0.0, 0.0, 0.0, 1.0);
+		sphere_obj = lib_object_begin();
+		lib_output_sphere(child_pt, output_format);
+		lib_object_end();
+    } else {
+		leaves_obj = lib_object_begin();
+		for (num_vert = 0; num_vert < 9; num_vert++) {
+			child_pt[X] = objset[num_vert][X] * (1.0 + direction[W]);
+			child_pt[Y] = objset[num_vert][Y] * (1.0 + direction[W]);
+			child_pt[Z] = objset[num_vert][Z] * (1.0 + direction[W]);
+			child_pt[W] = direction[W];
+			lib_output_sphere(child_pt, output_format);
 		}
+		lib_object_end();
     }
 }
 
@@ -215,6 +338,11 @@ char *argv[] ;
     /* compute and output object */
     SET_COORD4(center_pt, 0.0, 0.0, 0.0, radius / 2.0);
     SET_COORD4(direction, 0.0, 0.0, 1.0, 1.0/3.0);
+    task_depth = size_factor - TASK_LEVEL;
+    if (lib_use_instances()) {
+		define_objects(direction);
+		task_depth = -1;
+    }
     output_object(size_factor, center_pt, direction);
 	
     lib_close();
@@ -180,10 +180,38 @@ extern void          MacShutDown(void);
 #endif
 
 typedef double MATRIX[4][4];  /* row major form */
+typedef double AFFINE[4][3];  /* MATRIX with last column 0 0 0 1 left off */
 
 typedef double COORD3[3];
 typedef double COORD4[4];
 
+/*
+ * Vertices and normals kept for later output: the delayed object list and
+ * the PLG/OBJ triangle store.  Define STORE_FLOAT to keep these in single
+ * precision, which halves their memory.  Everything is still computed in
+ * double; values are rounded when stored and widened again when output.
+ */
+#ifdef STORE_FLOAT
+typedef float STORE_REAL;
+#else
+typedef double STORE_REAL;
+#endif
+typedef STORE_REAL STORE3[3];
+
+/*
+ * Count of stored triangles, and its printf format.  A 32 bit address
+ * space can't hold 2^32 stored triangles, so long is big enough wherever
+ * it is as wide as a pointer; 64 bit Windows keeps long at 32 bits, so
+ * there __int64 is used.
+ */
+#ifdef _WIN64
+typedef unsigned __int64 TRI_COUNT;
+#define TRI_COUNT_FMT "%I64u"
+#else
+typedef unsigned long TRI_COUNT;
+#define TRI_COUNT_FMT "%lu"
+#endif
+
 /* COORD3/COORD4 indices */
 #define X 0
 #define Y 1
@@ -216,6 +244,13 @@ typedef double COORD4[4];
 			       (r)[Y] = (a)[Y];\
 			       (r)[Z] = (a)[Z];\
 			       (r)[W] = (a)[W]; }
+/* Round a COORD3 into a STORE3, and widen a STORE3 back into a COORD3 */
+#define STORE_COORD3(r,a)  { (r)[X] = (STORE_REAL)(a)[X];\
+			     (r)[Y] = (STORE_REAL)(a)[Y];\
+			     (r)[Z] = (STORE_REAL)(a)[Z];}
+#define LOAD_COORD3(r,a)   { (r)[X] = (double)(a)[X];\
+			     (r)[Y] = (double)(a)[Y];\
+			     (r)[Z] = (double)(a)[Z];}
 #define CROSS(r,a,b)      { (r)[X] = (a)[Y] * (b)[Z] - (a)[Z] * (b)[Y];\
 			    (r)[Y] = (a)[Z] * (b)[X] - (a)[X] * (b)[Z];\
 			    (r)[Z] = (a)[X] * (b)[Y] - (a)[Y] * (b)[X]; }
@@ -230,6 +265,8 @@ typedef double COORD4[4];
 			      IS_VAL_ALMOST_ZERO( (a)[X], (E) )\
 			   && IS_VAL_ALMOST_ZERO( (a)[Y], (E) )\
 			   && IS_VAL_ALMOST_ZERO( (a)[Z], (E) ) )
+#define SAME_COORD3(a,b)        ( (a)[X] == (b)[X] && (a)[Y] == (b)[Y] &&\
+				  (a)[Z] == (b)[Z] )
 #define SET_COORD3(r,A,B,C)     { (r)[X] = (A); (r)[Y] = (B); (r)[Z] = (C); }
 #define SET_COORD4(r,A,B,C,D)   { (r)[X] = (A); (r)[Y] = (B); (r)[Z] = (C);\
 				  (r)[W] = (D); }
@@ -130,7 +130,9 @@ static SPDFileInfoRec	gFileInfo[] =
 	{'TEXT', kDefaultCreator},		// OUTPUT_OBJ
 	{'TEXT', kDefaultCreator},		// OUTPUT_RWX
 	{k3DMFFileType, 'ttxt'},		// OUTPUT_3DMF
+	{'TEXT', kDefaultCreator},		// OUTPUT_VRML1
 	{'TEXT', kDefaultCreator},		// OUTPUT_VRML2
+	{'BINA', kDefaultCreator},		// OUTPUT_BNFF
 	{'TEXT', kDefaultCreator}		// OUTPUT_DELAYED
 };
 
@@ -0,0 +1,182 @@
+/*
+ * fltcheck.c - Check that generators built with -DSTORE_FLOAT write the
+ *              same scenes as the double precision ones, to within single
+ *              precision.
+ *
+ * Author:  Eric Haines
+ *
+ * Usage:  fltcheck [dir [tolerance]]
+ *
+ * Each test case is run with the generator in the current directory and
+ * with the one in dir (default "float"), which should be built with
+ * -DSTORE_FLOAT; "make floatcheck" does this.  The outputs are compared
+ * word by word: numbers must agree to within tolerance (default 1e-4)
+ * times the larger of 1 and their size, and other words exactly.  The
+ * cases use RTrace, whose polygons are saved for lib_close, and PLG,
+ * whose triangles are.  Returns EXIT_FAIL if any case differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>	/* atof, strtod, system */
+#include <string.h>
+#include <math.h>
+#include "def.h"
+#include "lib.h"
+
+
+/* Numbers may differ by this much, relative to the larger of 1 and them */
+#define FLOAT_TOLERANCE 1.0e-4
+
+/* Longest word compared */
+#define WORD_SIZE      256
+
+/* Differences described for each case */
+#define MAX_REPORTS    5
+
+/* The cases, as generator, options and output format.  gears isn't here:
+   its faces are triangulated from the stored vertices, so rounding can
+   pick a different, equally good, set of triangles. */
+typedef struct {
+    char *program;
+    char *options;
+    int format;
+} test_case;
+
+static test_case cases[] = {
+    { "balls",    "-s 2 -t", OUTPUT_RTRACE },
+    { "balls",    "-s 2 -t", OUTPUT_PLG },
+    { "mount",    "-s 4",    OUTPUT_RTRACE },
+    { "mount",    "-s 4",    OUTPUT_PLG },
+    { "shells",   "-s 2",    OUTPUT_PLG },
+    { "sombrero", "-s 2",    OUTPUT_PLG },
+    { "teapot",   "-s 2",    OUTPUT_RTRACE },
+    { "teapot",   "-s 2",    OUTPUT_PLG },
+    { "tree",     "-s 6 -t", OUTPUT_PLG }
+};
+
+#define NUM_CASES      (sizeof(cases) / sizeof(test_case))
+
+/*-----------------------------------------------------------------*/
+/* TRUE if word is a whole number, put in *value */
+static int
+read_number(word, value)
+char *word;
+double *value;
+{
+    char *end;
+
+    *value = strtod(word, &end);
+    return (end != word) && (*end == '\0');
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Compare two output files word by word, returning the number of words
+ * that differ (a file running out early counts as one) and the largest
+ * relative difference between numbers in *max_error.  If "report" is
+ * set, the first few differences are printed.
+ */
+static long
+compare_files(name1, name2, tolerance, report, max_error)
+char *name1, *name2;
+double tolerance;
+int report;
+double *max_error;
+{
+    static char word1[WORD_SIZE], word2[WORD_SIZE];
+    FILE *f1, *f2;
+    double v1, v2, error;
+    long count, bad;
+    int got1, got2;
+
+    *max_error = 0.0;
+    f1 = fopen(name1, "r");
+    f2 = fopen(name2, "r");
+    if ((f1 == NULL) || (f2 == NULL)) {
+		fprintf(stderr, "Error(fltcheck): Can't open %s.\n",
+			(f1 == NULL) ? name1 : name2);
+		exit(EXIT_FAIL);
+    }
+
+    bad = 0;
+    for (count = 1; ; count++) {
+		got1 = (fscanf(f1, "%255s", word1) == 1);
+		got2 = (fscanf(f2, "%255s", word2) == 1);
+		if (!got1 || !got2) {
+			if (got1 != got2) {
+				if (report)
+					printf("    one output ends at word %ld\n", count);
+				bad++;
+			}
+			break;
+		}
+		if (read_number(word1, &v1) && read_number(word2, &v2)) {
+			error = fabs(v1 - v2) / MAX(1.0, MAX(fabs(v1), fabs(v2)));
+			if (error > *max_error)
+				*max_error = error;
+			if (error <= tolerance)
+				continue;
+		} else if (strcmp(word1, word2) == 0) {
+			continue;
+		}
+		if ((++bad <= MAX_REPORTS) && report)
+			printf("    word %ld: %s, but %s\n", count, word1, word2);
+    }
+
+    fclose(f1);
+    fclose(f2);
+    return bad;
+}
+
+/*-----------------------------------------------------------------*/
+main(argc, argv)
+int argc;
+char *argv[];
+{
+    static char command[2*WORD_SIZE], out1[WORD_SIZE], out2[WORD_SIZE];
+    char *dir;
+    double tolerance, max_error;
+    long bad;
+    int i, failed;
+
+    dir = "float";
+    tolerance = FLOAT_TOLERANCE;
+    if (argc > 1)
+		dir = argv[1];
+    if (argc > 2)
+		tolerance = atof(argv[2]);
+    if ((argc > 3) || (strlen(dir) > WORD_SIZE - 16) || (tolerance <= 0.0)) {
+		fprintf(stderr, "usage: fltcheck [dir [tolerance]]\n");
+		return EXIT_FAIL;
+    }
+    sprintf(out1, "%s/fltcheck.1", dir);
+    sprintf(out2, "%s/fltcheck.2", dir);
+
+    failed = 0;
+    for (i = 0; i < (int)NUM_CASES; i++) {
+		sprintf(command, "./%s %s -r %d > %s", cases[i].program,
+			cases[i].options, cases[i].format, out1);
+		if (system(command) != 0) {
+			fprintf(stderr, "Error(fltcheck): Can't run %s.\n", command);
+			return EXIT_FAIL;
+		}
+		sprintf(command, "%s/%s %s -r %d > %s", dir, cases[i].program,
+			cases[i].options, cases[i].format, out2);
+		if (system(command) != 0) {
+			fprintf(stderr, "Error(fltcheck): Can't run %s.\n", command);
+			return EXIT_FAIL;
+		}
+		bad = compare_files(out1, out2, tolerance, FALSE, &max_error);
+		printf("%-8s %-7s -r %-2d  largest error %8.2e  %s\n",
+			cases[i].program, cases[i].options, cases[i].format,
+			max_error, bad ? "DIFFERENT" : "ok");
+		if (bad) {
+			(void)compare_files(out1, out2, tolerance, TRUE, &max_error);
+			failed++;
+		}
+    }
+
+    remove(out1);
+    remove(out2);
+    return failed ? EXIT_FAIL : EXIT_SUCCESS;
+}
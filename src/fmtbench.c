@@ -0,0 +1,162 @@
+/*
+ * fmtbench.c - Check the library number formatter against sprintf("%g")
+ *              byte for byte, and time the two.
+ *
+ * Author:  Eric Haines
+ *
+ * Usage:  fmtbench [count]
+ *
+ * count is the number of values tried for each test (default 1000000).
+ * Returns EXIT_FAIL if any value formats differently.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>	/* atoi, strtod */
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "def.h"
+#include "lib.h"
+
+
+static unsigned long seed = 1;
+
+/*-----------------------------------------------------------------*/
+/* Small LCG so every platform tries the same values */
+static double
+rand_unit()
+{
+    seed = seed * 1103515245L + 12345L;
+    return (double)((seed >> 8) & 0xffffff) / (double)0x1000000;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Make up a test value.  Mix random magnitudes with the kinds of numbers
+ * the generators write: short decimals, integers, and halfway cases.
+ */
+static double
+test_value(i)
+long i;
+{
+    double v;
+
+    switch (i % 4) {
+	case 0:
+		v = rand_unit() * pow(10.0, (double)((int)(rand_unit() * 40.0) - 20));
+		break;
+	case 1:
+		v = floor(rand_unit() * 2000000.0) / 1000.0;
+		break;
+	case 2:
+		v = floor(rand_unit() * 1000.0);
+		break;
+	default:
+		v = (floor(rand_unit() * 1000000.0) + 0.5) / 1000000.0;
+		break;
+    }
+    return (rand_unit() < 0.5) ? -v : v;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Compare one style of output ("%g" or "%#g") over the test values,
+ * printing the first few mismatches.  Returns the mismatch count.
+ */
+static long
+compare_format(values, count, alt)
+double *values;
+long count;
+int alt;
+{
+    char ref[NUMBER_BUFFER_SIZE], buf[NUMBER_BUFFER_SIZE];
+    clock_t start;
+    double ref_time, lib_time;
+    long i, bad;
+
+    start = clock();
+    for (i = 0; i < count; i++)
+		sprintf_s(ref, NUMBER_BUFFER_SIZE, alt ? "%#g" : "%g", values[i]);
+    ref_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (i = 0; i < count; i++)
+		lib_format_number(buf, values[i], 6, alt);
+    lib_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    bad = 0;
+    for (i = 0; i < count; i++) {
+		sprintf_s(ref, NUMBER_BUFFER_SIZE, alt ? "%#g" : "%g", values[i]);
+		lib_format_number(buf, values[i], 6, alt);
+		if (strcmp(ref, buf) != 0) {
+			if (bad < 10)
+				printf("  mismatch: %.17g  sprintf \"%s\"  lib \"%s\"\n",
+					values[i], ref, buf);
+			bad++;
+		}
+    }
+
+    printf("%-4s %ld values: sprintf %.3f s, lib %.3f s, %ld mismatches\n",
+		alt ? "%#g" : "%g", count, ref_time, lib_time, bad);
+    return bad;
+}
+
+/*-----------------------------------------------------------------*/
+/* Check that the shortest round-trip format reads back exactly */
+static long
+check_shortest(values, count)
+double *values;
+long count;
+{
+    char buf[NUMBER_BUFFER_SIZE];
+    long i, bad;
+
+    lib_set_float_format(FLOAT_FORMAT_SHORTEST, 6);
+    bad = 0;
+    for (i = 0; i < count; i++) {
+		lib_format_double(buf, values[i]);
+		if (strtod(buf, NULL) != values[i]) {
+			if (bad < 10)
+				printf("  no round trip: %.17g -> \"%s\"\n",
+					values[i], buf);
+			bad++;
+		}
+    }
+    lib_set_float_format(FLOAT_FORMAT_FIXED, 6);
+
+    printf("shortest %ld values: %ld failed to read back\n", count, bad);
+    return bad;
+}
+
+/*-----------------------------------------------------------------*/
+main(argc, argv)
+int argc;
+char *argv[];
+{
+    double *values;
+    long count, i, bad;
+
+    count = 1000000L;
+    if (argc > 1) {
+		count = atol(argv[1]);
+		if (count <= 0) {
+			fprintf(stderr, "usage: fmtbench [count]\n");
+			return EXIT_FAIL;
+		}
+    }
+
+    values = (double *)malloc(count * sizeof(double));
+    if (values == NULL) {
+		fprintf(stderr, "Error(fmtbench): Can't allocate memory.\n");
+		return EXIT_FAIL;
+    }
+    for (i = 0; i < count; i++)
+		values[i] = test_value(i);
+
+    bad = compare_format(values, count, FALSE);
+    bad += compare_format(values, count, TRUE);
+    bad += check_shortest(values, count);
+    free(values);
+
+    return bad ? EXIT_FAIL : EXIT_SUCCESS;
+}
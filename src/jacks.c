@@ -32,6 +32,18 @@ static FILE * stdout_file = NULL;
 static COORD3 Pink    = { 0.737, 0.561, 0.561};
 static COORD3 DarkPurple = {0.2, 0.05, 0.2};
 
+/* Jacks this many levels down (64 of them) are each made, with their
+   smaller copies, as a task, which may run on a thread of its own with
+   "-j", as long as they have smaller copies */
+#define TASK_LEVEL 2
+
+static int task_depth;
+
+/* A jack for make_sub_jack, placed by the current transform */
+typedef struct {
+    int depth, max_depth;
+} sub_jack;
+
 /* Create a single copy of our recursive object.  The general
    sizing and placement of the object are maintained by the
    recursive routine make_rec_jack.  This routine does the
@@ -84,6 +96,18 @@ make_jack_obj()
 	lib_tx_pop();
 }
 
+static void make_rec_jack();
+
+/* Make a jack and its smaller copies, as a task */
+static void
+make_sub_jack(data)
+void *data;
+{
+    sub_jack *sj = (sub_jack *)data;
+
+    make_rec_jack(sj->depth, sj->max_depth);
+}
+
 /* Create a jack shaped object, then put a smaller copy in
    each of the octants defined by the arms of the jack.
    This process is repeated until depth reaches max_depth. */
@@ -92,6 +116,7 @@ make_rec_jack(depth, max_depth)
 {
     double i, j, k;
     COORD3 scale, trans;
+    sub_jack sj;
 	
     make_jack_obj();
 	
@@ -106,12 +131,53 @@ make_rec_jack(depth, max_depth)
 					SET_COORD3(trans, i, j, k);
 					lib_tx_translate(trans);
 					lib_tx_scale(scale);
-					make_rec_jack(depth+1, max_depth);
+					if (depth+1 == task_depth) {
+						sj.depth = depth+1;
+						sj.max_depth = max_depth;
+						lib_task_spawn(make_sub_jack, &sj, sizeof(sub_jack));
+					} else {
+						make_rec_jack(depth+1, max_depth);
+					}
 					lib_tx_pop();
 				}
 	}
 }
 
+/* Make the same jacks as make_rec_jack, but with each level defined
+   once, as a jack and eight instances of the level below, and then
+   output as an instance of the top level. */
+static void
+instance_jacks(max_depth)
+int max_depth;
+{
+    double i, j, k;
+    int depth;
+    long level_obj, sub_obj;
+    COORD3 scale, trans;
+	
+    level_obj = 0;
+    SET_COORD3(scale, 0.5, 0.5, 0.5);
+    for (depth = max_depth; depth >= 1; depth--) {
+		sub_obj = level_obj;
+		level_obj = lib_object_begin();
+		make_jack_obj();
+		if (sub_obj) {
+			for (i=-0.5;i<=0.5;i+=1)
+				for (j=-0.5;j<=0.5;j+=1)
+					for (k=-0.5;k<=0.5;k+=1) {
+						lib_tx_push();
+						SET_COORD3(trans, i, j, k);
+						lib_tx_translate(trans);
+						lib_tx_scale(scale);
+						lib_output_instance(sub_obj);
+						lib_tx_pop();
+					}
+		}
+		lib_object_end();
+    }
+    lib_output_instance(level_obj);
+}
+
 int
 main(argc, argv)
 int argc;
@@ -171,7 +237,12 @@ char *argv[];
 	lib_tx_rotate(Y_AXIS,-20 * PI / 180.0);
 	
 	lib_output_color(NULL, Pink, 0.1, 0.7, 0.7, 0.4, 20.0, 0.0, 1.0);
-	make_rec_jack(1, size_factor);
+	if (lib_use_instances()) {
+		instance_jacks(size_factor);
+	} else {
+		task_depth = (1 + TASK_LEVEL < size_factor) ? 1 + TASK_LEVEL : -1;
+		make_rec_jack(1, size_factor);
+	}
 	
     /* Back to where we started */
     lib_tx_pop();
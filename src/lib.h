@@ -167,7 +167,8 @@ extern "C" {
 #define OUTPUT_3DMF      17 /* 3D Metafile (Apple Quickdraw 3D text format) */
 #define OUTPUT_VRML1     18 /* Virtual Reality Modeling Language 1.0        */
 #define OUTPUT_VRML2     19 /* Virtual Reality Modeling Language 2.0        */
-#define OUTPUT_DELAYED   20 /* Needed for RTRACE/PLG output.
+#define OUTPUT_BNFF      20 /* Binary NFF, see libbnf.c                     */
+#define OUTPUT_DELAYED   21 /* Needed for RTRACE/PLG output.
 			       When this is used, all definitions will be
 			       stored rather than immediately dumped.  When
 			       all definitions are complete, use the call
@@ -181,6 +182,30 @@ extern "C" {
 
 #define OUTPUT_RESOLUTION       3       /* default amount of polygonalization */
 
+/* Default pixel error for adaptive tessellation, "-p" with no value, and
+   the finest resolution it will use */
+#define ADAPTIVE_ERROR          0.5
+#define ADAPTIVE_MAX_RESOLUTION 32
+
+/* Most levels of detail "-l" will output */
+#define LOD_MAX_LEVELS          4
+
+/* Size of the stdio buffer the library gives the output file */
+#ifndef OUTPUT_BUFFER_SIZE
+#define OUTPUT_BUFFER_SIZE      65536
+#endif
+
+/* Default grid spacing for welded output, "-w" with no value */
+#define WELD_TOLERANCE          1.0e-6
+
+/* Most threads "-j" will run tasks on */
+#define TASK_MAX_THREADS        64
+
+/* Size of the reals written to BNFF files: 8 for doubles, 4 for floats */
+#ifndef BNFF_REAL_SIZE
+#define BNFF_REAL_SIZE          8
+#endif
+
 
 /* ========== don't mess from here on down ============================= */
 
@@ -188,9 +213,35 @@ extern "C" {
 #define OUTPUT_CURVES           0       /* true curve output */
 #define OUTPUT_PATCHES          1       /* polygonal patches output */
 
-/* polygon stuff for libply.c and lib.c */
-#define VBUFFER_SIZE    1024
-#define POLYEND_SIZE    512
+/* "%g" output styles for lib_set_float_format (libfmt.c) */
+#define FLOAT_FORMAT_FIXED      0       /* fixed significant digits, like %g */
+#define FLOAT_FORMAT_SHORTEST   1       /* fewest digits that read back exactly */
+
+/* BNFF file header and record types (libbnf.c), with each payload:
+   "int" is an unsigned 32 bit value, "real" is BNFF_REAL_SIZE bytes. */
+#define BNFF_MAGIC              "BNFF"
+#define BNFF_VERSION            1
+#define BNFF_HEADER_SIZE        16
+#define BNFF_VIEW               1       /* int resx, resy; real from[3],
+					   at[3], up[3], angle, hither */
+#define BNFF_LIGHT              2       /* real position[3] */
+#define BNFF_BACKGROUND         3       /* real color[3] */
+#define BNFF_FILL               4       /* real color[3], kd, ks, phong_pow,
+					   t, i_of_r */
+#define BNFF_CONE               5       /* real base[4], apex[4] (xyz, r) */
+#define BNFF_SPHERE             6       /* real center[4] (xyz, r) */
+#define BNFF_POLYGON            7       /* int n, 0; real vert[n][3] */
+#define BNFF_PATCH              8       /* int n, 0; real vert[n][3],
+					   norm[n][3] */
+
+/* Room needed by lib_format_number for any one number */
+#define NUMBER_BUFFER_SIZE      350
+
+/* Most tessellation templates kept at once, see lib_get_template */
+#define TEMPLATE_CACHE_SIZE     16
+
+/* Size of each block of deferred object storage, see lib_arena_alloc */
+#define ARENA_CHUNK_SIZE        65536
 
 /*-----------------------------------------------------------------*/
 /* The following type definitions are used to build & store the database
@@ -234,24 +285,37 @@ struct disc_struct {
    double iradius, oradius;
    };
 
+/* Samples of a height field, "height" rows of "width" values.  They are
+   either held in one block, row after row, or made a row at a time by a
+   function, so a large field need never be in memory all at once.  See
+   lib_height_create and lib_height_create_rows in libpr3.c. */
+typedef void (*height_row_fn) PARAMS((void *data, int row, int width,
+									  float *values));
+typedef struct height_field_struct *height_ptr;
+struct height_field_struct {
+   int width, height;
+   float *data;               /* all the samples, or NULL if made by fn */
+   height_row_fn fn;
+   void *fn_data;
+   };
+
 /* 2D gridded data for a height field.  Limited support for this thing... */
 struct height_struct {
    char *filename;
-   float **data;
-   unsigned int width, height;
+   height_ptr field;
    float x0, x1, y0, y1, z0, z1;
    };
 
 /* Polygon - # of vertices and the 3D coordinates of the vertices themselves */
 struct polygon_struct {
    unsigned int tot_vert;
-   COORD3 *vert;
+   STORE3 *vert;
    };
 
 /* Smooth patch.  Vertices and normals associated with them. */
 struct polypatch_struct {
    unsigned int tot_vert;
-   COORD3 *vert, *norm;
+   STORE3 *vert, *norm;
    };
 
 /* Center/radius of a sphere */
@@ -334,59 +398,272 @@ struct object_struct {
    };
 
 /*-----------------------------------------------------------------*/
-/* Global variables - lib.h */
-/*-----------------------------------------------------------------*/
-#ifdef OUTPUT_TO_FILE
-extern FILE * gStdout_file;
-#else
-#define gStdout_file stdout
-#endif /* OUTPUT_TO_FILE */
+/*
+ * Output emitter - the set of writers for one output format, picked by
+ * lib_set_raytracer.  A NULL entry means the format writes nothing for
+ * that call; polygon-only formats point the sphere, cone and disc entries at
+ * the polygonalizers in libply.c.
+ */
+typedef struct emitter_struct *emitter_ptr;
+struct emitter_struct {
+   void   (*begin_scene) PARAMS((void));
+   void   (*end_scene) PARAMS((void));
+   void   (*viewpoint) PARAMS((COORD3 from, COORD3 at, COORD3 up,
+							   double fov_angle, double aspect_ratio,
+							   double hither, int resx, int resy));
+   void   (*light) PARAMS((COORD4 center_pt, COORD3 vec, double lscale));
+   char * (*surface) PARAMS((char *name, COORD3 color, double ka,
+							 double kd, double ks, double ks_spec,
+							 double ang, double kt, double i_of_r,
+							 double phong_pow));
+   void   (*sphere) PARAMS((COORD4 center_pt));
+   void   (*cone) PARAMS((COORD4 base_pt, COORD4 apex_pt));
+   void   (*disc) PARAMS((COORD3 center, COORD3 normal,
+						  double iradius, double oradius));
+   void   (*triangles) PARAMS((int cnt, COORD3 **verts, COORD3 **norms,
+							   COORD3 *pvert));
+   void   (*transform) PARAMS((MATRIX txmat, double *trans,
+							   int sflag, int rflag, int tflag));
+   void   (*object_begin) PARAMS((long object));
+   void   (*object_end) PARAMS((long object));
+   void   (*instance) PARAMS((long object));
+   };
 
-#define MAX_OUTFILE_NAME_SIZE  80
 /*
-Here are some local variables that are used to control things like
-the current output file, current texture, ...
-*/
-extern FILE *gOutfile;
-extern char gOutfileName[MAX_OUTFILE_NAME_SIZE];
-extern char *gTexture_name;
-extern int  gTexture_count;
-extern double gTexture_ior;
-extern int  gObject_count;
-extern int  gRT_out_format;
-extern int  gRT_orig_format;
-extern int  gU_resolution;
-extern int  gV_resolution;
-extern COORD3 gBkgnd_color;
-extern COORD3 gFgnd_color;
-extern double gView_bounds[2][3];
-extern int gView_init_flag;
-extern char *gLib_version_str;
-
-extern surface_ptr gLib_surfaces;
-extern object_ptr gLib_objects;
-extern light_ptr gLib_lights;
-extern viewpoint gViewpoint;
-
-/* Globals for tracking indentation level of output file */
-extern int      gTab_width;
-extern int      gTab_level;
+ * Triangles saved for PLG output.  Each field is its own array, indexed by
+ * triangle: 9 coordinates per triangle in vert and norm, one entry in
+ * patch (TRUE if it has vertex normals) and surf_index.  norm stays NULL
+ * until the first patch is stored.
+ */
+typedef struct {
+   TRI_COUNT count;           /* triangles stored */
+   TRI_COUNT size;            /* room in each array */
+   STORE_REAL *vert;
+   STORE_REAL *norm;
+   unsigned char *patch;
+   unsigned int *surf_index;
+   } tri_store;
+
+/* Vertex "i" of triangle "t", and its normal */
+#define TRI_VERT(store, t, i)  (&(store).vert[9*(t) + 3*(i)])
+#define TRI_NORM(store, t, i)  (&(store).norm[9*(t) + 3*(i)])
+
+/*
+ * Canonical tessellation grid, shared by every instance of a primitive
+ * with the same resolution (and shape exponents).  The grid is (u_res+1)
+ * by (v_res+1) points, stored u major.  What vert, norm and flag hold is
+ * up to the primitive; see lib_get_template.
+ */
+#define TEMPLATE_CIRCLE     1
+#define TEMPLATE_TORUS      2
+#define TEMPLATE_SUPERQ     3
+#define TEMPLATE_SPHERE     4
+
+typedef struct template_struct *template_ptr;
+struct template_struct {
+   int kind;
+   int u_res, v_res;
+   double p0, p1;             /* shape exponents, if any */
+   COORD3 *vert;
+   COORD3 *norm;
+   unsigned char *flag;
+   template_ptr next;
+   };
+
+/* Pool of shared vertices for welded output, see libwld.c */
+typedef struct weld_struct *weld_ptr;
+
+/* Point and unit normal of a patch at (u,v), see libpch.c */
+typedef void (*patch_eval_fn) PARAMS((void *data, double u, double v,
+									  COORD3 P, COORD3 N));
+
+/* Outputs a piece of a scene, such as a subtree, see libtsk.c */
+typedef void (*task_fn) PARAMS((void *data));
 
 /*-----------------------------------------------------------------*/
-/* Global variables - libply.h */
+/* Generation context */
 /*-----------------------------------------------------------------*/
-/* Polygon stack for making PLG files */
-extern object_ptr gPolygon_stack;
-extern unsigned long gVertex_count; /* Vertex coordinates */
-extern unsigned long gNormal_count; /* Vertex normals */
+#define MAX_OUTFILE_NAME_SIZE  80
 
-/* Storage for polygon indices */
-extern unsigned int *gPoly_vbuffer;
-extern int *gPoly_end;
+/*
+ * Everything the library keeps between calls while it builds a scene: the
+ * output file and format, the saved surfaces, lights and objects, the
+ * transform stack, scratch storage and statistics.  Every library call
+ * works on the current context, gContext.  A program building one scene
+ * never needs to know about this.  To build several scenes in one process,
+ * make a context for each with lib_context_create, and make it current
+ * with lib_context_select before calling lib_open, lib_output_* and
+ * lib_close for that scene.  Each scene's output goes to stdout unless it
+ * is given a file of its own with lib_set_output_file before lib_open.
+ * Defining CONTEXT_LOCAL as the compiler's thread local storage class
+ * (e.g. -DCONTEXT_LOCAL=__thread, the default with -DSPD_THREADS) gives
+ * each thread its own current context, so scenes can be built at the same
+ * time on different threads.  Each thread starts on the default context and
+ * should select one of its own.  Output to the screen is not part of a
+ * context, since there is only one screen.
+ *
+ * Settings with a default other than 0 come first, so the default context
+ * can be set up by a C89 initializer that stops after them.
+ */
+typedef struct context_struct *context_ptr;
+struct context_struct {
+   /* Output settings */
+   int rt_out_format;         /* format being written */
+   int rt_orig_format;        /* format given to lib_open */
+   int u_resolution, v_resolution;
+   double texture_ior;
+   viewpoint view;
+   int tab_width;
+   emitter_ptr emitter;       /* writers for rt_out_format */
+   int float_format, float_digits;
+   int lod_levels;
+   char *lod_name;            /* name given to lib_open */
+   /* Transform stack, libtx.c */
+   MATRIX current_tx;
+   MATRIX normal_tx;          /* inverse of current_tx, for normals */
+
+   /* Everything from here on starts out 0 */
+   int tx_active;
+   int normal_tx_dirty;
+   struct tx_struct *tx_stack;
+
+   /* Output file and scene */
+   FILE *stdout_file;
+   FILE *outfile;
+   char outfile_name[MAX_OUTFILE_NAME_SIZE];
+   char *out_buffer;          /* stdio buffer for outfile, libfmt.c */
+   int tab_level;
+   char *texture_name;
+   int texture_count;
+   int object_count;
+   COORD3 bkgnd_color, fgnd_color;
+   double view_bounds[2][3];
+   int view_init_flag;
+   int show_stats;            /* print statistics to stderr at lib_close */
+   surface_ptr lib_surfaces;
+   light_ptr lib_lights;
+   object_ptr lib_objects;
+   struct arena_chunk *arena_first;   /* storage for lib_objects */
+   struct arena_chunk *arena_current;
+   unsigned int hf_count;     /* height field files written */
+   int rib_light_count;       /* RIB lights written */
+
+   /* Polygons and tessellation, libply.c, libtri.c and libpch.c */
+   tri_store tris;
+   unsigned long vertex_count, normal_count;
+   template_ptr templates;
+   int *split_tri;
+   COORD3 *split_vert, *split_norm;
+   COORD3 **split_vptr, **split_nptr;
+   int split_size;
+   unsigned long split_polygons, split_triangles, split_allocs;
+   double adaptive_error;
+   unsigned long adaptive_triangles, adaptive_fixed;
+   int lod_level;
+   long lod_count;
+   int lod_open;
+   COORD4 *video_vert;
+   int video_size;
+   COORD3 *tess_vert, *tess_norm;
+   long tess_size;
+   struct tri_scratch_struct *tri_scratch;
+   double patch_tolerance;
+
+   /* Welding, libwld.c */
+   double weld_tolerance;
+   weld_ptr weld_verts, weld_norms;
+
+   /* Tasks, libtsk.c */
+   int task_threads;          /* threads to run tasks on, 1 or 0 for none */
+   struct task_group_struct *task_group;   /* tasks not yet spliced in */
+
+   /* Instancing, libins.c */
+   int instancing;            /* output repeated parts as instances */
+   long object_defs;          /* objects defined */
+   long object_open;          /* object being defined, 0 if none */
+   };
 
-/* Globals to determine which axes can be used to split the polygon */
-extern int gPoly_Axis1;
-extern int gPoly_Axis2;
+#ifndef CONTEXT_LOCAL
+#ifdef SPD_THREADS
+#define CONTEXT_LOCAL __thread
+#else
+#define CONTEXT_LOCAL
+#endif /* SPD_THREADS */
+#endif
+
+/* The current context */
+extern CONTEXT_LOCAL context_ptr gContext;
+
+/* Writers for each output format, in OUTPUT_* order, see libemt.c */
+extern struct emitter_struct gEmitter_table[];
+
+/*
+ * The settings and state used throughout the library, in the current
+ * context.
+ */
+#ifdef OUTPUT_TO_FILE
+#define gStdout_file      (gContext->stdout_file)
+#else
+#define gStdout_file      stdout
+#endif /* OUTPUT_TO_FILE */
+
+#define gOutfile          (gContext->outfile)
+#define gOutfileName      (gContext->outfile_name)
+#define gTexture_name     (gContext->texture_name)
+#define gTexture_count    (gContext->texture_count)
+#define gTexture_ior      (gContext->texture_ior)
+#define gObject_count     (gContext->object_count)
+#define gRT_out_format    (gContext->rt_out_format)
+#define gRT_orig_format   (gContext->rt_orig_format)
+#define gU_resolution     (gContext->u_resolution)
+#define gV_resolution     (gContext->v_resolution)
+#define gBkgnd_color      (gContext->bkgnd_color)
+#define gFgnd_color       (gContext->fgnd_color)
+#define gView_bounds      (gContext->view_bounds)
+#define gView_init_flag   (gContext->view_init_flag)
+#define gShow_stats       (gContext->show_stats)
+
+#define gLib_surfaces     (gContext->lib_surfaces)
+#define gLib_objects      (gContext->lib_objects)
+#define gLib_lights       (gContext->lib_lights)
+#define gViewpoint        (gContext->view)
+#define gEmitter          (gContext->emitter)
+
+/* Number formatting for lib_printf */
+#define gFloat_format     (gContext->float_format)
+#define gFloat_digits     (gContext->float_digits)
+
+/* Indentation level of output file */
+#define gTab_width        (gContext->tab_width)
+#define gTab_level        (gContext->tab_level)
+
+/* Triangle store for making PLG files */
+#define gTri_store        (gContext->tris)
+#define gVertex_count     (gContext->vertex_count)  /* Vertex coordinates */
+#define gNormal_count     (gContext->normal_count)  /* Vertex normals */
+
+/* Polygons split into triangles, and heap allocations made doing it */
+#define gSplit_polygons   (gContext->split_polygons)
+#define gSplit_triangles  (gContext->split_triangles)
+#define gSplit_allocs     (gContext->split_allocs)
+
+/* Pixel error for adaptive tessellation, 0 to use the fixed resolution */
+#define gAdaptive_error   (gContext->adaptive_error)
+/* Triangles made by adaptive tessellation, and the fixed resolution's */
+#define gAdaptive_triangles (gContext->adaptive_triangles)
+#define gAdaptive_fixed   (gContext->adaptive_fixed)
+/* Levels of detail to output, and the one being output (0 the finest) */
+#define gLod_levels       (gContext->lod_levels)
+#define gLod_level        (gContext->lod_level)
+
+/* Grid spacing for welded OBJ/PLG output, 0 for no welding */
+#define gWeld_tolerance   (gContext->weld_tolerance)
+/* Vertex and normal pools for welded OBJ output */
+#define gWeld_verts       (gContext->weld_verts)
+#define gWeld_norms       (gContext->weld_norms)
+
+/* Chord tolerance for patch subdivision, 0 for uniform steps */
+#define gPatch_tolerance  (gContext->patch_tolerance)
 
 
 /*-----------------------------------------------------------------*/
@@ -478,6 +755,83 @@ char *lib_output_color PARAMS((char *name, COORD3 color, double ka,
 							  double kd, double ks, double ks_spec,
 							  double ang, double kt, double i_of_r));
 
+/* Per-format writers for the emitter table in libemt.c */
+void    emit_view_nff PARAMS((COORD3, COORD3, COORD3, double, double, double,
+							  int, int));
+void    emit_view_pov PARAMS((COORD3, COORD3, COORD3, double, double, double,
+							  int, int));
+void    emit_view_polyray PARAMS((COORD3, COORD3, COORD3, double, double,
+								  double, int, int));
+void    emit_view_vivid PARAMS((COORD3, COORD3, COORD3, double, double, double,
+								int, int));
+void    emit_view_qrt PARAMS((COORD3, COORD3, COORD3, double, double, double,
+							  int, int));
+void    emit_view_rayshade PARAMS((COORD3, COORD3, COORD3, double, double,
+								   double, int, int));
+void    emit_view_rtrace PARAMS((COORD3, COORD3, COORD3, double, double,
+								 double, int, int));
+void    emit_view_art PARAMS((COORD3, COORD3, COORD3, double, double, double,
+							  int, int));
+void    emit_view_rib PARAMS((COORD3, COORD3, COORD3, double, double, double,
+							  int, int));
+void    emit_view_dxf PARAMS((COORD3, COORD3, COORD3, double, double, double,
+							  int, int));
+void    emit_view_3dmf PARAMS((COORD3, COORD3, COORD3, double, double, double,
+							   int, int));
+void    emit_view_vrml1 PARAMS((COORD3, COORD3, COORD3, double, double, double,
+								int, int));
+void    emit_view_vrml2 PARAMS((COORD3, COORD3, COORD3, double, double, double,
+								int, int));
+void    emit_light_delayed PARAMS((COORD4, COORD3, double));
+void    emit_light_nff PARAMS((COORD4, COORD3, double));
+void    emit_light_pov10 PARAMS((COORD4, COORD3, double));
+void    emit_light_pov PARAMS((COORD4, COORD3, double));
+void    emit_light_polyray PARAMS((COORD4, COORD3, double));
+void    emit_light_vivid PARAMS((COORD4, COORD3, double));
+void    emit_light_qrt PARAMS((COORD4, COORD3, double));
+void    emit_light_rayshade PARAMS((COORD4, COORD3, double));
+void    emit_light_rtrace PARAMS((COORD4, COORD3, double));
+void    emit_light_art PARAMS((COORD4, COORD3, double));
+void    emit_light_rib PARAMS((COORD4, COORD3, double));
+void    emit_light_3dmf PARAMS((COORD4, COORD3, double));
+void    emit_light_vrml PARAMS((COORD4, COORD3, double));
+char *  emit_surface_delayed PARAMS((char *, COORD3, double, double, double,
+									 double, double, double, double, double));
+char *  emit_surface_fgnd PARAMS((char *, COORD3, double, double, double,
+								  double, double, double, double, double));
+char *  emit_surface_nff PARAMS((char *, COORD3, double, double, double,
+								 double, double, double, double, double));
+char *  emit_surface_pov10 PARAMS((char *, COORD3, double, double, double,
+								   double, double, double, double, double));
+char *  emit_surface_pov PARAMS((char *, COORD3, double, double, double,
+								 double, double, double, double, double));
+char *  emit_surface_polyray PARAMS((char *, COORD3, double, double, double,
+									 double, double, double, double, double));
+char *  emit_surface_vivid PARAMS((char *, COORD3, double, double, double,
+								   double, double, double, double, double));
+char *  emit_surface_qrt PARAMS((char *, COORD3, double, double, double,
+								 double, double, double, double, double));
+char *  emit_surface_rayshade PARAMS((char *, COORD3, double, double, double,
+									  double, double, double, double, double));
+char *  emit_surface_rtrace PARAMS((char *, COORD3, double, double, double,
+									double, double, double, double, double));
+char *  emit_surface_obj PARAMS((char *, COORD3, double, double, double,
+								 double, double, double, double, double));
+char *  emit_surface_rwx PARAMS((char *, COORD3, double, double, double,
+								 double, double, double, double, double));
+char *  emit_surface_rawtri PARAMS((char *, COORD3, double, double, double,
+									double, double, double, double, double));
+char *  emit_surface_art PARAMS((char *, COORD3, double, double, double,
+								 double, double, double, double, double));
+char *  emit_surface_rib PARAMS((char *, COORD3, double, double, double,
+								 double, double, double, double, double));
+char *  emit_surface_3dmf PARAMS((char *, COORD3, double, double, double,
+								  double, double, double, double, double));
+char *  emit_surface_vrml1 PARAMS((char *, COORD3, double, double, double,
+								   double, double, double, double, double));
+char *  emit_surface_vrml2 PARAMS((char *, COORD3, double, double, double,
+								   double, double, double, double, double));
+
 
 
 /*==== Prototypes from libpr2.c ====*/
@@ -537,10 +891,55 @@ void lib_output_sq_sphere PARAMS((COORD4 center_pt, double a1, double a2,
 								 double a3, double n, double e,
 								 int curve_format));
 
+/* Per-format writers for the emitter table in libemt.c */
+void    emit_cone_nff PARAMS((COORD4, COORD4));
+void    emit_cone_pov10 PARAMS((COORD4, COORD4));
+void    emit_cone_pov PARAMS((COORD4, COORD4));
+void    emit_cone_polyray PARAMS((COORD4, COORD4));
+void    emit_cone_vivid PARAMS((COORD4, COORD4));
+void    emit_cone_qrt PARAMS((COORD4, COORD4));
+void    emit_cone_rayshade PARAMS((COORD4, COORD4));
+void    emit_cone_rtrace PARAMS((COORD4, COORD4));
+void    emit_cone_art PARAMS((COORD4, COORD4));
+void    emit_cone_rib PARAMS((COORD4, COORD4));
+void    emit_cone_3dmf PARAMS((COORD4, COORD4));
+void    emit_cone_vrml1 PARAMS((COORD4, COORD4));
+void    emit_cone_vrml2 PARAMS((COORD4, COORD4));
+void    emit_disc_pov10 PARAMS((COORD3, COORD3, double, double));
+void    emit_disc_pov PARAMS((COORD3, COORD3, double, double));
+void    emit_disc_polyray PARAMS((COORD3, COORD3, double, double));
+void    emit_disc_qrt PARAMS((COORD3, COORD3, double, double));
+void    emit_disc_rtrace PARAMS((COORD3, COORD3, double, double));
+void    emit_disc_art PARAMS((COORD3, COORD3, double, double));
+void    emit_disc_rib PARAMS((COORD3, COORD3, double, double));
+void    emit_disc_3dmf PARAMS((COORD3, COORD3, double, double));
+void    emit_sphere_rwx PARAMS((COORD4));
+void    emit_sphere_nff PARAMS((COORD4));
+void    emit_sphere_pov10 PARAMS((COORD4));
+void    emit_sphere_pov PARAMS((COORD4));
+void    emit_sphere_polyray PARAMS((COORD4));
+void    emit_sphere_vivid PARAMS((COORD4));
+void    emit_sphere_qrt PARAMS((COORD4));
+void    emit_sphere_rayshade PARAMS((COORD4));
+void    emit_sphere_rtrace PARAMS((COORD4));
+void    emit_sphere_art PARAMS((COORD4));
+void    emit_sphere_rib PARAMS((COORD4));
+void    emit_sphere_3dmf PARAMS((COORD4));
+void    emit_sphere_vrml1 PARAMS((COORD4));
+void    emit_sphere_vrml2 PARAMS((COORD4));
+
 
 /*==== Prototypes from libpr3.c ====*/
 
 /*-----------------------------------------------------------------*/
+height_ptr lib_height_create PARAMS((int height, int width));
+height_ptr lib_height_create_rows PARAMS((int height, int width,
+										  height_row_fn fn, void *fn_data));
+void    lib_height_free PARAMS((height_ptr hf));
+float * lib_height_row PARAMS((height_ptr hf, int row, float *buf));
+void lib_output_height_field PARAMS((char *, height_ptr,
+									double, double, double, double,
+									double, double));
 void lib_output_height PARAMS((char *, float **, int, int,
 							  double, double, double, double, double, double));
 
@@ -562,10 +961,11 @@ int     lib_open PARAMS((int raytracer_format, char *filename));
 
 void    lib_close PARAMS((void));
 
-void    lib_storage_initialize PARAMS((void));
-
 void    lib_storage_shutdown PARAMS((void));
 
+void *  lib_arena_alloc PARAMS((unsigned long size));
+void    lib_arena_reset PARAMS((void));
+
 void    show_gen_usage PARAMS((void));
 void    show_read_usage PARAMS((void));
 
@@ -575,8 +975,24 @@ int     lib_read_get_opts PARAMS((int argc, char *argv[],
 				  int *p_rdr, int *p_curve, char *p_infname));
 
 void    lib_clear_database PARAMS((void));
+
+context_ptr lib_context_create PARAMS((void));
+context_ptr lib_context_select PARAMS((context_ptr context));
+void    lib_context_free PARAMS((context_ptr context));
+context_ptr lib_context_fork PARAMS((void));
 void    lib_flush_definitions PARAMS((void));
 
+/* Scene header/trailer writers for the emitter table in libemt.c */
+void    emit_begin_rwx PARAMS((void));
+void    emit_begin_3dmf PARAMS((void));
+void    emit_begin_vrml1 PARAMS((void));
+void    emit_begin_vrml2 PARAMS((void));
+void    emit_end_rib PARAMS((void));
+void    emit_end_dxf PARAMS((void));
+void    emit_end_rwx PARAMS((void));
+void    emit_end_3dmf PARAMS((void));
+void    emit_end_vrml1 PARAMS((void));
+
 
 /*==== Prototypes from libply.c ====*/
 
@@ -584,7 +1000,7 @@ void    lib_output_polygon_cylcone PARAMS((COORD4 base_pt, COORD4 apex_pt));
 void    lib_output_polygon_disc PARAMS((COORD3 center, COORD3 normal,
 									   double iradius, double oradius));
 void    lib_output_polygon_sphere PARAMS((COORD4 center_pt));
-void    lib_output_polygon_height PARAMS((int height, int width, float **data,
+void    lib_output_polygon_height PARAMS((height_ptr hf,
 										 double x0, double x1,
 										 double y0, double y1,
 										 double z0, double z1));
@@ -593,12 +1009,45 @@ void    lib_output_polygon_torus PARAMS((COORD3 center, COORD3 normal,
 void    lib_output_polygon_box PARAMS((COORD3 p1, COORD3 p2));
 void    lib_output_polygon PARAMS((int tot_vert, COORD3 vert[]));
 void    lib_output_polypatch PARAMS((int tot_vert, COORD3 vert[], COORD3 norm[]));
+void    lib_tri_store_free PARAMS((void));
+void    lib_polygon_storage_free PARAMS((void));
+template_ptr lib_get_template PARAMS((int kind, int u_res, int v_res,
+									  double p0, double p1, int *is_new));
+void    lib_tess_buffers PARAMS((long count, COORD3 **vert, COORD3 **norm));
+void    lib_set_adaptive_tessellation PARAMS((double pixel_error));
+int     lib_tess_resolution PARAMS((COORD3 center, double bound,
+									double radius, int fixed));
+void    lib_tess_count PARAMS((long fixed, long count));
+void    lib_set_lod_levels PARAMS((int levels));
+int     lib_lod_inline PARAMS((int format));
+void    lib_lod_begin PARAMS((COORD3 center, double bound, double radius));
+int     lib_lod_next PARAMS((void));
+
+/* Per-format triangle writers for the emitter table in libemt.c */
+void    emit_tri_delayed PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_plg PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_video PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_nff PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_pov PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_polyray PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_vivid PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_qrt PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_rayshade PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_art PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_rtrace PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_rawtri PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_obj PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_rwx PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_rib PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_dxf PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_3dmf PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_vrml1 PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+void    emit_tri_vrml2 PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
 
 
 /*==== Prototypes from libdmp.c ====*/
 
 void    dump_plg_file PARAMS((void));
-void    dump_obj_file PARAMS((void));
 void    dump_all_objects PARAMS((void));
 void    dump_reorder_surfaces PARAMS((void));
 void    dump_all_lights PARAMS((void));
@@ -625,6 +1074,7 @@ void    dump_all_surfaces PARAMS((void));
 
 int lib_tx_active PARAMS((void));         /* Is a transform active? */
 void lib_get_current_tx PARAMS((MATRIX)); /* Get the current transform */
+void lib_get_current_normal_tx PARAMS((MATRIX)); /* Its inverse, for normals */
 void lib_set_current_tx PARAMS((MATRIX)); /* Replace the current transform */
 void lib_output_tx_sequence PARAMS((void)); /* Write transform */
 void lib_tx_pop PARAMS((void));           /* Pop off the top transform */
@@ -635,6 +1085,107 @@ void lib_tx_translate PARAMS((COORD3));   /* Add a translation */
 int lib_tx_unwind PARAMS((MATRIX, double *)); /* Turn tx into rotate/scale/translate */
 extern MATRIX IdentityTx; /* Identity matrix.  Don't write into this! */
 
+/* Per-format transform writers for the emitter table in libemt.c */
+void    emit_tx_rtrace PARAMS((MATRIX, double *, int, int, int));
+void    emit_tx_rwx PARAMS((MATRIX, double *, int, int, int));
+void    emit_tx_rib PARAMS((MATRIX, double *, int, int, int));
+void    emit_tx_vivid PARAMS((MATRIX, double *, int, int, int));
+void    emit_tx_rayshade PARAMS((MATRIX, double *, int, int, int));
+void    emit_tx_pov10 PARAMS((MATRIX, double *, int, int, int));
+void    emit_tx_pov PARAMS((MATRIX, double *, int, int, int));
+void    emit_tx_art PARAMS((MATRIX, double *, int, int, int));
+void    emit_tx_3dmf PARAMS((MATRIX, double *, int, int, int));
+void    emit_tx_vrml1 PARAMS((MATRIX, double *, int, int, int));
+void    emit_tx_vrml2 PARAMS((MATRIX, double *, int, int, int));
+
+
+/*==== Prototypes from libins.c ====*/
+
+void    lib_set_instancing PARAMS((int flag));
+int     lib_use_instances PARAMS((void));
+long    lib_object_begin PARAMS((void));
+void    lib_object_end PARAMS((void));
+void    lib_output_instance PARAMS((long object));
+
+/* Per-format object writers for the emitter table in libemt.c */
+void    emit_object_begin_pov PARAMS((long));
+void    emit_object_end_pov PARAMS((long));
+void    emit_instance_pov PARAMS((long));
+void    emit_object_begin_rib PARAMS((long));
+void    emit_object_end_rib PARAMS((long));
+void    emit_instance_rib PARAMS((long));
+void    emit_object_begin_vrml1 PARAMS((long));
+void    emit_object_end_vrml1 PARAMS((long));
+void    emit_instance_vrml1 PARAMS((long));
+void    emit_object_begin_vrml2 PARAMS((long));
+void    emit_object_end_vrml2 PARAMS((long));
+void    emit_instance_vrml2 PARAMS((long));
+void    emit_object_begin_rayshade PARAMS((long));
+void    emit_object_end_rayshade PARAMS((long));
+void    emit_instance_rayshade PARAMS((long));
+
+
+/*==== Prototypes from libemt.c ====*/
+
+emitter_ptr lib_get_emitter PARAMS((int format));
+
+
+/*==== Prototypes from libbnf.c ====*/
+
+int     lib_bnff_little_endian PARAMS((void));
+void    emit_begin_bnff PARAMS((void));
+void    emit_view_bnff PARAMS((COORD3, COORD3, COORD3, double, double, double,
+							   int, int));
+void    emit_light_bnff PARAMS((COORD4, COORD3, double));
+void    emit_background_bnff PARAMS((COORD3));
+char *  emit_surface_bnff PARAMS((char *, COORD3, double, double, double,
+								  double, double, double, double, double));
+void    emit_cone_bnff PARAMS((COORD4, COORD4));
+void    emit_sphere_bnff PARAMS((COORD4));
+void    emit_polygon_bnff PARAMS((int, COORD3 *, COORD3 *));
+void    emit_tri_bnff PARAMS((int, COORD3 **, COORD3 **, COORD3 *));
+
+
+/*==== Prototypes from libwld.c ====*/
+
+void    lib_set_weld_tolerance PARAMS((double tolerance));
+weld_ptr lib_weld_create PARAMS((double tolerance));
+void    lib_weld_free PARAMS((weld_ptr weld));
+long    lib_weld_vertex PARAMS((weld_ptr weld, COORD3 vert, int *is_new));
+long    lib_weld_count PARAMS((weld_ptr weld));
+double * lib_weld_get_vertex PARAMS((weld_ptr weld, long index));
+
+
+/*==== Prototypes from libpch.c ====*/
+
+void    lib_set_patch_tolerance PARAMS((double tolerance));
+long    lib_output_adaptive_patch PARAMS((patch_eval_fn eval, void *data,
+										  double u0, double u1,
+										  double v0, double v1,
+										  int u_res, int v_res));
+
+
+/*==== Prototypes from libtri.c ====*/
+
+int     lib_triangulate_polygon PARAMS((int n, COORD3 *vert, int *tri));
+void    lib_triangulate_free PARAMS((void));
+
+
+/*==== Prototypes from libtsk.c ====*/
+
+void    lib_set_task_threads PARAMS((int threads));
+void    lib_task_spawn PARAMS((task_fn fn, void *data, int size));
+void    lib_task_wait PARAMS((void));
+
+
+/*==== Prototypes from libfmt.c ====*/
+
+void    lib_set_float_format PARAMS((int format, int digits));
+void    lib_buffer_output PARAMS((FILE *outfile));
+int     lib_format_number PARAMS((char *buf, double value, int prec, int alt));
+int     lib_format_double PARAMS((char *buf, double value));
+void    lib_printf PARAMS((char *fmt, ...));
+
 #if __cplusplus
 }
 #endif
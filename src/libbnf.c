@@ -0,0 +1,338 @@
+/*
+ * libbnf.c - library of binary NFF (BNFF) output routines.
+ *
+ * Author:  Eric Haines
+ *
+ * BNFF holds the same entities as NFF, written as little-endian binary
+ * records instead of text.  The file starts with a BNFF_HEADER_SIZE byte
+ * header:
+ *
+ *   "BNFF"  version  real_size  reserved      (each 4 bytes)
+ *
+ * followed by records, each of which is:
+ *
+ *   type  length  payload[length]             (type and length 4 bytes)
+ *
+ * Integers are unsigned 32 bit, reals are IEEE floats or doubles as given
+ * by real_size.  Payloads are padded to a multiple of 8 bytes, so every
+ * record starts 8 byte aligned and a mapped file can be read in place.
+ * See lib.h for the record types and their payloads.
+ */
+
+/*-----------------------------------------------------------------*/
+/* include section */
+/*-----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "lib.h"
+
+
+/*-----------------------------------------------------------------*/
+/* defines/constants section */
+/*-----------------------------------------------------------------*/
+
+/* Bytes of padding needed after "n" reals to reach an 8 byte boundary */
+#define REAL_PAD(n)	((8 - ((n) * BNFF_REAL_SIZE) % 8) % 8)
+
+
+/*-----------------------------------------------------------------*/
+/* Returns TRUE if this machine stores numbers least significant byte first */
+int lib_bnff_little_endian PARAMS((void))
+{
+    static int one = 1;
+
+    return (*(char *)&one == 1);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+static void put_u32(unsigned long val)
+#else
+static void put_u32(val)
+unsigned long val;
+#endif
+{
+    unsigned char buf[4];
+
+    buf[0] = (unsigned char)(val & 0xff);
+    buf[1] = (unsigned char)((val >> 8) & 0xff);
+    buf[2] = (unsigned char)((val >> 16) & 0xff);
+    buf[3] = (unsigned char)((val >> 24) & 0xff);
+    fwrite(buf, 1, 4, gOutfile);
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Write "n" reals from a contiguous array.  Doubles on a little-endian
+ * machine go out in one fwrite; anything else is converted a value at a
+ * time.
+ */
+#ifdef ANSI_FN_DEF
+static void put_reals(double *vals, long n)
+#else
+static void put_reals(vals, n)
+double *vals;
+long n;
+#endif
+{
+    unsigned char buf[8], *p;
+    float fval;
+    long i;
+    int j;
+
+    if ((BNFF_REAL_SIZE == 8) && lib_bnff_little_endian()) {
+		fwrite(vals, sizeof(double), (size_t)n, gOutfile);
+		return;
+    }
+    for (i = 0; i < n; i++) {
+		if (BNFF_REAL_SIZE == 4) {
+			fval = (float)vals[i];
+			p = (unsigned char *)&fval;
+		} else
+			p = (unsigned char *)&vals[i];
+		if (lib_bnff_little_endian())
+			for (j = 0; j < BNFF_REAL_SIZE; j++)
+				buf[j] = p[j];
+		else
+			for (j = 0; j < BNFF_REAL_SIZE; j++)
+				buf[j] = p[BNFF_REAL_SIZE-1-j];
+		fwrite(buf, 1, BNFF_REAL_SIZE, gOutfile);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* Pad out a record after "n" reals */
+#ifdef ANSI_FN_DEF
+static void put_pad(long n)
+#else
+static void put_pad(n)
+long n;
+#endif
+{
+    static unsigned char zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    if (REAL_PAD(n) > 0)
+		fwrite(zeros, 1, REAL_PAD(n), gOutfile);
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Start a record holding "nwords" 32 bit integers followed by "nreals"
+ * reals.  nwords must be even to keep the reals aligned.
+ */
+#ifdef ANSI_FN_DEF
+static void put_record(unsigned long type, int nwords, long nreals)
+#else
+static void put_record(type, nwords, nreals)
+unsigned long type;
+int nwords;
+long nreals;
+#endif
+{
+    put_u32(type);
+    put_u32((unsigned long)(4 * nwords + nreals * BNFF_REAL_SIZE +
+		REAL_PAD(nreals)));
+}
+
+/*-----------------------------------------------------------------*/
+/* Write a record of "n" reals, with no integers */
+#ifdef ANSI_FN_DEF
+static void put_real_record(unsigned long type, double *vals, int n)
+#else
+static void put_real_record(type, vals, n)
+unsigned long type;
+double *vals;
+int n;
+#endif
+{
+    put_record(type, 0, (long)n);
+    put_reals(vals, (long)n);
+    put_pad((long)n);
+}
+
+/*-----------------------------------------------------------------*/
+void emit_begin_bnff PARAMS((void))
+{
+    fwrite(BNFF_MAGIC, 1, 4, gOutfile);
+    put_u32((unsigned long)BNFF_VERSION);
+    put_u32((unsigned long)BNFF_REAL_SIZE);
+    put_u32(0L);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_bnff(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+					double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_bnff(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    double vals[11];
+
+    COPY_COORD3(&vals[0], from);
+    COPY_COORD3(&vals[3], at);
+    COPY_COORD3(&vals[6], up);
+    vals[9] = fov_angle;
+    vals[10] = hither;
+    put_record((unsigned long)BNFF_VIEW, 2, 11L);
+    put_u32((unsigned long)resx);
+    put_u32((unsigned long)resy);
+    put_reals(vals, 11L);
+    put_pad(11L);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_bnff(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_bnff(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    put_real_record((unsigned long)BNFF_LIGHT, vec, 3);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_background_bnff(COORD3 color)
+#else
+void emit_background_bnff(color)
+COORD3 color;
+#endif
+{
+    put_real_record((unsigned long)BNFF_BACKGROUND, color, 3);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_bnff(char *name, COORD3 color, double ka, double kd,
+						 double ks, double ks_spec, double ang, double kt,
+						 double i_of_r, double phong_pow)
+#else
+char * emit_surface_bnff(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						 phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    double vals[8];
+
+    COPY_COORD3(&vals[0], color);
+    vals[3] = kd;
+    vals[4] = ks;
+    vals[5] = phong_pow;
+    vals[6] = kt;
+    vals[7] = i_of_r;
+    put_real_record((unsigned long)BNFF_FILL, vals, 8);
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_cone_bnff(COORD4 base_pt, COORD4 apex_pt)
+#else
+void emit_cone_bnff(base_pt, apex_pt)
+COORD4 base_pt, apex_pt;
+#endif
+{
+    MATRIX txmat;
+    double trans[16];
+    COORD4 tempv1;
+    double vals[8];
+
+    if (lib_tx_active()) {
+		lib_get_current_tx(txmat);
+		lib_tx_unwind(txmat, trans);
+		/* Transform the cone by modifying it's endpoints.  This
+		   assumes uniform scaling. */
+		lib_transform_point(tempv1, base_pt, txmat);
+		COPY_COORD3(base_pt, tempv1);
+		base_pt[W] *= fabs(trans[U_SCALEX]);
+		lib_transform_point(tempv1, apex_pt, txmat);
+		COPY_COORD3(apex_pt, tempv1);
+		apex_pt[W] *= fabs(trans[U_SCALEX]);
+    }
+    COPY_COORD4(&vals[0], base_pt);
+    COPY_COORD4(&vals[4], apex_pt);
+    put_real_record((unsigned long)BNFF_CONE, vals, 8);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_sphere_bnff(COORD4 center_pt)
+#else
+void emit_sphere_bnff(center_pt)
+COORD4 center_pt;
+#endif
+{
+    MATRIX txmat;
+    double trans[16];
+    COORD3 tempv;
+
+    if (lib_tx_active()) {
+		lib_get_current_tx(txmat);
+		lib_tx_unwind(txmat, trans);
+		/* Transform the sphere by modifying it's center.  This
+		assumes uniform scaling. */
+		lib_transform_point(tempv, center_pt, txmat);
+		COPY_COORD3(center_pt, tempv);
+		center_pt[W] *= fabs(trans[U_SCALEX]);
+    }
+    put_real_record((unsigned long)BNFF_SPHERE, center_pt, 4);
+}
+
+/*-----------------------------------------------------------------*/
+/* Polygon (norm == NULL) or polygonal patch, vertices already transformed */
+#ifdef ANSI_FN_DEF
+void emit_polygon_bnff(int tot_vert, COORD3 *vert, COORD3 *norm)
+#else
+void emit_polygon_bnff(tot_vert, vert, norm)
+int tot_vert;
+COORD3 *vert, *norm;
+#endif
+{
+    long n;
+
+    n = 3L * tot_vert;
+    if (norm == NULL) {
+		put_record((unsigned long)BNFF_POLYGON, 2, n);
+		put_u32((unsigned long)tot_vert);
+		put_u32(0L);
+		put_reals((double *)vert, n);
+		put_pad(n);
+    } else {
+		put_record((unsigned long)BNFF_PATCH, 2, 2*n);
+		put_u32((unsigned long)tot_vert);
+		put_u32(0L);
+		put_reals((double *)vert, n);
+		put_reals((double *)norm, n);
+		put_pad(2*n);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_bnff(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_bnff(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int t;
+
+    for (t=0;t<cnt;t++)
+		emit_polygon_bnff(3, verts[t],
+			(norms == NULL) ? (COORD3 *)NULL : norms[t]);
+}
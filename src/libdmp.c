@@ -24,91 +24,167 @@
 
 
 /*-----------------------------------------------------------------*/
-void
-dump_plg_file PARAMS((void))
+/* Weld a stored vertex, widened back to a COORD3 */
+#ifdef ANSI_FN_DEF
+static long weld_stored(weld_ptr weld, STORE_REAL *vert, int *is_new)
+#else
+static long weld_stored(weld, vert, is_new)
+weld_ptr weld;
+STORE_REAL *vert;
+int *is_new;
+#endif
 {
-    object_ptr temp_obj;
-    int i;
-    unsigned int fcnt, vcnt;
-	
-    fcnt = 0;
-    vcnt = 0;
-    for (temp_obj = gPolygon_stack;
-	temp_obj != NULL;
-	temp_obj = temp_obj->next_object) {
-		fcnt++;
-		vcnt += temp_obj->object_data.polygon.tot_vert;
+    COORD3 pt;
+
+    LOAD_COORD3(pt, vert);
+    return lib_weld_vertex(weld, pt, is_new);
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Get "tot_vert" stored vertices (and normals, if norm isn't NULL) as
+ * COORD3 arrays, for output.  Stored in double precision they are used
+ * as they are; in single precision they are widened into the scratch
+ * arrays of lib_tess_buffers, good until the next call.
+ */
+#ifdef ANSI_FN_DEF
+static void load_stored(unsigned int tot_vert, STORE3 *vert, STORE3 *norm,
+						COORD3 **p_vert, COORD3 **p_norm)
+#else
+static void load_stored(tot_vert, vert, norm, p_vert, p_norm)
+unsigned int tot_vert;
+STORE3 *vert, *norm;
+COORD3 **p_vert, **p_norm;
+#endif
+{
+#ifdef STORE_FLOAT
+    unsigned int i;
+
+    lib_tess_buffers((long)tot_vert, p_vert, p_norm);
+    for (i=0;i<tot_vert;i++) {
+		LOAD_COORD3((*p_vert)[i], vert[i]);
+		if (norm != NULL)
+			LOAD_COORD3((*p_norm)[i], norm[i]);
     }
-	
-    fprintf(gOutfile, "objx %d %d\n", vcnt, fcnt);
-	
-    /* Dump all vertices */
-    for (temp_obj = gPolygon_stack;
-	temp_obj != NULL;
-	temp_obj = temp_obj->next_object) {
-		
-		PLATFORM_MULTITASK();
-		for (i=0;i<(int)temp_obj->object_data.polygon.tot_vert;i++) {
-			fprintf(gOutfile, "%g %g %g\n",
-				temp_obj->object_data.polygon.vert[i][X],
-				temp_obj->object_data.polygon.vert[i][Y],
-				temp_obj->object_data.polygon.vert[i][Z]);
-		}
+#else
+    *p_vert = vert;
+    if (norm != NULL)
+		*p_norm = norm;
+#endif
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Weld the vertices of every triangle in gTri_store into a new pool, and
+ * put the number of triangles that don't collapse in *p_faces.  Returns
+ * NULL if welding is off or there isn't room for the pool.
+ */
+#ifdef ANSI_FN_DEF
+static weld_ptr weld_tri_store(TRI_COUNT *p_faces)
+#else
+static weld_ptr weld_tri_store(p_faces)
+TRI_COUNT *p_faces;
+#endif
+{
+    weld_ptr weld;
+    TRI_COUNT t;
+    long vi[3];
+    int i, is_new;
+
+    if (gWeld_tolerance <= 0.0)
+		return NULL;
+    weld = lib_weld_create(gWeld_tolerance);
+    if (weld == NULL)
+		/* Quietly fail, and write the vertices unwelded */
+		return NULL;
+
+    /* The store is written newest triangle first, as the old polygon
+       stack was, so weld in that order too */
+    *p_faces = 0;
+    for (t = gTri_store.count; t-- > 0;) {
+		for (i=0;i<3;i++)
+			vi[i] = weld_stored(weld, TRI_VERT(gTri_store, t, i), &is_new);
+		if ((vi[0] != vi[1]) && (vi[1] != vi[2]) && (vi[2] != vi[0]))
+			(*p_faces)++;
     }
-	
-    /* Dump all faces */
-    vcnt = 0;
-    for (temp_obj = gPolygon_stack;
-	temp_obj != NULL;
-	temp_obj = temp_obj->next_object) {
-		
-		PLATFORM_MULTITASK();
-		fprintf(gOutfile, "0x11ff %d ", temp_obj->object_data.polygon.tot_vert);
-		for (i=0;i<(int)temp_obj->object_data.polygon.tot_vert;i++)
-			fprintf(gOutfile, "%d ", vcnt + i);
-		fprintf(gOutfile, "\n");
-		vcnt += i;
+    return weld;
+}
+
+/*-----------------------------------------------------------------*/
+/* Write out the pool of welded vertices, each as "<prefix>x y z" */
+#ifdef ANSI_FN_DEF
+static void dump_weld_pool(char *prefix, weld_ptr weld)
+#else
+static void dump_weld_pool(prefix, weld)
+char *prefix;
+weld_ptr weld;
+#endif
+{
+    double *vert;
+    long i;
+
+    for (i=0;i<lib_weld_count(weld);i++) {
+		vert = lib_weld_get_vertex(weld, i);
+		lib_printf("%s%g %g %g\n", prefix, vert[X], vert[Y], vert[Z]);
     }
 }
 
 /*-----------------------------------------------------------------*/
+/*
+ * Write the triangles in gTri_store as a PLG object.  If welding is on,
+ * vertices shared between triangles are written once, and triangles that
+ * welding collapses are dropped.
+ */
 void
-dump_obj_file PARAMS((void))
+dump_plg_file PARAMS((void))
 {
-    object_ptr temp_obj;
-    int i;
-    unsigned int vcnt;
+    weld_ptr weld;
+    STORE_REAL *vert;
+    TRI_COUNT t, vcnt, fcnt, vi[3];
+    int i, is_new;
+	
+    weld = weld_tri_store(&fcnt);
+	
+    if (weld != NULL) {
+		vcnt = (TRI_COUNT)lib_weld_count(weld);
+    } else {
+		vcnt = 3 * gTri_store.count;
+		fcnt = gTri_store.count;
+    }
+	
+    lib_printf("objx " TRI_COUNT_FMT " " TRI_COUNT_FMT "\n", vcnt, fcnt);
 	
     /* Dump all vertices */
-    for (temp_obj = gPolygon_stack;
-	temp_obj != NULL;
-	temp_obj = temp_obj->next_object) {
-		
-		PLATFORM_MULTITASK();
-		for (i=0;i<(int)temp_obj->object_data.polygon.tot_vert;i++) {
-			fprintf(gOutfile, "v %g %g %g\n",
-				temp_obj->object_data.polygon.vert[i][X],
-				temp_obj->object_data.polygon.vert[i][Y],
-				temp_obj->object_data.polygon.vert[i][Z]);
+    if (weld != NULL) {
+		dump_weld_pool("", weld);
+    } else {
+		for (t = gTri_store.count; t-- > 0;) {
+			PLATFORM_MULTITASK();
+			for (i=0;i<3;i++) {
+				vert = TRI_VERT(gTri_store, t, i);
+				lib_printf("%g %g %g\n", vert[X], vert[Y], vert[Z]);
+			}
 		}
     }
 	
     /* Dump all faces */
     vcnt = 0;
-    for (temp_obj = gPolygon_stack;
-	temp_obj != NULL;
-	temp_obj = temp_obj->next_object) {
-		
+    for (t = gTri_store.count; t-- > 0;) {
 		PLATFORM_MULTITASK();
-		fprintf(gOutfile, "%d ", temp_obj->object_data.polygon.tot_vert);
-		for (i=0;i<(int)temp_obj->object_data.polygon.tot_vert;i++) {
-			fprintf(gOutfile, "%d", vcnt + i + 1);
-			if (i < (int)temp_obj->object_data.polygon.tot_vert - 1)
-				fprintf(gOutfile, " ");
-		}
-		fprintf(gOutfile, "\n");
-		vcnt += i;
+		for (i=0;i<3;i++)
+			if (weld != NULL)
+				vi[i] = (TRI_COUNT)weld_stored(weld,
+					TRI_VERT(gTri_store, t, i), &is_new);
+			else
+				vi[i] = vcnt + i;
+		vcnt += 3;
+		if ((vi[0] == vi[1]) || (vi[1] == vi[2]) || (vi[2] == vi[0]))
+			continue;
+		lib_printf("0x11ff 3 " TRI_COUNT_FMT " " TRI_COUNT_FMT " "
+			TRI_COUNT_FMT " \n", vi[0], vi[1], vi[2]);
     }
+	
+    lib_weld_free(weld);
 }
 
 /*-----------------------------------------------------------------*/
@@ -116,9 +192,10 @@ void
 dump_all_objects PARAMS((void))
 {
     object_ptr temp_obj;
+    COORD3 *vert = NULL, *norm = NULL;
 	
     if (gRT_out_format == OUTPUT_RTRACE)
-		fprintf(gOutfile, "Objects\n");
+		lib_printf("Objects\n");
 	
     /* Step through all objects dumping them as we go. */
     for (temp_obj = gLib_objects, gObject_count = 0;
@@ -153,10 +230,8 @@ dump_all_objects PARAMS((void))
 				temp_obj->curve_format);
 			break;
 		case HEIGHT_OBJ:
-			lib_output_height(temp_obj->object_data.height.filename,
-				temp_obj->object_data.height.data,
-				temp_obj->object_data.height.height,
-				temp_obj->object_data.height.width,
+			lib_output_height_field(temp_obj->object_data.height.filename,
+				temp_obj->object_data.height.field,
 				temp_obj->object_data.height.x0,
 				temp_obj->object_data.height.x1,
 				temp_obj->object_data.height.y0,
@@ -165,13 +240,16 @@ dump_all_objects PARAMS((void))
 				temp_obj->object_data.height.z1);
 			break;
 		case POLYGON_OBJ:
-			lib_output_polygon(temp_obj->object_data.polygon.tot_vert,
-				temp_obj->object_data.polygon.vert);
+			load_stored(temp_obj->object_data.polygon.tot_vert,
+				temp_obj->object_data.polygon.vert, NULL, &vert, NULL);
+			lib_output_polygon(temp_obj->object_data.polygon.tot_vert, vert);
 			break;
 		case POLYPATCH_OBJ:
-			lib_output_polypatch(temp_obj->object_data.polypatch.tot_vert,
+			load_stored(temp_obj->object_data.polypatch.tot_vert,
 				temp_obj->object_data.polypatch.vert,
-				temp_obj->object_data.polypatch.norm);
+				temp_obj->object_data.polypatch.norm, &vert, &norm);
+			lib_output_polypatch(temp_obj->object_data.polypatch.tot_vert,
+				vert, norm);
 			break;
 		case SPHERE_OBJ:
 			lib_output_sphere(temp_obj->object_data.sphere.center_pt,
@@ -194,7 +272,7 @@ dump_all_objects PARAMS((void))
 				temp_obj->curve_format);
 			break;
 		default:
-			fprintf(gOutfile, "Bad object type: %d\n",
+			lib_printf("Bad object type: %d\n",
 				temp_obj->object_type);
 			exit(1);
 		}
@@ -205,7 +283,7 @@ dump_all_objects PARAMS((void))
     }
 	
     if (gRT_out_format == OUTPUT_RTRACE)
-		fprintf(gOutfile, "\n");
+		lib_printf("\n");
 }
 
 /*-----------------------------------------------------------------*/
@@ -231,7 +309,7 @@ dump_all_lights PARAMS((void))
     light_ptr temp_ptr = gLib_lights;
 	
     if (gRT_out_format == OUTPUT_RTRACE)
-		fprintf(gOutfile, "Lights\n");
+		lib_printf("Lights\n");
 	
     while (temp_ptr != NULL) {
 		lib_output_light(temp_ptr->center_pt);
@@ -239,7 +317,7 @@ dump_all_lights PARAMS((void))
     }
 	
     if (gRT_out_format == OUTPUT_RTRACE)
-		fprintf(gOutfile, "\n");
+		lib_printf("\n");
 }
 
 /*-----------------------------------------------------------------*/
@@ -249,7 +327,7 @@ dump_all_surfaces PARAMS((void))
     surface_ptr temp_ptr = gLib_surfaces;
 	
     if (gRT_out_format == OUTPUT_RTRACE)
-		fprintf(gOutfile, "Surfaces\n");
+		lib_printf("Surfaces\n");
 	
     while (temp_ptr != NULL) {
 		lib_output_color(temp_ptr->surf_name, temp_ptr->color, temp_ptr->ka,
@@ -259,6 +337,6 @@ dump_all_surfaces PARAMS((void))
     }
 	
     if (gRT_out_format == OUTPUT_RTRACE)
-		fprintf(gOutfile, "\n");
+		lib_printf("\n");
 }
 
@@ -0,0 +1,162 @@
+/*
+ * libemt.c - output emitter tables, one entry per output format.
+ *
+ * Author:  Eric Haines
+ *
+ */
+
+/*-----------------------------------------------------------------*/
+/* include section */
+/*-----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "lib.h"
+
+
+/*-----------------------------------------------------------------*/
+/* defines/constants section */
+/*-----------------------------------------------------------------*/
+
+/*
+ * Writers for each raytracer type, in OUTPUT_* order.  Columns are
+ * begin_scene, end_scene, viewpoint, light, surface, sphere, cone,
+ * disc, triangles, transform, then object_begin, object_end and instance.
+ * A NULL entry means nothing is written; formats with no instance writer
+ * can't instance objects.
+ */
+struct emitter_struct gEmitter_table[OUTPUT_DELAYED+1] =
+{
+/* OUTPUT_VIDEO      Output direct to the screen (sys dependent) */
+{ NULL, NULL, NULL, NULL, emit_surface_fgnd,
+  lib_output_polygon_sphere, lib_output_polygon_cylcone,
+  lib_output_polygon_disc, emit_tri_video, NULL,
+  NULL, NULL, NULL },
+/* OUTPUT_NFF        MTV                                         */
+{ NULL, NULL, emit_view_nff, emit_light_nff, emit_surface_nff,
+  emit_sphere_nff, emit_cone_nff,
+  lib_output_polygon_disc, emit_tri_nff, NULL,
+  NULL, NULL, NULL },
+/* OUTPUT_POVRAY_10  POV-Ray 1.0                                 */
+{ NULL, NULL, emit_view_pov, emit_light_pov10, emit_surface_pov10,
+  emit_sphere_pov10, emit_cone_pov10,
+  emit_disc_pov10, emit_tri_pov, emit_tx_pov10,
+  NULL, NULL, NULL },
+/* OUTPUT_POVRAY_20  POV-Ray 2.x                                 */
+{ NULL, NULL, emit_view_pov, emit_light_pov, emit_surface_pov,
+  emit_sphere_pov, emit_cone_pov,
+  emit_disc_pov, emit_tri_pov, emit_tx_pov,
+  emit_object_begin_pov, emit_object_end_pov, emit_instance_pov },
+/* OUTPUT_POVRAY_30  POV-Ray 3.x                                 */
+{ NULL, NULL, emit_view_pov, emit_light_pov, emit_surface_pov,
+  emit_sphere_pov, emit_cone_pov,
+  emit_disc_pov, emit_tri_pov, emit_tx_pov,
+  emit_object_begin_pov, emit_object_end_pov, emit_instance_pov },
+/* OUTPUT_POLYRAY    Polyray v1.4 -> v1.8                        */
+{ NULL, NULL, emit_view_polyray, emit_light_polyray, emit_surface_polyray,
+  emit_sphere_polyray, emit_cone_polyray,
+  emit_disc_polyray, emit_tri_polyray, emit_tx_pov,
+  NULL, NULL, NULL },
+/* OUTPUT_VIVID      Vivid 2.0                                   */
+{ NULL, NULL, emit_view_vivid, emit_light_vivid, emit_surface_vivid,
+  emit_sphere_vivid, emit_cone_vivid,
+  lib_output_polygon_disc, emit_tri_vivid, emit_tx_vivid,
+  NULL, NULL, NULL },
+/* OUTPUT_QRT        QRT 1.5                                     */
+{ NULL, NULL, emit_view_qrt, emit_light_qrt, emit_surface_qrt,
+  emit_sphere_qrt, emit_cone_qrt,
+  emit_disc_qrt, emit_tri_qrt, NULL,
+  NULL, NULL, NULL },
+/* OUTPUT_RAYSHADE   Rayshade                                    */
+{ NULL, NULL, emit_view_rayshade, emit_light_rayshade, emit_surface_rayshade,
+  emit_sphere_rayshade, emit_cone_rayshade,
+  lib_output_polygon_disc, emit_tri_rayshade, emit_tx_rayshade,
+  emit_object_begin_rayshade, emit_object_end_rayshade,
+  emit_instance_rayshade },
+/* OUTPUT_RTRACE     RTrace 8.0.0                                */
+{ NULL, NULL, emit_view_rtrace, emit_light_rtrace, emit_surface_rtrace,
+  emit_sphere_rtrace, emit_cone_rtrace,
+  emit_disc_rtrace, emit_tri_rtrace, emit_tx_rtrace,
+  NULL, NULL, NULL },
+/* OUTPUT_PLG        PLG format for use with REND386/Avril       */
+{ NULL, NULL, NULL, NULL, emit_surface_fgnd,
+  lib_output_polygon_sphere, lib_output_polygon_cylcone,
+  lib_output_polygon_disc, emit_tri_plg, NULL,
+  NULL, NULL, NULL },
+/* OUTPUT_RAWTRI     Raw triangle output                         */
+{ NULL, NULL, NULL, NULL, emit_surface_rawtri,
+  lib_output_polygon_sphere, lib_output_polygon_cylcone,
+  lib_output_polygon_disc, emit_tri_rawtri, NULL,
+  NULL, NULL, NULL },
+/* OUTPUT_ART        Art 2.3                                     */
+{ NULL, NULL, emit_view_art, emit_light_art, emit_surface_art,
+  emit_sphere_art, emit_cone_art,
+  emit_disc_art, emit_tri_art, emit_tx_art,
+  NULL, NULL, NULL },
+/* OUTPUT_RIB        RenderMan RIB format                        */
+{ NULL, emit_end_rib, emit_view_rib, emit_light_rib, emit_surface_rib,
+  emit_sphere_rib, emit_cone_rib,
+  emit_disc_rib, emit_tri_rib, emit_tx_rib,
+  emit_object_begin_rib, emit_object_end_rib, emit_instance_rib },
+/* OUTPUT_DXF        Autodesk DXF format                         */
+{ NULL, emit_end_dxf, emit_view_dxf, NULL, NULL,
+  lib_output_polygon_sphere, lib_output_polygon_cylcone,
+  lib_output_polygon_disc, emit_tri_dxf, NULL,
+  NULL, NULL, NULL },
+/* OUTPUT_OBJ        Wavefront OBJ format                        */
+{ NULL, NULL, NULL, NULL, emit_surface_obj,
+  lib_output_polygon_sphere, lib_output_polygon_cylcone,
+  lib_output_polygon_disc, emit_tri_obj, NULL,
+  NULL, NULL, NULL },
+/* OUTPUT_RWX        RenderWare RWX script file                  */
+{ emit_begin_rwx, emit_end_rwx, NULL, NULL, emit_surface_rwx,
+  emit_sphere_rwx, lib_output_polygon_cylcone,
+  lib_output_polygon_disc, emit_tri_rwx, emit_tx_rwx,
+  NULL, NULL, NULL },
+/* OUTPUT_3DMF       3D Metafile (Apple Quickdraw 3D text format) */
+{ emit_begin_3dmf, emit_end_3dmf, emit_view_3dmf, emit_light_3dmf,
+  emit_surface_3dmf,
+  emit_sphere_3dmf, emit_cone_3dmf,
+  emit_disc_3dmf, emit_tri_3dmf, emit_tx_3dmf,
+  NULL, NULL, NULL },
+/* OUTPUT_VRML1      Virtual Reality Modeling Language 1.0       */
+{ emit_begin_vrml1, emit_end_vrml1, emit_view_vrml1, emit_light_vrml,
+  emit_surface_vrml1,
+  emit_sphere_vrml1, emit_cone_vrml1,
+  lib_output_polygon_disc, emit_tri_vrml1, emit_tx_vrml1,
+  emit_object_begin_vrml1, emit_object_end_vrml1, emit_instance_vrml1 },
+/* OUTPUT_VRML2      Virtual Reality Modeling Language 2.0       */
+{ emit_begin_vrml2, NULL, emit_view_vrml2, emit_light_vrml,
+  emit_surface_vrml2,
+  emit_sphere_vrml2, emit_cone_vrml2,
+  lib_output_polygon_disc, emit_tri_vrml2, emit_tx_vrml2,
+  emit_object_begin_vrml2, emit_object_end_vrml2, emit_instance_vrml2 },
+/* OUTPUT_BNFF       Binary NFF                                  */
+{ emit_begin_bnff, NULL, emit_view_bnff, emit_light_bnff, emit_surface_bnff,
+  emit_sphere_bnff, emit_cone_bnff,
+  lib_output_polygon_disc, emit_tri_bnff, NULL,
+  NULL, NULL, NULL },
+/* OUTPUT_DELAYED    Needed for RTRACE/PLG output.               */
+{ NULL, NULL, NULL, emit_light_delayed, emit_surface_delayed,
+  NULL, NULL,
+  NULL, emit_tri_delayed, NULL,
+  NULL, NULL, NULL },
+};
+
+
+/*-----------------------------------------------------------------*/
+/* Return the emitter for an output format, or NULL if out of range */
+#ifdef ANSI_FN_DEF
+emitter_ptr lib_get_emitter (int format)
+#else
+emitter_ptr lib_get_emitter(format)
+int format;
+#endif
+{
+    if ((format < OUTPUT_VIDEO) || (format > OUTPUT_DELAYED))
+		return NULL;
+    return &gEmitter_table[format];
+}
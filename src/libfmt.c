@@ -0,0 +1,433 @@
+/*
+ * libfmt.c - library of number formatting and buffered output routines.
+ *
+ * Author:  Eric Haines
+ *
+ */
+
+/*-----------------------------------------------------------------*/
+/* include section */
+/*-----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string.h>
+
+#include "lib.h"
+
+
+/*-----------------------------------------------------------------*/
+/* defines/constants section */
+/*-----------------------------------------------------------------*/
+
+/* Largest precision handled without falling back to sprintf */
+#define FAST_MAX_DIGITS   9
+
+/* Size of the local buffer used to build up one lib_printf call */
+#define LINE_SIZE      1024
+
+/* Output buffer handed to stdio for the output file, allocated once per
+   context.  How "%g" is written is set by gFloat_format and gFloat_digits,
+   see lib_set_float_format. */
+#define gOut_buffer    (gContext->out_buffer)
+
+/* Powers of ten exactly representable as doubles */
+static double Pow10[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+/*-----------------------------------------------------------------*/
+/* Set how "%g" values are written by lib_printf */
+#ifdef ANSI_FN_DEF
+void lib_set_float_format (int format, int digits)
+#else
+void lib_set_float_format(format, digits)
+int format, digits;
+#endif
+{
+    if (format == FLOAT_FORMAT_SHORTEST)
+		gFloat_format = FLOAT_FORMAT_SHORTEST;
+    else
+		gFloat_format = FLOAT_FORMAT_FIXED;
+    if ((digits > 0) && (digits <= 17))
+		gFloat_digits = digits;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Give the output file a large stdio buffer.  Must be called before
+ * anything is written to the file.  If the buffer can't be allocated we
+ * quietly keep the default one.
+ */
+#ifdef ANSI_FN_DEF
+void lib_buffer_output (FILE *outfile)
+#else
+void lib_buffer_output(outfile)
+FILE *outfile;
+#endif
+{
+    if (outfile == NULL)
+		return;
+    if (gOut_buffer == NULL) {
+		gOut_buffer = (char *)malloc(OUTPUT_BUFFER_SIZE);
+		if (gOut_buffer == NULL)
+			return;
+    }
+    setvbuf(outfile, gOut_buffer, _IOFBF, OUTPUT_BUFFER_SIZE);
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Write the digits of an unsigned value, most significant first.  A
+ * TRI_COUNT is at least as wide as an unsigned long.  Returns the number
+ * of characters written.
+ */
+#ifdef ANSI_FN_DEF
+static int format_ulong(char *buf, TRI_COUNT val)
+#else
+static int format_ulong(buf, val)
+char *buf;
+TRI_COUNT val;
+#endif
+{
+    char tmp[24];
+    int i, n;
+
+    n = 0;
+    do {
+		tmp[n++] = (char)('0' + (val % 10));
+		val /= 10;
+    } while (val > 0);
+    for (i = 0; i < n; i++)
+		buf[i] = tmp[n-1-i];
+    return n;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+static int format_long(char *buf, long val)
+#else
+static int format_long(buf, val)
+char *buf;
+long val;
+#endif
+{
+    if (val < 0) {
+		buf[0] = '-';
+		return 1 + format_ulong(buf+1, (TRI_COUNT)(-(val+1)) + 1);
+    }
+    return format_ulong(buf, (TRI_COUNT)val);
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Round |value| to "prec" significant digits.  The digits go in "digits"
+ * and the decimal exponent of the first digit in "exp".  Returns FALSE
+ * if the answer can't be guaranteed to match the C library (a near tie,
+ * or a value out of the exact power of ten range), in which case the
+ * caller uses sprintf.
+ */
+#ifdef ANSI_FN_DEF
+static int round_digits(double value, int prec, char *digits, int *exp)
+#else
+static int round_digits(value, prec, digits, exp)
+double value;
+int prec;
+char *digits;
+int *exp;
+#endif
+{
+    double m, f, frac;
+    unsigned long r;
+    int e, k, i;
+
+    /* Guess the decimal exponent from the binary one; the loop fixes it
+       up if the guess is one off. */
+    (void)frexp(value, &e);
+    e = (int)floor((e - 1) * 0.30102999566398120);
+    for (i = 0; i < 3; i++) {
+		k = prec - 1 - e;
+		if ((k > 22) || (k < -22))
+			return FALSE;
+		m = (k >= 0) ? value * Pow10[k] : value / Pow10[-k];
+		if (m < Pow10[prec-1])
+			e--;
+		else if (m >= Pow10[prec])
+			e++;
+		else
+			break;
+    }
+    if ((m < Pow10[prec-1]) || (m >= Pow10[prec]))
+		return FALSE;
+
+    /* The scaling is good to half an ulp, so anything that close to a
+       rounding tie is left to the C library. */
+    f = floor(m);
+    frac = m - f;
+    if (ABSOLUTE(frac - 0.5) <= m * 4.0e-16)
+		return FALSE;
+    r = (unsigned long)f;
+    if (frac > 0.5)
+		r++;
+    if ((double)r >= Pow10[prec]) {
+		r /= 10;
+		e++;
+    }
+
+    for (i = prec-1; i >= 0; i--) {
+		digits[i] = (char)('0' + (r % 10));
+		r /= 10;
+    }
+    *exp = e;
+    return TRUE;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Format a value as "%.<prec>g" would (or "%#.<prec>g" if alt is set).
+ * Returns the number of characters written.
+ */
+#ifdef ANSI_FN_DEF
+int lib_format_number (char *buf, double value, int prec, int alt)
+#else
+int lib_format_number(buf, value, prec, alt)
+char *buf;
+double value;
+int prec, alt;
+#endif
+{
+    char digits[FAST_MAX_DIGITS];
+    int e, n, i, last, xe;
+
+    if (prec < 1)
+		prec = 1;
+    if ((value == 0.0) && !alt && (1.0/value > 0.0)) {
+		buf[0] = '0';
+		buf[1] = '\0';
+		return 1;
+    }
+    if ((prec > FAST_MAX_DIGITS) || (value != value) || (value == 0.0) ||
+		(value - value != 0.0) ||
+		!round_digits(ABSOLUTE(value), prec, digits, &e)) {
+		return sprintf_s(buf, NUMBER_BUFFER_SIZE,
+			alt ? "%#.*g" : "%.*g", prec, value);
+    }
+
+    n = 0;
+    if (value < 0.0)
+		buf[n++] = '-';
+
+    /* Drop trailing zeros unless '#' was given */
+    last = prec - 1;
+    if (!alt)
+		while ((last > 0) && (digits[last] == '0'))
+			last--;
+
+    if ((e < -4) || (e >= prec)) {
+		/* d.ddde+xx */
+		buf[n++] = digits[0];
+		if ((last > 0) || alt)
+			buf[n++] = '.';
+		for (i = 1; i <= last; i++)
+			buf[n++] = digits[i];
+		buf[n++] = 'e';
+		if (e < 0) {
+			buf[n++] = '-';
+			xe = -e;
+		} else {
+			buf[n++] = '+';
+			xe = e;
+		}
+		if (xe < 10)
+			buf[n++] = '0';
+		n += format_ulong(&buf[n], (unsigned long)xe);
+    } else if (e >= 0) {
+		/* ddd.ddd */
+		for (i = 0; i <= e; i++)
+			buf[n++] = digits[i];
+		if ((last > e) || alt)
+			buf[n++] = '.';
+		for (i = e+1; i <= last; i++)
+			buf[n++] = digits[i];
+    } else {
+		/* 0.000ddd */
+		buf[n++] = '0';
+		buf[n++] = '.';
+		for (i = -1; i > e; i--)
+			buf[n++] = '0';
+		for (i = 0; i <= last; i++)
+			buf[n++] = digits[i];
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Format a value for "%g" output using the current float format: either
+ * gFloat_digits significant digits, or the fewest digits that read back
+ * as the same double.
+ */
+#ifdef ANSI_FN_DEF
+int lib_format_double (char *buf, double value)
+#else
+int lib_format_double(buf, value)
+char *buf;
+double value;
+#endif
+{
+    int prec, n;
+
+    if (gFloat_format != FLOAT_FORMAT_SHORTEST)
+		return lib_format_number(buf, value, gFloat_digits, FALSE);
+
+    n = 0;
+    for (prec = 1; prec <= 17; prec++) {
+		n = lib_format_number(buf, value, prec, FALSE);
+		if (strtod(buf, NULL) == value)
+			break;
+    }
+    return n;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * fprintf to the current output file.  Plain %g, %#g, %d, %ld, %lu, %s,
+ * %c and %% are formatted here, and TRI_COUNT_FMT; anything with a width,
+ * precision or other flags goes through sprintf one conversion at a time.
+ */
+void lib_printf (char *fmt, ...)
+{
+    va_list ap;
+    char line[LINE_SIZE], spec[20], *s;
+    int n, ns, flags, alt, is_long, is_wide;
+
+    va_start(ap, fmt);
+    n = 0;
+    while (*fmt) {
+		if (n > LINE_SIZE - NUMBER_BUFFER_SIZE) {
+			fwrite(line, 1, n, gOutfile);
+			n = 0;
+		}
+		if (*fmt != '%') {
+			line[n++] = *fmt++;
+			continue;
+		}
+
+		/* Pick up the conversion spec */
+		ns = 0;
+		spec[ns++] = *fmt++;
+		flags = alt = 0;
+		while ((ns < 12) && (strchr("-+ #0123456789.", *fmt) != NULL)) {
+			if (*fmt == '#')
+				alt = 1;
+			else
+				flags = 1;
+			spec[ns++] = *fmt++;
+		}
+		is_long = (*fmt == 'l');
+		if (is_long)
+			spec[ns++] = *fmt++;
+		/* Microsoft's 64 bit size, for a TRI_COUNT on 64 bit Windows */
+		is_wide = (strncmp(fmt, "I64", 3) == 0);
+		if (is_wide) {
+			memcpy(&spec[ns], fmt, 3);
+			ns += 3;
+			fmt += 3;
+		}
+		spec[ns++] = *fmt;
+		spec[ns] = '\0';
+		if (*fmt == '\0')
+			break;
+
+		switch (*fmt++) {
+		case 'g':
+			if (flags)
+				n += sprintf_s(&line[n], NUMBER_BUFFER_SIZE, spec,
+					va_arg(ap, double));
+			else if (alt)
+				/* "%#g" keeps its six digits whatever the float format */
+				n += lib_format_number(&line[n], va_arg(ap, double), 6, TRUE);
+			else
+				n += lib_format_double(&line[n], va_arg(ap, double));
+			break;
+
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'G':
+			n += sprintf_s(&line[n], NUMBER_BUFFER_SIZE, spec,
+				va_arg(ap, double));
+			break;
+
+		case 'd':
+		case 'i':
+			if (flags)
+				n += is_long ?
+					sprintf_s(&line[n], NUMBER_BUFFER_SIZE, spec,
+						va_arg(ap, long)) :
+					sprintf_s(&line[n], NUMBER_BUFFER_SIZE, spec,
+						va_arg(ap, int));
+			else
+				n += format_long(&line[n],
+					is_long ? va_arg(ap, long) : (long)va_arg(ap, int));
+			break;
+
+		case 'u':
+			if (!flags && (is_long || is_wide)) {
+				n += format_ulong(&line[n], is_wide ? va_arg(ap, TRI_COUNT) :
+					(TRI_COUNT)va_arg(ap, unsigned long));
+				break;
+			}
+			/* FALLTHROUGH */
+		case 'x':
+		case 'X':
+		case 'o':
+			if (is_wide)
+				n += sprintf_s(&line[n], NUMBER_BUFFER_SIZE, spec,
+					va_arg(ap, TRI_COUNT));
+			else
+				n += is_long ?
+					sprintf_s(&line[n], NUMBER_BUFFER_SIZE, spec,
+						va_arg(ap, unsigned long)) :
+					sprintf_s(&line[n], NUMBER_BUFFER_SIZE, spec,
+						va_arg(ap, unsigned int));
+			break;
+
+		case 'c':
+			line[n++] = (char)va_arg(ap, int);
+			break;
+
+		case 's':
+			s = va_arg(ap, char *);
+			if (flags || (strlen(s) >= NUMBER_BUFFER_SIZE)) {
+				/* Long or padded strings go straight to the file */
+				fwrite(line, 1, n, gOutfile);
+				n = 0;
+				fprintf(gOutfile, spec, s);
+			} else {
+				while (*s)
+					line[n++] = *s++;
+			}
+			break;
+
+		case '%':
+			line[n++] = '%';
+			break;
+
+		default:
+			/* Unknown conversion, write it out as is */
+			for (s = spec; *s; s++)
+				line[n++] = *s;
+			break;
+		}
+    }
+    if (n > 0)
+		fwrite(line, 1, n, gOutfile);
+    va_end(ap);
+}
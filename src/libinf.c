@@ -22,44 +22,8 @@
 /* defines/constants section */
 /*-----------------------------------------------------------------*/
 
-#ifdef OUTPUT_TO_FILE
-FILE * gStdout_file = NULL;
-#endif /* OUTPUT_TO_FILE */
-
-
-/*-----------------------------------------------------------------*/
-/* Here are some local variables that are used to control things like
-   the current output file, current texture, ... */
-FILE *gOutfile;
-char *gTexture_name = NULL;
-int  gTexture_count = 0;
-int  gObject_count = 0;
-double gTexture_ior = 1.0;
-int  gRT_out_format        = OUTPUT_NFF;
-int  gRT_orig_format   = OUTPUT_NFF;
-int  gU_resolution  = OUTPUT_RESOLUTION;
-int  gV_resolution  = OUTPUT_RESOLUTION;
-COORD3 gBkgnd_color = {0.0, 0.0, 0.0};
-COORD3 gFgnd_color = {0.0, 0.0, 0.0};
-double gView_bounds[2][3];
-int gView_init_flag = 0;
 char *gLib_version_str = LIB_VERSION;
 
-surface_ptr gLib_surfaces = NULL;
-object_ptr gLib_objects = NULL;
-light_ptr gLib_lights = NULL;
-viewpoint gViewpoint = {
-	{0, 0, -10},
-    {0, 0, 0},
-    {0, 1, 0},
-     45, 1, 1.0e-3, 10, 128, 128,
-    { {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1} }
-};
-
-/* Globals for tracking indentation level of output file */
-int      gTab_width = 4;
-int      gTab_level = 0;
-
 
 
 /*-----------------------------------------------------------------*/
@@ -141,6 +105,7 @@ int default_tracer;
 		exit(1);
     }
     gRT_out_format = default_tracer;
+    gEmitter = lib_get_emitter(default_tracer);
 }
 
 /*-----------------------------------------------------------------*/
@@ -13,6 +13,10 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#if defined(_WIN32)
+#include <io.h>		/* _setmode */
+#include <fcntl.h>
+#endif
 
 #include "lib.h"
 #include "drv.h"
@@ -22,10 +26,29 @@
 /* defines/constants section */
 /*-----------------------------------------------------------------*/
 
-/* output file name */
-char gOutfileName[MAX_OUTFILE_NAME_SIZE];
+/*
+ * The settings a context starts out with, see lib.h.  Everything not
+ * given here starts out 0.
+ */
+#define CONTEXT_DEFAULTS { \
+    OUTPUT_NFF, OUTPUT_NFF, OUTPUT_RESOLUTION, OUTPUT_RESOLUTION, 1.0, \
+    { {0, 0, -10}, {0, 0, 0}, {0, 1, 0}, 45, 1, 1.0e-3, 10, 128, 128, \
+      { {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1} } }, \
+    4, &gEmitter_table[OUTPUT_RT_DEFAULT], FLOAT_FORMAT_FIXED, 6, 1, "SPD", \
+    { {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1} }, \
+    { {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1} } }
+
+/* The context used by programs that never make one of their own */
+static struct context_struct Default_context = CONTEXT_DEFAULTS;
+
+/* Copied into each context made by lib_context_create */
+static struct context_struct New_context = CONTEXT_DEFAULTS;
+
+CONTEXT_LOCAL context_ptr gContext = &Default_context;
+
+/* Name given to lib_open, for the files holding levels of detail */
+#define gLod_name      (gContext->lod_name)
 
-#ifdef OUTPUT_TO_FILE
 /* Global output filename suffix list, for each raytracer type */
 static char	*gFnameSuffix[OUTPUT_DELAYED+1] =
 {
@@ -46,15 +69,175 @@ static char	*gFnameSuffix[OUTPUT_DELAYED+1] =
 ".dxf", /* OUTPUT_DXF        Autodesk DXF format                         */
 ".obj", /* OUTPUT_OBJ        Wavefront OBJ format                        */
 ".rwx", /* OUTPUT_RWX        RenderWare RWX script file                  */
-".3dm", /* 3D Metafile (Apple Quickdraw 3D text format)                  */
-".wrl", /* Virtual Reality Modeling Language 2.0                         */
+".3dm", /* OUTPUT_3DMF       3D Metafile (Apple Quickdraw 3D text format) */
+".wrl", /* OUTPUT_VRML1      Virtual Reality Modeling Language 1.0       */
+".wrl", /* OUTPUT_VRML2      Virtual Reality Modeling Language 2.0       */
+".bnf", /* OUTPUT_BNFF       Binary NFF                                  */
 ".out", /* OUTPUT_DELAYED    Needed for RTRACE/PLG output.               */
 };
-#endif
+
+/*-----------------------------------------------------------------*/
+/* Scene header/trailer writers for the output emitter tables in libemt.c */
+/*-----------------------------------------------------------------*/
+void emit_begin_rwx PARAMS((void))
+{
+    fprintf(gOutfile, "ModelBegin\n");
+    fprintf(gOutfile, "ClumpBegin\n");
+    fprintf(gOutfile, "LightSampling Vertex\n");
+}
+
+/*-----------------------------------------------------------------*/
+void emit_begin_3dmf PARAMS((void))
+{
+    fprintf(gOutfile, "3DMetafile ( 1 0 Normal toc> )\n");
+}
+
+/*-----------------------------------------------------------------*/
+void emit_begin_vrml1 PARAMS((void))
+{
+    fprintf(gOutfile, "#VRML V1.0 ascii\n");
+    fprintf(gOutfile, "Separator {\n");
+    tab_inc();
+    tab_indent();
+    fprintf(gOutfile, "ShapeHints {\n");
+    tab_inc();
+    tab_indent();
+    fprintf(gOutfile, "vertexOrdering COUNTERCLOCKWISE \n");
+    tab_indent();
+    fprintf(gOutfile, "shapeType UNKNOWN_SHAPE_TYPE \n");
+    tab_indent();
+    fprintf(gOutfile, "faceType UNKNOWN_FACE_TYPE \n");
+    tab_indent();
+    fprintf(gOutfile, "creaseAngle 0 \n");
+    tab_dec();
+    tab_indent();
+    fprintf(gOutfile, "}\n");
+}
+
+/*-----------------------------------------------------------------*/
+void emit_begin_vrml2 PARAMS((void))
+{
+    fprintf(gOutfile, "#VRML V2.0 utf8\n");
+}
+
+/*-----------------------------------------------------------------*/
+void emit_end_rib PARAMS((void))
+{
+    fprintf(gOutfile, "WorldEnd\n");
+    fprintf(gOutfile, "FrameEnd\n");
+}
+
+/*-----------------------------------------------------------------*/
+void emit_end_dxf PARAMS((void))
+{
+    fprintf(gOutfile, "  0\n");
+    fprintf(gOutfile, "ENDSEC\n");
+    fprintf(gOutfile, "  0\n");
+    fprintf(gOutfile, "EOF\n");
+}
+
+/*-----------------------------------------------------------------*/
+void emit_end_rwx PARAMS((void))
+{
+    fprintf(gOutfile, "ClumpEnd\n");
+    fprintf(gOutfile, "ModelEnd\n");
+}
+
+/*-----------------------------------------------------------------*/
+void emit_end_3dmf PARAMS((void))
+{
+    surface_ptr temp_ptr;
+	
+    /* Build the table of contents based on any texture names
+       we printed */
+    fprintf(gOutfile, "toc: TableOfContents (\n");
+    tab_inc();
+    tab_indent();
+    fprintf(gOutfile, "toc1>\n");
+    tab_indent();
+    fprintf(gOutfile, "%d -1 0 12 %d\n",
+		gTexture_count+2, gTexture_count);
+    /* Step through the textures, printing table of contents entries */
+    for (temp_ptr=gLib_surfaces;
+	 temp_ptr!= NULL;
+	 temp_ptr = temp_ptr->next) {
+		tab_indent();
+		fprintf(gOutfile, "%d %s>\n",
+			temp_ptr->surf_index, temp_ptr->surf_name);
+    }
+    tab_dec();
+    fprintf(gOutfile, ")\n");
+}
+
+/*-----------------------------------------------------------------*/
+void emit_end_vrml1 PARAMS((void))
+{
+    tab_dec();
+    tab_indent();
+    fprintf(gOutfile, "}\n");
+}
 
 /*-----------------------------------------------------------------*/
 /* Library initialization/teardown functions */
 /*-----------------------------------------------------------------*/
+/*-----------------------------------------------------------------*/
+/*
+ * TRUE if each level of detail goes in a file of its own.  The objects
+ * are saved up and written out once for each level by lib_close.
+ */
+#ifdef ANSI_FN_DEF
+static int lod_files(int format)
+#else
+static int lod_files(format)
+int format;
+#endif
+{
+    return (gLod_levels > 1) && (format != OUTPUT_VIDEO) &&
+		!lib_lod_inline(format);
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Write the saved objects once for each level of detail: the finest to
+ * the output file, the others to files named for the level, such as
+ * "Balls_lod1.nff".
+ */
+static void flush_lod_files PARAMS((void))
+{
+    FILE *outfile, *lod_file;
+    char fname[MAX_OUTFILE_NAME_SIZE + 16];
+
+    outfile = gOutfile;
+    for (gLod_level = 0; gLod_level < gLod_levels; gLod_level++) {
+		if (gLod_level > 0) {
+			sprintf(fname, "%.*s_lod%d%s", MAX_OUTFILE_NAME_SIZE, gLod_name,
+				gLod_level, gFnameSuffix[gRT_out_format]);
+			lod_file = fopen(fname,
+				(gRT_out_format == OUTPUT_BNFF) ? "wb" : "w");
+			if (lod_file == NULL) {
+				fprintf(stderr, "Can't open level of detail file %s\n",
+					fname);
+				exit(1);
+			}
+			setvbuf(lod_file, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+			lib_set_output_file(lod_file);
+			gVertex_count = 0;
+			gNormal_count = 0;
+		}
+		if (gEmitter->begin_scene != NULL)
+			(*gEmitter->begin_scene)();
+		lib_flush_definitions();
+		lib_tri_store_free();
+		if (gLod_level > 0) {
+			if (gEmitter->end_scene != NULL)
+				(*gEmitter->end_scene)();
+			fclose(gOutfile);
+		}
+    }
+    gLod_level = 0;
+    lib_set_output_file(outfile);
+}
+
 #ifdef ANSI_FN_DEF
 int lib_open(int raytracer_format, char *filename)
 #else
@@ -64,6 +247,8 @@ char    *filename ;     /* unused except for Mac version */
 #endif
 {
 	gOutfileName[0]=0;
+    if (filename != NULL)
+		gLod_name = filename;
 #ifdef OUTPUT_TO_FILE
     /* no stdout, so write to a file! */
     if (raytracer_format == OUTPUT_VIDEO) {
@@ -73,54 +258,34 @@ char    *filename ;     /* unused except for Mac version */
 		strcpy(gOutfileName, filename);
 		strcat(gOutfileName, gFnameSuffix[raytracer_format]);
 		/* open the file */
-		gStdout_file = fopen(gOutfileName, "w");
+		gStdout_file = fopen(gOutfileName,
+			(raytracer_format == OUTPUT_BNFF) ? "wb" : "w");
 		if ( gStdout_file == NULL ) return 1 ;
     }
+    lib_set_output_file(gStdout_file);
+#else
+    /* Write to stdout, unless a file was picked with lib_set_output_file */
+    if (gOutfile == NULL)
+		lib_set_output_file(stdout);
 #endif /* OUTPUT_TO_FILE */
+#if defined(_WIN32) && !defined(OUTPUT_TO_FILE)
+    /* BNFF is binary, so stdout must not translate newlines */
+    if ((raytracer_format == OUTPUT_BNFF) && (gOutfile == stdout))
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
 	
-    lib_set_output_file(gStdout_file);
+    lib_buffer_output(gOutfile);
 	
     gRT_orig_format = raytracer_format;
     if ((raytracer_format == OUTPUT_RTRACE) ||
-		(raytracer_format == OUTPUT_PLG))
+		(raytracer_format == OUTPUT_PLG) || lod_files(raytracer_format))
 		lib_set_raytracer(OUTPUT_DELAYED);
-    else if (raytracer_format == OUTPUT_RWX) {
-		fprintf(gOutfile, "ModelBegin\n");
-		fprintf(gOutfile, "ClumpBegin\n");
-		fprintf(gOutfile, "LightSampling Vertex\n");
-		lib_set_raytracer(raytracer_format);
-	}
-    else if (raytracer_format == OUTPUT_3DMF) {
-		fprintf(gOutfile, "3DMetafile ( 1 0 Normal toc> )\n");
-		lib_set_raytracer(raytracer_format);
-	}
-	else if (raytracer_format == OUTPUT_VRML1) {
-        fprintf(gOutfile, "#VRML V1.0 ascii\n");
-        fprintf(gOutfile, "Separator {\n");
-        tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "ShapeHints {\n");
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "vertexOrdering COUNTERCLOCKWISE \n");
-		tab_indent();
-		fprintf(gOutfile, "shapeType UNKNOWN_SHAPE_TYPE \n");
-		tab_indent();
-		fprintf(gOutfile, "faceType UNKNOWN_FACE_TYPE \n");
-		tab_indent();
-		fprintf(gOutfile, "creaseAngle 0 \n");
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-        lib_set_raytracer(raytracer_format);
-	}
-	else if (raytracer_format == OUTPUT_VRML2) {
-		fprintf(gOutfile, "#VRML V2.0 utf8\n");
-		lib_set_raytracer(raytracer_format);
-	}
     else
 		lib_set_raytracer(raytracer_format);
 	
+    if (gEmitter->begin_scene != NULL)
+		(*gEmitter->begin_scene)();
+	
     return 0;
 }
 
@@ -131,55 +296,21 @@ void lib_close(void)
 void lib_close PARAMS((void))
 #endif
 {
+    /* Splice in the output of any tasks still running */
+    lib_task_wait();
+
     /* Make sure everything is cleaned up */
-    if ((gRT_orig_format == OUTPUT_RTRACE) ||
+    if (lod_files(gRT_orig_format)) {
+		lib_set_raytracer(gRT_orig_format);
+		flush_lod_files();
+    } else if ((gRT_orig_format == OUTPUT_RTRACE) ||
 		(gRT_orig_format == OUTPUT_PLG)) {
 		lib_set_raytracer(gRT_orig_format);
 		lib_flush_definitions();
     }
 	
-    if (gRT_out_format == OUTPUT_RIB) {
-		fprintf(gOutfile, "WorldEnd\n");
-		fprintf(gOutfile, "FrameEnd\n");
-    }
-    else if (gRT_out_format == OUTPUT_DXF) {
-		fprintf(gOutfile, "  0\n");
-		fprintf(gOutfile, "ENDSEC\n");
-		fprintf(gOutfile, "  0\n");
-		fprintf(gOutfile, "EOF\n");
-    }
-    else if (gRT_out_format == OUTPUT_RWX) {
-		fprintf(gOutfile, "ClumpEnd\n");
-		fprintf(gOutfile, "ModelEnd\n");
-    }
-    else if (gRT_out_format == OUTPUT_3DMF) {
-	/* Build the table of contents based on any texture names
-		we printed */
-		surface_ptr temp_ptr;
-		
-		fprintf(gOutfile, "toc: TableOfContents (\n");
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "toc1>\n");
-		tab_indent();
-		fprintf(gOutfile, "%d -1 0 12 %d\n",
-			gTexture_count+2, gTexture_count);
-		/* Step through the textures, printing table of contents entries */
-		for (temp_ptr=gLib_surfaces;
-		temp_ptr!= NULL;
-		temp_ptr = temp_ptr->next) {
-			tab_indent();
-			fprintf(gOutfile, "%d %s>\n",
-				temp_ptr->surf_index, temp_ptr->surf_name);
-		}
-		tab_dec();
-		fprintf(gOutfile, ")\n");
-	}
-	else if (gRT_out_format == OUTPUT_VRML1) {
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-	}
+    if (gEmitter->end_scene != NULL)
+		(*gEmitter->end_scene)();
 	
 #ifdef OUTPUT_TO_FILE
     /* no stdout, so close our output! */
@@ -188,35 +319,233 @@ void lib_close PARAMS((void))
 #endif /* OUTPUT_TO_FILE */
     if (gRT_out_format == OUTPUT_VIDEO)
 		display_close(1);
+
+    if (gShow_stats) {
+		fprintf(stderr, "%lu polygons split into %lu triangles\n",
+			gSplit_polygons, gSplit_triangles);
+		fprintf(stderr, "%lu heap allocations made splitting polygons\n",
+			gSplit_allocs);
+		if ((gAdaptive_error > 0.0) || (gPatch_tolerance > 0.0)) {
+			fprintf(stderr, "%lu curved surface triangles made adaptively, ",
+				gAdaptive_triangles);
+			fprintf(stderr, "%lu at fixed resolution ", gAdaptive_fixed);
+			/* a fine tolerance can need more than the fixed grid */
+			if (gAdaptive_fixed >= gAdaptive_triangles)
+				fprintf(stderr, "(%lu saved)\n",
+					gAdaptive_fixed - gAdaptive_triangles);
+			else
+				fprintf(stderr, "(%lu more)\n",
+					gAdaptive_triangles - gAdaptive_fixed);
+		}
+    }
 }
 
 
 /*-----------------------------------------------------------------*/
-void lib_storage_initialize PARAMS((void))
+/* Give back the polygon splitter's and tessellator's scratch storage */
+void
+lib_storage_shutdown PARAMS((void))
 {
-    gPoly_vbuffer = (unsigned int*)malloc(VBUFFER_SIZE * sizeof(unsigned int));
-    gPoly_end = (int*)malloc(POLYEND_SIZE * sizeof(int));
-    if (!gPoly_vbuffer || !gPoly_end) {
-		fprintf(stderr,
-			"Error(lib_storage_initialize): Can't allocate memory.\n");
-		exit(1);
-    }
-} /* lib_storage_initialize */
+    lib_polygon_storage_free();
+    lib_triangulate_free();
+} /* lib_storage_shutdown */
 
 
 /*-----------------------------------------------------------------*/
-void
-lib_storage_shutdown PARAMS((void))
+/*
+ * Deferred object storage.  Objects saved for OUTPUT_DELAYED, and their
+ * vertex lists and matrices, are carved out of large chunks rather than
+ * malloc'ed one at a time.  Nothing is freed on its own; lib_arena_reset
+ * empties the whole store at once and keeps the chunks for reuse.
+ */
+typedef union {			/* most strictly aligned types */
+    double d;
+    long l;
+    void *p;
+} arena_align;
+
+#define ARENA_ALIGN(n)	((((n) + sizeof(arena_align) - 1) / \
+			  sizeof(arena_align)) * sizeof(arena_align))
+
+typedef struct arena_chunk {
+    struct arena_chunk *next;
+    unsigned long size;		/* bytes of storage after the header */
+    unsigned long used;		/* bytes handed out */
+} arena_chunk;
+
+#define gArena_first   (gContext->arena_first)	/* all chunks */
+#define gArena_current (gContext->arena_current)	/* chunk being filled */
+
+/*-----------------------------------------------------------------*/
+/* Get storage for a deferred object.  Returns NULL if out of memory. */
+#ifdef ANSI_FN_DEF
+void *lib_arena_alloc(unsigned long size)
+#else
+void *lib_arena_alloc(size)
+unsigned long size;
+#endif
 {
-    if (gPoly_vbuffer) {
-		free(gPoly_vbuffer);
-		gPoly_vbuffer = NULL;
+    arena_chunk *chunk;
+    unsigned long chunk_size;
+	
+    size = ARENA_ALIGN(size);
+	
+    /* Move on to chunks left over from before the last reset */
+    while ((gArena_current != NULL) &&
+		(gArena_current->used + size > gArena_current->size) &&
+		(gArena_current->next != NULL)) {
+		gArena_current = gArena_current->next;
+		gArena_current->used = 0;
     }
-    if (gPoly_end) {
-		free(gPoly_end);
-		gPoly_end = NULL;
+	
+    if ((gArena_current == NULL) ||
+		(gArena_current->used + size > gArena_current->size)) {
+		chunk_size = (size > ARENA_CHUNK_SIZE) ? size : ARENA_CHUNK_SIZE;
+		chunk = (arena_chunk *)malloc(ARENA_ALIGN(sizeof(arena_chunk)) +
+			chunk_size);
+		if (chunk == NULL)
+			return NULL;
+		chunk->size = chunk_size;
+		chunk->used = 0;
+		chunk->next = NULL;
+		if (gArena_current == NULL)
+			gArena_first = chunk;
+		else
+			gArena_current->next = chunk;
+		gArena_current = chunk;
     }
-} /* lib_storage_shutdown */
+	
+    gArena_current->used += size;
+    return (char *)gArena_current + ARENA_ALIGN(sizeof(arena_chunk)) +
+		gArena_current->used - size;
+} /* lib_arena_alloc */
+
+/*-----------------------------------------------------------------*/
+/* Throw away all deferred objects at once */
+void
+lib_arena_reset PARAMS((void))
+{
+    gArena_current = gArena_first;
+    if (gArena_current != NULL)
+		gArena_current->used = 0;
+} /* lib_arena_reset */
+
+
+/*-----------------------------------------------------------------*/
+/*
+ * Make a new context, with the same settings a program starts out with.
+ * Returns NULL if out of memory.
+ */
+context_ptr
+lib_context_create PARAMS((void))
+{
+    context_ptr context;
+
+    context = (context_ptr)malloc(sizeof(struct context_struct));
+    if (context != NULL)
+		*context = New_context;
+    return context;
+} /* lib_context_create */
+
+/*-----------------------------------------------------------------*/
+/*
+ * Make a context that carries on from the current one: the same output
+ * format and settings, surface and transform, but with no output file,
+ * nothing saved and scratch storage of its own.  Its statistics start at
+ * 0.  Tasks it spawns are run at once.  Returns NULL if out of memory.
+ */
+context_ptr
+lib_context_fork PARAMS((void))
+{
+    context_ptr context;
+
+    context = (context_ptr)malloc(sizeof(struct context_struct));
+    if (context == NULL)
+		return NULL;
+    *context = *gContext;
+
+    context->tx_stack = NULL;
+    context->stdout_file = NULL;
+    context->outfile = NULL;
+    context->out_buffer = NULL;
+    context->lib_surfaces = NULL;
+    context->lib_lights = NULL;
+    context->lib_objects = NULL;
+    context->arena_first = context->arena_current = NULL;
+    memset(&context->tris, 0, sizeof(tri_store));
+    context->templates = NULL;
+    context->split_tri = NULL;
+    context->split_vert = context->split_norm = NULL;
+    context->split_vptr = context->split_nptr = NULL;
+    context->split_size = 0;
+    context->split_polygons = context->split_triangles = 0;
+    context->split_allocs = 0;
+    context->adaptive_triangles = context->adaptive_fixed = 0;
+    context->video_vert = NULL;
+    context->video_size = 0;
+    context->tess_vert = context->tess_norm = NULL;
+    context->tess_size = 0;
+    context->tri_scratch = NULL;
+    context->weld_verts = context->weld_norms = NULL;
+    context->task_threads = 0;
+    context->task_group = NULL;
+    return context;
+} /* lib_context_fork */
+
+/*-----------------------------------------------------------------*/
+/*
+ * Make "context" the current one, or the default context if NULL.
+ * Returns the context that was current.
+ */
+#ifdef ANSI_FN_DEF
+context_ptr lib_context_select (context_ptr context)
+#else
+context_ptr lib_context_select(context)
+context_ptr context;
+#endif
+{
+    context_ptr previous;
+
+    previous = gContext;
+    gContext = (context != NULL) ? context : &Default_context;
+    return previous;
+} /* lib_context_select */
+
+/*-----------------------------------------------------------------*/
+/*
+ * Free a context made by lib_context_create, and everything kept in it.
+ * Call lib_close first, and close any file given to lib_set_output_file,
+ * since the file's stdio buffer belongs to the context.  Freeing the
+ * current context makes the default context current.
+ */
+#ifdef ANSI_FN_DEF
+void lib_context_free (context_ptr context)
+#else
+void lib_context_free(context)
+context_ptr context;
+#endif
+{
+    context_ptr previous;
+    struct arena_chunk *chunk;
+
+    if ((context == NULL) || (context == &Default_context))
+		return;
+    previous = lib_context_select(context);
+
+    lib_clear_database();
+    while (gArena_first != NULL) {
+		chunk = gArena_first;
+		gArena_first = chunk->next;
+		free(chunk);
+    }
+    while (context->tx_stack != NULL)
+		lib_tx_pop();
+    if (context->out_buffer != NULL)
+		free(context->out_buffer);
+
+    lib_context_select((previous != context) ? previous : NULL);
+    free(context);
+} /* lib_context_free */
 
 
 /*-----------------------------------------------------------------*/
@@ -227,7 +556,7 @@ void show_gen_usage PARAMS((void))
     /* and don't write to stdout on Macs, which don't have console I/O, and  */
     /* won't ever get this error anyway, since parms are auto-generated.     */
 #else
-    fprintf(stderr, "usage [-s size] [-r format] [-c|t [#]]\n");
+    fprintf(stderr, "usage [-s size] [-r format] [-c|t [#]] [-w [#]] [-p [#]] [-l #] [-j #] [-i] [-v]\n");
     fprintf(stderr, "-s size - input size of database\n");
     fprintf(stderr, "-r format - input database format to output:\n");
     fprintf(stderr, "   0   Output direct to the screen (sys dependent)\n");
@@ -250,8 +579,16 @@ void show_gen_usage PARAMS((void))
     fprintf(stderr, "   17  3D Metafile (Apple Quickdraw 3D text format)\n");
     fprintf(stderr, "   18  VRML 1.0 (Virtual Reality Modeling Language)\n");
     fprintf(stderr, "   19  VRML 2.0 (Virtual Reality Modeling Language)\n");
+    fprintf(stderr, "   20  Binary NFF\n");
     fprintf(stderr, "-c - output true curved descriptions\n");
     fprintf(stderr, "-t [#] - output tessellated triangle descriptions [and resolution]\n");
+    fprintf(stderr, "         a # with a decimal point is a patch chord tolerance\n");
+    fprintf(stderr, "-w [#] - weld shared vertices in OBJ and PLG output [grid spacing]\n");
+    fprintf(stderr, "-p [#] - adapt tessellation to the view [pixel error]\n");
+    fprintf(stderr, "-l # - output # levels of detail of tessellated objects\n");
+    fprintf(stderr, "-j # - generate on # threads, where supported\n");
+    fprintf(stderr, "-i - output repeated parts once, as instances, where supported\n");
+    fprintf(stderr, "-v - print statistics when done\n");
 	
 #endif
 } /* show_gen_usage */
@@ -263,7 +600,7 @@ void show_read_usage PARAMS((void))
     /* and don't write to stdout on Macs, which don't have console I/O, and  */
     /* won't ever get this error anyway, since parms are auto-generated.     */
 #else
-    fprintf(stderr, "usage [-f filename] [-r format] [-c|t [#]]\n");
+    fprintf(stderr, "usage [-f filename] [-r format] [-c|t [#]] [-w [#]] [-p [#]] [-l #] [-v]\n");
     fprintf(stderr, "-f filename - file to import/convert/display\n");
     fprintf(stderr, "-r format - format to output:\n");
     fprintf(stderr, "   0   Output direct to the screen (sys dependent)\n");
@@ -286,8 +623,13 @@ void show_read_usage PARAMS((void))
     fprintf(stderr, "   17  3D Metafile (Apple Quickdraw 3D text format)\n");
     fprintf(stderr, "   18  VRML 1.0 (Virtual Reality Modeling Language)\n");
     fprintf(stderr, "   19  VRML 2.0 (Virtual Reality Modeling Language)\n");
+    fprintf(stderr, "   20  Binary NFF\n");
     fprintf(stderr, "-c - output true curved descriptions\n");
     fprintf(stderr, "-t [#] - output tessellated triangle descriptions [and resolution]\n");
+    fprintf(stderr, "-w [#] - weld shared vertices in OBJ and PLG output [grid spacing]\n");
+    fprintf(stderr, "-p [#] - adapt tessellation to the view [pixel error]\n");
+    fprintf(stderr, "-l # - output # levels of detail of tessellated objects\n");
+    fprintf(stderr, "-v - print statistics when done\n");
 	
 #endif
 } /* show_read_usage */
@@ -301,6 +643,11 @@ void show_read_usage PARAMS((void))
  * -r format - input database format to output (see lib.h for formats)
  * -c - output true curved descriptions
  * -t [#] - output tessellated triangle descriptions [and resolution]
+ *          (a # with a decimal point is a patch chord tolerance)
+ * -w [#] - weld shared vertices in OBJ and PLG output [grid spacing]
+ * -j # - generate on # threads, where supported
+ * -i - output repeated parts once, as instances, where supported
+ * -v - print statistics when done
  *
  * TRUE returned if bad command line detected
  * some of these are useless for the various routines - we're being a bit
@@ -317,6 +664,7 @@ int     *p_size, *p_rdr, *p_curve ;
 {
 	int num_arg ;
 	int val ;
+	double fval ;
 	
     num_arg = 0 ;
 	
@@ -331,18 +679,103 @@ int     *p_size, *p_rdr, *p_curve ;
 				if ( num_arg < argc-1 ) {
 					if ( argv[num_arg+1][0] != '-' ) {
 						num_arg++ ;
-						sscanf_s( argv[num_arg], "%d", &val ) ;
-						if ( val < 1 ) {
+						if ( strchr( argv[num_arg], '.' ) != NULL ) {
+							/* a decimal point means a chord tolerance */
+							sscanf_s( argv[num_arg], "%lf", &fval ) ;
+							if ( fval <= 0.0 ) {
+								fprintf( stderr,
+									"bad patch tolerance %s given\n",
+									argv[num_arg]);
+								show_gen_usage();
+								return( TRUE ) ;
+							}
+							lib_set_patch_tolerance( fval ) ;
+						} else {
+							sscanf_s( argv[num_arg], "%d", &val ) ;
+							if ( val < 1 ) {
+								fprintf( stderr,
+									"bad resolution value %s given\n",
+									argv[num_arg]);
+								show_gen_usage();
+								return( TRUE ) ;
+							}
+							gU_resolution =
+								gV_resolution = val ;
+						}
+					}
+				} /* else no resolution found */
+				break ;
+			case 'w':       /* welded OBJ/PLG output */
+				lib_set_weld_tolerance( WELD_TOLERANCE ) ;
+				if ( num_arg < argc-1 ) {
+					if ( argv[num_arg+1][0] != '-' ) {
+						num_arg++ ;
+						sscanf_s( argv[num_arg], "%lf", &fval ) ;
+						if ( fval <= 0.0 ) {
 							fprintf( stderr,
-								"bad resolution value %s given\n",
+								"bad weld spacing %s given\n",
 								argv[num_arg]);
 							show_gen_usage();
 							return( TRUE ) ;
 						}
-						gU_resolution =
-							gV_resolution = val ;
+						lib_set_weld_tolerance( fval ) ;
 					}
-				} /* else no resolution found */
+				} /* else use the default spacing */
+				break ;
+			case 'p':       /* adaptive tessellation to a pixel error */
+				lib_set_adaptive_tessellation( ADAPTIVE_ERROR ) ;
+				if ( num_arg < argc-1 ) {
+					if ( argv[num_arg+1][0] != '-' ) {
+						num_arg++ ;
+						sscanf_s( argv[num_arg], "%lf", &fval ) ;
+						if ( fval <= 0.0 ) {
+							fprintf( stderr,
+								"bad pixel error %s given\n",
+								argv[num_arg]);
+							show_gen_usage();
+							return( TRUE ) ;
+						}
+						lib_set_adaptive_tessellation( fval ) ;
+					}
+				} /* else use the default error */
+				break ;
+			case 'l':       /* levels of detail */
+				if ( ++num_arg < argc ) {
+					sscanf_s( argv[num_arg], "%d", &val ) ;
+					if ( val < 1 || val > LOD_MAX_LEVELS ) {
+						fprintf( stderr,
+							"bad level of detail count %d given\n",val);
+						show_gen_usage();
+						return( TRUE ) ;
+					}
+					lib_set_lod_levels( val ) ;
+				} else {
+					fprintf( stderr, "not enough args for -l option\n" ) ;
+					show_gen_usage();
+					return( TRUE ) ;
+				}
+				break ;
+			case 'j':       /* threads to generate on */
+				if ( ++num_arg < argc ) {
+					sscanf_s( argv[num_arg], "%d", &val ) ;
+					if ( val < 1 || val > TASK_MAX_THREADS ) {
+						fprintf( stderr,
+							"bad thread count %d given\n",val);
+						show_gen_usage();
+						return( TRUE ) ;
+					}
+					lib_set_task_threads( val ) ;
+				} else {
+					fprintf( stderr, "not enough args for -j option\n" ) ;
+					show_gen_usage();
+					return( TRUE ) ;
+				}
+				break ;
+			case 'i':       /* instanced output */
+				lib_set_instancing( TRUE ) ;
+				break ;
+			case 'v':       /* statistics */
+				gShow_stats = TRUE ;
 				break ;
 			case 'r':       /* renderer selection */
 				if ( ++num_arg < argc ) {
@@ -401,6 +834,8 @@ int     *p_size, *p_rdr, *p_curve ;
  * -r format - input database format to output (see lib.h for formats)
  * -c - output true curved descriptions
  * -t [#] - output tessellated triangle descriptions [and resolution]
+ * -w [#] - weld shared vertices in OBJ and PLG output [grid spacing]
+ * -v - print statistics when done
  *
  * TRUE returned if bad command line detected
  * some of these are useless for the various routines - we're being a bit
@@ -418,6 +853,7 @@ char *p_infname;
 {
 	int num_arg ;
 	int val ;
+	double fval ;
 	
     num_arg = 0 ;
     *p_rdr = OUTPUT_NFF ;	/* default format if none given */
@@ -450,6 +886,59 @@ char *p_infname;
 					}
 				}
 				break ;
+			case 'w':       /* welded OBJ/PLG output */
+				lib_set_weld_tolerance( WELD_TOLERANCE ) ;
+				if ( num_arg < argc-1 ) {
+					if ( argv[num_arg+1][0] != '-' ) {
+						num_arg++ ;
+						sscanf_s( argv[num_arg], "%lf", &fval ) ;
+						if ( fval <= 0.0 ) {
+							fprintf( stderr,
+								"bad weld spacing %s given\n",
+								argv[num_arg]);
+							show_read_usage();
+							return( TRUE ) ;
+						}
+						lib_set_weld_tolerance( fval ) ;
+					}
+				} /* else use the default spacing */
+				break ;
+			case 'p':       /* adaptive tessellation to a pixel error */
+				lib_set_adaptive_tessellation( ADAPTIVE_ERROR ) ;
+				if ( num_arg < argc-1 ) {
+					if ( argv[num_arg+1][0] != '-' ) {
+						num_arg++ ;
+						sscanf_s( argv[num_arg], "%lf", &fval ) ;
+						if ( fval <= 0.0 ) {
+							fprintf( stderr,
+								"bad pixel error %s given\n",
+								argv[num_arg]);
+							show_read_usage();
+							return( TRUE ) ;
+						}
+						lib_set_adaptive_tessellation( fval ) ;
+					}
+				} /* else use the default error */
+				break ;
+			case 'l':       /* levels of detail */
+				if ( ++num_arg < argc ) {
+					sscanf_s( argv[num_arg], "%d", &val ) ;
+					if ( val < 1 || val > LOD_MAX_LEVELS ) {
+						fprintf( stderr,
+							"bad level of detail count %d given\n",val);
+						show_read_usage();
+						return( TRUE ) ;
+					}
+					lib_set_lod_levels( val ) ;
+				} else {
+					fprintf( stderr, "not enough args for -l option\n" ) ;
+					show_read_usage();
+					return( TRUE ) ;
+				}
+				break ;
+			case 'v':       /* statistics */
+				gShow_stats = TRUE ;
+				break ;
 			case 'r':       /* renderer selection */
 				if ( ++num_arg < argc ) {
 					sscanf_s( argv[num_arg], "%d", &val ) ;
@@ -493,7 +982,6 @@ void
 lib_clear_database PARAMS((void))
 {
     surface_ptr ts1, ts2;
-    object_ptr to1, to2;
     light_ptr tl1, tl2;
 	
     gOutfile = stdout;
@@ -502,6 +990,7 @@ lib_clear_database PARAMS((void))
     gObject_count = 0;
     gTexture_ior = 1.0;
     gRT_out_format = OUTPUT_RT_DEFAULT;
+    gEmitter = lib_get_emitter(OUTPUT_RT_DEFAULT);
     gU_resolution = OUTPUT_RESOLUTION;
     gV_resolution = OUTPUT_RESOLUTION;
     SET_COORD3(gBkgnd_color, 0.0, 0.0, 0.0);
@@ -517,14 +1006,11 @@ lib_clear_database PARAMS((void))
     }
     gLib_surfaces = NULL;
 	
-    /* Remove all objects */
-    to1 = gLib_objects;
-    while (to1 != NULL) {
-		to2 = to1;
-		to1 = to1->next_object;
-		free(to2);
-    }
+    /* Remove all objects, along with everything they point to, and the
+       triangles saved for PLG output */
+    lib_arena_reset();
     gLib_objects = NULL;
+    lib_tri_store_free();
 	
     /* Remove all lights */
     tl1 = gLib_lights;
@@ -538,21 +1024,17 @@ lib_clear_database PARAMS((void))
     /* Reset the view */
 	
     /* Deallocate polygon buffer */
-    if (gPoly_vbuffer != NULL)
-		lib_storage_shutdown();
+    lib_storage_shutdown();
 	
     /* Clear vertex counters for polygons */
     gVertex_count = 0; /* Vertex coordinates */
     gNormal_count = 0; /* Vertex normals */
 	
-    /* Clear out the polygon stack */
-    to1 = gPolygon_stack;
-    while (to1 != NULL) {
-		to2 = to1;
-		to1 = to1->next_object;
-		free(to2);
-    }
-    gPolygon_stack = NULL;
+    /* Empty the welded vertex pools */
+    lib_weld_free(gWeld_verts);
+    gWeld_verts = NULL;
+    lib_weld_free(gWeld_norms);
+    gWeld_norms = NULL;
 }
 
 /*-----------------------------------------------------------------*/
@@ -574,9 +1056,13 @@ lib_flush_definitions PARAMS((void))
 	case OUTPUT_OBJ:
 	case OUTPUT_RWX:
 	case OUTPUT_RAWTRI:
+	case OUTPUT_ART:
+	case OUTPUT_RIB:
+	case OUTPUT_DXF:
 	case OUTPUT_3DMF:
 	case OUTPUT_VRML1:
 	case OUTPUT_VRML2:
+	case OUTPUT_BNFF:
 		lib_output_viewpoint(gViewpoint.from, gViewpoint.at, gViewpoint.up, gViewpoint.angle,
 			gViewpoint.aspect, gViewpoint.hither, gViewpoint.resx, gViewpoint.resy);
 		
@@ -0,0 +1,403 @@
+/*
+ * libins.c - library of object instancing routines.
+ *
+ * Author:  Eric Haines
+ *
+ * A generator that builds its model from copies of the same piece can
+ * output the piece once, as a numbered object definition, and then each
+ * copy as an instance of it placed by the current transform:
+ *
+ *	if (lib_use_instances()) {
+ *	    obj = lib_object_begin();
+ *	    ...output the piece, and instances of earlier objects...
+ *	    lib_object_end();
+ *	    ...lib_tx_push, lib_tx_translate, etc...
+ *	    lib_output_instance(obj);
+ *	    lib_tx_pop();
+ *	}
+ *
+ * A self-similar recursive model defines one object per level, each made
+ * of instances of the level below, so its output grows with the depth
+ * rather than with the number of primitives.  A model that isn't, such as
+ * the sphereflake, can only share the pieces that really repeat.  Inside a
+ * definition the transform starts out as the identity.  Definitions can't
+ * be nested.
+ *
+ * POV-Ray 2.0 and 3.1 get #declare and object, RIB ObjectBegin and
+ * ObjectInstance, VRML 1.0 and 2.0 DEF (hidden in a Switch) and USE, and
+ * Rayshade name and object.  Other formats, levels of detail and formats
+ * saved up for lib_close can't, and the generator outputs every copy.  So
+ * can't adaptive tessellation, which would tessellate each copy to its own
+ * size on screen.
+ */
+
+/*-----------------------------------------------------------------*/
+/* include section */
+/*-----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "lib.h"
+
+
+/*-----------------------------------------------------------------*/
+/* defines/constants section */
+/*-----------------------------------------------------------------*/
+
+#define Instancing     (gContext->instancing)
+#define ObjectDefs     (gContext->object_defs)
+#define ObjectOpen     (gContext->object_open)
+
+
+/*-----------------------------------------------------------------*/
+/*
+ * Ask for repeated parts of the model to be output once and instanced,
+ * where the format can.  See lib_use_instances.
+ */
+#ifdef ANSI_FN_DEF
+void lib_set_instancing (int flag)
+#else
+void lib_set_instancing(flag)
+int flag;
+#endif
+{
+    Instancing = flag;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * TRUE if instancing was asked for and the current output format can do
+ * it.  Call after lib_open and lib_gen_get_opts.
+ */
+int lib_use_instances PARAMS((void))
+{
+    return Instancing && (gEmitter->instance != NULL) && (gLod_levels <= 1) &&
+		(gAdaptive_error <= 0.0);
+}
+
+/*-----------------------------------------------------------------*/
+/* Start the definition of an object, returning its number (from 1) */
+long lib_object_begin PARAMS((void))
+{
+    if (ObjectOpen) {
+		fprintf(stderr, "Object definitions can't be nested\n");
+		exit(1);
+    }
+    ObjectOpen = ++ObjectDefs;
+
+    /* The object is in its own coordinates */
+    lib_tx_push();
+    lib_set_current_tx(IdentityTx);
+
+    if (gEmitter->object_begin != NULL)
+		(*gEmitter->object_begin)(ObjectOpen);
+    return ObjectOpen;
+}
+
+/*-----------------------------------------------------------------*/
+/* Finish the object definition started by lib_object_begin */
+void lib_object_end PARAMS((void))
+{
+    if (!ObjectOpen) {
+		fprintf(stderr, "No object definition to end\n");
+		exit(1);
+    }
+    if (gEmitter->object_end != NULL)
+		(*gEmitter->object_end)(ObjectOpen);
+    ObjectOpen = 0;
+    lib_tx_pop();
+}
+
+/*-----------------------------------------------------------------*/
+/* Output a copy of a defined object, placed by the current transform */
+#ifdef ANSI_FN_DEF
+void lib_output_instance (long object)
+#else
+void lib_output_instance(object)
+long object;
+#endif
+{
+    if ((object < 1) || (object > ObjectDefs) || (object == ObjectOpen)) {
+		fprintf(stderr, "Instance of undefined object %ld\n", object);
+		exit(1);
+    }
+    PLATFORM_MULTITASK();
+    if (gEmitter->instance != NULL)
+		(*gEmitter->instance)(object);
+}
+
+
+/*-----------------------------------------------------------------*/
+/*
+ * Object writers for the output emitter tables in libemt.c.  Objects are
+ * named "Object_1" and so on, or numbered for RIB.
+ */
+#ifdef ANSI_FN_DEF
+void emit_object_begin_pov(long object)
+#else
+void emit_object_begin_pov(object)
+long object;
+#endif
+{
+    tab_indent();
+    lib_printf("#declare Object_%ld = union {\n", object);
+    tab_inc();
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_object_end_pov(long object)
+#else
+void emit_object_end_pov(object)
+long object;
+#endif
+{
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+    lib_printf("\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_instance_pov(long object)
+#else
+void emit_instance_pov(object)
+long object;
+#endif
+{
+    tab_indent();
+    lib_printf("object { Object_%ld ", object);
+    if (lib_tx_active())
+		lib_output_tx_sequence();
+    lib_printf(" }\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_object_begin_rib(long object)
+#else
+void emit_object_begin_rib(object)
+long object;
+#endif
+{
+    tab_indent();
+    lib_printf("ObjectBegin %ld\n", object);
+    tab_inc();
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_object_end_rib(long object)
+#else
+void emit_object_end_rib(object)
+long object;
+#endif
+{
+    tab_dec();
+    tab_indent();
+    lib_printf("ObjectEnd\n");
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * The transform is written as a matrix: RIB applies the last transform
+ * given first, and instances of instances need the order right.
+ */
+#ifdef ANSI_FN_DEF
+void emit_instance_rib(long object)
+#else
+void emit_instance_rib(object)
+long object;
+#endif
+{
+    MATRIX txmat;
+    int i;
+
+    tab_indent();
+    lib_printf("TransformBegin\n");
+    tab_inc();
+    if (lib_tx_active()) {
+		lib_get_current_tx(txmat);
+		tab_indent();
+		lib_printf("ConcatTransform [");
+		for (i=0;i<4;i++)
+			lib_printf(" %#g %#g %#g %#g",
+				txmat[i][0], txmat[i][1], txmat[i][2], txmat[i][3]);
+		lib_printf(" ]\n");
+    }
+    tab_indent();
+    lib_printf("ObjectInstance %ld\n", object);
+    tab_dec();
+    tab_indent();
+    lib_printf("TransformEnd\n");
+}
+
+/*-----------------------------------------------------------------*/
+/* The definition is in a Switch that shows nothing, so only its USEs
+   are seen */
+#ifdef ANSI_FN_DEF
+void emit_object_begin_vrml1(long object)
+#else
+void emit_object_begin_vrml1(object)
+long object;
+#endif
+{
+    tab_indent();
+    lib_printf("Switch {\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("whichChild -1\n");
+    tab_indent();
+    lib_printf("DEF Object_%ld Separator {\n", object);
+    tab_inc();
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_object_end_vrml1(long object)
+#else
+void emit_object_end_vrml1(object)
+long object;
+#endif
+{
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_instance_vrml1(long object)
+#else
+void emit_instance_vrml1(object)
+long object;
+#endif
+{
+    tab_indent();
+    lib_printf("Separator {\n");
+    tab_inc();
+    if (lib_tx_active()) {
+		tab_indent();
+		lib_printf("Transform {\n");
+		tab_inc();
+		lib_output_tx_sequence();
+		tab_dec();
+		tab_indent();
+		lib_printf("}\n");
+    }
+    tab_indent();
+    lib_printf("USE Object_%ld\n", object);
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_object_begin_vrml2(long object)
+#else
+void emit_object_begin_vrml2(object)
+long object;
+#endif
+{
+    tab_indent();
+    lib_printf("Switch {\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("whichChoice -1\n");
+    tab_indent();
+    lib_printf("choice [\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("DEF Object_%ld Group {\n", object);
+    tab_inc();
+    tab_indent();
+    lib_printf("children [\n");
+    tab_inc();
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_object_end_vrml2(long object)
+#else
+void emit_object_end_vrml2(object)
+long object;
+#endif
+{
+    tab_dec();
+    tab_dec();
+    tab_indent();
+    lib_printf("] }\n");
+    tab_dec();
+    tab_indent();
+    lib_printf("]\n");
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_instance_vrml2(long object)
+#else
+void emit_instance_vrml2(object)
+long object;
+#endif
+{
+    if (lib_tx_active()) {
+		tab_indent();
+		lib_printf("Transform {\n");
+		tab_inc();
+		lib_output_tx_sequence();
+		tab_indent();
+		lib_printf("children [ USE Object_%ld ]\n", object);
+		tab_dec();
+		tab_indent();
+		lib_printf("}\n");
+    } else {
+		tab_indent();
+		lib_printf("USE Object_%ld\n", object);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_object_begin_rayshade(long object)
+#else
+void emit_object_begin_rayshade(object)
+long object;
+#endif
+{
+    lib_printf("name Object_%ld list\n", object);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_object_end_rayshade(long object)
+#else
+void emit_object_end_rayshade(object)
+long object;
+#endif
+{
+    lib_printf("end\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_instance_rayshade(long object)
+#else
+void emit_instance_rayshade(object)
+long object;
+#endif
+{
+    lib_printf("object Object_%ld", object);
+    if (lib_tx_active())
+		lib_output_tx_sequence();
+    lib_printf("\n");
+}
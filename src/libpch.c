@@ -0,0 +1,311 @@
+/*
+ * libpch.c - library of adaptive patch subdivision routines.
+ *
+ * Author:  Eric Haines
+ *
+ * A parametric patch is cut into a coarse grid of cells, two triangles
+ * each, and every triangle is then split where its edges are not flat.
+ * Whether an edge splits depends only on the edge itself: the surface at
+ * its midpoint and quarter points is compared with the straight chord.
+ * Two triangles sharing an edge therefore always agree on how it is
+ * split, so neighbouring sub-patches meet without cracks, and so do
+ * neighbouring patches that share a boundary curve.  A triangle with one,
+ * two or three split edges is cut into two, three or four pieces, which
+ * are tested in turn.
+ */
+
+/*-----------------------------------------------------------------*/
+/* include section */
+/*-----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "lib.h"
+
+
+/*-----------------------------------------------------------------*/
+/* defines/constants section */
+/*-----------------------------------------------------------------*/
+
+/* An edge is not split once it is this many halvings shorter than a
+   starting cell */
+#define PATCH_MAX_DEPTH   8
+
+/* A point on the patch, in parameter space and on the surface */
+typedef struct {
+    double u, v;
+    COORD3 P, N;
+} patch_vert;
+
+/* What the subdivision of one patch needs to know */
+typedef struct {
+    patch_eval_fn eval;
+    void *data;
+    double tolerance;
+    double umin, vmin;	/* shortest edge split, in u and in v */
+    long count;		/* triangles output */
+} patch_info;
+
+
+/*-----------------------------------------------------------------*/
+/*
+ * Subdivide patches adaptively to the given chord tolerance, or use
+ * uniform steps if tolerance is 0.
+ */
+#ifdef ANSI_FN_DEF
+void lib_set_patch_tolerance (double tolerance)
+#else
+void lib_set_patch_tolerance(tolerance)
+double tolerance;
+#endif
+{
+    gPatch_tolerance = (tolerance > 0.0) ? tolerance : 0.0;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+static void patch_eval(patch_info *info, double u, double v, patch_vert *pv)
+#else
+static void patch_eval(info, u, v, pv)
+patch_info *info;
+double u, v;
+patch_vert *pv;
+#endif
+{
+    pv->u = u;
+    pv->v = v;
+    (*info->eval)(info->data, u, v, pv->P, pv->N);
+}
+
+/*-----------------------------------------------------------------*/
+/* Distance from the surface point "pv" to the point "f" of the way along
+   the chord from "a" to "b" */
+#ifdef ANSI_FN_DEF
+static double chord_error(patch_vert *a, patch_vert *b, double f,
+						  patch_vert *pv)
+#else
+static double chord_error(a, b, f, pv)
+patch_vert *a, *b, *pv;
+double f;
+#endif
+{
+    COORD3 diff;
+    int i;
+
+    for (i = 0; i < 3; i++)
+		diff[i] = pv->P[i] - ((1.0 - f) * a->P[i] + f * b->P[i]);
+    return sqrt(DOT_PRODUCT(diff, diff));
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Returns TRUE if the edge from "a" to "b" must be split, with its
+ * midpoint in "m".  The test gives the same answer whichever way round
+ * the edge is given.
+ */
+#ifdef ANSI_FN_DEF
+static int edge_splits(patch_info *info, patch_vert *a, patch_vert *b,
+					   patch_vert *m)
+#else
+static int edge_splits(info, a, b, m)
+patch_info *info;
+patch_vert *a, *b, *m;
+#endif
+{
+    patch_vert q;
+
+    if ((fabs(b->u - a->u) <= info->umin) &&
+		(fabs(b->v - a->v) <= info->vmin))
+		return FALSE;
+
+    patch_eval(info, (a->u + b->u) / 2.0, (a->v + b->v) / 2.0, m);
+    if (chord_error(a, b, 0.5, m) > info->tolerance)
+		return TRUE;
+
+    /* An S shaped edge can pass through its chord's midpoint */
+    patch_eval(info, (a->u + m->u) / 2.0, (a->v + m->v) / 2.0, &q);
+    if (chord_error(a, b, 0.25, &q) > info->tolerance)
+		return TRUE;
+    patch_eval(info, (m->u + b->u) / 2.0, (m->v + b->v) / 2.0, &q);
+    return chord_error(a, b, 0.75, &q) > info->tolerance;
+}
+
+/*-----------------------------------------------------------------*/
+/* Output a triangle, unless it has no area (as at a cusp) */
+#ifdef ANSI_FN_DEF
+static void patch_output(patch_info *info, patch_vert *a, patch_vert *b,
+						 patch_vert *c)
+#else
+static void patch_output(info, a, b, c)
+patch_info *info;
+patch_vert *a, *b, *c;
+#endif
+{
+    COORD3 verts[3], norms[3], e1, e2, cross;
+    double len1, len2;
+
+    SUB3_COORD3(e1, b->P, a->P);
+    SUB3_COORD3(e2, c->P, a->P);
+    CROSS(cross, e1, e2);
+    len1 = DOT_PRODUCT(e1, e1);
+    len2 = DOT_PRODUCT(e2, e2);
+    if (DOT_PRODUCT(cross, cross) <= 1.0e-20 * len1 * len2)
+		return;
+
+    COPY_COORD3(verts[0], a->P);
+    COPY_COORD3(verts[1], b->P);
+    COPY_COORD3(verts[2], c->P);
+    COPY_COORD3(norms[0], a->N);
+    COPY_COORD3(norms[1], b->N);
+    COPY_COORD3(norms[2], c->N);
+    lib_output_polypatch(3, verts, norms);
+    info->count++;
+}
+
+static void patch_triangle PARAMS((patch_info *info, patch_vert *a,
+								   patch_vert *b, patch_vert *c));
+
+/*-----------------------------------------------------------------*/
+/* Split the quadrilateral a,b,c,d along its shorter diagonal */
+#ifdef ANSI_FN_DEF
+static void patch_quad(patch_info *info, patch_vert *a, patch_vert *b,
+					   patch_vert *c, patch_vert *d)
+#else
+static void patch_quad(info, a, b, c, d)
+patch_info *info;
+patch_vert *a, *b, *c, *d;
+#endif
+{
+    COORD3 ac, bd;
+
+    SUB3_COORD3(ac, c->P, a->P);
+    SUB3_COORD3(bd, d->P, b->P);
+    if (DOT_PRODUCT(ac, ac) <= DOT_PRODUCT(bd, bd)) {
+		patch_triangle(info, a, b, c);
+		patch_triangle(info, a, c, d);
+    } else {
+		patch_triangle(info, a, b, d);
+		patch_triangle(info, b, c, d);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* Output the triangle a,b,c, split wherever its edges are not flat */
+#ifdef ANSI_FN_DEF
+static void patch_triangle(patch_info *info, patch_vert *a, patch_vert *b,
+						   patch_vert *c)
+#else
+static void patch_triangle(info, a, b, c)
+patch_info *info;
+patch_vert *a, *b, *c;
+#endif
+{
+    patch_vert mab, mbc, mca;
+    int split;
+
+    split = 0;
+    if (edge_splits(info, a, b, &mab))
+		split |= 1;
+    if (edge_splits(info, b, c, &mbc))
+		split |= 2;
+    if (edge_splits(info, c, a, &mca))
+		split |= 4;
+
+    PLATFORM_MULTITASK();
+
+    switch (split) {
+	case 0:
+		patch_output(info, a, b, c);
+		break;
+	case 1:
+		patch_triangle(info, a, &mab, c);
+		patch_triangle(info, &mab, b, c);
+		break;
+	case 2:
+		patch_triangle(info, a, b, &mbc);
+		patch_triangle(info, a, &mbc, c);
+		break;
+	case 4:
+		patch_triangle(info, a, b, &mca);
+		patch_triangle(info, &mca, b, c);
+		break;
+	case 3:
+		patch_triangle(info, &mab, b, &mbc);
+		patch_quad(info, a, &mab, &mbc, c);
+		break;
+	case 5:
+		patch_triangle(info, a, &mab, &mca);
+		patch_quad(info, &mab, b, c, &mca);
+		break;
+	case 6:
+		patch_triangle(info, &mca, &mbc, c);
+		patch_quad(info, a, b, &mbc, &mca);
+		break;
+	default:
+		patch_triangle(info, a, &mab, &mca);
+		patch_triangle(info, &mab, b, &mbc);
+		patch_triangle(info, &mca, &mbc, c);
+		patch_triangle(info, &mab, &mbc, &mca);
+		break;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Output the patch over u0..u1, v0..v1 as triangles no further than
+ * gPatch_tolerance (times 4 per level of detail below the finest) from
+ * the surface.  "eval" gives the point and unit normal at (u,v), with
+ * "data" passed through.  The patch starts as a u_res by v_res grid of
+ * cells, which should be fine enough that no cell hides a bump inside
+ * flat edges.  Returns the number of triangles output.
+ */
+#ifdef ANSI_FN_DEF
+long lib_output_adaptive_patch (patch_eval_fn eval, void *data,
+								double u0, double u1, double v0, double v1,
+								int u_res, int v_res)
+#else
+long lib_output_adaptive_patch(eval, data, u0, u1, v0, v1, u_res, v_res)
+patch_eval_fn eval;
+void *data;
+double u0, u1, v0, v1;
+int u_res, v_res;
+#endif
+{
+    patch_info info;
+    patch_vert *row0, *row1, *trow;
+    int i, j;
+
+    info.eval = eval;
+    info.data = data;
+    info.tolerance = gPatch_tolerance * (double)(1L << (2 * gLod_level));
+    info.umin = fabs(u1 - u0) / (double)u_res / (double)(1L << PATCH_MAX_DEPTH);
+    info.vmin = fabs(v1 - v0) / (double)v_res / (double)(1L << PATCH_MAX_DEPTH);
+    info.count = 0;
+
+    row0 = (patch_vert *)malloc((v_res + 1) * sizeof(patch_vert));
+    row1 = (patch_vert *)malloc((v_res + 1) * sizeof(patch_vert));
+    if ((row0 == NULL) || (row1 == NULL)) {
+		fprintf(stderr, "Failed to allocate polygon data\n");
+		exit(1);
+    }
+
+    for (i = 0; i <= u_res; i++) {
+		for (j = 0; j <= v_res; j++)
+			patch_eval(&info, u0 + (u1 - u0) * (double)i / (double)u_res,
+				v0 + (v1 - v0) * (double)j / (double)v_res, &row1[j]);
+		if (i > 0) {
+			/* Same winding as the normals, which are Pv x Pu */
+			for (j = 0; j < v_res; j++) {
+				patch_triangle(&info, &row0[j], &row0[j+1], &row1[j+1]);
+				patch_triangle(&info, &row0[j], &row1[j+1], &row1[j]);
+			}
+		}
+		trow = row0; row0 = row1; row1 = trow;
+    }
+
+    free(row1);
+    free(row0);
+    return info.count;
+}
@@ -24,39 +24,475 @@
 /*-----------------------------------------------------------------*/
 /* defines/constants section */
 
-#define VERT(i, a) ((verts[gPoly_vbuffer[i]])[a])
+/* Starting room for triangles split from a polygon, grown by doubling */
+#define SPLIT_START_SIZE       64
+
+/* Starting size of the triangle store, grown by doubling as needed */
+#define TRI_STORE_START_SIZE   1024
 
 
 /*-----------------------------------------------------------------*/
-/* Polygon stack for making PLG files */
-object_ptr gPolygon_stack = NULL;
+/* Scratch storage kept in the current context between calls; the rest of
+   the polygon state (gTri_store, gSplit_polygons, ...) is in lib.h */
+
+/* Cached tessellation templates, most recently used first */
+#define gTemplates     (gContext->templates)
+
+/* Room for the triangles split from a polygon, see split_scratch */
+#define gSplit_tri     (gContext->split_tri)
+#define gSplit_vert    (gContext->split_vert)
+#define gSplit_norm    (gContext->split_norm)
+#define gSplit_vptr    (gContext->split_vptr)
+#define gSplit_nptr    (gContext->split_nptr)
+#define gSplit_size    (gContext->split_size)
+
+/* Primitives given levels of detail inline so far, and whether one is
+   being output now */
+#define gLod_count     (gContext->lod_count)
+#define gLod_open      (gContext->lod_open)
 
-/* Keep track of how many vertices/faces have been emitted */
-unsigned long gVertex_count = 0; /* Vertex coordinates */
-unsigned long gNormal_count = 0; /* Vertex normals */
-unsigned long gFace_count = 0;
+/* Room for the vertices of a polygon projected to the screen */
+#define gVideo_vert    (gContext->video_vert)
+#define gVideo_size    (gContext->video_size)
 
-/* Storage for polygon indices */
-unsigned int *gPoly_vbuffer = NULL;
-int *gPoly_end = NULL;
+/* Room for one instance of a template, moved into place */
+#define gTess_vert     (gContext->tess_vert)
+#define gTess_norm     (gContext->tess_norm)
+#define gTess_size     (gContext->tess_size)
 
-/* Globals to determine which axes can be used to split the polygon */
-int gPoly_Axis1 = 0;
-int gPoly_Axis2 = 1;
 
 
 /*-----------------------------------------------------------------*/
+/*
+ * Find the tessellation template for a primitive kind, resolution and
+ * shape exponents.  If there isn't one cached, an empty one is made with
+ * room for the whole grid (six of them for a sphere's cube faces) in vert,
+ * norm and flag, and *is_new is set TRUE so the caller can fill it in.
+ * Only TEMPLATE_CACHE_SIZE templates are kept; the least recently used is
+ * dropped to make room.
+ */
 #ifdef ANSI_FN_DEF
-void lib_output_polygon_cylcone (COORD4 base_pt, COORD4 apex_pt)
+template_ptr lib_get_template (int kind, int u_res, int v_res,
+							   double p0, double p1, int *is_new)
 #else
-void lib_output_polygon_cylcone(base_pt, apex_pt)
+template_ptr lib_get_template(kind, u_res, v_res, p0, p1, is_new)
+int kind, u_res, v_res;
+double p0, p1;
+int *is_new;
+#endif
+{
+    template_ptr tmpl, prev;
+    long count;
+    int n;
+
+    prev = NULL;
+    for (tmpl = gTemplates, n = 1; tmpl != NULL; tmpl = tmpl->next, n++) {
+		if ((tmpl->kind == kind) && (tmpl->u_res == u_res) &&
+			(tmpl->v_res == v_res) && (tmpl->p0 == p0) && (tmpl->p1 == p1)) {
+			/* Move it to the front of the list */
+			if (prev != NULL) {
+				prev->next = tmpl->next;
+				tmpl->next = gTemplates;
+				gTemplates = tmpl;
+			}
+			*is_new = FALSE;
+			return tmpl;
+		}
+		if ((n == TEMPLATE_CACHE_SIZE) && (tmpl->next == NULL)) {
+			/* Cache is full, drop the last one */
+			if (prev != NULL)
+				prev->next = NULL;
+			else
+				gTemplates = NULL;
+			free(tmpl->vert);
+			free(tmpl->norm);
+			free(tmpl->flag);
+			free(tmpl);
+			break;
+		}
+		prev = tmpl;
+    }
+
+    count = (long)(u_res + 1) * (long)(v_res + 1);
+    if (kind == TEMPLATE_SPHERE)
+		count *= 6;
+    tmpl = (template_ptr)malloc(sizeof(struct template_struct));
+    if (tmpl != NULL) {
+		tmpl->vert = (COORD3 *)malloc(count * sizeof(COORD3));
+		tmpl->norm = (COORD3 *)malloc(count * sizeof(COORD3));
+		tmpl->flag = (unsigned char *)malloc(count);
+    }
+    if ((tmpl == NULL) || (tmpl->vert == NULL) || (tmpl->norm == NULL) ||
+		(tmpl->flag == NULL)) {
+		fprintf(stderr, "Failed to allocate polygon data\n");
+		exit(1);
+    }
+    tmpl->kind = kind;
+    tmpl->u_res = u_res;
+    tmpl->v_res = v_res;
+    tmpl->p0 = p0;
+    tmpl->p1 = p1;
+    tmpl->next = gTemplates;
+    gTemplates = tmpl;
+    *is_new = TRUE;
+    return tmpl;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Get scratch arrays with room for "count" points and normals (norm may
+ * be NULL if only points are needed).  The arrays are reused by the next
+ * call.
+ */
+#ifdef ANSI_FN_DEF
+void lib_tess_buffers (long count, COORD3 **vert, COORD3 **norm)
+#else
+void lib_tess_buffers(count, vert, norm)
+long count;
+COORD3 **vert, **norm;
+#endif
+{
+    COORD3 *tvert, *tnorm;
+
+    if (gTess_size < count) {
+		tvert = (COORD3 *)realloc(gTess_vert, count * sizeof(COORD3));
+		if (tvert != NULL)
+			gTess_vert = tvert;
+		tnorm = (COORD3 *)realloc(gTess_norm, count * sizeof(COORD3));
+		if (tnorm != NULL)
+			gTess_norm = tnorm;
+		if ((tvert == NULL) || (tnorm == NULL)) {
+			fprintf(stderr, "Failed to allocate polygon data\n");
+			exit(1);
+		}
+		gTess_size = count;
+    }
+    *vert = gTess_vert;
+    if (norm != NULL)
+		*norm = gTess_norm;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Turn adaptive tessellation on, so each curved primitive is split just
+ * finely enough that its edges stay within "pixel_error" pixels of the
+ * true surface as seen from gViewpoint, or off (every primitive uses
+ * gU_resolution and gV_resolution) if pixel_error is 0.
+ */
+#ifdef ANSI_FN_DEF
+void lib_set_adaptive_tessellation (double pixel_error)
+#else
+void lib_set_adaptive_tessellation(pixel_error)
+double pixel_error;
+#endif
+{
+    gAdaptive_error = (pixel_error > 0.0) ? pixel_error : 0.0;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Move a primitive's "center" into world space, and return how much the
+ * current transform scales it by (at most).
+ */
+#ifdef ANSI_FN_DEF
+static double world_center(COORD3 center, COORD4 pt)
+#else
+static double world_center(center, pt)
+COORD3 center;
+COORD4 pt;
+#endif
+{
+    MATRIX txmat;
+    double scale, len;
+    int i;
+
+    if (!lib_tx_active()) {
+		COPY_COORD3(pt, center);
+		return 1.0;
+    }
+    lib_get_current_tx(txmat);
+    lib_transform_point(pt, center, txmat);
+    scale = 0.0;
+    for (i=0;i<3;i++) {
+		len = sqrt(txmat[i][X] * txmat[i][X] + txmat[i][Y] * txmat[i][Y] +
+			txmat[i][Z] * txmat[i][Z]);
+		if (len > scale)
+			scale = len;
+    }
+    return scale;
+}
+
+/*-----------------------------------------------------------------*/
+/* Pixels covered by one unit of length at distance 1 from the eye */
+static double pixel_scale PARAMS((void))
+{
+    return (double)gViewpoint.resy / (2.0 * tan(PI * gViewpoint.angle / 360.0));
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Resolution to tessellate a curve of "radius" with, for a primitive that
+ * fits in a sphere of "bound" around "center" (all before the current
+ * transform).  The primitives put 4*resolution segments around a full
+ * circle.  With adaptive tessellation off this is just "fixed"; otherwise
+ * the curve's radius in pixels is found at the primitive's nearest point
+ * to the eye, and the resolution is the least that keeps the gap between
+ * each segment and the curve under gAdaptive_error pixels.  Each level of
+ * detail past the first halves the resolution.
+ */
+#ifdef ANSI_FN_DEF
+int lib_tess_resolution (COORD3 center, double bound, double radius, int fixed)
+#else
+int lib_tess_resolution(center, bound, radius, fixed)
+COORD3 center;
+double bound, radius;
+int fixed;
+#endif
+{
+    COORD4 pt;
+    COORD3 dir;
+    double depth, scale, pixels, segments;
+    int res;
+
+    if (gAdaptive_error <= 0.0) {
+		res = fixed;
+    } else {
+		scale = world_center(center, pt);
+		bound *= scale;
+		radius *= scale;
+
+		/* Distance along the line of sight to the nearest point */
+		SUB3_COORD3(dir, gViewpoint.at, gViewpoint.from);
+		lib_normalize_vector(dir);
+		depth = (pt[X] - gViewpoint.from[X]) * dir[X] +
+			(pt[Y] - gViewpoint.from[Y]) * dir[Y] +
+			(pt[Z] - gViewpoint.from[Z]) * dir[Z];
+		if (depth + bound < 0.0) {
+			/* Wholly behind the eye */
+			res = 1;
+		} else if (depth - bound <= gViewpoint.hither) {
+			res = ADAPTIVE_MAX_RESOLUTION;
+		} else {
+			pixels = radius * pixel_scale() / (depth - bound);
+			if (pixels <= gAdaptive_error) {
+				res = 1;
+			} else {
+				segments = PI / acos(1.0 - gAdaptive_error / pixels);
+				res = (int)ceil(segments / 4.0);
+				if (res > ADAPTIVE_MAX_RESOLUTION)
+					res = ADAPTIVE_MAX_RESOLUTION;
+			}
+		}
+    }
+
+    res = (res + (1 << gLod_level) - 1) >> gLod_level;
+    return (res < 1) ? 1 : res;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Note that a primitive made "count" triangles where the fixed resolution
+ * would have made "fixed", for the statistics printed by lib_close.  Only
+ * the finest level of detail is counted.
+ */
+#ifdef ANSI_FN_DEF
+void lib_tess_count (long fixed, long count)
+#else
+void lib_tess_count(fixed, count)
+long fixed, count;
+#endif
+{
+    if (((gAdaptive_error > 0.0) || (gPatch_tolerance > 0.0)) &&
+		(gLod_level == 0)) {
+		gAdaptive_fixed += (unsigned long)fixed;
+		gAdaptive_triangles += (unsigned long)count;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Output "levels" levels of detail of each tessellated primitive, or just
+ * the one if levels is 1.  See lib_lod_begin.
+ */
+#ifdef ANSI_FN_DEF
+void lib_set_lod_levels (int levels)
+#else
+void lib_set_lod_levels(levels)
+int levels;
+#endif
+{
+    if (levels < 1)
+		levels = 1;
+    else if (levels > LOD_MAX_LEVELS)
+		levels = LOD_MAX_LEVELS;
+    gLod_levels = levels;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * TRUE if the format can hold all the levels of detail of a primitive
+ * together in one file.  The others get one file for each level, see
+ * lib_close.
+ */
+#ifdef ANSI_FN_DEF
+int lib_lod_inline (int format)
+#else
+int lib_lod_inline(format)
+int format;
+#endif
+{
+    return (format == OUTPUT_OBJ) || (format == OUTPUT_VRML2);
+}
+
+/*-----------------------------------------------------------------*/
+/* Start the group holding the current level of detail */
+static void lod_level_begin PARAMS((void))
+{
+    if (gRT_out_format == OUTPUT_VRML2) {
+		tab_indent();
+		lib_printf("Group { children [\n");
+		tab_inc();
+    } else {
+		lib_printf("g object%ld lod%d\n", gLod_count, gLod_level);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Begin the levels of detail of a tessellated primitive, sized as for
+ * lib_tess_resolution.  A primitive is output with
+ *
+ *	lib_lod_begin(center, bound, radius);
+ *	do {
+ *	    ...tessellate at lib_tess_resolution()...
+ *	} while (lib_lod_next());
+ *
+ * which runs once, unless the format holds levels of detail inline.  Then
+ * it runs once for each level, and each level is grouped: VRML 2.0 gets
+ * an LOD node that switches to each coarser level at the distance where
+ * its error drops under the pixel error (gAdaptive_error, or ADAPTIVE_ERROR
+ * if that is off), and OBJ gets a group for each primitive and level.
+ */
+#ifdef ANSI_FN_DEF
+void lib_lod_begin (COORD3 center, double bound, double radius)
+#else
+void lib_lod_begin(center, bound, radius)
+COORD3 center;
+double bound, radius;
+#endif
+{
+    COORD4 pt;
+    double scale, error, dist;
+    int res;
+
+    gLod_open = (gLod_levels > 1) && lib_lod_inline(gRT_out_format);
+    if (!gLod_open)
+		return;
+
+    gLod_count++;
+    if (gRT_out_format == OUTPUT_VRML2) {
+		/* The triangles are in their own transforms, so the LOD is in
+		   world space */
+		scale = world_center(center, pt);
+		error = (gAdaptive_error > 0.0) ? gAdaptive_error : ADAPTIVE_ERROR;
+		tab_indent();
+		lib_printf("LOD {\n");
+		tab_inc();
+		tab_indent();
+		lib_printf("center %g %g %g\n", pt[X], pt[Y], pt[Z]);
+		tab_indent();
+		lib_printf("range [");
+		for (gLod_level=1;gLod_level<gLod_levels;gLod_level++) {
+			/* Gap between the segments and the curve at this level */
+			res = lib_tess_resolution(center, bound, radius, gU_resolution);
+			dist = scale * (bound + radius * (1.0 - cos(PI / (4.0 * res))) *
+				pixel_scale() / error);
+			lib_printf((gLod_level > 1) ? ", %g" : " %g", dist);
+		}
+		lib_printf(" ]\n");
+		tab_indent();
+		lib_printf("level [\n");
+		tab_inc();
+    }
+    gLod_level = 0;
+    lod_level_begin();
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Finish the current level of detail.  Returns TRUE if there is another
+ * to output, FALSE when done.
+ */
+int lib_lod_next PARAMS((void))
+{
+    if (!gLod_open)
+		return FALSE;
+
+    if (gRT_out_format == OUTPUT_VRML2) {
+		tab_dec();
+		tab_indent();
+		lib_printf("] }\n");
+    }
+    if (++gLod_level < gLod_levels) {
+		lod_level_begin();
+		return TRUE;
+    }
+
+    if (gRT_out_format == OUTPUT_VRML2) {
+		tab_dec();
+		tab_indent();
+		lib_printf("]\n");
+		tab_dec();
+		tab_indent();
+		lib_printf("}\n");
+    } else {
+		lib_printf("g default\n");
+    }
+    gLod_level = 0;
+    gLod_open = FALSE;
+    return FALSE;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Unit circle of "res" segments: vert[i] is (cos, sin, 0) of the angle
+ * i * 2 PI / res.  The angles are summed up step by step, the same way the
+ * polygonalizers always stepped around.
+ */
+#ifdef ANSI_FN_DEF
+static template_ptr circle_template(int res)
+#else
+static template_ptr circle_template(res)
+int res;
+#endif
+{
+    template_ptr tmpl;
+    double angle, delta_angle;
+    int i, is_new;
+
+    tmpl = lib_get_template(TEMPLATE_CIRCLE, res, 0, 0.0, 0.0, &is_new);
+    if (is_new) {
+		delta_angle = 2.0 * PI / (double)res;
+		for (i=0,angle=0.0;i<=res;i++,angle+=delta_angle)
+			SET_COORD3(tmpl->vert[i], cos(angle), sin(angle), 0.0);
+    }
+    return tmpl;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+static void cylcone_polygons (COORD4 base_pt, COORD4 apex_pt, int res)
+#else
+static void cylcone_polygons(base_pt, apex_pt, res)
 COORD4 base_pt, apex_pt;
+int res;
 #endif
 {
-    double angle, delta_angle, height, divisor, ba;
-    COORD3 axis, dir, norm_axis, start_dir, start_norm;
-    COORD3 norm[4], vert[4], start_radius[4];
-    MATRIX nmx, mx;
+    double height, divisor, ba, norm_out, norm_up;
+    COORD3 axis, dir, norm_axis, start_dir, side_dir, start_norm, rdir;
+    COORD3 norm[4], vert[4];
+    template_ptr circle;
+    double *cs;
     int    i;
 	
     SUB3_COORD3(axis, apex_pt, base_pt);
@@ -72,16 +508,16 @@ COORD4 base_pt, apex_pt;
 		CROSS(start_dir, axis, dir);
 		lib_normalize_vector(start_dir);
     }
+    /* Rotating start_dir about the axis sweeps it towards side_dir */
+    CROSS(side_dir, norm_axis, start_dir);
 	
-    start_radius[0][X] = start_dir[X] * base_pt[W];
-    start_radius[0][Y] = start_dir[Y] * base_pt[W];
-    start_radius[0][Z] = start_dir[Z] * base_pt[W];
-    ADD3_COORD3(vert[2], base_pt, start_radius[0]);
+    vert[2][X] = base_pt[X] + start_dir[X] * base_pt[W];
+    vert[2][Y] = base_pt[Y] + start_dir[Y] * base_pt[W];
+    vert[2][Z] = base_pt[Z] + start_dir[Z] * base_pt[W];
 	
-    start_radius[1][X] = start_dir[X] * apex_pt[W];
-    start_radius[1][Y] = start_dir[Y] * apex_pt[W];
-    start_radius[1][Z] = start_dir[Z] * apex_pt[W];
-    ADD3_COORD3(vert[1], apex_pt, start_radius[1]);
+    vert[1][X] = apex_pt[X] + start_dir[X] * apex_pt[W];
+    vert[1][Y] = apex_pt[Y] + start_dir[Y] * apex_pt[W];
+    vert[1][Z] = apex_pt[Z] + start_dir[Z] * apex_pt[W];
 	
     if ( base_pt[W] == apex_pt[W] ) {
 		/* it's a cylinder, so simply copy dir to norm */
@@ -96,19 +532,28 @@ COORD4 base_pt, apex_pt;
     }
     COPY_COORD3(norm[2], start_norm);
     COPY_COORD3(norm[1], start_norm);
+    /* The normal is this much outwards and this much along the axis */
+    norm_out = DOT_PRODUCT(start_norm, start_dir);
+    norm_up = DOT_PRODUCT(start_norm, norm_axis);
 	
-    delta_angle = 2.0 * PI / (double)(4*gU_resolution);
-    for (i=1,angle=delta_angle;i<=4*gU_resolution;++i,angle+=delta_angle) {
-		lib_create_axis_rotate_matrix(mx, norm_axis, angle);
-		lib_invert_matrix(nmx, mx);
-		lib_transform_point(vert[0], start_radius[1], mx);
-		ADD2_COORD3(vert[0], apex_pt);
-		lib_transform_normal(norm[0], start_norm, nmx);
+    circle = circle_template(4*res);
+    for (i=1;i<=4*res;++i) {
+		cs = circle->vert[i];
+		rdir[X] = start_dir[X] * cs[X] + side_dir[X] * cs[Y];
+		rdir[Y] = start_dir[Y] * cs[X] + side_dir[Y] * cs[Y];
+		rdir[Z] = start_dir[Z] * cs[X] + side_dir[Z] * cs[Y];
+		vert[0][X] = apex_pt[X] + rdir[X] * apex_pt[W];
+		vert[0][Y] = apex_pt[Y] + rdir[Y] * apex_pt[W];
+		vert[0][Z] = apex_pt[Z] + rdir[Z] * apex_pt[W];
+		norm[0][X] = rdir[X] * norm_out + norm_axis[X] * norm_up;
+		norm[0][Y] = rdir[Y] * norm_out + norm_axis[Y] * norm_up;
+		norm[0][Z] = rdir[Z] * norm_out + norm_axis[Z] * norm_up;
 		lib_output_polypatch(3, vert, norm);
 		COPY_COORD3(vert[1], vert[0]);
 		COPY_COORD3(norm[1], norm[0]);
-		lib_transform_point(vert[0], start_radius[0], mx);
-		ADD2_COORD3(vert[0], base_pt);
+		vert[0][X] = base_pt[X] + rdir[X] * base_pt[W];
+		vert[0][Y] = base_pt[Y] + rdir[Y] * base_pt[W];
+		vert[0][Z] = base_pt[Z] + rdir[Z] * base_pt[W];
 		lib_output_polypatch(3, vert, norm);
 		
 		COPY_COORD3(vert[2], vert[0]);
@@ -120,19 +565,27 @@ COORD4 base_pt, apex_pt;
 
 /*-----------------------------------------------------------------*/
 #ifdef ANSI_FN_DEF
-static void disc_evaluator(MATRIX trans, double theta, double v, double r, COORD3 vert)
+void lib_output_polygon_cylcone (COORD4 base_pt, COORD4 apex_pt)
 #else
-static void disc_evaluator(trans, theta, v, r, vert)
-MATRIX trans;
-double theta, v, r;
-COORD3 vert;
+void lib_output_polygon_cylcone(base_pt, apex_pt)
+COORD4 base_pt, apex_pt;
 #endif
 {
-    COORD3 tvert;
-	
-    /* Compute the position of the point */
-    SET_COORD3(tvert, (r + v) * cos(theta), (r + v) * sin(theta), 0.0);
-    lib_transform_point(vert, tvert, trans);
+    COORD3 axis, mid_pt;
+    double radius, bound;
+    int res;
+
+    SUB3_COORD3(axis, apex_pt, base_pt);
+    ADD3_COORD3(mid_pt, base_pt, apex_pt);
+    SET_COORD3(mid_pt, mid_pt[X] / 2.0, mid_pt[Y] / 2.0, mid_pt[Z] / 2.0);
+    radius = MAX(ABSOLUTE(base_pt[W]), ABSOLUTE(apex_pt[W]));
+    bound = sqrt(DOT_PRODUCT(axis, axis) / 4.0 + radius * radius);
+    lib_lod_begin(mid_pt, bound, radius);
+    do {
+		res = lib_tess_resolution(mid_pt, bound, radius, gU_resolution);
+		lib_tess_count(8L * gU_resolution, 8L * res);
+		cylcone_polygons(base_pt, apex_pt, res);
+    } while (lib_lod_next());
 }
 
 /*-----------------------------------------------------------------*/
@@ -145,10 +598,11 @@ void lib_output_polygon_disc (COORD3 center, COORD3 normal,
 double iradius, oradius;
 #endif
 {
-    double u, v, delta_u, delta_v;
     MATRIX mx, imx;
-    int i;
+    int i, res;
     COORD3 norm, vert[4];
+    COORD3 *inner, *outer;
+    template_ptr circle;
 	
     COPY_COORD3(norm, normal);
     if ( lib_normalize_vector(norm) < EPSILON2) {
@@ -156,522 +610,1513 @@ double iradius, oradius;
 		exit(1);
     }
     lib_create_canonical_matrix(mx, imx, center, norm);
-    delta_u = 2.0 * PI / (double)(4 * gU_resolution);
-	
-    /* Dump out polygons */
-    for (i=0,u=0.0;i<4*gU_resolution;i++,u+=delta_u) {
-		PLATFORM_MULTITASK();
-		v = 0.0;
-		delta_v = oradius-iradius;
-		disc_evaluator(imx, u, v, iradius, vert[3]);
-		disc_evaluator(imx, u+delta_u, v, iradius, vert[2]);
-		disc_evaluator(imx, u+delta_u, v+delta_v, iradius, vert[1]);
-		disc_evaluator(imx, u, v+delta_v, iradius, vert[0]);
-		lib_output_polygon(4, vert);
-    }
+    lib_lod_begin(center, oradius, oradius);
+    do {
+		res = 4 * lib_tess_resolution(center, oradius, oradius,
+			gU_resolution);
+		lib_tess_count(8L * gU_resolution, 2L * res);
+		circle = circle_template(res);
+
+		/* Inner and outer rings, moved into place */
+		lib_tess_buffers(2L * (res + 1), &inner, NULL);
+		outer = inner + res + 1;
+		for (i=0;i<=res;i++) {
+			SET_COORD3(inner[i], iradius * circle->vert[i][X],
+				iradius * circle->vert[i][Y], 0.0);
+			SET_COORD3(outer[i], oradius * circle->vert[i][X],
+				oradius * circle->vert[i][Y], 0.0);
+		}
+		lib_transform_points(inner, inner, 2L * (res + 1), imx);
+
+		/* Dump out polygons */
+		for (i=0;i<res;i++) {
+			PLATFORM_MULTITASK();
+			COPY_COORD3(vert[3], inner[i]);
+			COPY_COORD3(vert[2], inner[i+1]);
+			COPY_COORD3(vert[1], outer[i+1]);
+			COPY_COORD3(vert[0], outer[i]);
+			lib_output_polygon(4, vert);
+		}
+    } while (lib_lod_next());
 }
 
 /*-----------------------------------------------------------------*/
+/*
+ * Unit sphere mesh: a grid of (u_res+1) by (v_res+1) points on each of the
+ * six cube faces, stored face by face; each point is also the sphere
+ * normal there.
+ */
 #ifdef ANSI_FN_DEF
-void lib_output_polygon_sphere(COORD4 center_pt)
+static template_ptr sphere_template(int u_res, int v_res)
 #else
-void lib_output_polygon_sphere(center_pt)
-COORD4 center_pt;
+static template_ptr sphere_template(u_res, v_res)
+int u_res, v_res;
 #endif
 {
     double  angle;
-    COORD3  edge_norm[3], edge_pt[3];
-    long    num_face, num_edge, num_tri, num_vert;
-    COORD3  *x_axis, *y_axis, **pt;
+    long    num_face, num_edge, u_pol, v_pol, nu, nv;
+    COORD3  *x_axis, *y_axis, *pt, *mesh;
     COORD3  mid_axis;
     MATRIX  rot_mx;
-    long    u_pol, v_pol;
-	
-    /* Allocate storage for the polygon vertices */
-    x_axis = (COORD3 *)malloc((gU_resolution+1) * sizeof(COORD3));
-    y_axis = (COORD3 *)malloc((gV_resolution+1) * sizeof(COORD3));
-    pt     = (COORD3 **)malloc((gU_resolution+1) * sizeof(COORD3 *));
-    if (x_axis == NULL || y_axis == NULL || pt == NULL) {
+    template_ptr tmpl;
+    int     is_new;
+
+    tmpl = lib_get_template(TEMPLATE_SPHERE, u_res, v_res, 0.0, 0.0, &is_new);
+    if (!is_new)
+		return tmpl;
+
+    nu = u_res + 1;
+    nv = v_res + 1;
+    mesh = tmpl->vert;
+    x_axis = (COORD3 *)malloc(nu * sizeof(COORD3));
+    y_axis = (COORD3 *)malloc(nv * sizeof(COORD3));
+    if (x_axis == NULL || y_axis == NULL) {
 		fprintf(stderr, "Failed to allocate polygon data\n");
 		exit(1);
     }
-	
-    for (num_edge=0;num_edge<gU_resolution+1;num_edge++) {
-		pt[num_edge] = (COORD3 *)malloc((gV_resolution+1) * sizeof(COORD3));
-		if (pt[num_edge] == NULL) {
-			fprintf(stderr, "Failed to allocate polygon data\n");
-			exit(1);
-		}
-    }
-	
+
     /* calculate axes used to find grid points */
-    for (num_edge=0;num_edge<=gU_resolution;++num_edge) {
-		angle = (PI/4.0) * (2.0*(double)num_edge/gU_resolution - 1.0);
+    for (num_edge=0;num_edge<=u_res;++num_edge) {
+		angle = (PI/4.0) * (2.0*(double)num_edge/u_res - 1.0);
 		mid_axis[X] = 1.0; mid_axis[Y] = 0.0; mid_axis[Z] = 0.0;
 		lib_create_rotate_matrix(rot_mx, Y_AXIS, angle);
 		lib_transform_vector(x_axis[num_edge], mid_axis, rot_mx);
     }
-	
-    for (num_edge=0;num_edge<=gV_resolution;++num_edge) {
-		angle = (PI/4.0) * (2.0*(double)num_edge/gV_resolution - 1.0);
+
+    for (num_edge=0;num_edge<=v_res;++num_edge) {
+		angle = (PI/4.0) * (2.0*(double)num_edge/v_res - 1.0);
 		mid_axis[X] = 0.0; mid_axis[Y] = 1.0; mid_axis[Z] = 0.0;
 		lib_create_rotate_matrix(rot_mx, X_AXIS, angle);
 		lib_transform_vector(y_axis[num_edge], mid_axis, rot_mx);
     }
-	
+
     /* set up grid of points on +Z sphere surface */
-    for (u_pol=0;u_pol<=gU_resolution;++u_pol) {
-		for (v_pol=0;v_pol<=gU_resolution;++v_pol) {
-			CROSS(pt[u_pol][v_pol], x_axis[u_pol], y_axis[v_pol]);
-			lib_normalize_vector(pt[u_pol][v_pol]);
+    for (u_pol=0;u_pol<=u_res;++u_pol) {
+		for (v_pol=0;v_pol<=v_res;++v_pol) {
+			pt = &mesh[u_pol*nv + v_pol];
+			CROSS(*pt, x_axis[u_pol], y_axis[v_pol]);
+			lib_normalize_vector(*pt);
 		}
     }
-	
+
+    /* each face is the previous one rotated to the next cube face */
     for (num_face=0;num_face<6;++num_face) {
-		/* transform points to cube face */
-		for (u_pol=0;u_pol<=gU_resolution;++u_pol) {
-			for (v_pol=0;v_pol<=gV_resolution;++v_pol) {
-				lib_rotate_cube_face(pt[u_pol][v_pol], Z_AXIS, num_face);
-			}
+		pt = &mesh[num_face*nu*nv];
+		if (num_face > 0)
+			memcpy(pt, pt - nu*nv, nu * nv * sizeof(COORD3));
+		for (num_edge=0;num_edge<nu*nv;++num_edge)
+			lib_rotate_cube_face(pt[num_edge], Z_AXIS, (int)num_face);
+    }
+
+    free(y_axis);
+    free(x_axis);
+    return tmpl;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+static void sphere_polygons(COORD4 center_pt, int u_res, int v_res)
+#else
+static void sphere_polygons(center_pt, u_res, v_res)
+COORD4 center_pt;
+int u_res, v_res;
+#endif
+{
+    COORD3  edge_norm[3], edge_pt[3];
+    COORD3  *norm, *tpt;
+    double  *src, *dst;
+    long    num_face, num_edge, num_tri, num_vert, nu, nv, i, j;
+    long    u_pol, v_pol;
+    template_ptr sphere;
+
+    sphere = sphere_template(u_res, v_res);
+    nu = u_res + 1;
+    nv = v_res + 1;
+
+    /* Room for one face of the grid, moved into place */
+    lib_tess_buffers(nu * nv, &tpt, NULL);
+
+    for (num_face=0;num_face<6;++num_face) {
+		/* scale and translate the unit grid for this face */
+		norm = &sphere->vert[num_face*nu*nv];
+		src = (double *)norm;
+		dst = (double *)tpt;
+		for (i=0,j=0;i<nu*nv;i++,j+=3) {
+			dst[j]   = src[j]   * center_pt[W] + center_pt[X];
+			dst[j+1] = src[j+1] * center_pt[W] + center_pt[Y];
+			dst[j+2] = src[j+2] * center_pt[W] + center_pt[Z];
 		}
-		
+
 		/* output grid */
-		for (u_pol=0;u_pol<gU_resolution;++u_pol) {
-			for (v_pol=0;v_pol<gV_resolution;++v_pol) {
+		for (u_pol=0;u_pol<u_res;++u_pol) {
+			for (v_pol=0;v_pol<v_res;++v_pol) {
 				PLATFORM_MULTITASK();
 				for (num_tri=0;num_tri<2;++num_tri) {
 					for (num_edge=0;num_edge<3;++num_edge) {
 						num_vert = (num_tri*2 + num_edge) % 4;
-						if (num_vert == 0) {
-							COPY_COORD3(edge_pt[num_edge], pt[u_pol][v_pol]);
-						} else if ( num_vert == 1 ) {
-							COPY_COORD3(edge_pt[num_edge], pt[u_pol][v_pol+1]);
-						} else if ( num_vert == 2 ) {
-							COPY_COORD3(edge_pt[num_edge],pt[u_pol+1][v_pol+1]);
-						} else {
-							COPY_COORD3(edge_pt[num_edge], pt[u_pol+1][v_pol]);
-						}
-						COPY_COORD3(edge_norm[num_edge], edge_pt[num_edge]);
-						edge_pt[num_edge][X] =
-							edge_pt[num_edge][X] * center_pt[W] +
-							center_pt[X];
-						edge_pt[num_edge][Y] =
-							edge_pt[num_edge][Y] * center_pt[W] +
-							center_pt[Y];
-						edge_pt[num_edge][Z] =
-							edge_pt[num_edge][Z] * center_pt[W] +
-							center_pt[Z];
-						
+						if (num_vert == 0)
+							i = u_pol*nv + v_pol;
+						else if ( num_vert == 1 )
+							i = u_pol*nv + v_pol+1;
+						else if ( num_vert == 2 )
+							i = (u_pol+1)*nv + v_pol+1;
+						else
+							i = (u_pol+1)*nv + v_pol;
+						COPY_COORD3(edge_pt[num_edge], tpt[i]);
+						COPY_COORD3(edge_norm[num_edge], norm[i]);
 					}
 					lib_output_polypatch(3, edge_pt, edge_norm);
 				}
 			}
 		}
     }
-	
-    /* Release any memory used */
-    for (num_edge=0;num_edge<gU_resolution+1;num_edge++)
-		free(pt[num_edge]);
-    free(pt);
-    free(y_axis);
-    free(x_axis);
 }
 
 
 /*-----------------------------------------------------------------*/
 #ifdef ANSI_FN_DEF
-void    lib_output_polygon_height (int height, int width, float **data,
+void lib_output_polygon_sphere(COORD4 center_pt)
+#else
+void lib_output_polygon_sphere(center_pt)
+COORD4 center_pt;
+#endif
+{
+    int u_res, v_res;
+
+    lib_lod_begin(center_pt, center_pt[W], center_pt[W]);
+    do {
+		u_res = lib_tess_resolution(center_pt, center_pt[W], center_pt[W],
+			gU_resolution);
+		v_res = lib_tess_resolution(center_pt, center_pt[W], center_pt[W],
+			gV_resolution);
+		lib_tess_count(12L * gU_resolution * gV_resolution,
+			12L * u_res * v_res);
+		sphere_polygons(center_pt, u_res, v_res);
+    } while (lib_lod_next());
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void    lib_output_polygon_height (height_ptr hf,
 								   double x0, double x1,
 								   double y0, double y1,
 								   double z0, double z1)
 #else
-								   void lib_output_polygon_height(height, width, data, x0, x1, y0, y1, z0, z1)
-								   int height, width;
-float **data;
+void lib_output_polygon_height(hf, x0, x1, y0, y1, z0, z1)
+height_ptr hf;
 double x0, x1, y0, y1, z0, z1;
 #endif
 {
-    int i, j;
+    int i, j, height, width;
     double xdelta, zdelta;
+    float *buf[2], *row0, *row1;
     COORD3 verts[3];
 	
 #if defined (applec)
 #pragma unused (y1)
 #endif /* applec */
 	
+    height = hf->height;
+    width = hf->width;
     xdelta = (x1 - x0) / (double)(width - 1);
     zdelta = (z1 - z0) / (double)(height - 1);
+
+    /* Only two rows are needed at a time */
+    buf[0] = (float *)malloc(width * sizeof(float));
+    buf[1] = (float *)malloc(width * sizeof(float));
+    if ((buf[0] == NULL) || (buf[1] == NULL)) {
+		fprintf(stderr, "Failed to allocate polygon data\n");
+		exit(1);
+    }
+
+    row0 = lib_height_row(hf, 0, buf[0]);
     for (i=0;i<height-1;i++) {
+		row1 = lib_height_row(hf, i+1, buf[(i+1) & 1]);
 		for (j=0;j<width-1;j++) {
 			PLATFORM_MULTITASK();
-			SET_COORD3(verts[0], x0 + j * xdelta, y0 + data[i][j],
+			SET_COORD3(verts[0], x0 + j * xdelta, y0 + row0[j],
 				z0 + i * zdelta);
-			SET_COORD3(verts[1], x0 + (j+1) * xdelta, y0 + data[i+1][j+1],
+			SET_COORD3(verts[1], x0 + (j+1) * xdelta, y0 + row1[j+1],
 				z0 + (i + 1) * zdelta);
-			SET_COORD3(verts[2], x0 + (j+1) * xdelta, y0 + data[i][j+1],
+			SET_COORD3(verts[2], x0 + (j+1) * xdelta, y0 + row0[j+1],
 				z0 + i * zdelta);
 			lib_output_polygon(3, verts);
 			COPY_COORD3(verts[2], verts[1]);	/* copy corner from previous */
-			SET_COORD3(verts[1], x0 + j * xdelta, y0 + data[i+1][j],
+			SET_COORD3(verts[1], x0 + j * xdelta, y0 + row1[j],
 				z0 + (i + 1) * zdelta);
 			lib_output_polygon(3, verts);
 		}
+		row0 = row1;
+    }
+
+    free(buf[1]);
+    free(buf[0]);
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Unit torus grid of "u_res" steps around the tube by "v_res" steps around
+ * the ring.  vert holds the direction from the center to the ring,
+ * (cos(phi), sin(phi), 0), and norm the direction from the ring out to the
+ * surface.  A torus of radii r0 and r1 has its point at r0*vert + r1*norm.
+ */
+#ifdef ANSI_FN_DEF
+static template_ptr torus_template(int u_res, int v_res)
+#else
+static template_ptr torus_template(u_res, v_res)
+int u_res, v_res;
+#endif
+{
+    template_ptr tmpl, theta, phi;
+    double *ct, *cp;
+    int i, j, is_new;
+    long k;
+
+    tmpl = lib_get_template(TEMPLATE_TORUS, u_res, v_res, 0.0, 0.0, &is_new);
+    if (is_new) {
+		theta = circle_template(u_res);
+		phi = circle_template(v_res);
+		for (i=0,k=0;i<=u_res;i++) {
+			ct = theta->vert[i];
+			for (j=0;j<=v_res;j++,k++) {
+				cp = phi->vert[j];
+				SET_COORD3(tmpl->vert[k], cp[X], cp[Y], 0.0);
+				SET_COORD3(tmpl->norm[k], ct[Y] * cp[X], ct[Y] * cp[Y], ct[X]);
+			}
+		}
+    }
+    return tmpl;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+static void torus_polygons (MATRIX imx, double iradius, double oradius,
+							int u_res, int v_res)
+#else
+static void torus_polygons(imx, iradius, oradius, u_res, v_res)
+MATRIX imx;
+double iradius, oradius;
+int u_res, v_res;
+#endif
+{
+    int i, j;
+    long k, nv;
+    double side;
+    COORD3 vert[4], norm[4];
+    COORD3 *pt, *pn;
+    template_ptr torus;
+	
+    nv = v_res + 1;
+    torus = torus_template(u_res, v_res);
+	
+    /* Move the grid into place */
+    lib_tess_buffers((long)(u_res + 1) * nv, &pt, &pn);
+    for (k=0;k<(long)(u_res + 1) * nv;k++) {
+		pt[k][X] = iradius * torus->vert[k][X] + oradius * torus->norm[k][X];
+		pt[k][Y] = iradius * torus->vert[k][Y] + oradius * torus->norm[k][Y];
+		pt[k][Z] = oradius * torus->norm[k][Z];
+		/* The normal flips where the tube passes through the center */
+		side = oradius * (iradius + oradius *
+			DOT_PRODUCT(torus->vert[k], torus->norm[k]));
+		if (side > 0.0) {
+			COPY_COORD3(pn[k], torus->norm[k]);
+		} else if (side < 0.0) {
+			SET_COORD3(pn[k], -torus->norm[k][X], -torus->norm[k][Y],
+				-torus->norm[k][Z]);
+		} else {
+			SET_COORD3(pn[k], 0.0, 0.0, 0.0);
+		}
+    }
+    lib_transform_points(pt, pt, (long)(u_res + 1) * nv, imx);
+    lib_transform_vectors(pn, pn, (long)(u_res + 1) * nv, imx);
+	
+    /* Dump out polygons */
+    for (i=0;i<u_res;i++) {
+		PLATFORM_MULTITASK();
+		for (j=0;j<v_res;j++) {
+			k = i * nv + j;
+			COPY_COORD3(vert[2], pt[k]);
+			COPY_COORD3(norm[2], pn[k]);
+			COPY_COORD3(vert[1], pt[k+1]);
+			COPY_COORD3(norm[1], pn[k+1]);
+			COPY_COORD3(vert[0], pt[k+nv+1]);
+			COPY_COORD3(norm[0], pn[k+nv+1]);
+			lib_output_polypatch(3, vert, norm);
+			COPY_COORD3(vert[1], vert[0]);
+			COPY_COORD3(norm[1], norm[0]);
+			COPY_COORD3(vert[0], pt[k+nv]);
+			COPY_COORD3(norm[0], pn[k+nv]);
+			lib_output_polypatch(3, vert, norm);
+		}
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void lib_output_polygon_torus (COORD3 center, COORD3 normal,
+							   double iradius, double oradius)
+#else
+							   void lib_output_polygon_torus(center, normal, iradius, oradius)
+							   COORD3 center, normal;
+double iradius, oradius;
+#endif
+{
+    MATRIX mx, imx;
+    int u_res, v_res;
+	
+    if ( lib_normalize_vector(normal) < EPSILON2) {
+		fprintf(stderr, "Bad torus normal\n");
+		exit(1);
+    }
+    lib_create_canonical_matrix(mx, imx, center, normal);
+    lib_lod_begin(center, iradius + oradius, iradius + oradius);
+    do {
+		/* u goes around the tube, v around the ring */
+		u_res = 4 * lib_tess_resolution(center, iradius + oradius, oradius,
+			gU_resolution);
+		v_res = 4 * lib_tess_resolution(center, iradius + oradius,
+			iradius + oradius, gV_resolution);
+		lib_tess_count(32L * gU_resolution * gV_resolution,
+			2L * u_res * v_res);
+		torus_polygons(imx, iradius, oradius, u_res, v_res);
+    } while (lib_lod_next());
+}
+/*-----------------------------------------------------------------*/
+/* Generate a box as a set of 4-sided polygons */
+#ifdef ANSI_FN_DEF
+void lib_output_polygon_box (COORD3 p1, COORD3 p2)
+#else
+void lib_output_polygon_box(p1, p2)
+COORD3 p1, p2;
+#endif
+{
+    COORD3 box_verts[4];
+	
+    /* Sides */
+    SET_COORD3(box_verts[0], p1[X], p1[Y], p1[Z]);
+    SET_COORD3(box_verts[1], p1[X], p1[Y], p2[Z]);
+    SET_COORD3(box_verts[2], p1[X], p2[Y], p2[Z]);
+    SET_COORD3(box_verts[3], p1[X], p2[Y], p1[Z]);
+    lib_output_polygon(4, box_verts);
+    SET_COORD3(box_verts[0], p2[X], p1[Y], p2[Z]);
+    SET_COORD3(box_verts[1], p2[X], p1[Y], p1[Z]);
+    SET_COORD3(box_verts[2], p2[X], p2[Y], p1[Z]);
+    SET_COORD3(box_verts[3], p2[X], p2[Y], p2[Z]);
+    lib_output_polygon(4, box_verts);
+	
+    /* Front/Back */
+    SET_COORD3(box_verts[0], p1[X], p1[Y], p1[Z]);
+    SET_COORD3(box_verts[3], p2[X], p1[Y], p1[Z]);
+    SET_COORD3(box_verts[2], p2[X], p2[Y], p1[Z]);
+    SET_COORD3(box_verts[1], p1[X], p2[Y], p1[Z]);
+    lib_output_polygon(4, box_verts);
+    SET_COORD3(box_verts[0], p2[X], p1[Y], p2[Z]);
+    SET_COORD3(box_verts[3], p1[X], p1[Y], p2[Z]);
+    SET_COORD3(box_verts[2], p1[X], p2[Y], p2[Z]);
+    SET_COORD3(box_verts[1], p2[X], p2[Y], p2[Z]);
+    lib_output_polygon(4, box_verts);
+	
+    /* Top/Bottom */
+    SET_COORD3(box_verts[0], p1[X], p1[Y], p1[Z]);
+    SET_COORD3(box_verts[3], p1[X], p1[Y], p2[Z]);
+    SET_COORD3(box_verts[2], p2[X], p1[Y], p2[Z]);
+    SET_COORD3(box_verts[1], p2[X], p1[Y], p1[Z]);
+    lib_output_polygon(4, box_verts);
+    SET_COORD3(box_verts[0], p2[X], p2[Y], p1[Z]);
+    SET_COORD3(box_verts[3], p2[X], p2[Y], p2[Z]);
+    SET_COORD3(box_verts[2], p1[X], p2[Y], p2[Z]);
+    SET_COORD3(box_verts[1], p1[X], p2[Y], p1[Z]);
+    lib_output_polygon(4, box_verts);
+}
+
+
+/*-----------------------------------------------------------------*/
+/* Save a batch of triangles onto an object list */
+#ifdef ANSI_FN_DEF
+static void store_triangles(int cnt, COORD3 **verts, COORD3 **norms,
+							object_ptr *list)
+#else
+static void store_triangles(cnt, verts, norms, list)
+int cnt;
+COORD3 **verts, **norms;
+object_ptr *list;
+#endif
+{
+    object_ptr new_object;
+    int i, t;
+	
+    for (t=0;t<cnt;t++) {
+		/* Save all the pertinent information */
+		new_object = (object_ptr)lib_arena_alloc(sizeof(struct object_struct));
+		if (new_object == NULL) return;
+		new_object->tx = NULL;
+		if (norms == NULL) {
+			new_object->object_type  = POLYGON_OBJ;
+			new_object->object_data.polygon.tot_vert = 3;
+			new_object->object_data.polygon.vert =
+				(STORE3 *)lib_arena_alloc(3 * sizeof(STORE3));
+			if (new_object->object_data.polygon.vert == NULL) return;
+		} else {
+			new_object->object_type  = POLYPATCH_OBJ;
+			new_object->object_data.polypatch.tot_vert = 3;
+			new_object->object_data.polypatch.vert =
+				(STORE3 *)lib_arena_alloc(3 * sizeof(STORE3));
+			if (new_object->object_data.polypatch.vert == NULL) return;
+			new_object->object_data.polypatch.norm =
+				(STORE3 *)lib_arena_alloc(3 * sizeof(STORE3));
+			if (new_object->object_data.polypatch.norm == NULL) return;
+		}
+		new_object->curve_format = OUTPUT_PATCHES;
+		new_object->surf_index   = gTexture_count;
+		for (i=0;i<3;i++) {
+			if (norms == NULL) {
+				STORE_COORD3(new_object->object_data.polygon.vert[i],
+					verts[t][i]);
+			} else {
+				STORE_COORD3(new_object->object_data.polypatch.vert[i],
+					verts[t][i]);
+				STORE_COORD3(new_object->object_data.polypatch.norm[i],
+					norms[t][i]);
+			}
+		}
+		new_object->next_object = *list;
+		*list = new_object;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Make room for "size" triangles in the triangle store.  The normal array
+ * is only grown once there is one.  Returns FALSE if out of memory.
+ */
+#ifdef ANSI_FN_DEF
+static int tri_store_grow(TRI_COUNT size)
+#else
+static int tri_store_grow(size)
+TRI_COUNT size;
+#endif
+{
+    STORE_REAL *vert, *norm;
+    unsigned char *patch;
+    unsigned int *surf_index;
+
+    vert = (STORE_REAL *)realloc(gTri_store.vert,
+		size * 9 * sizeof(STORE_REAL));
+    if (vert != NULL)
+		gTri_store.vert = vert;
+    norm = NULL;
+    if (gTri_store.norm != NULL) {
+		norm = (STORE_REAL *)realloc(gTri_store.norm,
+			size * 9 * sizeof(STORE_REAL));
+		if (norm != NULL)
+			gTri_store.norm = norm;
+    }
+    patch = (unsigned char *)realloc(gTri_store.patch, size);
+    if (patch != NULL)
+		gTri_store.patch = patch;
+    surf_index = (unsigned int *)realloc(gTri_store.surf_index,
+		size * sizeof(unsigned int));
+    if (surf_index != NULL)
+		gTri_store.surf_index = surf_index;
+    if ((vert == NULL) || ((gTri_store.norm != NULL) && (norm == NULL)) ||
+		(patch == NULL) || (surf_index == NULL))
+		return FALSE;
+    gTri_store.size = size;
+    return TRUE;
+}
+
+/*-----------------------------------------------------------------*/
+/* Add a batch of triangles to the end of the triangle store */
+#ifdef ANSI_FN_DEF
+static void tri_store_append(int cnt, COORD3 **verts, COORD3 **norms)
+#else
+static void tri_store_append(cnt, verts, norms)
+int cnt;
+COORD3 **verts, **norms;
+#endif
+{
+    TRI_COUNT n;
+    int i, t;
+
+    if (gTri_store.count + cnt > gTri_store.size) {
+		n = (gTri_store.size > 0) ? gTri_store.size : TRI_STORE_START_SIZE;
+		while (gTri_store.count + cnt > n)
+			n *= 2;
+		if (!tri_store_grow(n))
+			/* Quietly fail */
+			return;
+    }
+    if ((norms != NULL) && (gTri_store.norm == NULL)) {
+		gTri_store.norm = (STORE_REAL *)malloc(gTri_store.size * 9 *
+			sizeof(STORE_REAL));
+		if (gTri_store.norm == NULL)
+			/* Quietly fail */
+			return;
+    }
+
+    for (t=0;t<cnt;t++) {
+		n = gTri_store.count++;
+		for (i=0;i<3;i++) {
+			STORE_COORD3(TRI_VERT(gTri_store, n, i), verts[t][i]);
+			if (norms != NULL)
+				STORE_COORD3(TRI_NORM(gTri_store, n, i), norms[t][i]);
+		}
+		gTri_store.patch[n] = (unsigned char)(norms != NULL);
+		gTri_store.surf_index[n] = gTexture_count;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* Empty the triangle store and give back its memory */
+void
+lib_tri_store_free PARAMS((void))
+{
+    if (gTri_store.vert != NULL) free(gTri_store.vert);
+    if (gTri_store.norm != NULL) free(gTri_store.norm);
+    if (gTri_store.patch != NULL) free(gTri_store.patch);
+    if (gTri_store.surf_index != NULL) free(gTri_store.surf_index);
+    gTri_store.vert = NULL;
+    gTri_store.norm = NULL;
+    gTri_store.patch = NULL;
+    gTri_store.surf_index = NULL;
+    gTri_store.count = 0;
+    gTri_store.size = 0;
+}
+
+/*-----------------------------------------------------------------*/
+/* Give back the templates and the scratch storage used while making
+   polygons */
+void
+lib_polygon_storage_free PARAMS((void))
+{
+    template_ptr tmpl;
+
+    while (gTemplates != NULL) {
+		tmpl = gTemplates;
+		gTemplates = tmpl->next;
+		free(tmpl->vert);
+		free(tmpl->norm);
+		free(tmpl->flag);
+		free(tmpl);
+    }
+    if (gSplit_tri != NULL) {
+		free(gSplit_tri);
+		free(gSplit_vert);
+		free(gSplit_norm);
+		free(gSplit_vptr);
+		free(gSplit_nptr);
+		gSplit_tri = NULL;
+		gSplit_vert = gSplit_norm = NULL;
+		gSplit_vptr = gSplit_nptr = NULL;
+		gSplit_size = 0;
+    }
+    if (gVideo_vert != NULL) {
+		free(gVideo_vert);
+		gVideo_vert = NULL;
+		gVideo_size = 0;
+    }
+    if (gTess_vert != NULL) {
+		free(gTess_vert);
+		free(gTess_norm);
+		gTess_vert = gTess_norm = NULL;
+		gTess_size = 0;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Triangle writers for the output emitter tables in libemt.c.  Each gets
+ * the (transformed) triangles split from one polygon, and "pvert", the
+ * untransformed vertices of that polygon.  Norms is NULL if the polygon
+ * had no vertex normals.
+ */
+#ifdef ANSI_FN_DEF
+void emit_tri_delayed(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_delayed(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    store_triangles(cnt, verts, norms, &gLib_objects);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_plg(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_plg(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    /* We are currently in the process of turning objects into a stack of
+       polygons.  Since we don't want to put these polygons back onto the
+       original stack of objects, we put them into gTri_store */
+    tri_store_append(cnt, verts, norms);
+}
+
+
+/*-----------------------------------------------------------------*/
+/* Draw the outline of a polygon on the screen */
+#ifdef ANSI_FN_DEF
+static void video_polygon(int tot_vert, COORD3 *vert)
+#else
+static void video_polygon(tot_vert, vert)
+int tot_vert;
+COORD3 *vert;
+#endif
+{
+    COORD4 *tvert, v0, v1;
+    int i;
+
+    /* First make sure the display has been opened for drawing */
+    if (!gView_init_flag) {
+		lib_create_view_matrix(gViewpoint.tx, gViewpoint.from, gViewpoint.at,
+			gViewpoint.up, gViewpoint.resx, gViewpoint.resy,
+			gViewpoint.angle, gViewpoint.aspect);
+		display_init(gViewpoint.resx, gViewpoint.resy, gBkgnd_color);
+		gView_init_flag = 1;
+    }
+
+    /* Project all the vertices onto the screen at once */
+    if (gVideo_size < tot_vert) {
+		tvert = (COORD4 *)realloc(gVideo_vert, tot_vert * sizeof(COORD4));
+		if (tvert == NULL) {
+			fprintf(stderr, "Failed to allocate polygon data\n");
+			exit(1);
+		}
+		gVideo_vert = tvert;
+		gVideo_size = tot_vert;
+    }
+    tvert = gVideo_vert;
+    for (i=0;i<tot_vert;i++) {
+		COPY_COORD3(tvert[i], vert[i]);
+		tvert[i][W] = 1.0;
+    }
+    lib_transform_coords(tvert, tvert, (long)tot_vert, gViewpoint.tx);
+
+    /* Step through each segment of the polygon */
+    for (i=0;i<tot_vert;i++) {
+		COPY_COORD4(v0, tvert[i]);
+		COPY_COORD4(v1, tvert[(i+1)%tot_vert]);
+		/* Do the perspective transform on the points */
+		v0[X] /= v0[W]; v0[Y] /= v0[W];
+		v1[X] /= v1[W]; v1[Y] /= v1[W];
+		if (lib_clip_to_box(v0, v1, gView_bounds))
+			display_line((int)v0[X], (int)v0[Y],
+				(int)v1[X], (int)v1[Y], gFgnd_color);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_video(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_video(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int t;
+
+    for (t=0;t<cnt;t++)
+		video_polygon(3, verts[t]);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_nff(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_nff(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		if (norms == NULL) {
+			lib_printf("p 3\n");
+			for (i=0;i<3;++i) {
+				lib_printf("%g %g %g\n",
+					verts[t][i][X], verts[t][i][Y],
+					verts[t][i][Z]);
+			}
+		} else {
+			lib_printf("pp 3\n");
+			for (i=0;i<3;++i) {
+				lib_printf("%g %g %g %g %g %g\n",
+					verts[t][i][X], verts[t][i][Y],
+					verts[t][i][Z], norms[t][i][X],
+					norms[t][i][Y], norms[t][i][Z]);
+			}
+		}
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_pov(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_pov(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		tab_indent();
+		lib_printf("object {\n");
+		tab_inc();
+
+		tab_indent();
+		if (norms == NULL)
+			lib_printf("triangle {\n");
+		else
+			lib_printf("smooth_triangle {\n");
+		tab_inc();
+
+		for (i=0;i<3;++i) {
+			tab_indent();
+			if (gRT_out_format == OUTPUT_POVRAY_10) {
+				lib_printf("<%g %g %g>",
+					verts[t][i][X],
+					verts[t][i][Y],
+					verts[t][i][Z]);
+				if (norms != NULL)
+					lib_printf(" <%g %g %g>",
+					norms[t][i][X],
+					norms[t][i][Y],
+					norms[t][i][Z]);
+			} else {
+				lib_printf("<%g, %g, %g>",
+					verts[t][i][X],
+					verts[t][i][Y],
+					verts[t][i][Z]);
+				if (norms != NULL)
+					lib_printf(" <%g, %g, %g>",
+					norms[t][i][X],
+					norms[t][i][Y],
+					norms[t][i][Z]);
+				if (i < 2)
+					lib_printf(",");
+			}
+			lib_printf("\n");
+		} /*for*/
+
+		tab_dec();
+		tab_indent();
+		lib_printf("} // tri\n");
+
+		if (gTexture_name != NULL) {
+			tab_indent();
+			lib_printf("texture { %s }\n", gTexture_name);
+		}
+
+		tab_dec();
+		tab_indent();
+		lib_printf("} // object\n");
+
+		lib_printf("\n");
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_polyray(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_polyray(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		if (norms == NULL) {
+			tab_indent();
+			lib_printf("object { polygon 3,");
+			for (i=0;i<3;i++) {
+				lib_printf(" <%g, %g, %g>",
+					verts[t][i][X], verts[t][i][Y],
+					verts[t][i][Z]);
+				if (i < 2)
+					lib_printf(", ");
+			}
+		} else {
+			tab_indent();
+			lib_printf("object { patch ");
+			for (i=0;i<3;i++) {
+				lib_printf(" <%g, %g, %g>, <%g, %g, %g>",
+					verts[t][i][X], verts[t][i][Y],
+					verts[t][i][Z], norms[t][i][X],
+					norms[t][i][Y], norms[t][i][Z]);
+				if (i < 2)
+					lib_printf(", ");
+			}
+		}
+		if (gTexture_name != NULL)
+			lib_printf(" %s", gTexture_name);
+		lib_printf(" }\n");
+		lib_printf("\n");
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_vivid(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_vivid(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		if (norms == NULL) {
+			tab_indent();
+			lib_printf("polygon { points 3 ");
+			for (i=0;i<3;i++) {
+				lib_printf(" vertex %g %g %g ",
+					verts[t][i][X], verts[t][i][Y],
+					verts[t][i][Z]);
+			}
+		} else {
+			lib_printf("patch {");
+			for (i=0;i<3;++i) {
+				lib_printf(
+					" vertex %g %g %g  normal %g %g %g ",
+					verts[t][i][X], verts[t][i][Y],
+					verts[t][i][Z], norms[t][i][X],
+					norms[t][i][Y], norms[t][i][Z]);
+			}
+		}
+		lib_printf(" }\n");
+		lib_printf("\n");
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_qrt(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_qrt(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int t;
+
+    for (t=0;t<cnt;t++) {
+		/* Doesn't matter if there are vertex normals,
+		 * QRT can't use them.
+		 */
+		lib_printf("TRIANGLE ( ");
+		lib_printf("loc = (%g, %g, %g), ",
+			verts[t][0][X], verts[t][0][Y],
+			verts[t][0][Z]);
+		lib_printf("vect1 = (%g, %g, %g), ",
+			verts[t][1][X] - verts[t][0][X],
+			verts[t][1][Y] - verts[t][0][Y],
+			verts[t][1][Z] - verts[t][0][Z]);
+		lib_printf("vect2 = (%g, %g, %g) ",
+			verts[t][2][X] - verts[t][0][X],
+			verts[t][2][Y] - verts[t][0][Y],
+			verts[t][2][Z] - verts[t][0][Z]);
+		lib_printf(" );\n");
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_rayshade(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_rayshade(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		lib_printf("triangle ");
+		if (gTexture_name != NULL)
+			lib_printf("%s ", gTexture_name);
+		for (i=0;i<3;i++) {
+			lib_printf("%g %g %g ",
+				verts[t][i][X], verts[t][i][Y],
+				verts[t][i][Z]);
+			if (norms != NULL)
+				lib_printf("%g %g %g ",
+				norms[t][i][X], norms[t][i][Y],
+				norms[t][i][Z]);
+		}
+		lib_printf("\n");
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_art(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_art(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		tab_indent();
+		lib_printf("polygon {\n");
+		tab_inc();
+
+		tab_indent();
+		for (i=0;i<3;i++) {
+			tab_indent();
+			lib_printf("vertex(%f, %f, %f)",
+				verts[t][i][X], verts[t][i][Y],
+				verts[t][i][Z]);
+			if (norms != NULL)
+				lib_printf(", (%f, %f, %f)\n",
+				norms[t][i][X], norms[t][i][Y],
+				norms[t][i][Z]);
+			else
+				lib_printf("\n");
+		}
+		tab_dec();
+		tab_indent();
+		lib_printf("}\n");
+		lib_printf("\n");
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_rtrace(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_rtrace(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		if (norms == NULL) {
+			lib_printf("5 %d %g 0 0 0 1 1 1 -\n",
+				gTexture_count, gTexture_ior);
+			lib_printf("3 1 2 3\n\n");
+		} else {
+			lib_printf("6 %d %g 0 0 0 1 1 1 -\n",
+				gTexture_count, gTexture_ior);
+		}
+		for (i=0;i<3;i++) {
+			if (fabs(verts[t][i][X]) < 1.0e-10)
+				verts[t][i][X] = 0.0;
+			if (fabs(verts[t][i][Y]) < 1.0e-10)
+				verts[t][i][Y] = 0.0;
+			if (fabs(verts[t][i][Z]) < 1.0e-10)
+				verts[t][i][Z] = 0.0;
+			lib_printf("%g %g %g",
+				verts[t][i][X], verts[t][i][Y],
+				verts[t][i][Z]);
+			if (norms != NULL) {
+				if (fabs(norms[t][i][X]) < 1.0e-10)
+					norms[t][i][X] = 0.0;
+				if (fabs(norms[t][i][Y]) < 1.0e-10)
+					norms[t][i][Y] = 0.0;
+				if (fabs(norms[t][i][Z]) < 1.0e-10)
+					norms[t][i][Z] = 0.0;
+				lib_printf(" %g %g %g",
+					norms[t][i][X], norms[t][i][Y],
+					norms[t][i][Z]);
+			}
+			lib_printf("\n");
+		}
+		lib_printf("\n");
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tri_rawtri(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
+#else
+void emit_tri_rawtri(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
+#endif
+{
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		for (i=0;i<3;++i) {
+			lib_printf("%-10.5g %-10.5g %-10.5g  ",
+				verts[t][i][X], verts[t][i][Y],
+				verts[t][i][Z]);
+		}
+
+    #ifdef RAWTRI_WITH_TEXTURES
+		/* raw triangle format extension to do textured raw
+		 * triangles */
+		if (gTexture_name != NULL)
+			lib_printf("%s", gTexture_name);
+		else
+			/* for lack of a better name */
+			lib_printf("texNone");
+    #endif /* RAWTRI_WITH_TEXTURES */
+
+		lib_printf("\n");
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Write an OBJ vertex ("v") or normal ("vn") and return its index, counting
+ * from 1 as Wavefront does.  When welding, a vertex already in the pool is
+ * not written again and its earlier index is returned.
+ */
+#ifdef ANSI_FN_DEF
+static unsigned long obj_vertex(char *tag, COORD3 vert, weld_ptr *pool,
+								unsigned long *count)
+#else
+static unsigned long obj_vertex(tag, vert, pool, count)
+char *tag;
+COORD3 vert;
+weld_ptr *pool;
+unsigned long *count;
+#endif
+{
+    long index;
+    int is_new;
+
+    if (gWeld_tolerance > 0.0) {
+		if (*pool == NULL) {
+			*pool = lib_weld_create(gWeld_tolerance);
+			if (*pool == NULL) {
+				fprintf(stderr, "Error(obj_vertex): Can't allocate memory.\n");
+				exit(1);
+			}
+		}
+		index = lib_weld_vertex(*pool, vert, &is_new);
+		if (!is_new)
+			return (unsigned long)index + 1;
     }
+    lib_printf("%s %g %g %g\n", tag, vert[X], vert[Y], vert[Z]);
+    return ++(*count);
 }
 
 /*-----------------------------------------------------------------*/
 #ifdef ANSI_FN_DEF
-static void torus_evaluator(MATRIX trans,
-							double theta, double phi, double r0, double r1,
-							COORD3 vert, COORD3 norm)
+void emit_tri_obj(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
 #else
-							static void torus_evaluator(trans, theta, phi, r0, r1, vert, norm)
-							MATRIX trans;
-double theta, phi, r0, r1;
-COORD3 vert, norm;
+void emit_tri_obj(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
 #endif
 {
-    COORD3 v0, v1, tvert, tnorm;
-	
-    /* Compute the position of the point */
-    SET_COORD3(tvert, (r0 + r1 * sin(theta)) * cos(phi),
-		      (r0 + r1 * sin(theta)) * sin(phi),
-			  r1 * cos(theta));
-    /* Compute the normal at that point */
-    SET_COORD3(v0, r1*cos(theta)*cos(phi),
-		r1*cos(theta)*sin(phi),
-		-r1*sin(theta));
-    SET_COORD3(v1,-(r0+r1*sin(theta))*sin(phi),
-		(r0+r1*sin(theta))*cos(phi),
-		0.0);
-    CROSS(tnorm, v0, v1);
-    lib_normalize_vector(tnorm);
-    lib_transform_point(vert, tvert, trans);
-    lib_transform_vector(norm, tnorm, trans);
+    unsigned long vi[3], ni[3];
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		/* First the vertices */
+		for (i=0;i<3;++i)
+			vi[i] = obj_vertex("v", verts[t][i], &gWeld_verts,
+				&gVertex_count);
+		if (norms != NULL)
+			for (i=0;i<3;++i)
+				ni[i] = obj_vertex("vn", norms[t][i], &gWeld_norms,
+					&gNormal_count);
+
+		/* Welding can collapse a thin triangle, drop it */
+		if ((vi[0] == vi[1]) || (vi[1] == vi[2]) || (vi[2] == vi[0]))
+			continue;
+
+		/* Then the face - note that Wavefront vertices start at 1,
+		   not 0. */
+		if (norms == NULL)
+			lib_printf("f %ld %ld %ld\n", vi[0], vi[1], vi[2]);
+		else
+			lib_printf("f %ld//%ld %ld//%ld %ld//%ld\n",
+				vi[0], ni[0], vi[1], ni[1], vi[2], ni[2]);
+    }
 }
 
 /*-----------------------------------------------------------------*/
 #ifdef ANSI_FN_DEF
-void lib_output_polygon_torus (COORD3 center, COORD3 normal,
-							   double iradius, double oradius)
+void emit_tri_rwx(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
 #else
-							   void lib_output_polygon_torus(center, normal, iradius, oradius)
-							   COORD3 center, normal;
-double iradius, oradius;
+void emit_tri_rwx(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
 #endif
 {
-    double u, v, delta_u, delta_v;
-    MATRIX mx, imx;
-    int i, j;
-    COORD3 vert[4], norm[4];
-	
-    if ( lib_normalize_vector(normal) < EPSILON2) {
-		fprintf(stderr, "Bad torus normal\n");
-		exit(1);
-    }
-    lib_create_canonical_matrix(mx, imx, center, normal);
-    delta_u = 2.0 * PI / (double)(4*gU_resolution);
-    delta_v = 2.0 * PI / (double)(4*gV_resolution);
-	
-    /* Dump out polygons */
-    for (i=0,u=0.0;i<(4*gU_resolution);i++,u+=delta_u) {
-		PLATFORM_MULTITASK();
-		for (j=0,v=0.0;j<(4*gV_resolution);j++,v+=delta_v) {
-			torus_evaluator(imx, u, v, iradius, oradius, vert[2], norm[2]);
-			torus_evaluator(imx, u, v+delta_v, iradius, oradius,
-				vert[1], norm[1]);
-			torus_evaluator(imx, u+delta_u, v+delta_v,
-				iradius, oradius, vert[0], norm[0]);
-			lib_output_polypatch(3, vert, norm);
-			COPY_COORD3(vert[1], vert[0]);
-			COPY_COORD3(norm[1], norm[0]);
-			torus_evaluator(imx, u+delta_u, v, iradius, oradius,
-				vert[0], norm[0]);
-			lib_output_polypatch(3, vert, norm);
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		/* First the vertices */
+		for (i=0;i<3;++i) {
+			tab_indent();
+			lib_printf("Vertex %g %g %g",
+				verts[t][i][X], verts[t][i][Y],
+				verts[t][i][Z]);
+			if (norms != NULL)
+				lib_printf(" Normal %g %g %g\n",
+				norms[t][i][X], norms[t][i][Y],
+				norms[t][i][Z]);
+			else
+				lib_printf("\n");
 		}
+
+		/* Then the face */
+		tab_indent();
+		lib_printf("Triangle %ld %ld %ld\n",
+			gVertex_count+1, gVertex_count+2,
+			gVertex_count+3);
+		gVertex_count += 3;
     }
 }
+
 /*-----------------------------------------------------------------*/
-/* Generate a box as a set of 4-sided polygons */
 #ifdef ANSI_FN_DEF
-void lib_output_polygon_box (COORD3 p1, COORD3 p2)
+void emit_tri_rib(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
 #else
-void lib_output_polygon_box(p1, p2)
-COORD3 p1, p2;
+void emit_tri_rib(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
 #endif
 {
-    COORD3 box_verts[4];
-	
-    /* Sides */
-    SET_COORD3(box_verts[0], p1[X], p1[Y], p1[Z]);
-    SET_COORD3(box_verts[1], p1[X], p1[Y], p2[Z]);
-    SET_COORD3(box_verts[2], p1[X], p2[Y], p2[Z]);
-    SET_COORD3(box_verts[3], p1[X], p2[Y], p1[Z]);
-    lib_output_polygon(4, box_verts);
-    SET_COORD3(box_verts[0], p2[X], p1[Y], p2[Z]);
-    SET_COORD3(box_verts[1], p2[X], p1[Y], p1[Z]);
-    SET_COORD3(box_verts[2], p2[X], p2[Y], p1[Z]);
-    SET_COORD3(box_verts[3], p2[X], p2[Y], p2[Z]);
-    lib_output_polygon(4, box_verts);
-	
-    /* Front/Back */
-    SET_COORD3(box_verts[0], p1[X], p1[Y], p1[Z]);
-    SET_COORD3(box_verts[3], p2[X], p1[Y], p1[Z]);
-    SET_COORD3(box_verts[2], p2[X], p2[Y], p1[Z]);
-    SET_COORD3(box_verts[1], p1[X], p2[Y], p1[Z]);
-    lib_output_polygon(4, box_verts);
-    SET_COORD3(box_verts[0], p2[X], p1[Y], p2[Z]);
-    SET_COORD3(box_verts[3], p1[X], p1[Y], p2[Z]);
-    SET_COORD3(box_verts[2], p1[X], p2[Y], p2[Z]);
-    SET_COORD3(box_verts[1], p2[X], p2[Y], p2[Z]);
-    lib_output_polygon(4, box_verts);
-	
-    /* Top/Bottom */
-    SET_COORD3(box_verts[0], p1[X], p1[Y], p1[Z]);
-    SET_COORD3(box_verts[3], p1[X], p1[Y], p2[Z]);
-    SET_COORD3(box_verts[2], p2[X], p1[Y], p2[Z]);
-    SET_COORD3(box_verts[1], p2[X], p1[Y], p1[Z]);
-    lib_output_polygon(4, box_verts);
-    SET_COORD3(box_verts[0], p2[X], p2[Y], p1[Z]);
-    SET_COORD3(box_verts[3], p2[X], p2[Y], p2[Z]);
-    SET_COORD3(box_verts[2], p1[X], p2[Y], p2[Z]);
-    SET_COORD3(box_verts[1], p1[X], p2[Y], p1[Z]);
-    lib_output_polygon(4, box_verts);
-}
+    int i, t;
 
+    for (t=0;t<cnt;t++) {
+		/* The order of the vertices has to be inverted for the
+		   LH system */
+		tab_indent();
+		lib_printf("Polygon \"P\" [\n");
+		tab_inc();
+		for (i=2;i>=0;i--)
+		{
+			tab_indent();
+			lib_printf("%#g %#g %#g\n",
+				verts[t][i][X], verts[t][i][Y],
+				verts[t][i][Z]);
+		}
+		if (norms != NULL)
+		{
+			tab_dec();
+			tab_indent();
+			tab_inc();
+			lib_printf("]  \"N\" [\n");
+			for (i=2;i>=0;i--)
+			{
+				/* Normals are also inverted in LH */
+				tab_indent();
+				lib_printf("%#g %#g %#g\n",
+					-norms[t][i][X], -norms[t][i][Y],
+					-norms[t][i][Z]);
+			}
+		}
+		tab_dec();
+		tab_indent();
+		lib_printf("]\n");
+    }
+}
 
 /*-----------------------------------------------------------------*/
-/* Given a polygon defined by vertices in verts, determine which of the
-   components of the vertex correspond to useful x and y coordinates - with
-   these we can pretend the polygon is 2D to do our work on it. */
 #ifdef ANSI_FN_DEF
-static void find_axes(COORD3 *verts)
+void emit_tri_dxf(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
 #else
-static void find_axes(verts)
-COORD3 *verts;
+void emit_tri_dxf(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
 #endif
 {
-    double P1[3], P2[3], x, y, z;
-	
-    P1[0] = VERT(1, 0) - VERT(0, 0);
-    P1[1] = VERT(1, 1) - VERT(0, 1);
-    P1[2] = VERT(1, 2) - VERT(0, 2);
-	
-    P2[0] = VERT(2, 0) - VERT(0, 0);
-    P2[1] = VERT(2, 1) - VERT(0, 1);
-    P2[2] = VERT(2, 2) - VERT(0, 2);
-	
-    /* Cross product - don't need to normalize cause we're only interested
-	in the size of the components */
-    x = fabs(P1[1] * P2[2] - P1[2] * P2[1]);
-    y = fabs(P1[2] * P2[0] - P1[0] * P2[2]);
-    z = fabs(P1[0] * P2[1] - P1[1] * P2[0]);
-	
-    if (x > y && x > z) {
-		gPoly_Axis1 = 1;
-		gPoly_Axis2 = 2;
-    } else if (y > x && y > z) {
-		gPoly_Axis1 = 0;
-		gPoly_Axis2 = 2;
-    } else {
-		gPoly_Axis1 = 0;
-		gPoly_Axis2 = 1;
+    int i, ii, j, t;
+
+    for (t=0;t<cnt;t++) {
+		lib_printf("  0\n3DFACE\n  8\n0----\n" ) ;
+		for (i=0;i<4;++i) {
+			ii = (i == 3) ? 2 : i ;
+			for (j=0;j<3;++j) {
+				lib_printf(" %d%d\n%0.4f\n",j+1,i,
+					verts[t][ii][j] ) ;
+			}
+		}
     }
 }
 
 /*-----------------------------------------------------------------*/
-/* Find the left most vertex in the polygon that has vertices m ... n. */
 #ifdef ANSI_FN_DEF
-static int leftmost_vertex(int m, int n, COORD3 *verts)
+void emit_tri_3dmf(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
 #else
-static int leftmost_vertex(m, n, verts)
-int m, n;
-COORD3 *verts;
+void emit_tri_3dmf(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
 #endif
 {
-    int l, i;
-    double x;
-	
-    /* Assume the first vertex is the farthest to the left */
-    l = m;
-    x = VERT(m, gPoly_Axis1);
-	
-    /* Now see if any of the others are farther to the left */
-    for (i=m+1;i<=n;i++) {
-		if (VERT(i, gPoly_Axis1) < x) {
-			l = i;
-			x = VERT(i, gPoly_Axis1);
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		tab_indent();
+		lib_printf("Container (\n");
+		tab_inc();
+		tab_indent();
+		lib_printf("Triangle (");
+		for (i = 0; i < 3; i++) {
+			lib_printf(" %g %g %g",
+				pvert[i][X], pvert[i][Y], pvert[i][Z]);
+		}
+		lib_printf(" )\n");
+		/* Write out normal attributes */
+		tab_indent();
+		lib_printf("Container ( VertexAttributeSetList ( 3 Exclude 0 )\n");
+		tab_inc();
+		for (i = 0; i < 3; i++) {
+			tab_indent();
+			lib_printf("Container ( AttributeSet ( ) ");
+			lib_printf("Normal ( %g %g %g ) )\n",
+				norms[t][i][X], norms[t][i][Y],
+				norms[t][i][Z]);
 		}
+		tab_dec();
+		tab_indent();
+		lib_printf(")\n");
+		if (gTexture_count > 0) {
+			/* Write out texturing attributes */
+			lib_printf(" Reference ( %d ) ", gTexture_count);
+		}
+		tab_dec();
+		tab_indent();
+		lib_printf(")\n");
     }
-    return l;
 }
 
 /*-----------------------------------------------------------------*/
-/* Given the leftmost vertex in a polygon, this routine finds another vertex
-   can be used to safely split the polygon. */
 #ifdef ANSI_FN_DEF
-static int split_vertex(int l, int la, int lb, int m, int n, COORD3 *verts)
+void emit_tri_vrml1(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
 #else
-static int split_vertex(l, la, lb, m, n, verts)
-int l, la, lb, m, n;
-COORD3 *verts;
+void emit_tri_vrml1(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
 #endif
 {
-    int t, k, lpu, lpl;
-    double yu, yl;
-	
-    yu = MAX(VERT(l, gPoly_Axis2), MAX(VERT(la, gPoly_Axis2), VERT(lb, gPoly_Axis2)));
-    yl = MIN(VERT(l, gPoly_Axis2), MIN(VERT(la, gPoly_Axis2), VERT(lb, gPoly_Axis2)));
-    if (VERT(lb, gPoly_Axis2) > VERT(la, gPoly_Axis2)) {
-		lpu = lb;
-		lpl = la;
-    } else {
-		lpu = la;
-		lpl = lb;
-    }
-    t = (VERT(lb, gPoly_Axis1) > VERT(la, gPoly_Axis1) ? lb : la);
-    for (k=m;k<n;k++) {
-		if (k != la && k != l && k != lb) {
-			if (VERT(k, gPoly_Axis2) <= yu && VERT(k, gPoly_Axis2) >= yl) {
-				if (VERT(k, gPoly_Axis1) < VERT(t, gPoly_Axis1) &&
-					((VERT(k, gPoly_Axis2) - VERT(l, gPoly_Axis2)) *
-					(VERT(lpu, gPoly_Axis1) - VERT(l, gPoly_Axis1))) <=
-					((VERT(lpu, gPoly_Axis2) - VERT(l, gPoly_Axis2)) *
-					(VERT(k, gPoly_Axis1) - VERT(l, gPoly_Axis1)))) {
-					if (((VERT(k, gPoly_Axis2) - VERT(l, gPoly_Axis2)) *
-						(VERT(lpl, gPoly_Axis1) - VERT(l, gPoly_Axis1))) >=
-						((VERT(lpl, gPoly_Axis2) - VERT(l, gPoly_Axis2)) *
-						(VERT(k, gPoly_Axis1) - VERT(l, gPoly_Axis1)))) {
-						t = k;
-					}
-				}
+    int i, t;
+
+    for (t=0;t<cnt;t++) {
+		tab_indent();
+		lib_printf("Separator {\n");
+		tab_inc();
+
+		if (lib_tx_active()) {
+			tab_indent();
+			lib_printf("Transform {\n");
+			tab_inc();
+			lib_output_tx_sequence();
+			tab_dec();
+			tab_indent();
+			lib_printf("}\n");
+		}
+
+		tab_indent();
+		lib_printf("Coordinate3 { point [");
+		for (i = 0; i < 3; i++) {
+			lib_printf("%g %g %g",
+				pvert[i][X], pvert[i][Y], pvert[i][Z]);
+			if (i < 2)
+				lib_printf(", ");
+		}
+		lib_printf("] }\n");
+
+		/* Write out normal attributes */
+		if (norms != NULL) {
+			tab_indent();
+			lib_printf("Normal { vector [");
+			for (i = 0; i < 3; i++) {
+				lib_normalize_vector(norms[t][i]);
+				lib_printf(" %g %g %g",
+					norms[t][i][X], norms[t][i][Y],
+					norms[t][i][Z]);
+				if (i < 2)
+					lib_printf(", ");
 			}
+			lib_printf("] }\n");
 		}
+
+		tab_indent();
+		lib_printf("IndexedFaceSet {\n");
+		tab_inc();
+		tab_indent();
+		lib_printf("coordIndex [0, 1, 2]\n");
+		tab_indent();
+		lib_printf("normalIndex [0, 1, 2]\n");
+		tab_dec();
+		tab_indent();
+		lib_printf("}\n");
+
+		tab_dec();
+		tab_indent();
+		lib_printf("}\n");
     }
-    return t;
 }
 
 /*-----------------------------------------------------------------*/
-/* Test polygon vertices to see if they are linear */
 #ifdef ANSI_FN_DEF
-static int linear_vertices(int m, int n, COORD3 *verts)
+void emit_tri_vrml2(int cnt, COORD3 **verts, COORD3 **norms, COORD3 *pvert)
 #else
-static int linear_vertices(m, n, verts)
-int m, n;
-COORD3 *verts;
+void emit_tri_vrml2(cnt, verts, norms, pvert)
+int cnt;
+COORD3 **verts, **norms, *pvert;
 #endif
 {
-#if defined (applec)
-#pragma unused (m,n,verts)
-#endif /* applec */
-    /* Not doing anything right now */
-    return 0;
-}
+    int i, t;
 
-/*-----------------------------------------------------------------*/
-/* Shift vertex indices around to make two polygons out of one. */
-#ifdef ANSI_FN_DEF
-static void perform_split(int m, int m1, int n, int n1)
-#else
-static void perform_split(m, m1, n, n1)
-int n, n1, m, m1;
-#endif
-{
-    int i, j, k;
-	
-    k = n + 3 - m;
-    /* Move the new polygon up over the place the current one sits */
-    for (j=m1;j<=n1;j++) gPoly_vbuffer[j+k] = gPoly_vbuffer[j];
-	
-    /* Move top part of remaining polygon */
-    for (j=n;j>=n1;j--) gPoly_vbuffer[j+2] = gPoly_vbuffer[j];
-	
-    /* Move bottom part of remaining polygon */
-    k = n1 - m1 + 1;
-    for (j=m1;j>=m;j--) gPoly_vbuffer[j+k] = gPoly_vbuffer[j];
-	
-    /* Copy the new polygon so that it sits before the remaining polygon */
-    i = n + 3 - m;
-    k = m - m1;
-    for (j=m1;j<=n1;j++) gPoly_vbuffer[j+k] = gPoly_vbuffer[j+i];
+    for (t=0;t<cnt;t++) {
+		if (lib_tx_active()) {
+			lib_printf("Transform {\n");
+			tab_inc();
+			lib_output_tx_sequence();
+			tab_indent();
+			lib_printf("children [\n");
+			tab_inc();
+		}
+
+		tab_indent();
+		lib_printf("Shape {\n");
+		tab_inc();
+		tab_indent();
+		lib_printf("geometry IndexedFaceSet {\n");
+		tab_inc();
+		tab_indent();
+		lib_printf("coordIndex [0, 1, 2]\n");
+		tab_indent();
+		lib_printf("coord Coordinate { point [");
+		for (i = 0; i < 3; i++) {
+			lib_printf("%g %g %g",
+				pvert[i][X], pvert[i][Y], pvert[i][Z]);
+			if (i < 2)
+				lib_printf(", ");
+		}
+		lib_printf("] }\n");
+		/* Write out normal attributes */
+		if (norms != NULL) {
+			tab_indent();
+			lib_printf("normal Normal { vector [");
+			for (i = 0; i < 3; i++) {
+				lib_normalize_vector(norms[t][i]);
+				lib_printf(" %g %g %g",
+					norms[t][i][X], norms[t][i][Y],
+					norms[t][i][Z]);
+				if (i < 2)
+					lib_printf(", ");
+			}
+			lib_printf("] }\n");
+		}
+		tab_dec();
+		tab_indent();
+		lib_printf("}\n");
+		if (gTexture_name != NULL) {
+			/* Write out texturing attributes */
+			tab_indent();
+			lib_printf("appearance Appearance { material %s {} }\n",
+				gTexture_name);
+		}
+		tab_dec();
+		tab_indent();
+		lib_printf("}\n");
+
+		if (lib_tx_active()) {
+			tab_dec();
+			tab_indent();
+			lib_printf("] }\n");
+			tab_dec();
+		}
+    }
 }
 
 /*-----------------------------------------------------------------*/
-/* Copy an indirectly referenced triangle into the output triangle buffer */
+/*
+ * Make room for "cnt" triangles in the split scratch storage.  It only
+ * grows, so once it is big enough splitting allocates nothing.
+ */
 #ifdef ANSI_FN_DEF
-static void add_new_triangle(int m, COORD3 *verts, COORD3 *norms,
-							 int *out_cnt, COORD3 **out_verts, COORD3 **out_norms)
+static void split_scratch(int cnt)
 #else
-							 static void add_new_triangle(m, verts, norms, out_cnt, out_verts, out_norms)
-							 int m, *out_cnt;
-COORD3 *verts, *norms, **out_verts, **out_norms;
+static void split_scratch(cnt)
+int cnt;
 #endif
 {
-    if (out_verts != NULL) {
-		COPY_COORD3(out_verts[*out_cnt][0], verts[gPoly_vbuffer[m]]);
-		COPY_COORD3(out_verts[*out_cnt][1], verts[gPoly_vbuffer[m+1]]);
-		COPY_COORD3(out_verts[*out_cnt][2], verts[gPoly_vbuffer[m+2]]);
+    int size, t;
+
+    if (cnt <= gSplit_size)
+		return;
+    size = (gSplit_size > 0) ? gSplit_size : SPLIT_START_SIZE;
+    while (size < cnt)
+		size *= 2;
+
+    if (gSplit_tri != NULL) {
+		free(gSplit_tri);
+		free(gSplit_vert);
+		free(gSplit_norm);
+		free(gSplit_vptr);
+		free(gSplit_nptr);
     }
-    if (out_norms != NULL) {
-		COPY_COORD3(out_norms[*out_cnt][0], norms[gPoly_vbuffer[m]]);
-		COPY_COORD3(out_norms[*out_cnt][1], norms[gPoly_vbuffer[m+1]]);
-		COPY_COORD3(out_norms[*out_cnt][2], norms[gPoly_vbuffer[m+2]]);
+    gSplit_tri = (int *)malloc(3 * size * sizeof(int));
+    gSplit_vert = (COORD3 *)malloc(3 * size * sizeof(COORD3));
+    gSplit_norm = (COORD3 *)malloc(3 * size * sizeof(COORD3));
+    gSplit_vptr = (COORD3 **)malloc(size * sizeof(COORD3 *));
+    gSplit_nptr = (COORD3 **)malloc(size * sizeof(COORD3 *));
+    gSplit_allocs += 5;
+    if ((gSplit_tri == NULL) || (gSplit_vert == NULL) ||
+		(gSplit_norm == NULL) || (gSplit_vptr == NULL) ||
+		(gSplit_nptr == NULL)) {
+		fprintf(stderr, "Failed to allocate polygon data\n");
+		exit(1);
     }
-    *out_cnt += 1;
+    for (t=0;t<size;t++) {
+		gSplit_vptr[t] = &gSplit_vert[3*t];
+		gSplit_nptr[t] = &gSplit_norm[3*t];
+    }
+    gSplit_size = size;
 }
 
 /*-----------------------------------------------------------------*/
+/*
+ * TRUE if the quadrilateral turns the same way, and not straight, at each
+ * corner.
+ */
 #ifdef ANSI_FN_DEF
-static void split_buffered_polygon(int cnt, COORD3 *verts, COORD3 *norms,
-								   int *out_cnt, COORD3 **out_verts, COORD3 **out_norms)
+static int convex_quad(COORD3 *vert)
 #else
-								   static void split_buffered_polygon(cnt, verts, norms, out_cnt, out_verts, out_norms)
-								   int cnt, *out_cnt;
-COORD3 *verts, *norms, **out_verts, **out_norms;
+static int convex_quad(vert)
+COORD3 *vert;
 #endif
 {
-    int i, m, m1, n, n1;
-    int l, la, lb, ls;
-	
-    /* No triangles to start with */
-    *out_cnt = 0;
-	
-    /* Initialize the polygon splitter */
-    gPoly_end[0] = -1;
-    gPoly_end[1] = cnt-1;
-	
-    /* Split and push polygons until they turn into triangles */
-    for (i=1;i>0;) {
-		m = gPoly_end[i-1] + 1;
-		n = gPoly_end[i];
-		if (n - m == 2) {
-			if (!linear_vertices(m, n, verts)) {
-				add_new_triangle(m, verts, norms, out_cnt,
-					out_verts, out_norms);
-			}
-			i = i - 1;
-		} else {
-			l = leftmost_vertex(m, n, verts);
-			la = (l == n ? m : l + 1);
-			lb = (l == m ? n : l - 1);
-			ls = split_vertex(l, la, lb, m, n, verts);
-			if (ls == la || ls == lb) {
-				m1 = (la < lb ? la : lb);
-				n1 = (la > lb ? la : lb);
-			} else {
-				m1 = (l < ls ? l : ls);
-				n1 = (l > ls ? l : ls);
-			}
-			perform_split(m, m1, n, n1);
-			gPoly_end[i++] = m + n1 - m1;
-			gPoly_end[i] = n + 2;
-		}
+    COORD3 e0, e1, c0, c;
+    int i;
+
+    SUB3_COORD3(e0, vert[0], vert[3]);
+    SUB3_COORD3(e1, vert[1], vert[0]);
+    CROSS(c0, e0, e1);
+    if (DOT_PRODUCT(c0, c0) == 0.0)
+		return FALSE;
+    for (i=1;i<4;i++) {
+		COPY_COORD3(e0, e1);
+		SUB3_COORD3(e1, vert[(i+1)&3], vert[i]);
+		CROSS(c, e0, e1);
+		if (DOT_PRODUCT(c, c0) <= 0.0)
+			return FALSE;
     }
+    return TRUE;
 }
 
 /*-----------------------------------------------------------------*/
 /*
- * Split an arbitrary polygon into triangles.
+ * Split an arbitrary polygon into triangles.  Triangles and convex quads
+ * are handled in local storage; anything else goes to the triangulator
+ * and the split scratch storage.
  */
 #ifdef ANSI_FN_DEF
 static void split_polygon(int n, COORD3 *vert, COORD3 *norm)
@@ -681,647 +2126,61 @@ int n;
 COORD3 *vert, *norm;
 #endif
 {
-    COORD4 tvert[3], v0, v1;
+    static int quad_tri[6] = { 0, 1, 2, 0, 2, 3 };
+    COORD3 tvert[6], tnorm[6], *vptr[2], *nptr[2];
     COORD3 **out_verts, **out_norms;
     MATRIX nmx, txmat;
-    int i, ii, j ;
-    int t, out_n;
-    object_ptr new_object;
+    int i, t, out_n, *tri;
 	
     /* Can't split a NULL vertex list */
     if (vert == NULL) return;
-    if (gPoly_vbuffer == NULL) { /* [esp] Added error */
-		lib_storage_initialize();
-		/* [are] removed error, go and initialize if it hasn't been done. */
-    }
+    if (n < 3) return;
 	
-    /* Allocate space to hold the intermediate polygon stacks */
-    out_verts = (COORD3 **)malloc((n - 2) * sizeof(COORD3 *));
-    if (norm != NULL)
-		out_norms = (COORD3 **)malloc((n - 2) * sizeof(COORD3 *));
-    else
-		out_norms = NULL;
-
-    for (i=0;i<n-2;i++) {
-		out_verts[i] = (COORD3 *)malloc(3 * sizeof(COORD3));
-		if (norm != NULL)
-			out_norms[i] = (COORD3 *)malloc(3 * sizeof(COORD3));
+    if ((n == 3) || ((n == 4) && convex_quad(vert))) {
+		/* A triangle with a repeated vertex has nothing to show */
+		if ((n == 3) &&
+			(SAME_COORD3(vert[0], vert[1]) || SAME_COORD3(vert[1], vert[2]) ||
+			SAME_COORD3(vert[2], vert[0])))
+			return;
+		out_n = n - 2;
+		tri = quad_tri;
+		vptr[0] = &tvert[0];
+		vptr[1] = &tvert[3];
+		nptr[0] = &tnorm[0];
+		nptr[1] = &tnorm[3];
+		out_verts = vptr;
+		out_norms = (norm != NULL) ? nptr : (COORD3 **)NULL;
+    } else {
+		split_scratch(n - 2);
+		tri = gSplit_tri;
+		out_n = lib_triangulate_polygon(n, vert, tri);
+		out_verts = gSplit_vptr;
+		out_norms = (norm != NULL) ? gSplit_nptr : (COORD3 **)NULL;
     }
-	
-    /* Start with a strict identity of vertices in verts and vertices in
-	the polygon buffer */
-    for (i=0;i<n;i++) gPoly_vbuffer[i] = i;
-	
-    /* Make sure we know which axes to look at */
-    find_axes(vert);
-	
-    out_n = 0;
-    split_buffered_polygon(n, vert, norm, &out_n, out_verts, out_norms);
+    for (t=0;t<out_n;t++) {
+		for (i=0;i<3;i++) {
+			COPY_COORD3(out_verts[t][i], vert[tri[3*t+i]]);
+			if (norm != NULL)
+				COPY_COORD3(out_norms[t][i], norm[tri[3*t+i]]);
+		}
+    }
+    gSplit_polygons++;
+    gSplit_triangles += out_n;
 	
     if (lib_tx_active()) {
 	/* Perform transformations of the vertices and normals of
 		the polygon(s) */
 		lib_get_current_tx(txmat);
-		lib_invert_matrix(nmx, txmat);
-		for (t=0;t<out_n;t++)
-			for (i=0;i<3;i++) {
-				lib_transform_point(out_verts[t][i], out_verts[t][i], txmat);
-				if (out_norms != NULL)
-					lib_transform_normal(out_norms[t][i], out_norms[t][i], nmx);
-			}
+		lib_get_current_normal_tx(nmx);
+		lib_transform_points(out_verts[0], out_verts[0], 3L * out_n, txmat);
+		if (out_norms != NULL)
+			lib_transform_normals(out_norms[0], out_norms[0], 3L * out_n,
+				nmx);
     }
 	
     /* Now output the triangles that we generated */
-    for (t=0;t<out_n;t++) {
-		PLATFORM_MULTITASK();
-		if (gRT_out_format == OUTPUT_DELAYED ||
-			gRT_out_format == OUTPUT_PLG) {
-			/* Save all the pertinent information */
-			new_object = (object_ptr)malloc(sizeof(struct object_struct));
-			if (new_object == NULL) return;
-			new_object->tx = NULL;
-			if (norm == NULL) {
-				new_object->object_type  = POLYGON_OBJ;
-				new_object->object_data.polygon.tot_vert = 3;
-				new_object->object_data.polygon.vert =
-					(COORD3 *)malloc(3 * sizeof(COORD3));
-				if (new_object->object_data.polygon.vert == NULL) return;
-			} else {
-				new_object->object_type  = POLYPATCH_OBJ;
-				new_object->object_data.polypatch.tot_vert = 3;
-				new_object->object_data.polypatch.vert =
-					(COORD3 *)malloc(3 * sizeof(COORD3));
-				if (new_object->object_data.polypatch.vert == NULL) return;
-				new_object->object_data.polypatch.norm =
-					(COORD3 *)malloc(3 * sizeof(COORD3));
-				if (new_object->object_data.polypatch.norm == NULL) return;
-			}
-			new_object->curve_format = OUTPUT_PATCHES;
-			new_object->surf_index   = gTexture_count;
-			for (i=0;i<3;i++) {
-				if (norm == NULL) {
-					COPY_COORD3(new_object->object_data.polygon.vert[i],
-						out_verts[t][i]);
-				} else {
-					COPY_COORD3(new_object->object_data.polypatch.vert[i],
-						out_verts[t][i]);
-					COPY_COORD3(new_object->object_data.polypatch.norm[i],
-						out_norms[t][i]);
-				}
-			}
-			if (gRT_out_format == OUTPUT_PLG) {
-				/* We are currently in the process of turning objects
-				   into a stack of polygons.  Since we don't want to
-				   put these polygons back onto the original stack of
-				   objects, we put them into gPolygon_stack
-				 */
-				new_object->next_object = gPolygon_stack;
-				gPolygon_stack = new_object;
-			}
-			else {
-				new_object->next_object = gLib_objects;
-				gLib_objects = new_object;
-			}
-		} else {
-			switch (gRT_out_format) {
-			case OUTPUT_VIDEO:
-				/* First make sure the display has been opened for
-				 * drawing
-				 */
-				if (!gView_init_flag) {
-					lib_create_view_matrix(gViewpoint.tx, gViewpoint.from, gViewpoint.at,
-						gViewpoint.up, gViewpoint.resx, gViewpoint.resy,
-						gViewpoint.angle, gViewpoint.aspect);
-					display_init(gViewpoint.resx, gViewpoint.resy, gBkgnd_color);
-					gView_init_flag = 1;
-				}
-				/* Step through each segment of the polygon, projecting it
-				   onto the screen. */
-				for (i=0;i<3;i++) {
-					COPY_COORD3(tvert[0], out_verts[t][i]);
-					tvert[0][W] = 1.0;
-					lib_transform_coord(v0, tvert[0], gViewpoint.tx);
-					COPY_COORD3(tvert[1], out_verts[t][(i+1)%3]);
-					tvert[1][W] = 1.0;
-					lib_transform_coord(v1, tvert[1], gViewpoint.tx);
-					/* Do the perspective transform on the points */
-					v0[X] /= v0[W]; v0[Y] /= v0[W];
-					v1[X] /= v1[W]; v1[Y] /= v1[W];
-					if (lib_clip_to_box(v0, v1, gView_bounds))
-						display_line((int)v0[X], (int)v0[Y],
-						(int)v1[X], (int)v1[Y], gFgnd_color);
-				}
-				break;
-				
-			case OUTPUT_NFF:
-				if (norm == NULL) {
-					fprintf(gOutfile, "p 3\n");
-					for (i=0;i<3;++i) {
-						fprintf(gOutfile, "%g %g %g\n",
-							out_verts[t][i][X], out_verts[t][i][Y],
-							out_verts[t][i][Z]);
-					}
-				} else {
-					fprintf(gOutfile, "pp 3\n");
-					for (i=0;i<3;++i) {
-						fprintf(gOutfile, "%g %g %g %g %g %g\n",
-							out_verts[t][i][X], out_verts[t][i][Y],
-							out_verts[t][i][Z], out_norms[t][i][X],
-							out_norms[t][i][Y], out_norms[t][i][Z]);
-					}
-				}
-				break;
-				
-			case OUTPUT_POVRAY_10:
-			case OUTPUT_POVRAY_20:
-			case OUTPUT_POVRAY_30:
-				tab_indent();
-				fprintf(gOutfile, "object {\n");
-				tab_inc();
-				
-				tab_indent();
-				if (norm == NULL)
-					fprintf(gOutfile, "triangle {\n");
-				else
-					fprintf(gOutfile, "smooth_triangle {\n");
-				tab_inc();
-				
-				for (i=0;i<3;++i) {
-					tab_indent();
-					if (gRT_out_format == OUTPUT_POVRAY_10) {
-						fprintf(gOutfile, "<%g %g %g>",
-							out_verts[t][i][X],
-							out_verts[t][i][Y],
-							out_verts[t][i][Z]);
-						if (norm != NULL)
-							fprintf(gOutfile, " <%g %g %g>",
-							out_norms[t][i][X],
-							out_norms[t][i][Y],
-							out_norms[t][i][Z]);
-					} else {
-						fprintf(gOutfile, "<%g, %g, %g>",
-							out_verts[t][i][X],
-							out_verts[t][i][Y],
-							out_verts[t][i][Z]);
-						if (norm != NULL)
-							fprintf(gOutfile, " <%g, %g, %g>",
-							out_norms[t][i][X],
-							out_norms[t][i][Y],
-							out_norms[t][i][Z]);
-						if (i < 2)
-							fprintf(gOutfile, ",");
-					}
-					fprintf(gOutfile, "\n");
-				} /*for*/
-				
-				tab_dec();
-				tab_indent();
-				fprintf(gOutfile, "} // tri\n");
-				
-				if (gTexture_name != NULL) {
-					tab_indent();
-					fprintf(gOutfile, "texture { %s }\n", gTexture_name);
-				}
-				
-				tab_dec();
-				tab_indent();
-				fprintf(gOutfile, "} // object\n");
-				
-				fprintf(gOutfile, "\n");
-				break;
-				
-			case OUTPUT_POLYRAY:
-				if (norm == NULL) {
-					tab_indent();
-					fprintf(gOutfile, "object { polygon 3,");
-					for (i=0;i<3;i++) {
-						fprintf(gOutfile, " <%g, %g, %g>",
-							out_verts[t][i][X], out_verts[t][i][Y],
-							out_verts[t][i][Z]);
-						if (i < 2)
-							fprintf(gOutfile, ", ");
-					}
-				} else {
-					tab_indent();
-					fprintf(gOutfile, "object { patch ");
-					for (i=0;i<3;i++) {
-						fprintf(gOutfile, " <%g, %g, %g>, <%g, %g, %g>",
-							out_verts[t][i][X], out_verts[t][i][Y],
-							out_verts[t][i][Z], out_norms[t][i][X],
-							out_norms[t][i][Y], out_norms[t][i][Z]);
-						if (i < 2)
-							fprintf(gOutfile, ", ");
-					}
-				}
-				if (gTexture_name != NULL)
-					fprintf(gOutfile, " %s", gTexture_name);
-				fprintf(gOutfile, " }\n");
-				fprintf(gOutfile, "\n");
-				break;
-				
-			case OUTPUT_VIVID:
-				if (norm == NULL) {
-					tab_indent();
-					fprintf(gOutfile, "polygon { points 3 ");
-					for (i=0;i<3;i++) {
-						fprintf(gOutfile, " vertex %g %g %g ",
-							out_verts[t][i][X], out_verts[t][i][Y],
-							out_verts[t][i][Z]);
-					}
-				} else {
-					fprintf(gOutfile, "patch {");
-					for (i=0;i<3;++i) {
-						fprintf(gOutfile,
-							" vertex %g %g %g  normal %g %g %g ",
-							out_verts[t][i][X], out_verts[t][i][Y],
-							out_verts[t][i][Z], out_norms[t][i][X],
-							out_norms[t][i][Y], out_norms[t][i][Z]);
-					}
-				}
-				fprintf(gOutfile, " }\n");
-				fprintf(gOutfile, "\n");
-				break;
-				
-			case OUTPUT_QRT:
-				/* Doesn't matter if there are vertex normals,
-				 * QRT can't use them.
-				 */
-				fprintf(gOutfile, "TRIANGLE ( ");
-				fprintf(gOutfile, "loc = (%g, %g, %g), ",
-					out_verts[t][0][X], out_verts[t][0][Y],
-					out_verts[t][0][Z]);
-				fprintf(gOutfile, "vect1 = (%g, %g, %g), ",
-					out_verts[t][1][X] - out_verts[t][0][X],
-					out_verts[t][1][Y] - out_verts[t][0][Y],
-					out_verts[t][1][Z] - out_verts[t][0][Z]);
-				fprintf(gOutfile, "vect2 = (%g, %g, %g) ",
-					out_verts[t][2][X] - out_verts[t][0][X],
-					out_verts[t][2][Y] - out_verts[t][0][Y],
-					out_verts[t][2][Z] - out_verts[t][0][Z]);
-				fprintf(gOutfile, " );\n");
-				break;
-				
-			case OUTPUT_RAYSHADE:
-				fprintf(gOutfile, "triangle ");
-				if (gTexture_name != NULL)
-					fprintf(gOutfile, "%s ", gTexture_name);
-				for (i=0;i<3;i++) {
-					fprintf(gOutfile, "%g %g %g ",
-						out_verts[t][i][X], out_verts[t][i][Y],
-						out_verts[t][i][Z]);
-					if (norm != NULL)
-						fprintf(gOutfile, "%g %g %g ",
-						out_norms[t][i][X], out_norms[t][i][Y],
-						out_norms[t][i][Z]);
-				}
-				fprintf(gOutfile, "\n");
-				break;
-				
-			case OUTPUT_ART:
-				tab_indent();
-				fprintf(gOutfile, "polygon {\n");
-				tab_inc();
-				
-				tab_indent();
-				for (i=0;i<3;i++) {
-					tab_indent();
-					fprintf(gOutfile, "vertex(%f, %f, %f)",
-						out_verts[t][i][X], out_verts[t][i][Y],
-						out_verts[t][i][Z]);
-					if (norm != NULL)
-						fprintf(gOutfile, ", (%f, %f, %f)\n",
-						out_norms[t][i][X], out_norms[t][i][Y],
-						out_norms[t][i][Z]);
-					else
-						fprintf(gOutfile, "\n");
-				}
-				tab_dec();
-				tab_indent();
-				fprintf(gOutfile, "}\n");
-				fprintf(gOutfile, "\n");
-				break;
-				
-			case OUTPUT_RTRACE:
-				if (norm == NULL) {
-					fprintf(gOutfile, "5 %d %g 0 0 0 1 1 1 -\n",
-						gTexture_count, gTexture_ior);
-					fprintf(gOutfile, "3 1 2 3\n\n");
-				} else {
-					fprintf(gOutfile, "6 %d %g 0 0 0 1 1 1 -\n",
-						gTexture_count, gTexture_ior);
-				}
-				for (i=0;i<3;i++) {
-					if (fabs(out_verts[t][i][X]) < 1.0e-10)
-						out_verts[t][i][X] = 0.0;
-					if (fabs(out_verts[t][i][Y]) < 1.0e-10)
-						out_verts[t][i][Y] = 0.0;
-					if (fabs(out_verts[t][i][Z]) < 1.0e-10)
-						out_verts[t][i][Z] = 0.0;
-					fprintf(gOutfile, "%g %g %g",
-						out_verts[t][i][X], out_verts[t][i][Y],
-						out_verts[t][i][Z]);
-					if (norm != NULL) {
-						if (fabs(out_norms[t][i][X]) < 1.0e-10)
-							out_norms[t][i][X] = 0.0;
-						if (fabs(out_norms[t][i][Y]) < 1.0e-10)
-							out_norms[t][i][Y] = 0.0;
-						if (fabs(out_norms[t][i][Z]) < 1.0e-10)
-							out_norms[t][i][Z] = 0.0;
-						fprintf(gOutfile, " %g %g %g",
-							out_norms[t][i][X], out_norms[t][i][Y],
-							out_norms[t][i][Z]);
-					}
-					fprintf(gOutfile, "\n");
-				}
-				fprintf(gOutfile, "\n");
-				break;
-				
-			case OUTPUT_RAWTRI:
-				for (i=0;i<3;++i) {
-					fprintf(gOutfile, "%-10.5g %-10.5g %-10.5g  ",
-						out_verts[t][i][X], out_verts[t][i][Y],
-						out_verts[t][i][Z]);
-				}
-				
-#ifdef RAWTRI_WITH_TEXTURES
-				/* raw triangle format extension to do textured raw
-				 * triangles */
-				if (gTexture_name != NULL)
-					fprintf(gOutfile, "%s", gTexture_name);
-				else
-					/* for lack of a better name */
-					fprintf(gOutfile, "texNone");
-#endif /* RAWTRI_WITH_TEXTURES */
-				
-				fprintf(gOutfile, "\n");
-				break;
-				
-			case OUTPUT_OBJ:
-				/* First the vertices */
-				for (i=0;i<3;++i)
-					fprintf(gOutfile, "v %g %g %g\n",
-					out_verts[t][i][X], out_verts[t][i][Y],
-					out_verts[t][i][Z]);
-				if (norm != NULL)
-					for (i=0;i<3;++i)
-						fprintf(gOutfile, "vn %g %g %g\n",
-						out_norms[t][i][X], out_norms[t][i][Y],
-						out_norms[t][i][Z]);
-
-					/* Then the face - note that we add one to the count
-					   since Wavefront vertices start at 1, not 0. */
-					if (norm == NULL) {
-						fprintf(gOutfile, "f %ld %ld %ld\n",
-							gVertex_count+1, gVertex_count+2,
-							gVertex_count+3);
-						gVertex_count += 3;
-					}
-					else {
-						fprintf(gOutfile, "f %ld//%ld %ld//%ld %ld//%ld\n",
-							gVertex_count+1, gNormal_count+1,
-							gVertex_count+2, gNormal_count+2,
-							gVertex_count+3, gNormal_count+3);
-						gVertex_count += 3;
-						gNormal_count += 3;
-					}
-					break;
-					
-			case OUTPUT_RWX:
-				/* First the vertices */
-				for (i=0;i<3;++i) {
-					tab_indent();
-					fprintf(gOutfile, "Vertex %g %g %g",
-						out_verts[t][i][X], out_verts[t][i][Y],
-						out_verts[t][i][Z]);
-					if (norm != NULL)
-						fprintf(gOutfile, " Normal %g %g %g\n",
-						out_norms[t][i][X], out_norms[t][i][Y],
-						out_norms[t][i][Z]);
-					else
-						fprintf(gOutfile, "\n");
-				}
-				
-				/* Then the face */
-				tab_indent();
-				fprintf(gOutfile, "Triangle %ld %ld %ld\n",
-					gVertex_count+1, gVertex_count+2,
-					gVertex_count+3);
-				gVertex_count += 3;
-				break;
-				
-			case OUTPUT_RIB:
-				/* The order of the vertices has to be inverted for the
-				   LH system */
-				tab_indent();
-				fprintf(gOutfile, "Polygon \"P\" [\n");
-				tab_inc();
-				for (i=2;i>=0;i--)
-				{
-					tab_indent();
-					fprintf(gOutfile, "%#g %#g %#g\n",
-						out_verts[t][i][X], out_verts[t][i][Y],
-						out_verts[t][i][Z]);
-				}
-				if (norm != NULL)
-				{
-					tab_dec();
-					tab_indent();
-					tab_inc();
-					fprintf(gOutfile, "]  \"N\" [\n");
-					for (i=2;i>=0;i--)
-					{
-						/* Normals are also inverted in LH */
-						tab_indent();
-						fprintf(gOutfile, "%#g %#g %#g\n",
-							-out_norms[t][i][X], -out_norms[t][i][Y],
-							-out_norms[t][i][Z]);
-					}
-				}
-				tab_dec();
-				tab_indent();
-				fprintf(gOutfile, "]\n");
-				break;
-				
-			case OUTPUT_DXF:
-				fprintf(gOutfile, "  0\n3DFACE\n  8\n0----\n" ) ;
-				for (i=0;i<4;++i) {
-					ii = (i == 3) ? 2 : i ;
-					for (j=0;j<3;++j) {
-						fprintf(gOutfile, " %d%d\n%0.4f\n",j+1,i,
-							out_verts[t][ii][j] ) ;
-					}
-				}
-				break;
-				
-			case OUTPUT_3DMF:
-				tab_indent();
-				fprintf(gOutfile, "Container (\n");
-				tab_inc();
-				tab_indent();
-				fprintf(gOutfile, "Triangle (");
-				for (i = 0; i < 3; i++) {
-					fprintf(gOutfile, " %g %g %g",
-						vert[i][X], vert[i][Y], vert[i][Z]);
-				}
-				fprintf(gOutfile, " )\n");
-				/* Write out normal attributes */
-				tab_indent();
-				fprintf(gOutfile, "Container ( VertexAttributeSetList ( 3 Exclude 0 )\n");
-				tab_inc();
-				for (i = 0; i < 3; i++) {
-					tab_indent();
-					fprintf(gOutfile, "Container ( AttributeSet ( ) ");
-					fprintf(gOutfile, "Normal ( %g %g %g ) )\n",
-						out_norms[t][i][X], out_norms[t][i][Y],
-						out_norms[t][i][Z]);
-				}
-				tab_dec();
-				tab_indent();
-				fprintf(gOutfile, ")\n");
-				if (gTexture_count > 0) {
-					/* Write out texturing attributes */
-					fprintf(gOutfile, " Reference ( %d ) ", gTexture_count);
-				}
-				tab_dec();
-				tab_indent();
-				fprintf(gOutfile, ")\n");
-				break;
-				
-			case OUTPUT_VRML1:
-				tab_indent();
-				fprintf(gOutfile, "Separator {\n");
-				tab_inc();
-				
-				if (lib_tx_active()) {
-					tab_indent();
-					fprintf(gOutfile, "Transform {\n");
-					tab_inc();
-					lib_output_tx_sequence();
-					tab_dec();
-					tab_indent();
-					fprintf(gOutfile, "}\n");
-				}
-				
-				tab_indent();
-				fprintf(gOutfile, "Coordinate3 { point [");
-				for (i = 0; i < 3; i++) {
-					fprintf(gOutfile, "%g %g %g",
-						vert[i][X], vert[i][Y], vert[i][Z]);
-					if (i < 2)
-						fprintf(gOutfile, ", ");
-				}
-				fprintf(gOutfile, "] }\n");
-				
-				/* Write out normal attributes */
-				if (norm != NULL) {
-					tab_indent();
-					fprintf(gOutfile, "Normal { vector [");
-					for (i = 0; i < 3; i++) {
-						lib_normalize_vector(out_norms[t][i]);
-						fprintf(gOutfile, " %g %g %g",
-							out_norms[t][i][X], out_norms[t][i][Y],
-							out_norms[t][i][Z]);
-						if (i < 2)
-							fprintf(gOutfile, ", ");
-					}
-					fprintf(gOutfile, "] }\n");
-				}
-				
-				tab_indent();
-				fprintf(gOutfile, "IndexedFaceSet {\n");
-				tab_inc();
-				tab_indent();
-				fprintf(gOutfile, "coordIndex [0, 1, 2]\n");
-				tab_indent();
-				fprintf(gOutfile, "normalIndex [0, 1, 2]\n");
-				tab_dec();
-				tab_indent();
-				fprintf(gOutfile, "}\n");
-				
-				tab_dec();
-				tab_indent();
-				fprintf(gOutfile, "}\n");
-				break;
-				
-			case OUTPUT_VRML2:
-				if (lib_tx_active()) {
-					fprintf(gOutfile, "Transform {\n");
-					tab_inc();
-					lib_output_tx_sequence();
-					tab_indent();
-					fprintf(gOutfile, "children [\n");
-					tab_inc();
-				}
-				
-				tab_indent();
-				fprintf(gOutfile, "Shape {\n");
-				tab_inc();
-				tab_indent();
-				fprintf(gOutfile, "geometry IndexedFaceSet {\n");
-				tab_inc();
-				tab_indent();
-				fprintf(gOutfile, "coordIndex [0, 1, 2]\n");
-				tab_indent();
-				fprintf(gOutfile, "coord Coordinate { point [");
-				for (i = 0; i < 3; i++) {
-					fprintf(gOutfile, "%g %g %g",
-						vert[i][X], vert[i][Y], vert[i][Z]);
-					if (i < 2)
-						fprintf(gOutfile, ", ");
-				}
-				fprintf(gOutfile, "] }\n");
-				/* Write out normal attributes */
-				if (norm != NULL) {
-					tab_indent();
-					fprintf(gOutfile, "normal Normal { vector [");
-					for (i = 0; i < 3; i++) {
-						lib_normalize_vector(out_norms[t][i]);
-						fprintf(gOutfile, " %g %g %g",
-							out_norms[t][i][X], out_norms[t][i][Y],
-							out_norms[t][i][Z]);
-						if (i < 2)
-							fprintf(gOutfile, ", ");
-					}
-					fprintf(gOutfile, "] }\n");
-				}
-				tab_dec();
-				tab_indent();
-				fprintf(gOutfile, "}\n");
-				if (gTexture_name != NULL) {
-					/* Write out texturing attributes */
-					tab_indent();
-					fprintf(gOutfile, "appearance Appearance { material %s {} }\n",
-						gTexture_name);
-				}
-				tab_dec();
-				tab_indent();
-				fprintf(gOutfile, "}\n");
-				
-				if (lib_tx_active()) {
-					tab_dec();
-					tab_indent();
-					fprintf(gOutfile, "] }\n");
-					tab_dec();
-				}
-				break;
-			default:
-				fprintf(stderr, "Internal Error: bad file type in libply.c\n");
-				exit(1);
-				break;
-				
-		} /* switch */
-	} /* else !OUTPUT_DELAYED */
-    } /* else for loop */
-	
-    /* Clean up intermediate storage */
-    for (i=0;i<n-2;i++) {
-		free(out_verts[i]);
-		if (norm != NULL)
-			free(out_norms[i]);
-    }
-	
-    free(out_verts);
-    if (out_norms != NULL) free(out_norms);
+    PLATFORM_MULTITASK();
+    (*gEmitter->triangles)(out_n, out_verts, out_norms, vert);
 }
 
 /*-----------------------------------------------------------------*/
@@ -1347,8 +2206,8 @@ COORD3 *vert, *norm;
  {
 	 object_ptr new_object;
 	 int num_vert, i, j;
+	 unsigned long first;
 	 COORD3 x;
-	 COORD4 tvert[3], v0, v1;
 	 MATRIX txmat;
 	 
 	 /* First let's do a couple of checks to see if this is a valid polygon */
@@ -1374,16 +2233,18 @@ COORD3 *vert, *norm;
 	     /* Perform transformations of the vertices and normals of
 		    the polygon(s) */
 		 lib_get_current_tx(txmat);
-		 for (i=0;i<tot_vert;i++)
-			 lib_transform_point(vert[i], vert[i], txmat);
+		 lib_transform_points(vert, vert, (long)tot_vert, txmat);
 	 }
 	 
 	 if (gRT_out_format == OUTPUT_DELAYED) {
 		 /* Save all the pertinent information */
-		 new_object = (object_ptr)malloc(sizeof(struct object_struct));
+		 new_object = (object_ptr)lib_arena_alloc(sizeof(struct object_struct));
+		 if (new_object == NULL)
+			 /* Quietly fail */
+			 return;
 		 new_object->object_data.polygon.vert =
-			 (COORD3 *)malloc(tot_vert * sizeof(COORD3));
-		 if (new_object == NULL || new_object->object_data.polygon.vert == NULL)
+			 (STORE3 *)lib_arena_alloc(tot_vert * sizeof(STORE3));
+		 if (new_object->object_data.polygon.vert == NULL)
 			 /* Quietly fail */
 			 return;
 		 new_object->object_type  = POLYGON_OBJ;
@@ -1392,73 +2253,57 @@ COORD3 *vert, *norm;
 		 new_object->object_data.polygon.tot_vert = tot_vert;
 		 new_object->tx = NULL;
 		 for (i=0;i<tot_vert;i++) {
-			 COPY_COORD3(new_object->object_data.polygon.vert[i], vert[i]);
+			 STORE_COORD3(new_object->object_data.polygon.vert[i], vert[i]);
 		 }
 		 new_object->next_object = gLib_objects;
 		 gLib_objects = new_object;
 	 } else {
 		 switch (gRT_out_format) {
 		 case OUTPUT_VIDEO:
-			 /* First make sure the display has been opened for drawing */
-			 if (!gView_init_flag) {
-				 lib_create_view_matrix(gViewpoint.tx, gViewpoint.from, gViewpoint.at,
-					 gViewpoint.up, gViewpoint.resx, gViewpoint.resy,
-					 gViewpoint.angle, gViewpoint.aspect);
-				 display_init(gViewpoint.resx, gViewpoint.resy, gBkgnd_color);
-				 gView_init_flag = 1;
-			 }
-			 /* Step through each segment of the polygon, projecting it
-			    onto the screen. */
-			 for (i=0;i<tot_vert;i++) {
-				 COPY_COORD3(tvert[0], vert[i]);
-				 tvert[0][W] = 1.0;
-				 lib_transform_coord(v0, tvert[0], gViewpoint.tx);
-				 COPY_COORD3(tvert[1], vert[(i+1)%tot_vert]);
-				 tvert[1][W] = 1.0;
-				 lib_transform_coord(v1, tvert[1], gViewpoint.tx);
-				 /* Do the perspective transform on the points */
-				 v0[X] /= v0[W]; v0[Y] /= v0[W];
-				 v1[X] /= v1[W]; v1[Y] /= v1[W];
-				 if (lib_clip_to_box(v0, v1, gView_bounds))
-					 display_line((int)v0[X], (int)v0[Y],
-					 (int)v1[X], (int)v1[Y], gFgnd_color);
-			 }
+			 video_polygon(tot_vert, vert);
 			 break;
 			 
 		 case OUTPUT_NFF:
-			 fprintf(gOutfile, "p %d\n", tot_vert);
+			 lib_printf("p %d\n", tot_vert);
 			 for (num_vert=0;num_vert<tot_vert;++num_vert)
-				 fprintf(gOutfile, "%g %g %g\n",
+				 lib_printf("%g %g %g\n",
 				 vert[num_vert][X],
 				 vert[num_vert][Y],
 				 vert[num_vert][Z]);
 			 break;
 			 
+		 case OUTPUT_BNFF:
+			 emit_polygon_bnff(tot_vert, vert, (COORD3 *)NULL);
+			 break;
+			 
 		 case OUTPUT_OBJ:
 			 /* First the vertices */
+			 first = gVertex_count;
 			 for (num_vert=0;num_vert<tot_vert;++num_vert)
-				 fprintf(gOutfile, "v %g %g %g\n",
-					 vert[num_vert][X],
-					 vert[num_vert][Y],
-					 vert[num_vert][Z]);
+				 (void)obj_vertex("v", vert[num_vert],
+					 &gWeld_verts, &gVertex_count);
 
 			 /* Then the face - note that we add one to the count
-			    since Wavefront vertices start at 1, not 0. */
-			 fprintf(gOutfile, "f ");
+			    since Wavefront vertices start at 1, not 0.  Welded
+			    vertices are looked up again for their shared index. */
+			 lib_printf("f ");
 			 for (num_vert=0;num_vert<tot_vert;num_vert++) {
-				 fprintf(gOutfile, "%ld", gVertex_count+num_vert+1);
+				 if (gWeld_tolerance > 0.0)
+					 lib_printf("%ld", obj_vertex("v", vert[num_vert],
+						 &gWeld_verts, &gVertex_count));
+				 else
+					 lib_printf("%ld", first+num_vert+1);
 				 if (num_vert < tot_vert - 1)
-					 fprintf(gOutfile, " ");
+					 lib_printf(" ");
 			 }
-			 fprintf(gOutfile, "\n");
-			 gVertex_count += tot_vert;
+			 lib_printf("\n");
 			 break;
 			 
 		 case OUTPUT_RWX:
 			 /* First the vertices */
 			 for (num_vert=0;num_vert<tot_vert;++num_vert) {
 				 tab_indent();
-				 fprintf(gOutfile, "Vertex %g %g %g\n",
+				 lib_printf("Vertex %g %g %g\n",
 					 vert[num_vert][X],
 					 vert[num_vert][Y],
 					 vert[num_vert][Z]);
@@ -1466,13 +2311,13 @@ COORD3 *vert, *norm;
 			 /* Then the face - note that we add one to the count
 				since RenderWare vertices start at 1, not 0. */
 			 tab_indent();
-			 fprintf(gOutfile, "Polygon %d ", num_vert);
+			 lib_printf("Polygon %d ", num_vert);
 			 for (num_vert=0;num_vert<tot_vert;num_vert++) {
-				 fprintf(gOutfile, "%ld", (long)(gVertex_count+num_vert+1));
+				 lib_printf("%ld", (long)(gVertex_count+num_vert+1));
 				 if (num_vert < tot_vert - 1)
-					 fprintf(gOutfile, " ");
+					 lib_printf(" ");
 			 }
-			 fprintf(gOutfile, "\n");
+			 lib_printf("\n");
 			 gVertex_count += tot_vert;
 			 break;
 			 
@@ -1491,59 +2336,59 @@ COORD3 *vert, *norm;
 			 
 		 case OUTPUT_POLYRAY:
 			 tab_indent();
-			 fprintf(gOutfile, "object { polygon %d,", tot_vert);
+			 lib_printf("object { polygon %d,", tot_vert);
 			 for (num_vert = 0; num_vert < tot_vert; num_vert++) {
-				 fprintf(gOutfile, " <%g, %g, %g>",
+				 lib_printf(" <%g, %g, %g>",
 					 vert[num_vert][X],
 					 vert[num_vert][Y],
 					 vert[num_vert][Z]);
 				 if (num_vert < tot_vert-1)
-					 fprintf(gOutfile, ", ");
+					 lib_printf(", ");
 			 }
 			 if (gTexture_name != NULL)
-				 fprintf(gOutfile, " %s", gTexture_name);
-			 fprintf(gOutfile, " }\n");
-			 fprintf(gOutfile, "\n");
+				 lib_printf(" %s", gTexture_name);
+			 lib_printf(" }\n");
+			 lib_printf("\n");
 			 break;
 			 
 		 case OUTPUT_VIVID:
 			 tab_indent();
-			 fprintf(gOutfile, "polygon { points %d ", tot_vert);
+			 lib_printf("polygon { points %d ", tot_vert);
 			 for (num_vert = 0; num_vert < tot_vert; num_vert++) {
 			 /* Vivid has problems with very long input lines, so in
 			  * order to handle polygons with many vertices, we split
 			  * the vertices one to a line.
 			  */
-				 fprintf(gOutfile, " vertex %g %g %g \n",
+				 lib_printf(" vertex %g %g %g \n",
 					 vert[num_vert][X],
 					 vert[num_vert][Y],
 					 vert[num_vert][Z]);
 			 }
-			 fprintf(gOutfile, " }\n");
-			 fprintf(gOutfile, "\n");
+			 lib_printf(" }\n");
+			 lib_printf("\n");
 			 break;
 			 
 		 case OUTPUT_RAYSHADE:
-			 fprintf(gOutfile, "polygon ");
+			 lib_printf("polygon ");
 			 if (gTexture_name != NULL)
-				 fprintf(gOutfile, "%s ", gTexture_name);
+				 lib_printf("%s ", gTexture_name);
 			 for (num_vert=0;num_vert<tot_vert;num_vert++) {
-				 if (!(num_vert%3)) fprintf(gOutfile, "\n");
-				 fprintf(gOutfile, "%g %g %g ",
+				 if (!(num_vert%3)) lib_printf("\n");
+				 lib_printf("%g %g %g ",
 					 vert[num_vert][X],
 					 vert[num_vert][Y],
 					 vert[num_vert][Z]);
 			 }
-			 fprintf(gOutfile, "\n");
+			 lib_printf("\n");
 			 break;
 			 
 		 case OUTPUT_RTRACE:
-			 fprintf(gOutfile, "5 %d %g 0 0 0 1 1 1 -\n",
+			 lib_printf("5 %d %g 0 0 0 1 1 1 -\n",
 				 gTexture_count, gTexture_ior);
-			 fprintf(gOutfile, "%d ", tot_vert);
+			 lib_printf("%d ", tot_vert);
 			 for (num_vert=0;num_vert<tot_vert;num_vert++)
-				 fprintf(gOutfile, "%d ", num_vert+1);
-			 fprintf(gOutfile, "\n\n");
+				 lib_printf("%d ", num_vert+1);
+			 lib_printf("\n\n");
 			 for (num_vert=0;num_vert<tot_vert;num_vert++) {
 				 if (fabs(vert[num_vert][X]) < 1.0e-10)
 					 vert[num_vert][X] = 0.0;
@@ -1551,163 +2396,163 @@ COORD3 *vert, *norm;
 					 vert[num_vert][Y] = 0.0;
 				 if (fabs(vert[num_vert][Z]) < 1.0e-10)
 					 vert[num_vert][Z] = 0.0;
-				 fprintf(gOutfile, "%g %g %g\n",
+				 lib_printf("%g %g %g\n",
 					 vert[num_vert][X],
 					 vert[num_vert][Y],
 					 vert[num_vert][Z]);
 			 }
-			 fprintf(gOutfile, "\n");
+			 lib_printf("\n");
 			 break;
 			 
 		 case OUTPUT_ART:
 			 tab_indent();
-			 fprintf(gOutfile, "polygon {\n");
+			 lib_printf("polygon {\n");
 			 tab_inc();
 			 
 			 for (num_vert=0;num_vert<tot_vert;num_vert++) {
 				 tab_indent();
-				 fprintf(gOutfile, "vertex(%f, %f, %f)\n",
+				 lib_printf("vertex(%f, %f, %f)\n",
 					 vert[num_vert][X],
 					 vert[num_vert][Y],
 					 vert[num_vert][Z]);
 			 }
 			 tab_dec();
 			 tab_indent();
-			 fprintf(gOutfile, "}\n");
-			 fprintf(gOutfile, "\n");
+			 lib_printf("}\n");
+			 lib_printf("\n");
 			 break;
 			 
 		 case OUTPUT_RIB:
 			 tab_indent();
-			 fprintf(gOutfile, "Polygon \"P\" [\n");
+			 lib_printf("Polygon \"P\" [\n");
 			 tab_inc();
 			 
 			 for (num_vert=tot_vert-1;num_vert>=0;num_vert--)
 			 {
 				 tab_indent();
-				 fprintf(gOutfile, "%#g %#g %#g\n",
+				 lib_printf("%#g %#g %#g\n",
 					 vert[num_vert][X], vert[num_vert][Y],
 					 vert[num_vert][Z]);
 			 }
 			 
 			 tab_dec();
 			 tab_indent();
-			 fprintf(gOutfile, "]\n");
+			 lib_printf("]\n");
 			 break;
 			 
 		 case OUTPUT_3DMF:
 			 tab_indent();
-			 fprintf(gOutfile, "Container ( Polygon ( %d", tot_vert);
+			 lib_printf("Container ( Polygon ( %d", tot_vert);
 			 for (num_vert = 0; num_vert < tot_vert; num_vert++) {
-				 fprintf(gOutfile, " %g %g %g",
+				 lib_printf(" %g %g %g",
 					 vert[num_vert][X],
 					 vert[num_vert][Y],
 					 vert[num_vert][Z]);
 			 }
-			 fprintf(gOutfile, " ) ");
+			 lib_printf(" ) ");
 			 if (gTexture_count > 0) {
 				 /* Write out texturing attributes */
-				 fprintf(gOutfile, " Reference ( %d ) ", gTexture_count);
+				 lib_printf(" Reference ( %d ) ", gTexture_count);
 			 }
 			 tab_indent();
-			 fprintf(gOutfile, ")\n");
+			 lib_printf(")\n");
 			 break;
 			 
 		 case OUTPUT_VRML1:
 			 tab_indent();
-			 fprintf(gOutfile, "Separator {\n");
+			 lib_printf("Separator {\n");
 			 tab_inc();
 			 
 			 if (lib_tx_active()) {
 				 tab_indent();
-				 fprintf(gOutfile, "Transform {\n");
+				 lib_printf("Transform {\n");
 				 tab_inc();
 				 lib_output_tx_sequence();
 				 tab_dec();
 				 tab_indent();
-				 fprintf(gOutfile, "}\n");
+				 lib_printf("}\n");
 			 }
 			 
 			 tab_indent();
-			 fprintf(gOutfile, "Coordinate3 { point [");
+			 lib_printf("Coordinate3 { point [");
 			 for (i = 0; i < tot_vert; i++) {
-				 fprintf(gOutfile, "%g %g %g",
+				 lib_printf("%g %g %g",
 					 vert[i][X], vert[i][Y], vert[i][Z]);
 				 if (i < tot_vert-1)
-					 fprintf(gOutfile, ", ");
+					 lib_printf(", ");
 			 }
-			 fprintf(gOutfile, "] }\n");
+			 lib_printf("] }\n");
 			 
 			 tab_indent();
-			 fprintf(gOutfile, "IndexedFaceSet {\n");
+			 lib_printf("IndexedFaceSet {\n");
 			 tab_inc();
 			 tab_indent();
-			 fprintf(gOutfile, "coordIndex [");
+			 lib_printf("coordIndex [");
 			 for (i=0;i<tot_vert;i++) {
-				 fprintf(gOutfile, "%d", i);
+				 lib_printf("%d", i);
 				 if (i < tot_vert - 1)
-					 fprintf(gOutfile, ", ");
+					 lib_printf(", ");
 			 }
-			 fprintf(gOutfile, "]\n");
+			 lib_printf("]\n");
 			 tab_dec();
 			 tab_indent();
-			 fprintf(gOutfile, "}\n");
+			 lib_printf("}\n");
 			 
 			 tab_dec();
 			 tab_indent();
-			 fprintf(gOutfile, "}\n");
+			 lib_printf("}\n");
 			 break;
 			 
 		 case OUTPUT_VRML2:
 			 if (lib_tx_active()) {
-				 fprintf(gOutfile, "Transform {\n");
+				 lib_printf("Transform {\n");
 				 tab_inc();
 				 lib_output_tx_sequence();
 				 tab_indent();
-				 fprintf(gOutfile, "children [\n");
+				 lib_printf("children [\n");
 				 tab_inc();
 			 }
 			 
 			 tab_indent();
-			 fprintf(gOutfile, "Shape {\n");
+			 lib_printf("Shape {\n");
 			 tab_inc();
 			 tab_indent();
-			 fprintf(gOutfile, "geometry IndexedFaceSet {\n");
+			 lib_printf("geometry IndexedFaceSet {\n");
 			 tab_inc();
 			 tab_indent();
-			 fprintf(gOutfile, "coordIndex [");
+			 lib_printf("coordIndex [");
 			 for (i=0;i<tot_vert;i++) {
-				 fprintf(gOutfile, "%d", i);
+				 lib_printf("%d", i);
 				 if (i < tot_vert - 1)
-					 fprintf(gOutfile, ", ");
+					 lib_printf(", ");
 			 }
-			 fprintf(gOutfile, "]\n");
+			 lib_printf("]\n");
 			 tab_indent();
-			 fprintf(gOutfile, "coord Coordinate { point [");
+			 lib_printf("coord Coordinate { point [");
 			 for (i = 0; i < tot_vert; i++) {
-				 fprintf(gOutfile, "%g %g %g",
+				 lib_printf("%g %g %g",
 					 vert[i][X], vert[i][Y], vert[i][Z]);
 				 if (i < tot_vert-1)
-					 fprintf(gOutfile, ", ");
+					 lib_printf(", ");
 			 }
-			 fprintf(gOutfile, "] }\n");
+			 lib_printf("] }\n");
 			 tab_dec();
 			 tab_indent();
-			 fprintf(gOutfile, "}\n");
+			 lib_printf("}\n");
 			 if (gTexture_name != NULL) {
 				 /* Write out texturing attributes */
 				 tab_indent();
-				 fprintf(gOutfile, "appearance Appearance { material %s {} }\n",
+				 lib_printf("appearance Appearance { material %s {} }\n",
 					 gTexture_name);
 			 }
 			 tab_dec();
 			 tab_indent();
-			 fprintf(gOutfile, "}\n");
+			 lib_printf("}\n");
 			 
 			 if (lib_tx_active()) {
 				 tab_dec();
 				 tab_indent();
-				 fprintf(gOutfile, "] }\n");
+				 lib_printf("] }\n");
 				 tab_dec();
 			 }
 			 break;
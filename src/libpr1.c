@@ -39,6 +39,7 @@ char *comment;
 	case OUTPUT_RAWTRI:
 	case OUTPUT_DXF:		/* well, there's the 999 format, but... >>>>> */
 	case OUTPUT_RWX:
+	case OUTPUT_BNFF:
 		/* no comments allowed for these file formats */
 		break;
 		
@@ -48,7 +49,7 @@ char *comment;
 	case OUTPUT_3DMF:
 	case OUTPUT_VRML1:
 	case OUTPUT_VRML2:
-		fprintf(gOutfile, "# %s\n", comment);
+		lib_printf("# %s\n", comment);
 		break;
 		
 	case OUTPUT_RAYSHADE:
@@ -56,7 +57,7 @@ char *comment;
 	case OUTPUT_POVRAY_10:
 	case OUTPUT_POVRAY_20:
 	case OUTPUT_POVRAY_30:
-		fprintf(gOutfile, "// %s\n", comment);
+		lib_printf("// %s\n", comment);
 		break;
 		
 		/* unknown comment formats... whoever knows, please fix or fill in! */
@@ -66,7 +67,7 @@ char *comment;
 	case OUTPUT_QRT:
 	case OUTPUT_ART:
 	default:
-		fprintf(gOutfile, "// <comment> '%s'\n", comment);
+		lib_printf("// <comment> '%s'\n", comment);
 		break;
 		
 	}
@@ -86,6 +87,7 @@ double  x, y, z;
 	case OUTPUT_DELAYED:
 	case OUTPUT_DXF:
 	case OUTPUT_RWX:
+	case OUTPUT_BNFF:
 		break;
 		
 	case OUTPUT_PLG:
@@ -98,21 +100,21 @@ double  x, y, z;
 	case OUTPUT_3DMF:
 	case OUTPUT_VRML1:
 	case OUTPUT_VRML2:
-		fprintf(gOutfile, "%g %g %g", x, y, z);
+		lib_printf("%g %g %g", x, y, z);
 		break;
 		
 	case OUTPUT_POVRAY_10:
-		fprintf(gOutfile, "<%g %g %g>", x, y, z);
+		lib_printf("<%g %g %g>", x, y, z);
 		break;
 	case OUTPUT_POVRAY_20:
 	case OUTPUT_POVRAY_30:
-		fprintf(gOutfile, "<%g, %g, %g>", x, y, z);
+		lib_printf("<%g, %g, %g>", x, y, z);
 		break;
 		
 	case OUTPUT_POLYRAY:
 	case OUTPUT_QRT:
 	case OUTPUT_ART:
-		fprintf(gOutfile, "%g, %g, %g", x, y, z);
+		lib_printf("%g, %g, %g", x, y, z);
 		break;
 		
 	default:
@@ -146,6 +148,455 @@ double *xang, *yang;
 		*yang = -(*yang);
 } /* axis_to_z */
 
+/*-----------------------------------------------------------------*/
+/* Viewpoint writers for the output emitter tables in libemt.c */
+#ifdef ANSI_FN_DEF
+void emit_view_nff(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+				   double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_nff(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    lib_printf("v\n");
+    lib_printf("from %g %g %g\n", from[X], from[Y], from[Z]);
+    lib_printf("at %g %g %g\n", at[X], at[Y], at[Z]);
+    lib_printf("up %g %g %g\n", up[X], up[Y], up[Z]);
+    lib_printf("angle %g\n", fov_angle);
+    lib_printf("hither %g\n", hither);
+    lib_printf("resolution %d %d\n", resx, resy);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_pov(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+				   double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_pov(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    COORD4 viewvec, rightvec;
+    double frustrumheight, frustrumwidth;
+
+    /* Let's get a set of vectors that are all at right angles to each
+       other that describe the view given. */
+    lib_normalize_vector(up);
+    SUB3_COORD3(viewvec, at, from);
+    lib_normalize_vector(viewvec);
+    CROSS(rightvec, up, viewvec);
+    lib_normalize_vector(rightvec);
+    CROSS(up, viewvec, rightvec);
+    lib_normalize_vector(up);
+
+    /* Calculate the height of the view frustrum in world coordinates.
+       and then scale the right and up vectors appropriately. */
+    frustrumheight = 2.0 * tan(PI * fov_angle / 360.0);
+    frustrumwidth = aspect_ratio * frustrumheight;
+    up[X] *= frustrumheight;
+    up[Y] *= frustrumheight;
+    up[Z] *= frustrumheight;
+    rightvec[X] *= frustrumwidth;
+    rightvec[Y] *= frustrumwidth;
+    rightvec[Z] *= frustrumwidth;
+
+    tab_indent();
+    lib_printf("camera {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("location ");
+    lib_output_vector(from[X], from[Y], from[Z]);
+    lib_printf("\n");
+
+    tab_indent();
+    lib_printf("direction ");
+    lib_output_vector(viewvec[X], viewvec[Y], viewvec[Z]);
+    lib_printf("\n");
+
+    tab_indent();
+    lib_printf("right     ");
+    lib_output_vector(-rightvec[X], -rightvec[Y], -rightvec[Z]);
+    lib_printf("\n");
+
+    tab_indent();
+    lib_printf("up        ");
+    lib_output_vector(up[X], up[Y], up[Z]);
+    lib_printf("\n");
+
+    tab_dec();
+    lib_printf("} // camera\n\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_polyray(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+					   double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_polyray(from, at, up, fov_angle, aspect_ratio, hither, resx,
+					   resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    tab_indent();
+    lib_printf("viewpoint {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("from <%g, %g, %g>\n", from[X], from[Y], from[Z]);
+    tab_indent();
+    lib_printf("at <%g, %g, %g>\n", at[X], at[Y], at[Z]);
+    tab_indent();
+    lib_printf("up <%g, %g, %g>\n", up[X], up[Y], up[Z]);
+    tab_indent();
+    lib_printf("angle %g\n", fov_angle);
+    tab_indent();
+    /* Note the negative, this is to change to right handed
+       coordinates (like most of the other tracers) */
+    lib_printf("aspect %g\n", -aspect_ratio);
+    tab_indent();
+    lib_printf("hither %g\n", hither);
+    tab_indent();
+    lib_printf("resolution %d, %d\n", resx, resy);
+
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+    lib_printf("\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_vivid(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+					 double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_vivid(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    tab_indent();
+    lib_printf("studio {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("from %g %g %g\n", from[X], from[Y], from[Z]);
+    tab_indent();
+    lib_printf("at %g %g %g\n", at[X], at[Y], at[Z]);
+    tab_indent();
+    lib_printf("up %g %g %g\n", up[X], up[Y], up[Z]);
+    tab_indent();
+    lib_printf("angle %g\n", fov_angle);
+    tab_indent();
+    lib_printf("aspect %g\n", aspect_ratio);
+    tab_indent();
+    lib_printf("resolution %d %d\n", resx, resy);
+    tab_indent();
+    lib_printf("no_exp_trans\n");
+
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+    lib_printf("\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_qrt(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+				   double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_qrt(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    tab_indent();
+    lib_printf("OBSERVER = (\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("loc = (%g,%g,%g),\n", from[X], from[Y], from[Z]);
+    tab_indent();
+    lib_printf("lookat = (%g,%g,%g),\n", at[X], at[Y], at[Z]);
+    tab_indent();
+    lib_printf("up = (%g,%g,%g)\n", up[X], up[Y], up[Z]);
+    tab_dec();
+    tab_indent();
+    lib_printf(")\n");
+
+    tab_indent();
+    lib_printf("FOC_LENGTH = %g\n",
+		35.0 / tan(PI * fov_angle / 360.0));
+    tab_indent();
+    lib_printf("DEFAULT (\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("aspect = %g,\n", 6.0 * aspect_ratio / 7.0);
+    tab_indent();
+    lib_printf("x_res = %d, y_res = %d\n", resx, resy);
+    tab_dec();
+    tab_indent();
+    lib_printf(")\n");
+
+    /* QRT insists on having the output file as part of the data text */
+    tab_indent();
+    lib_printf("FILE_NAME = qrt.tga\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_rayshade(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+						double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_rayshade(from, at, up, fov_angle, aspect_ratio, hither, resx,
+						resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    lib_printf("eyep %g %g %g\n", from[X], from[Y], from[Z]);
+    lib_printf("lookp %g %g %g\n", at[X], at[Y], at[Z]);
+    lib_printf("up %g %g %g\n", up[X], up[Y], up[Z]);
+    lib_printf("fov %g %g\n", aspect_ratio * fov_angle,
+		fov_angle);
+    lib_printf("screen %d %d\n", resx, resy);
+    lib_printf("sample 1 nojitter\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_rtrace(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+					  double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_rtrace(from, at, up, fov_angle, aspect_ratio, hither, resx,
+					  resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    lib_printf("View\n");
+    lib_printf("%g %g %g\n", from[X], from[Y], from[Z]);
+    lib_printf("%g %g %g\n", at[X], at[Y], at[Z]);
+    lib_printf("%g %g %g\n", up[X], up[Y], up[Z]);
+    lib_printf("%g %g\n", aspect_ratio * fov_angle/2,
+		fov_angle/2);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_art(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+				   double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_art(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    lib_printf("maxhitlevel 4\n");
+    lib_printf("screensize 0.0, 0.0\n");
+    lib_printf("fieldofview %g\n", fov_angle);
+    lib_printf("up(%g, %g, %g)\n", up[X], up[Y], up[Z]);
+    lib_printf("lookat(%g, %g, %g, ", from[X], from[Y], from[Z]);
+    lib_printf("%g, %g, %g, 0.0)\n", at[X], at[Y], at[Z]);
+    lib_printf("\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_rib(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+				   double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_rib(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    COORD3 axis, myright, tmp;
+    MATRIX m1;
+    double tmpf;
+
+    //lib_printf("version 3.03\n");
+    lib_printf("FrameBegin 1\n");
+    lib_printf("Format %d %d 1\n", resx, resy);
+    lib_printf("PixelSamples 1 1\n");
+    lib_printf("ShadingRate 1.0\n");
+    //lib_printf("Declare \"reflected\" \"float\"\n");
+    //lib_printf("Declare \"transmitted\" \"float\"\n"); 
+    //lib_printf("Declare \"index\" \"float\"\n");
+    //lib_printf("Option \"render\" \"max_raylevel\" [4]\n");
+    lib_printf("Attribute \"visibility\" \"int trace\" [1]\n");
+			lib_printf("Attribute \"visibility\" \"string transmission\" [\"opaque\"]\n");
+			lib_printf("Attribute \"trace\" \"int maxspeculardepth\" [4]\n");
+
+    lib_printf("Projection \"perspective\" \"fov\" %#g\n",
+		fov_angle);
+    lib_printf("Clipping %#g %#g\n\n", hither, 1e38);
+
+    /* Calculate transformation from intrisic position */
+    SUB3_COORD3(axis, at, from);
+    lib_normalize_vector(axis);
+
+    COPY_COORD3(tmp,axis);
+    tmpf = DOT_PRODUCT(up,axis);
+    tmp[0] *= tmpf;  tmp[1] *= tmpf;  tmp[2] *= tmpf;
+    SUB2_COORD3(up,tmp);
+    lib_normalize_vector(up);
+
+    CROSS(myright,up,axis);
+    lib_normalize_vector (myright);
+
+    m1[0][0] = myright[0];  m1[1][0] = myright[1];
+    m1[2][0] = myright[2];  m1[3][0] = 0;
+    m1[0][1] = up[0];  m1[1][1] = up[1];
+    m1[2][1] = up[2]; m1[3][1] = 0;
+    m1[0][2] = axis[0];  m1[1][2] = axis[1];
+    m1[2][2] = axis[2];  m1[3][2] = 0;
+    m1[0][3] = 0;  m1[1][3] = 0;  m1[2][3] = 0;  m1[3][3] = 1;
+    lib_printf("ConcatTransform [%g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g]\n",
+		m1[0][0], m1[0][1], m1[0][2], m1[0][3],
+		m1[1][0], m1[1][1], m1[1][2], m1[1][3],
+		m1[2][0], m1[2][1], m1[2][2], m1[2][3],
+		m1[3][0], m1[3][1], m1[3][2], m1[3][3]);
+    lib_printf("Translate %g %g %g\n", -from[0], -from[1], -from[2]);
+
+    lib_printf("WorldBegin\n");
+    tab_inc();
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_dxf(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+				   double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_dxf(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    lib_printf("  0\n" ) ;
+    lib_printf("SECTION\n" ) ;
+    lib_printf("  2\n" ) ;
+    lib_printf("HEADER\n" ) ;
+    lib_printf("  0\n" ) ;
+    lib_printf("ENDSEC\n" ) ;
+    lib_printf("  0\n" ) ;
+    lib_printf("SECTION\n" ) ;
+    lib_printf("  2\n" ) ;
+    lib_printf("ENTITIES\n" ) ;
+    /* should add view someday ... */
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_3dmf(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+					double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_3dmf(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    tab_indent();
+    lib_printf("Container (\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("ViewAngleAspectCamera ( %g %g )\n",
+		fov_angle, aspect_ratio);
+    tab_indent();
+    lib_printf("CameraPlacement ( %g %g %g %g %g %g %g %g %g )\n",
+		from[X], from[Y], from[Z],
+		at[X], at[Y], at[Z],
+		up[X], up[Y], up[Z]);
+    tab_dec();
+    tab_indent();
+    lib_printf(")\n");
+    tab_indent();
+    lib_printf("Container (\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("ViewHints ( )\n");
+    tab_indent();
+    lib_printf("ImageDimensions ( %d %d )\n",
+		resx, resy);
+    tab_dec();
+    tab_indent();
+    lib_printf(")\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_vrml1(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+					 double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_vrml1(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    COORD4 viewvec;
+
+    tab_indent();
+    lib_printf("PerspectiveCamera {\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("heightAngle %g\n", DEG2RAD(fov_angle));
+    tab_indent();
+    lib_printf("position %g %g %g\n",
+		from[X], from[Y], from[Z]);
+    tab_indent();
+    lib_calc_view_vector(from, at, up, viewvec);
+    lib_printf("orientation %g %g %g %g\n",
+		viewvec[0], viewvec[1], viewvec[2], viewvec[3]);
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_view_vrml2(COORD3 from, COORD3 at, COORD3 up, double fov_angle,
+					 double aspect_ratio, double hither, int resx, int resy)
+#else
+void emit_view_vrml2(from, at, up, fov_angle, aspect_ratio, hither, resx, resy)
+COORD3 from, at, up;
+double fov_angle, aspect_ratio, hither;
+int resx, resy;
+#endif
+{
+    COORD4 viewvec;
+
+    tab_indent();
+    lib_printf("Viewpoint {\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("fieldOfView %g\n", DEG2RAD(fov_angle));
+    tab_indent();
+    lib_printf("position %g %g %g\n",
+		from[X], from[Y], from[Z]);
+    tab_indent();
+    lib_calc_view_vector(from, at, up, viewvec);
+    lib_printf("orientation %g %g %g %g\n",
+		viewvec[0], viewvec[1], viewvec[2], viewvec[3]);
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+}
+
 /*-----------------------------------------------------------------*/
 /*
  * Output viewpoint location.  The parameters are:
@@ -177,364 +628,315 @@ double fov_angle, aspect_ratio, hither;
 int    resx, resy;
 #endif
 {
-    COORD3 axis, myright, tmp;
-    COORD4 viewvec, rightvec;
-    MATRIX m1;
-    double tmpf;
-    double frustrumheight, frustrumwidth;
-	
-    switch (gRT_out_format) {
-	case OUTPUT_DELAYED:
-	case OUTPUT_VIDEO:
-	case OUTPUT_PLG:
-	case OUTPUT_OBJ:
-	case OUTPUT_RWX:
-		/* Save the various view parameters */
-		COPY_COORD3(gViewpoint.from, from);
-		COPY_COORD3(gViewpoint.at, at);
-		COPY_COORD3(gViewpoint.up, up);
-		gViewpoint.angle  = fov_angle;
-		gViewpoint.hither = hither;
-		gViewpoint.resx   = resx;
-		gViewpoint.resy   = resy;
-		gViewpoint.aspect = aspect_ratio;
-		
-		/* Make the 3D clipping box for this view */
-		gView_bounds[0][0] = 0;
-		gView_bounds[1][0] = gViewpoint.resx;
-		gView_bounds[0][1] = 0;
-		gView_bounds[1][1] = gViewpoint.resy;
-		gView_bounds[0][2] = gViewpoint.hither;
-		gView_bounds[1][2] = 1.0e10;
-		
-		/* Generate the perspective view matrix */
-		lib_create_view_matrix(gViewpoint.tx, gViewpoint.from, gViewpoint.at,
-			gViewpoint.up, gViewpoint.resx, gViewpoint.resy,
-			gViewpoint.angle, gViewpoint.aspect);
-		
-		/* Turn on graphics using system dependent video routines */
-		if (gRT_out_format == OUTPUT_VIDEO) {
-			display_init(gViewpoint.resx, gViewpoint.resy, gBkgnd_color);
-			gView_init_flag = 1;
-		}
-		break;
-		
-	case OUTPUT_NFF:
-		fprintf(gOutfile, "v\n");
-		fprintf(gOutfile, "from %g %g %g\n", from[X], from[Y], from[Z]);
-		fprintf(gOutfile, "at %g %g %g\n", at[X], at[Y], at[Z]);
-		fprintf(gOutfile, "up %g %g %g\n", up[X], up[Y], up[Z]);
-		fprintf(gOutfile, "angle %g\n", fov_angle);
-		fprintf(gOutfile, "hither %g\n", hither);
-		fprintf(gOutfile, "resolution %d %d\n", resx, resy);
-		break;
-		
-	case OUTPUT_POVRAY_10:
-	case OUTPUT_POVRAY_20:
-	case OUTPUT_POVRAY_30:
-		/* Let's get a set of vectors that are all at right angles to each
-	       other that describe the view given. */
-		lib_normalize_vector(up);
-		SUB3_COORD3(viewvec, at, from);
-		lib_normalize_vector(viewvec);
-		CROSS(rightvec, up, viewvec);
-		lib_normalize_vector(rightvec);
-		CROSS(up, viewvec, rightvec);
-		lib_normalize_vector(up);
-		
-		/* Calculate the height of the view frustrum in world coordinates.
-	       and then scale the right and up vectors appropriately. */
-		frustrumheight = 2.0 * tan(PI * fov_angle / 360.0);
-		frustrumwidth = aspect_ratio * frustrumheight;
-		up[X] *= frustrumheight;
-		up[Y] *= frustrumheight;
-		up[Z] *= frustrumheight;
-		rightvec[X] *= frustrumwidth;
-		rightvec[Y] *= frustrumwidth;
-		rightvec[Z] *= frustrumwidth;
-		
-		tab_indent();
-		fprintf(gOutfile, "camera {\n");
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "location ");
-		lib_output_vector(from[X], from[Y], from[Z]);
-		fprintf(gOutfile, "\n");
-		
-		tab_indent();
-		fprintf(gOutfile, "direction ");
-		lib_output_vector(viewvec[X], viewvec[Y], viewvec[Z]);
-		fprintf(gOutfile, "\n");
-		
-		tab_indent();
-		fprintf(gOutfile, "right     ");
-		lib_output_vector(-rightvec[X], -rightvec[Y], -rightvec[Z]);
-		fprintf(gOutfile, "\n");
-		
-		tab_indent();
-		fprintf(gOutfile, "up        ");
-		lib_output_vector(up[X], up[Y], up[Z]);
-		fprintf(gOutfile, "\n");
-		
-		tab_dec();
-		fprintf(gOutfile, "} // camera\n\n");
-		break;
-		
-	case OUTPUT_POLYRAY:
-		tab_indent();
-		fprintf(gOutfile, "viewpoint {\n");
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "from <%g, %g, %g>\n", from[X], from[Y], from[Z]);
-		tab_indent();
-		fprintf(gOutfile, "at <%g, %g, %g>\n", at[X], at[Y], at[Z]);
-		tab_indent();
-		fprintf(gOutfile, "up <%g, %g, %g>\n", up[X], up[Y], up[Z]);
-		tab_indent();
-		fprintf(gOutfile, "angle %g\n", fov_angle);
-		tab_indent();
-		/* Note the negative, this is to change to right handed
-	       coordinates (like most of the other tracers) */
-		fprintf(gOutfile, "aspect %g\n", -aspect_ratio);
-		tab_indent();
-		fprintf(gOutfile, "hither %g\n", hither);
-		tab_indent();
-		fprintf(gOutfile, "resolution %d, %d\n", resx, resy);
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-		fprintf(gOutfile, "\n");
-		break;
-		
-	case OUTPUT_VIVID:
-		tab_indent();
-		fprintf(gOutfile, "studio {\n");
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "from %g %g %g\n", from[X], from[Y], from[Z]);
-		tab_indent();
-		fprintf(gOutfile, "at %g %g %g\n", at[X], at[Y], at[Z]);
-		tab_indent();
-		fprintf(gOutfile, "up %g %g %g\n", up[X], up[Y], up[Z]);
-		tab_indent();
-		fprintf(gOutfile, "angle %g\n", fov_angle);
-		tab_indent();
-		fprintf(gOutfile, "aspect %g\n", aspect_ratio);
-		tab_indent();
-		fprintf(gOutfile, "resolution %d %d\n", resx, resy);
-		tab_indent();
-		fprintf(gOutfile, "no_exp_trans\n");
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-		fprintf(gOutfile, "\n");
-		break;
-		
-	case OUTPUT_QRT:
-		tab_indent();
-		fprintf(gOutfile, "OBSERVER = (\n");
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "loc = (%g,%g,%g),\n", from[X], from[Y], from[Z]);
-		tab_indent();
-		fprintf(gOutfile, "lookat = (%g,%g,%g),\n", at[X], at[Y], at[Z]);
-		tab_indent();
-		fprintf(gOutfile, "up = (%g,%g,%g)\n", up[X], up[Y], up[Z]);
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, ")\n");
-		
-		tab_indent();
-		fprintf(gOutfile, "FOC_LENGTH = %g\n",
-			35.0 / tan(PI * fov_angle / 360.0));
-		tab_indent();
-		fprintf(gOutfile, "DEFAULT (\n");
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "aspect = %g,\n", 6.0 * aspect_ratio / 7.0);
-		tab_indent();
-		fprintf(gOutfile, "x_res = %d, y_res = %d\n", resx, resy);
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, ")\n");
-		
-		/* QRT insists on having the output file as part of the data text */
-		tab_indent();
-		fprintf(gOutfile, "FILE_NAME = qrt.tga\n");
-		break;
-		
-	case OUTPUT_RAYSHADE:
-		fprintf(gOutfile, "eyep %g %g %g\n", from[X], from[Y], from[Z]);
-		fprintf(gOutfile, "lookp %g %g %g\n", at[X], at[Y], at[Z]);
-		fprintf(gOutfile, "up %g %g %g\n", up[X], up[Y], up[Z]);
-		fprintf(gOutfile, "fov %g %g\n", aspect_ratio * fov_angle,
-			fov_angle);
-		fprintf(gOutfile, "screen %d %d\n", resx, resy);
-		fprintf(gOutfile, "sample 1 nojitter\n");
-		break;
-		
-	case OUTPUT_RTRACE:
-		fprintf(gOutfile, "View\n");
-		fprintf(gOutfile, "%g %g %g\n", from[X], from[Y], from[Z]);
-		fprintf(gOutfile, "%g %g %g\n", at[X], at[Y], at[Z]);
-		fprintf(gOutfile, "%g %g %g\n", up[X], up[Y], up[Z]);
-		fprintf(gOutfile, "%g %g\n", aspect_ratio * fov_angle/2,
-			fov_angle/2);
-		break;
-		
-	case OUTPUT_ART:
-		fprintf(gOutfile, "maxhitlevel 4\n");
-		fprintf(gOutfile, "screensize 0.0, 0.0\n");
-		fprintf(gOutfile, "fieldofview %g\n", fov_angle);
-		fprintf(gOutfile, "up(%g, %g, %g)\n", up[X], up[Y], up[Z]);
-		fprintf(gOutfile, "lookat(%g, %g, %g, ", from[X], from[Y], from[Z]);
-		fprintf(gOutfile, "%g, %g, %g, 0.0)\n", at[X], at[Y], at[Z]);
-		fprintf(gOutfile, "\n");
-		break;
-		
-	case OUTPUT_RAWTRI:
-		break;
-		
-	case OUTPUT_RIB:
-		//fprintf(gOutfile, "version 3.03\n");
-		fprintf(gOutfile, "FrameBegin 1\n");
-		fprintf(gOutfile, "Format %d %d 1\n", resx, resy);
-		fprintf(gOutfile, "PixelSamples 1 1\n");
-		fprintf(gOutfile, "ShadingRate 1.0\n");
-		//fprintf(gOutfile, "Declare \"reflected\" \"float\"\n");
-		//fprintf(gOutfile, "Declare \"transmitted\" \"float\"\n"); 
-		//fprintf(gOutfile, "Declare \"index\" \"float\"\n");
-		//fprintf(gOutfile, "Option \"render\" \"max_raylevel\" [4]\n");
-		fprintf(gOutfile, "Attribute \"visibility\" \"int trace\" [1]\n");
-                fprintf(gOutfile, "Attribute \"visibility\" \"string transmission\" [\"opaque\"]\n");
-                fprintf(gOutfile, "Attribute \"trace\" \"int maxspeculardepth\" [4]\n");
-
-		fprintf(gOutfile, "Projection \"perspective\" \"fov\" %#g\n",
-			fov_angle);
-		fprintf(gOutfile, "Clipping %#g %#g\n\n", hither, 1e38);
-		
-		/* Calculate transformation from intrisic position */
-		SUB3_COORD3(axis, at, from);
-		lib_normalize_vector(axis);
-		
-		COPY_COORD3(tmp,axis);
-		tmpf = DOT_PRODUCT(up,axis);
-		tmp[0] *= tmpf;  tmp[1] *= tmpf;  tmp[2] *= tmpf;
-		SUB2_COORD3(up,tmp);
-		lib_normalize_vector(up);
-		
-		CROSS(myright,up,axis);
-		lib_normalize_vector (myright);
-		
-		m1[0][0] = myright[0];  m1[1][0] = myright[1];
-		m1[2][0] = myright[2];  m1[3][0] = 0;
-		m1[0][1] = up[0];  m1[1][1] = up[1];
-		m1[2][1] = up[2]; m1[3][1] = 0;
-		m1[0][2] = axis[0];  m1[1][2] = axis[1];
-		m1[2][2] = axis[2];  m1[3][2] = 0;
-		m1[0][3] = 0;  m1[1][3] = 0;  m1[2][3] = 0;  m1[3][3] = 1;
-		fprintf (gOutfile, "ConcatTransform [%g %g %g %g %g %g %g %g %g %g %g %g %g %g %g %g]\n",
-			m1[0][0], m1[0][1], m1[0][2], m1[0][3],
-			m1[1][0], m1[1][1], m1[1][2], m1[1][3],
-			m1[2][0], m1[2][1], m1[2][2], m1[2][3],
-			m1[3][0], m1[3][1], m1[3][2], m1[3][3]);
-		fprintf (gOutfile, "Translate %g %g %g\n", -from[0], -from[1], -from[2]);
-		
-		fprintf(gOutfile, "WorldBegin\n");
-		tab_inc();
-		break ;
-		
-	case OUTPUT_DXF:
-		fprintf(gOutfile, "  0\n" ) ;
-		fprintf(gOutfile, "SECTION\n" ) ;
-		fprintf(gOutfile, "  2\n" ) ;
-		fprintf(gOutfile, "HEADER\n" ) ;
-		fprintf(gOutfile, "  0\n" ) ;
-		fprintf(gOutfile, "ENDSEC\n" ) ;
-		fprintf(gOutfile, "  0\n" ) ;
-		fprintf(gOutfile, "SECTION\n" ) ;
-		fprintf(gOutfile, "  2\n" ) ;
-		fprintf(gOutfile, "ENTITIES\n" ) ;
-		/* should add view someday ... */
-		break;
-		
-	case OUTPUT_3DMF:
-		tab_indent();
-		fprintf(gOutfile, "Container (\n");
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "ViewAngleAspectCamera ( %g %g )\n",
-			fov_angle, aspect_ratio);
-		tab_indent();
-		fprintf(gOutfile, "CameraPlacement ( %g %g %g %g %g %g %g %g %g )\n",
-			from[X], from[Y], from[Z],
-			at[X], at[Y], at[Z],
-			up[X], up[Y], up[Z]);
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, ")\n");
-		tab_indent();
-		fprintf(gOutfile, "Container (\n");
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "ViewHints ( )\n");
-		tab_indent();
-		fprintf(gOutfile, "ImageDimensions ( %d %d )\n",
+    /* Every format keeps the view, for adaptive tessellation */
+    COPY_COORD3(gViewpoint.from, from);
+    COPY_COORD3(gViewpoint.at, at);
+    COPY_COORD3(gViewpoint.up, up);
+    gViewpoint.angle  = fov_angle;
+    gViewpoint.hither = hither;
+    gViewpoint.resx   = resx;
+    gViewpoint.resy   = resy;
+    gViewpoint.aspect = aspect_ratio;
+
+    /* Make the 3D clipping box for this view */
+    gView_bounds[0][0] = 0;
+    gView_bounds[1][0] = gViewpoint.resx;
+    gView_bounds[0][1] = 0;
+    gView_bounds[1][1] = gViewpoint.resy;
+    gView_bounds[0][2] = gViewpoint.hither;
+    gView_bounds[1][2] = 1.0e10;
+
+    /* Generate the perspective view matrix */
+    lib_create_view_matrix(gViewpoint.tx, gViewpoint.from, gViewpoint.at,
+		gViewpoint.up, gViewpoint.resx, gViewpoint.resy,
+		gViewpoint.angle, gViewpoint.aspect);
+
+    /* Turn on graphics using system dependent video routines */
+    if (gRT_out_format == OUTPUT_VIDEO) {
+		display_init(gViewpoint.resx, gViewpoint.resy, gBkgnd_color);
+		gView_init_flag = 1;
+    }
+
+    if (gEmitter->viewpoint != NULL)
+		(*gEmitter->viewpoint)(from, at, up, fov_angle, aspect_ratio, hither,
 			resx, resy);
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, ")\n");
-		break;
-		
-	case OUTPUT_VRML1:
-		tab_indent();
-		fprintf(gOutfile, "PerspectiveCamera {\n");
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "heightAngle %g\n", DEG2RAD(fov_angle));
-		tab_indent();
-		fprintf(gOutfile, "position %g %g %g\n",
-			from[X], from[Y], from[Z]);
-		tab_indent();
-		lib_calc_view_vector(from, at, up, viewvec);
-		fprintf(gOutfile, "orientation %g %g %g %g\n",
-			viewvec[0], viewvec[1], viewvec[2], viewvec[3]);
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-		break;
-		
-	case OUTPUT_VRML2:
-		tab_indent();
-		fprintf(gOutfile, "Viewpoint {\n");
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "fieldOfView %g\n", DEG2RAD(fov_angle));
-		tab_indent();
-		fprintf(gOutfile, "position %g %g %g\n",
-			from[X], from[Y], from[Z]);
-		tab_indent();
-		lib_calc_view_vector(from, at, up, viewvec);
-		fprintf(gOutfile, "orientation %g %g %g %g\n",
-			viewvec[0], viewvec[1], viewvec[2], viewvec[3]);
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-		break;
-		
-	default:
-		fprintf(stderr, "Internal Error: bad file type in libpr1.c\n");
-		exit(1);
-		break;
+}
+
+/*-----------------------------------------------------------------*/
+/* Light writers.  "vec" is the transformed light position, "lscale" its
+   intensity. */
+#ifdef ANSI_FN_DEF
+void emit_light_delayed(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_delayed(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    light_ptr new_light;
+
+    new_light = (light_ptr)malloc(sizeof(struct light_struct));
+    if (new_light == NULL)
+		/* Quietly fail & return */
+		return;
+    COPY_COORD4(new_light->center_pt, center_pt);
+    new_light->center_pt[W] = lscale;
+    new_light->next = gLib_lights;
+    gLib_lights = new_light;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_nff(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_nff(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    lib_printf("l %g %g %g\n",
+		vec[X], vec[Y], vec[Z]);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_pov10(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_pov10(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    tab_indent();
+    lib_printf("object {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("light_source {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("<%g %g %g>",
+		vec[X], vec[Y], vec[Z]);
+    lib_printf(" color red %g green %g blue %g\n",
+		lscale, lscale, lscale);
+
+    tab_dec();
+    tab_indent();
+    lib_printf("} // light\n");
+
+    tab_dec();
+    tab_indent();
+    lib_printf("} // object\n");
+
+    lib_printf("\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_pov(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_pov(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    tab_indent();
+    lib_printf("light_source {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("<%g, %g, %g>",
+		vec[X], vec[Y], vec[Z]);
+    lib_printf(" color red %g green %g blue %g\n",
+		lscale, lscale, lscale);
+
+    tab_dec();
+    tab_indent();
+    lib_printf("} // light\n");
+
+    lib_printf("\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_polyray(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_polyray(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    tab_indent();
+    lib_printf("light <%g, %g, %g>, <%g, %g, %g>\n",
+		lscale, lscale, lscale,
+		vec[X], vec[Y], vec[Z]);
+    lib_printf("\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_vivid(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_vivid(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    tab_indent();
+    lib_printf("light {type point position %g %g %g",
+		vec[X], vec[Y], vec[Z]);
+    lib_printf(" color %g %g %g }\n",
+		lscale, lscale, lscale);
+    lib_printf("\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_qrt(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_qrt(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    tab_indent();
+    lib_printf("LAMP ( loc = (%g,%g,%g), dist = 0, radius = 1,",
+		vec[X], vec[Y], vec[Z]);
+    lib_printf(" amb = (%g,%g,%g) )\n",
+		lscale, lscale, lscale);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_rayshade(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_rayshade(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    lib_printf("light %g point %g %g %g\n",
+		lscale, vec[X], vec[Y], vec[Z]);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_rtrace(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_rtrace(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    lib_printf("1 %g %g %g %g %g %g\n",
+		vec[X], vec[Y], vec[Z], lscale, lscale, lscale);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_art(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_art(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    tab_indent();
+    lib_printf("light \n{");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("location(%g, %g, %g)  colour 0.5, 0.5, 0.5\n",
+		vec[X], vec[Y], vec[Z]);
+
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+    lib_printf("\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_rib(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_rib(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    {
+		//lib_printf("Attribute \"light\" \"shadows\" \"on\"\n");
+		lib_printf("LightSource \"shadowspot\" %d \"from\" [ %#g %#g %#g ] \"intensity\" [20] \"shadowname\" [\"raytrace\"]\n",
+		   gContext->rib_light_count++,
+						   vec[X], vec[Y], vec[Z]);
+		//lib_printf("LightSource \"pointlight\" %d \"from\" [ %#g %#g %#g ] \"intensity\" [20]\n",
+       //	 number++,
+       //	 vec[X], vec[Y], vec[Z]);
     }
 }
 
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_3dmf(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_3dmf(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    tab_indent();
+    lib_printf("Container (\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("PointLight ( %g %g %g 1 0 0 True )\n",
+		vec[X], vec[Y], vec[Z]);
+    tab_indent();
+    lib_printf("LightData ( True %g 1 1 1 )\n", lscale);
+    tab_dec();
+    tab_indent();
+    lib_printf(")\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_light_vrml(COORD4 center_pt, COORD3 vec, double lscale)
+#else
+void emit_light_vrml(center_pt, vec, lscale)
+COORD4 center_pt;
+COORD3 vec;
+double lscale;
+#endif
+{
+    tab_indent();
+    lib_printf("PointLight {\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("color 1 1 1\n");
+    tab_indent();
+    lib_printf("intensity %g\n", lscale);
+    tab_indent();
+    lib_printf("location %g %g %g\n",
+		vec[X], vec[Y], vec[Z]);
+    tab_indent();
+    lib_printf("on TRUE\n");
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+}
+
 /*-----------------------------------------------------------------*/
 /*
  * Output light.  A light is defined by position.  All lights have the same
@@ -551,7 +953,6 @@ int    resx, resy;
 	 COORD3 vec;
 	 MATRIX txmat;
 	 double lscale;
-	 light_ptr new_light;
 	 
 	 if (center_pt[W] != 0.0)
 		 lscale = center_pt[W];
@@ -566,181 +967,8 @@ int    resx, resy;
 		 lib_transform_vector(vec, vec, txmat);
 	 }
 	 
-	 switch (gRT_out_format) {
-	 case OUTPUT_DELAYED:
-		 new_light = (light_ptr)malloc(sizeof(struct light_struct));
-		 if (new_light == NULL)
-			 /* Quietly fail & return */
-			 return;
-		 COPY_COORD4(new_light->center_pt, center_pt);
-		 new_light->center_pt[W] = lscale;
-		 new_light->next = gLib_lights;
-		 gLib_lights = new_light;
-		 break;
-		 
-	 case OUTPUT_VIDEO:
-	 case OUTPUT_PLG:
-	 case OUTPUT_OBJ:
-	 case OUTPUT_RWX:
-		 /* Not currently doing anything with lights */
-		 break;
-		 
-	 case OUTPUT_NFF:
-		 fprintf(gOutfile, "l %g %g %g\n",
-			 vec[X], vec[Y], vec[Z]);
-		 break;
-		 
-	 case OUTPUT_POVRAY_10:
-		 tab_indent();
-		 fprintf(gOutfile, "object {\n");
-		 tab_inc();
-		 
-		 tab_indent();
-		 fprintf(gOutfile, "light_source {\n");
-		 tab_inc();
-		 
-		 tab_indent();
-		 fprintf(gOutfile, "<%g %g %g>",
-			 vec[X], vec[Y], vec[Z]);
-		 fprintf(gOutfile, " color red %g green %g blue %g\n",
-			 lscale, lscale, lscale);
-		 
-		 tab_dec();
-		 tab_indent();
-		 fprintf(gOutfile, "} // light\n");
-		 
-		 tab_dec();
-		 tab_indent();
-		 fprintf(gOutfile, "} // object\n");
-		 
-		 fprintf(gOutfile, "\n");
-		 break;
-		 
-	 case OUTPUT_POVRAY_20:
-	 case OUTPUT_POVRAY_30:
-		 tab_indent();
-		 fprintf(gOutfile, "light_source {\n");
-		 tab_inc();
-		 
-		 tab_indent();
-		 fprintf(gOutfile, "<%g, %g, %g>",
-			 vec[X], vec[Y], vec[Z]);
-		 fprintf(gOutfile, " color red %g green %g blue %g\n",
-			 lscale, lscale, lscale);
-		 
-		 tab_dec();
-		 tab_indent();
-		 fprintf(gOutfile, "} // light\n");
-		 
-		 fprintf(gOutfile, "\n");
-		 break;
-		 
-	 case OUTPUT_POLYRAY:
-		 tab_indent();
-		 fprintf(gOutfile, "light <%g, %g, %g>, <%g, %g, %g>\n",
-			 lscale, lscale, lscale,
-			 vec[X], vec[Y], vec[Z]);
-		 fprintf(gOutfile, "\n");
-		 break;
-		 
-	 case OUTPUT_VIVID:
-		 tab_indent();
-		 fprintf(gOutfile, "light {type point position %g %g %g",
-			 vec[X], vec[Y], vec[Z]);
-		 fprintf(gOutfile, " color %g %g %g }\n",
-			 lscale, lscale, lscale);
-		 fprintf(gOutfile, "\n");
-		 break;
-		 
-	 case OUTPUT_QRT:
-		 tab_indent();
-		 fprintf(gOutfile, "LAMP ( loc = (%g,%g,%g), dist = 0, radius = 1,",
-			 vec[X], vec[Y], vec[Z]);
-		 fprintf(gOutfile, " amb = (%g,%g,%g) )\n",
-			 lscale, lscale, lscale);
-		 break;
-		 
-	 case OUTPUT_RAYSHADE:
-		 fprintf(gOutfile, "light %g point %g %g %g\n",
-			 lscale, vec[X], vec[Y], vec[Z]);
-		 break;
-		 
-	 case OUTPUT_RTRACE:
-		 fprintf(gOutfile, "1 %g %g %g %g %g %g\n",
-			 vec[X], vec[Y], vec[Z], lscale, lscale, lscale);
-		 break;
-		 
-	 case OUTPUT_ART:
-		 tab_indent();
-		 fprintf(gOutfile, "light \n{");
-		 tab_inc();
-		 
-		 tab_indent();
-		 fprintf(gOutfile, "location(%g, %g, %g)  colour 0.5, 0.5, 0.5\n",
-			 vec[X], vec[Y], vec[Z]);
-		 
-		 tab_dec();
-		 tab_indent();
-		 fprintf(gOutfile, "}\n");
-		 fprintf(gOutfile, "\n");
-		 break;
-		 
-	 case OUTPUT_RAWTRI:
-	 case OUTPUT_DXF:
-		 break;
-		 
-	 case OUTPUT_RIB:
-		 {
-			 static int number= 0;
-			 
-			 //fprintf(gOutfile, "Attribute \"light\" \"shadows\" \"on\"\n");
-			 fprintf(gOutfile, "LightSource \"shadowspot\" %d \"from\" [ %#g %#g %#g ] \"intensity\" [20] \"shadowname\" [\"raytrace\"]\n",
-				number++,
-                                vec[X], vec[Y], vec[Z]);
-			 //fprintf(gOutfile, "LightSource \"pointlight\" %d \"from\" [ %#g %#g %#g ] \"intensity\" [20]\n",
-			//	 number++,
-			//	 vec[X], vec[Y], vec[Z]);
-		 }
-		 break;
-		 
-	 case OUTPUT_3DMF:
-		 tab_indent();
-		 fprintf(gOutfile, "Container (\n");
-		 tab_inc();
-		 tab_indent();
-		 fprintf(gOutfile, "PointLight ( %g %g %g 1 0 0 True )\n",
-			 vec[X], vec[Y], vec[Z]);
-		 tab_indent();
-		 fprintf(gOutfile, "LightData ( True %g 1 1 1 )\n", lscale);
-		 tab_dec();
-		 tab_indent();
-		 fprintf(gOutfile, ")\n");
-		 break;
-		 
-	 case OUTPUT_VRML1:
-	 case OUTPUT_VRML2:
-		 tab_indent();
-		 fprintf(gOutfile, "PointLight {\n");
-		 tab_inc();
-		 tab_indent();
-		 fprintf(gOutfile, "color 1 1 1\n");
-		 tab_indent();
-		 fprintf(gOutfile, "intensity %g\n", lscale);
-		 tab_indent();
-		 fprintf(gOutfile, "location %g %g %g\n",
-			 vec[X], vec[Y], vec[Z]);
-		 tab_indent();
-		 fprintf(gOutfile, "on TRUE\n");
-		 tab_dec();
-		 tab_indent();
-		 fprintf(gOutfile, "}\n");
-		 break;
-		 
-	 default:
-		 fprintf(stderr, "Internal Error: bad file type in libpr1.c\n");
-		 exit(1);
-		 break;
-    }
+	 if (gEmitter->light != NULL)
+		 (*gEmitter->light)(center_pt, vec, lscale);
 }
 
 /*-----------------------------------------------------------------*/
@@ -765,31 +993,35 @@ int    resx, resy;
 		 break;
 		 
 	 case OUTPUT_NFF:
-		 fprintf(gOutfile, "b %g %g %g\n", color[X], color[Y], color[Z]);
+		 lib_printf("b %g %g %g\n", color[X], color[Y], color[Z]);
+		 break;
+		 
+	 case OUTPUT_BNFF:
+		 emit_background_bnff(color);
 		 break;
 		 
 	 case OUTPUT_POVRAY_10:
 		 tab_indent();
-		 fprintf(gOutfile, "// POV-Ray 1.0 scene file\n");
+		 lib_printf("// POV-Ray 1.0 scene file\n");
 		 /* POV-Ray 1.0 does not support a background color */
 		 /* Instead, create arbitrarily large enclosing sphere of that
 		  * color */
 		 tab_indent();
-		 fprintf(gOutfile, "// background color:\n");
+		 lib_printf("// background color:\n");
 		 
 		 tab_indent();
-		 fprintf(gOutfile, "object {\n");
+		 lib_printf("object {\n");
 		 tab_inc();
 		 
 		 tab_indent();
-		 fprintf(gOutfile, "sphere { <0 0 0> 9000  ");
-		 fprintf(gOutfile,
+		 lib_printf("sphere { <0 0 0> 9000  ");
+		 lib_printf(
 			 "texture { ambient 1 diffuse 0 color red %g green %g blue %g } }\n",
 			 color[X], color[Y], color[Z]);
 		 tab_dec();
 		 tab_indent();
-		 fprintf(gOutfile, "} // object - background\n");
-		 fprintf(gOutfile, "\n");
+		 lib_printf("} // object - background\n");
+		 lib_printf("\n");
 		 break;
 		 
 	 case OUTPUT_POVRAY_20:
@@ -797,52 +1029,52 @@ int    resx, resy;
 		 if (gRT_out_format==OUTPUT_POVRAY_20)
 		 {
 			 tab_indent();
-			 fprintf(gOutfile, "// POV-Ray 2 scene file\n");
+			 lib_printf("// POV-Ray 2 scene file\n");
 		 }
 		 else
 		 {
 			 tab_indent();
-			 fprintf(gOutfile, "// POV-Ray 3 scene file\n");
+			 lib_printf("// POV-Ray 3 scene file\n");
 		 }
 		 
 		 tab_indent();
-		 fprintf(gOutfile, "background { color red %g green %g blue %g }\n",
+		 lib_printf("background { color red %g green %g blue %g }\n",
 			 color[X], color[Y], color[Z]);
-		 fprintf(gOutfile, "\n");
+		 lib_printf("\n");
 		 break;
 		 
 	 case OUTPUT_POLYRAY:
 		 tab_indent();
-		 fprintf(gOutfile, "background <%g, %g, %g>\n",
+		 lib_printf("background <%g, %g, %g>\n",
 			 color[X], color[Y], color[Z]);
-		 fprintf(gOutfile, "\n");
+		 lib_printf("\n");
 		 break;
 		 
 	 case OUTPUT_VIVID:
 		 /* Vivid insists on putting the background into the studio */
 		 tab_indent();
-		 fprintf(gOutfile, "studio { background %g %g %g }\n",
+		 lib_printf("studio { background %g %g %g }\n",
 			 color[X], color[Y], color[Z]);
-		 fprintf(gOutfile, "\n");
+		 lib_printf("\n");
 		 break;
 		 
 	 case OUTPUT_QRT:
 		 tab_indent();
-		 fprintf(gOutfile, "SKY ( horiz = (%g,%g,%g), zenith = (%g,%g,%g),",
+		 lib_printf("SKY ( horiz = (%g,%g,%g), zenith = (%g,%g,%g),",
 			 color[X], color[Y], color[Z],
 			 color[X], color[Y], color[Z]);
-		 fprintf(gOutfile, " dither = 0 )\n");
+		 lib_printf(" dither = 0 )\n");
 		 break;
 		 
 	 case OUTPUT_RAYSHADE:
-		 fprintf(gOutfile, "background %g %g %g\n",
+		 lib_printf("background %g %g %g\n",
 			 color[X], color[Y], color[Z]);
 		 break;
 		 
 	 case OUTPUT_RTRACE:
-		 fprintf(gOutfile, "Colors\n");
-		 fprintf(gOutfile, "%g %g %g\n", color[X], color[Y], color[Z]);
-		 fprintf(gOutfile, "0 0 0\n");
+		 lib_printf("Colors\n");
+		 lib_printf("%g %g %g\n", color[X], color[Y], color[Z]);
+		 lib_printf("0 0 0\n");
 		 break;
 		 
 	 case OUTPUT_RAWTRI:
@@ -851,27 +1083,27 @@ int    resx, resy;
 		 
 	 case OUTPUT_ART:
 		 tab_indent();
-		 fprintf(gOutfile, "background %g, %g, %g\n",
+		 lib_printf("background %g, %g, %g\n",
 			 color[X], color[Y], color[Z]);
-		 fprintf(gOutfile, "\n");
+		 lib_printf("\n");
 		 break;
 	 case OUTPUT_RIB:
-		 fprintf(gOutfile, "# Background color [%#g %#g %#g]\n",
+		 lib_printf("# Background color [%#g %#g %#g]\n",
 			 color[X], color[Y], color[Z]);
 		 break;
 		 
 	 case OUTPUT_3DMF:
 		 tab_indent();
-		 fprintf(gOutfile, "Container (\n");
+		 lib_printf("Container (\n");
 		 tab_inc();
 		 tab_indent();
-		 fprintf(gOutfile, "ViewHints ( )\n");
+		 lib_printf("ViewHints ( )\n");
 		 tab_indent();
-		 fprintf(gOutfile, "ImageClearColor ( %g %g %g )\n",
+		 lib_printf("ImageClearColor ( %g %g %g )\n",
 			 color[X], color[Y], color[Z]);
 		 tab_dec();
 		 tab_indent();
-		 fprintf(gOutfile, ")\n");
+		 lib_printf(")\n");
 		 break;
 		 
 	 case OUTPUT_VRML1:
@@ -880,14 +1112,14 @@ int    resx, resy;
 		 
 	 case OUTPUT_VRML2:
 		 tab_indent();
-		 fprintf(gOutfile, "Background {\n");
+		 lib_printf("Background {\n");
 		 tab_inc();
 		 tab_indent();
-		 fprintf(gOutfile, "skyColor [ %g %g %g ]\n",
+		 lib_printf("skyColor [ %g %g %g ]\n",
 			 color[X], color[Y], color[Z]);
 		 tab_dec();
 		 tab_indent();
-		 fprintf(gOutfile, "}\n");
+		 lib_printf("}\n");
 		 break;
 		 
 	 default:
@@ -899,23 +1131,788 @@ int    resx, resy;
 
 /*-----------------------------------------------------------------*/
 #ifdef ANSI_FN_DEF
-static char * create_surface_name(char *name, int val)
+static char * create_surface_name(char *name, int val)
+#else
+static char * create_surface_name(name, val)
+char *name;
+int val;
+#endif
+{
+    char *txname;
+	
+    if (name != NULL)
+		return name;
+	
+    txname = (char *)malloc(7*sizeof(char));
+    if (txname == NULL)
+		return NULL;
+    sprintf_s(txname, 7, "txt%03d", val);
+    txname[6] = '\0';
+    return txname;
+}
+
+/*-----------------------------------------------------------------*/
+/* Surface writers.  Each returns the texture name to make current, if
+   the format uses one. */
+#ifdef ANSI_FN_DEF
+char * emit_surface_delayed(char *name, COORD3 color, double ka, double kd,
+							double ks, double ks_spec, double ang, double kt,
+							double i_of_r, double phong_pow)
+#else
+char * emit_surface_delayed(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+							phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    surface_ptr new_surf;
+
+    new_surf = (surface_ptr)malloc(sizeof(struct surface_struct));
+    if (new_surf == NULL)
+		/* Quietly fail */
+		return NULL;
+    new_surf->surf_name = create_surface_name(name, gTexture_count);
+    new_surf->surf_index = gTexture_count;
+    COPY_COORD3(new_surf->color, color);
+    new_surf->ka = ka;
+    new_surf->kd = kd;
+    new_surf->ks = ks;
+    new_surf->ks_spec = ks_spec;
+    new_surf->ang = ang;
+    new_surf->kt = kt;
+    new_surf->ior = i_of_r;
+    new_surf->next = gLib_surfaces;
+    gLib_surfaces = new_surf;
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_fgnd(char *name, COORD3 color, double ka, double kd,
+						 double ks, double ks_spec, double ang, double kt,
+						 double i_of_r, double phong_pow)
+#else
+char * emit_surface_fgnd(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						 phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    COPY_COORD3(gFgnd_color, color);
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_nff(char *name, COORD3 color, double ka, double kd,
+						double ks, double ks_spec, double ang, double kt,
+						double i_of_r, double phong_pow)
+#else
+char * emit_surface_nff(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    lib_printf("f %g %g %g %g %g %g %g %g\n",
+		color[X], color[Y], color[Z], kd, ks, phong_pow, kt, i_of_r);
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_pov10(char *name, COORD3 color, double ka, double kd,
+						  double ks, double ks_spec, double ang, double kt,
+						  double i_of_r, double phong_pow)
+#else
+char * emit_surface_pov10(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						  phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    char *txname;
+
+    txname = create_surface_name(name, gTexture_count);
+    tab_indent();
+    lib_printf("#declare %s = texture {\n", txname);
+    tab_inc();
+
+    tab_indent();
+    lib_printf("color red %g green %g blue %g",
+		color[X], color[Y], color[Z]);
+    if (kt > 0)
+		lib_printf(" alpha %g", kt);
+    lib_printf("\n");
+
+    tab_indent();
+    lib_printf("ambient %g\n", ka);
+
+    tab_indent();
+    lib_printf("diffuse %g\n", kd);
+
+    if (ks_spec != 0) {
+		tab_indent();
+		lib_printf("phong %g phong_size %g\n", ks_spec, phong_pow);
+    }
+
+    if (ks != 0) {
+		tab_indent();
+		lib_printf("reflection %g\n", ks);
+    }
+
+    if (kt != 0) {
+		tab_indent();
+		lib_printf("refraction 1.0 ior %g\n", i_of_r);
+    }
+
+    tab_dec();
+    tab_indent();
+    lib_printf("} // texture %s\n", txname);
+    lib_printf("\n");
+
+    return txname;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_pov(char *name, COORD3 color, double ka, double kd,
+						double ks, double ks_spec, double ang, double kt,
+						double i_of_r, double phong_pow)
+#else
+char * emit_surface_pov(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    char *txname;
+
+    txname = create_surface_name(name, gTexture_count);
+    tab_indent();
+    lib_printf("#declare %s = texture {\n", txname);
+    tab_inc();
+
+    tab_indent();
+    lib_printf("pigment {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("color red %g green %g blue %g",
+		color[X], color[Y], color[Z]);
+    if (kt > 0)
+		lib_printf(" filter %g", kt);
+    lib_printf("\n");
+
+    tab_dec();
+    tab_indent();
+    lib_printf("} // pigment\n");
+
+    tab_indent();
+    lib_printf("// normal { bumps, ripples, etc. }\n");
+
+    tab_indent();
+    lib_printf("finish {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("ambient %g\n", ka);
+
+    tab_indent();
+    lib_printf("diffuse %g\n", kd);
+
+    if (ks_spec != 0) {
+		tab_indent();
+		/* if (gRT_out_format==OUTPUT_POVRAY_20) { */
+			lib_printf("phong %g  phong_size %g\n", ks_spec, phong_pow);
+		/* alternate: } else {
+			lib_printf("specular %g  roughness %g\n", ks_spec, (float)(1.0/(4.0*phong_pow)));
+		} */
+    }
+
+    if (ks != 0) {
+		tab_indent();
+		lib_printf("reflection %g\n", ks);
+    }
+
+    if (kt != 0) {
+		tab_indent();
+		lib_printf("refraction 1.0 ior %g\n", i_of_r);
+    }
+
+    tab_dec();
+    tab_indent();
+    lib_printf("} // finish\n");
+
+    tab_dec();
+    tab_indent();
+    lib_printf("} // texture %s\n", txname);
+    lib_printf("\n");
+
+    return txname;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_polyray(char *name, COORD3 color, double ka, double kd,
+							double ks, double ks_spec, double ang, double kt,
+							double i_of_r, double phong_pow)
+#else
+char * emit_surface_polyray(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+							phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    char *txname;
+
+    txname = create_surface_name(name, gTexture_count);
+    tab_indent();
+    lib_printf("define %s\n", txname);
+
+    tab_indent();
+    lib_printf("texture {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("surface {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("ambient <%g, %g, %g>, %g\n",
+		color[X], color[Y], color[Z], ka);
+
+    tab_indent();
+    lib_printf("diffuse <%g, %g, %g>, %g\n",
+		color[X], color[Y], color[Z], kd);
+
+    if (ks_spec != 0) {
+		tab_indent();
+		lib_printf("specular white, %g\n", ks_spec);
+		tab_indent();
+		lib_printf("microfacet Phong %g\n", ang);
+    }
+
+    if (ks != 0) {
+		tab_indent();
+		lib_printf("reflection white, %g\n", ks);
+    }
+
+    if (kt != 0) {
+		tab_indent();
+		lib_printf("transmission white, %g, %g\n", kt, i_of_r);
+    }
+
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+    lib_printf("\n");
+
+    return txname;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_vivid(char *name, COORD3 color, double ka, double kd,
+						  double ks, double ks_spec, double ang, double kt,
+						  double i_of_r, double phong_pow)
+#else
+char * emit_surface_vivid(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						  phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    tab_indent();
+    lib_printf("surface {\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("ambient %g %g %g\n",
+		ka * color[X], ka * color[Y], ka * color[Z]);
+
+    tab_indent();
+    lib_printf("diffuse %g %g %g\n",
+		kd * color[X], kd * color[Y], kd * color[Z]);
+
+    if (ks_spec != 0) {
+		tab_indent();
+		lib_printf("shine %g %g %g %g\n",
+			phong_pow, ks_spec, ks_spec, ks_spec);
+    }
+    if (ks != 0) {
+		tab_indent();
+		lib_printf("specular %g %g %g\n", ks, ks, ks);
+    }
+    if (kt != 0) {
+		tab_indent();
+		lib_printf("transparent %g %g %g\n",
+			kt * color[X], kt * color[Y], kt * color[Z]);
+		tab_indent();
+		lib_printf("ior %g\n", i_of_r);
+    }
+
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+    lib_printf("\n");
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_qrt(char *name, COORD3 color, double ka, double kd,
+						double ks, double ks_spec, double ang, double kt,
+						double i_of_r, double phong_pow)
+#else
+char * emit_surface_qrt(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    tab_indent();
+    lib_printf("DEFAULT (\n");
+    tab_inc();
+
+    tab_indent();
+    lib_printf("amb = (%g,%g,%g),\n",
+		ka * color[X], ka * color[Y], ka * color[Z]);
+    tab_indent();
+    lib_printf("diff = (%g,%g,%g),\n",
+		kd * color[X], kd * color[Y], kd * color[Z]);
+    tab_indent();
+    lib_printf("reflect = %g, sreflect = %g,\n",
+		ks_spec, phong_pow);
+    tab_indent();
+    lib_printf("mirror = (%g,%g,%g),\n",
+		ks * color[X], ks * color[Y], ks * color[Z]);
+    tab_indent();
+    lib_printf("trans = (%g,%g,%g), index = %g,\n",
+		kt * color[X], kt * color[Y], kt * color[Z], i_of_r);
+    tab_indent();
+    lib_printf("dither = 0\n");
+
+    tab_dec();
+    tab_indent();
+    lib_printf(")\n");
+    lib_printf("\n");
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_rayshade(char *name, COORD3 color, double ka, double kd,
+							 double ks, double ks_spec, double ang, double kt,
+							 double i_of_r, double phong_pow)
+#else
+char * emit_surface_rayshade(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+							 phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    char *txname;
+
+    txname = create_surface_name(name, gTexture_count);
+    tab_indent();
+    lib_printf("surface %s\n", txname);
+    tab_inc();
+
+    tab_indent();
+    lib_printf("ambient %g %g %g\n",
+		ka * color[X], ka * color[Y], ka * color[Z]);
+    tab_indent();
+    lib_printf("diffuse %g %g %g\n",
+		kd * color[X], kd * color[Y], kd * color[Z]);
+
+    if (ks_spec != 0) {
+		tab_indent();
+		lib_printf("specular %g %g %g\n", ks_spec, ks_spec, ks_spec);
+		tab_indent();
+		lib_printf("specpow %g\n", phong_pow);
+    }
+
+    if (ks != 0) {
+		if (ks_spec == 0.0) {
+		/* If there is no Phong highlighting, but there is
+		reflectivity, then we need to define the color of
+			specular reflections */
+			tab_indent();
+			lib_printf("specular 1.0 1.0 1.0\n");
+			tab_indent();
+			lib_printf("specpow 0.0\n");
+		}
+		tab_indent();
+		lib_printf("reflect %g\n", ks);
+    }
+
+    if (kt != 0) {
+		tab_indent();
+		lib_printf("transp %g index %g\n", kt, i_of_r);
+    }
+
+    tab_dec();
+    tab_indent();
+
+    return txname;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_rtrace(char *name, COORD3 color, double ka, double kd,
+						   double ks, double ks_spec, double ang, double kt,
+						   double i_of_r, double phong_pow)
+#else
+char * emit_surface_rtrace(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						   phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    if (ks_spec > 0 && ks == 0.0) ks = ks_spec;
+    lib_printf("1 %g %g %g %g %g %g %g %g %g %g 0 %g %g %g\n",
+		color[X], color[Y], color[Z],
+		kd, kd, kd,
+		ks, ks, ks,
+		(phong_pow > 100.0 ? 100.0 : phong_pow),
+		kt, kt, kt);
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_obj(char *name, COORD3 color, double ka, double kd,
+						double ks, double ks_spec, double ang, double kt,
+						double i_of_r, double phong_pow)
+#else
+char * emit_surface_obj(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    char *txname;
+
+    txname = create_surface_name(name, gTexture_count);
+    lib_printf("usemtl %s\n", txname);
+
+    return txname;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_rwx(char *name, COORD3 color, double ka, double kd,
+						double ks, double ks_spec, double ang, double kt,
+						double i_of_r, double phong_pow)
+#else
+char * emit_surface_rwx(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    tab_indent();
+    lib_printf("Color %g %g %g\n",
+		color[X], color[Y], color[Z]);
+    tab_indent();
+    lib_printf("Surface %g %g %g\n",
+		ka, kd, ks);
+    tab_indent();
+    lib_printf("Opacity %g\n",
+		1.0-kt);
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_rawtri(char *name, COORD3 color, double ka, double kd,
+						   double ks, double ks_spec, double ang, double kt,
+						   double i_of_r, double phong_pow)
+#else
+char * emit_surface_rawtri(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						   phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    char *txname;
+
+    txname = create_surface_name(name, gTexture_count);
+
+    return txname;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_art(char *name, COORD3 color, double ka, double kd,
+						double ks, double ks_spec, double ang, double kt,
+						double i_of_r, double phong_pow)
+#else
+char * emit_surface_art(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    tab_indent();
+    lib_printf("colour %g, %g, %g\n",
+		color[X], color[Y], color[Z]);
+    tab_indent();
+    lib_printf("ambient %g, %g, %g\n",
+		color[X] * 0.05, color[Y] * 0.05, color[Z] * 0.05);
+
+    if (ks != 0.0) {
+		tab_indent();
+		lib_printf("material %g, %g, %g, %g\n",
+			i_of_r, kd, ks, phong_pow);
+    } else {
+		tab_indent();
+		lib_printf("material %g, %g, 0.0, 0.0\n",
+			i_of_r, kd);
+    }
+
+    tab_indent();
+    lib_printf("reflectance %g\n", ks);
+    tab_indent();
+    lib_printf("transparency %g\n", kt);
+    lib_printf("\n");
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_rib(char *name, COORD3 color, double ka, double kd,
+						double ks, double ks_spec, double ang, double kt,
+						double i_of_r, double phong_pow)
+#else
+char * emit_surface_rib(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    lib_printf("\n");
+    if (name != NULL)
+		lib_printf("Attribute \"identifier\" \"name\" \"%s\"\n",
+		name);
+    lib_printf("Color [ %#g %#g %#g ]\n",
+		color[X], color[Y], color[Z]);
+    lib_printf("Surface \"spd\" \"Ka\" %#g \"Kd\" %#g" 
+		" \"Ks\" %#g \"roughness\" %#g \"reflected\" %#g" 
+		" \"transmitted\" %#g \"index\" %#g \n",
+		ka, kd, ks_spec, 1.0/phong_pow, ks, kt, i_of_r);
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_3dmf(char *name, COORD3 color, double ka, double kd,
+						 double ks, double ks_spec, double ang, double kt,
+						 double i_of_r, double phong_pow)
+#else
+char * emit_surface_3dmf(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						 phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    surface_ptr new_surf;
+
+    /* We need to save the texture characteristics so the table
+       of contents file can be built */
+    new_surf = (surface_ptr)malloc(sizeof(struct surface_struct));
+    if (new_surf == NULL)
+		/* Quietly fail */
+		return NULL;
+    new_surf->surf_name = create_surface_name(name, gTexture_count);
+    new_surf->surf_index = gTexture_count;
+    COPY_COORD3(new_surf->color, color);
+    new_surf->ka = ka;
+    new_surf->kd = kd;
+    new_surf->ks = ks;
+    new_surf->ks_spec = ks_spec;
+    new_surf->ang = ang;
+    new_surf->kt = kt;
+    new_surf->ior = i_of_r;
+    new_surf->next = gLib_surfaces;
+    gLib_surfaces = new_surf;
+
+    tab_indent();
+    lib_printf("%s:\nContainer ( AttributeSet ( )\n",
+		new_surf->surf_name);
+    tab_inc();
+    tab_indent();
+    lib_printf("AmbientCoefficient ( %g )\n", ka);
+    tab_indent();
+    lib_printf("DiffuseColor ( %g %g %g )\n",
+		color[X], color[Y], color[Z]);
+    tab_indent();
+    lib_printf("SpecularColor ( %g %g %g )\n", ks, ks, ks);
+    tab_indent();
+    lib_printf("SpecularControl ( %g )\n", phong_pow);
+    tab_indent();
+    lib_printf("TransparencyColor ( %g %g %g)\n",
+		kt * color[X], kt * color[Y], kt * color[Z]);
+    tab_dec();
+    tab_indent();
+    lib_printf(")\n" ) ;
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_vrml1(char *name, COORD3 color, double ka, double kd,
+						  double ks, double ks_spec, double ang, double kt,
+						  double i_of_r, double phong_pow)
+#else
+char * emit_surface_vrml1(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						  phong_pow)
+char *name;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
+#endif
+{
+    char *txname;
+
+    /* example:
+    DEF txt001 Material {
+		ambientColor 0.5 0.5 0.5
+		diffuseColor 1 0.2 0.2
+    }
+    */
+    txname = create_surface_name(name, gTexture_count);
+    tab_indent();
+    lib_printf("DEF %s Material {\n",txname);
+    tab_inc();
+    tab_indent();
+    lib_printf("ambientColor %g %g %g\n",
+		ka*color[X], ka*color[Y], ka*color[Z]);
+    if (ks_spec != 0) {
+		/* if specular, tone down the color so that the specular does not
+		 * overwhelm everything.
+		 */
+		tab_indent();
+		lib_printf("diffuseColor %g %g %g\n",
+			(float)(color[X]*kd), (float)(color[Y]*kd), (float)(color[Z]*kd));
+		tab_indent();
+		lib_printf("specularColor %g %g %g\n",
+			(float)(color[X]*ks_spec), (float)(color[Y]*ks_spec), (float)(color[Z]*ks_spec));
+
+		tab_indent();
+		lib_printf("shininess %g\n", (phong_pow > 128.0/4.0) ? 1.0f : (float)(4.0 * phong_pow / 128.0));
+    } else {
+		tab_indent();
+		lib_printf("diffuseColor %g %g %g\n",
+			(float)(color[X]*kd), (float)(color[Y]*kd), (float)(color[Z]*kd));
+    }
+
+    if (kt != 0) {
+		tab_indent();
+		lib_printf("transparency %g\n", kt);
+    }
+
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+
+    return txname;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+char * emit_surface_vrml2(char *name, COORD3 color, double ka, double kd,
+						  double ks, double ks_spec, double ang, double kt,
+						  double i_of_r, double phong_pow)
 #else
-static char * create_surface_name(name, val)
+char * emit_surface_vrml2(name, color, ka, kd, ks, ks_spec, ang, kt, i_of_r,
+						  phong_pow)
 char *name;
-int val;
+COORD3 color;
+double ka, kd, ks, ks_spec, ang, kt, i_of_r, phong_pow;
 #endif
 {
     char *txname;
-	
-    if (name != NULL)
-		return name;
-	
-    txname = (char *)malloc(7*sizeof(char));
-    if (txname == NULL)
-		return NULL;
-    sprintf_s(txname, 7, "txt%03d", val);
-    txname[6] = '\0';
+
+    /* example:
+    PROTO txt001 [] {
+		Material {
+			ambientIntensity 0
+			diffuseColor 1 0.2 0.2
+		}
+    }
+    */
+    txname = create_surface_name(name, gTexture_count);
+    tab_indent();
+    lib_printf("PROTO %s [] {\n", txname);
+    tab_inc();
+    tab_indent();
+    lib_printf("Material {\n");
+    tab_inc();
+    tab_indent();
+    lib_printf("ambientIntensity %g\n", ka);
+
+    if (ks_spec != 0) {
+		/* if specular, tone down the color so that the specular does not
+		 * overwhelm everything.
+		 */
+		tab_indent();
+		lib_printf("diffuseColor %g %g %g\n",
+			(float)(color[X]*kd), (float)(color[Y]*kd), (float)(color[Z]*kd));
+		tab_indent();
+		lib_printf("specularColor %g %g %g\n",
+			(float)(color[X]*ks_spec), (float)(color[Y]*ks_spec), (float)(color[Z]*ks_spec));
+
+		tab_indent();
+		lib_printf("shininess %g\n", (phong_pow > 128.0/4.0) ? 1.0f : (float)(4.0 * phong_pow / 128.0));
+    } else {
+		tab_indent();
+		lib_printf("diffuseColor %g %g %g\n",
+			(float)(color[X]*kd), (float)(color[Y]*kd), (float)(color[Z]*kd));
+    }
+
+    if (kt != 0) {
+		tab_indent();
+		lib_printf("transparency %g\n", kt);
+    }
+
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+    tab_dec();
+    tab_indent();
+    lib_printf("}\n");
+
     return txname;
 }
 
@@ -951,7 +1948,6 @@ COORD3 color;
 double ka, kd, ks, ks_spec, ang, kt, i_of_r;
 #endif
 {
-    surface_ptr new_surf;
     char *txname = NULL;
     double phong_pow, ang_radians;
 	
@@ -972,507 +1968,9 @@ double ka, kd, ks, ks_spec, ang, kt, i_of_r;
     ang = (float)((180.0/(2.0*PI)) * acos( exp((log(0.5))/phong_pow) ));
 	 */
 
-    switch (gRT_out_format) {
-	case OUTPUT_DELAYED:
-		new_surf = (surface_ptr)malloc(sizeof(struct surface_struct));
-		if (new_surf == NULL)
-			/* Quietly fail */
-			return NULL;
-		new_surf->surf_name = create_surface_name(name, gTexture_count);
-		new_surf->surf_index = gTexture_count;
-		COPY_COORD3(new_surf->color, color);
-		new_surf->ka = ka;
-		new_surf->kd = kd;
-		new_surf->ks = ks;
-		new_surf->ks_spec = ks_spec;
-		new_surf->ang = ang;
-		new_surf->kt = kt;
-		new_surf->ior = i_of_r;
-		new_surf->next = gLib_surfaces;
-		gLib_surfaces = new_surf;
-		break;
-		
-	case OUTPUT_PLG:
-	case OUTPUT_VIDEO:
-		COPY_COORD3(gFgnd_color, color);
-		break;
-		
-	case OUTPUT_NFF:
-		fprintf(gOutfile, "f %g %g %g %g %g %g %g %g\n",
-			color[X], color[Y], color[Z], kd, ks, phong_pow, kt, i_of_r);
-		break;
-		
-	case OUTPUT_POVRAY_10:
-		txname = create_surface_name(name, gTexture_count);
-		tab_indent();
-		fprintf(gOutfile, "#declare %s = texture {\n", txname);
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "color red %g green %g blue %g",
-			color[X], color[Y], color[Z]);
-		if (kt > 0)
-			fprintf(gOutfile, " alpha %g", kt);
-		fprintf(gOutfile, "\n");
-		
-		tab_indent();
-		fprintf(gOutfile, "ambient %g\n", ka);
-		
-		tab_indent();
-		fprintf(gOutfile, "diffuse %g\n", kd);
-		
-		if (ks_spec != 0) {
-			tab_indent();
-			fprintf(gOutfile, "phong %g phong_size %g\n", ks_spec, phong_pow);
-		}
-		
-		if (ks != 0) {
-			tab_indent();
-			fprintf(gOutfile, "reflection %g\n", ks);
-		}
-		
-		if (kt != 0) {
-			tab_indent();
-			fprintf(gOutfile, "refraction 1.0 ior %g\n", i_of_r);
-		}
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "} // texture %s\n", txname);
-		fprintf(gOutfile, "\n");
-		break;
-		
-	case OUTPUT_POVRAY_20:
-	case OUTPUT_POVRAY_30:
-		txname = create_surface_name(name, gTexture_count);
-		tab_indent();
-		fprintf(gOutfile, "#declare %s = texture {\n", txname);
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "pigment {\n");
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "color red %g green %g blue %g",
-			color[X], color[Y], color[Z]);
-		if (kt > 0)
-			fprintf(gOutfile, " filter %g", kt);
-		fprintf(gOutfile, "\n");
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "} // pigment\n");
-		
-		tab_indent();
-		fprintf(gOutfile, "// normal { bumps, ripples, etc. }\n");
-		
-		tab_indent();
-		fprintf(gOutfile, "finish {\n");
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "ambient %g\n", ka);
-		
-		tab_indent();
-		fprintf(gOutfile, "diffuse %g\n", kd);
-		
-		if (ks_spec != 0) {
-			tab_indent();
-			/* if (gRT_out_format==OUTPUT_POVRAY_20) { */
-				fprintf(gOutfile, "phong %g  phong_size %g\n", ks_spec, phong_pow);
-			/* alternate: } else {
-				fprintf(gOutfile, "specular %g  roughness %g\n", ks_spec, (float)(1.0/(4.0*phong_pow)));
-			} */
-		}
-		
-		if (ks != 0) {
-			tab_indent();
-			fprintf(gOutfile, "reflection %g\n", ks);
-		}
-		
-		if (kt != 0) {
-			tab_indent();
-			fprintf(gOutfile, "refraction 1.0 ior %g\n", i_of_r);
-		}
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "} // finish\n");
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "} // texture %s\n", txname);
-		fprintf(gOutfile, "\n");
-		break;
-		
-	case OUTPUT_POLYRAY:
-		txname = create_surface_name(name, gTexture_count);
-		tab_indent();
-		fprintf(gOutfile, "define %s\n", txname);
-		
-		tab_indent();
-		fprintf(gOutfile, "texture {\n");
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "surface {\n");
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "ambient <%g, %g, %g>, %g\n",
-			color[X], color[Y], color[Z], ka);
-		
-		tab_indent();
-		fprintf(gOutfile, "diffuse <%g, %g, %g>, %g\n",
-			color[X], color[Y], color[Z], kd);
-		
-		if (ks_spec != 0) {
-			tab_indent();
-			fprintf(gOutfile, "specular white, %g\n", ks_spec);
-			tab_indent();
-			fprintf(gOutfile, "microfacet Phong %g\n", ang);
-		}
-		
-		if (ks != 0) {
-			tab_indent();
-			fprintf(gOutfile, "reflection white, %g\n", ks);
-		}
-		
-		if (kt != 0) {
-			tab_indent();
-			fprintf(gOutfile, "transmission white, %g, %g\n", kt, i_of_r);
-		}
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-		fprintf(gOutfile, "\n");
-		break;
-		
-	case OUTPUT_VIVID:
-		tab_indent();
-		fprintf(gOutfile, "surface {\n");
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "ambient %g %g %g\n",
-			ka * color[X], ka * color[Y], ka * color[Z]);
-		
-		tab_indent();
-		fprintf(gOutfile, "diffuse %g %g %g\n",
-			kd * color[X], kd * color[Y], kd * color[Z]);
-		
-		if (ks_spec != 0) {
-			tab_indent();
-			fprintf(gOutfile, "shine %g %g %g %g\n",
-				phong_pow, ks_spec, ks_spec, ks_spec);
-		}
-		if (ks != 0) {
-			tab_indent();
-			fprintf(gOutfile, "specular %g %g %g\n", ks, ks, ks);
-		}
-		if (kt != 0) {
-			tab_indent();
-			fprintf(gOutfile, "transparent %g %g %g\n",
-				kt * color[X], kt * color[Y], kt * color[Z]);
-			tab_indent();
-			fprintf(gOutfile, "ior %g\n", i_of_r);
-		}
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-		fprintf(gOutfile, "\n");
-		break;
-		
-	case OUTPUT_QRT:
-		tab_indent();
-		fprintf(gOutfile, "DEFAULT (\n");
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "amb = (%g,%g,%g),\n",
-			ka * color[X], ka * color[Y], ka * color[Z]);
-		tab_indent();
-		fprintf(gOutfile, "diff = (%g,%g,%g),\n",
-			kd * color[X], kd * color[Y], kd * color[Z]);
-		tab_indent();
-		fprintf(gOutfile, "reflect = %g, sreflect = %g,\n",
-			ks_spec, phong_pow);
-		tab_indent();
-		fprintf(gOutfile, "mirror = (%g,%g,%g),\n",
-			ks * color[X], ks * color[Y], ks * color[Z]);
-		tab_indent();
-		fprintf(gOutfile, "trans = (%g,%g,%g), index = %g,\n",
-			kt * color[X], kt * color[Y], kt * color[Z], i_of_r);
-		tab_indent();
-		fprintf(gOutfile, "dither = 0\n");
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, ")\n");
-		fprintf(gOutfile, "\n");
-		break;
-		
-	case OUTPUT_RAYSHADE:
-		txname = create_surface_name(name, gTexture_count);
-		tab_indent();
-		fprintf(gOutfile, "surface %s\n", txname);
-		tab_inc();
-		
-		tab_indent();
-		fprintf(gOutfile, "ambient %g %g %g\n",
-			ka * color[X], ka * color[Y], ka * color[Z]);
-		tab_indent();
-		fprintf(gOutfile, "diffuse %g %g %g\n",
-			kd * color[X], kd * color[Y], kd * color[Z]);
-		
-		if (ks_spec != 0) {
-			tab_indent();
-			fprintf(gOutfile, "specular %g %g %g\n", ks_spec, ks_spec, ks_spec);
-			tab_indent();
-			fprintf(gOutfile, "specpow %g\n", phong_pow);
-		}
-		
-		if (ks != 0) {
-			if (ks_spec == 0.0) {
-			/* If there is no Phong highlighting, but there is
-			reflectivity, then we need to define the color of
-				specular reflections */
-				tab_indent();
-				fprintf(gOutfile, "specular 1.0 1.0 1.0\n");
-				tab_indent();
-				fprintf(gOutfile, "specpow 0.0\n");
-			}
-			tab_indent();
-			fprintf(gOutfile, "reflect %g\n", ks);
-		}
-		
-		if (kt != 0) {
-			tab_indent();
-			fprintf(gOutfile, "transp %g index %g\n", kt, i_of_r);
-		}
-		
-		tab_dec();
-		tab_indent();
-		break;
-		
-	case OUTPUT_RTRACE:
-		if (ks_spec > 0 && ks == 0.0) ks = ks_spec;
-		fprintf(gOutfile, "1 %g %g %g %g %g %g %g %g %g %g 0 %g %g %g\n",
-			color[X], color[Y], color[Z],
-			kd, kd, kd,
-			ks, ks, ks,
-			(phong_pow > 100.0 ? 100.0 : phong_pow),
-			kt, kt, kt);
-		break;
-		
-	case OUTPUT_OBJ:
-		txname = create_surface_name(name, gTexture_count);
-		fprintf(gOutfile, "usemtl %s\n", txname);
-		break;
-		
-	case OUTPUT_RWX:
-		tab_indent();
-		fprintf(gOutfile, "Color %g %g %g\n",
-			color[X], color[Y], color[Z]);
-		tab_indent();
-		fprintf(gOutfile, "Surface %g %g %g\n",
-			ka, kd, ks);
-		tab_indent();
-		fprintf(gOutfile, "Opacity %g\n",
-			1.0-kt);
-		break;
-		
-	case OUTPUT_RAWTRI:
-		txname = create_surface_name(name, gTexture_count);
-		break;
-		
-	case OUTPUT_ART:
-		tab_indent();
-		fprintf(gOutfile, "colour %g, %g, %g\n",
-			color[X], color[Y], color[Z]);
-		tab_indent();
-		fprintf(gOutfile, "ambient %g, %g, %g\n",
-			color[X] * 0.05, color[Y] * 0.05, color[Z] * 0.05);
-		
-		if (ks != 0.0) {
-			tab_indent();
-			fprintf(gOutfile, "material %g, %g, %g, %g\n",
-				i_of_r, kd, ks, phong_pow);
-		} else {
-			tab_indent();
-			fprintf(gOutfile, "material %g, %g, 0.0, 0.0\n",
-				i_of_r, kd);
-		}
-		
-		tab_indent();
-		fprintf(gOutfile, "reflectance %g\n", ks);
-		tab_indent();
-		fprintf(gOutfile, "transparency %g\n", kt);
-		fprintf(gOutfile, "\n");
-		break;
-	case OUTPUT_RIB:
-		fprintf(gOutfile, "\n");
-		if (name != NULL)
-			fprintf(gOutfile, "Attribute \"identifier\" \"name\" \"%s\"\n",
-			name);
-		fprintf(gOutfile, "Color [ %#g %#g %#g ]\n",
-			color[X], color[Y], color[Z]);
-		fprintf(gOutfile, "Surface \"spd\" \"Ka\" %#g \"Kd\" %#g" 
-			" \"Ks\" %#g \"roughness\" %#g \"reflected\" %#g" 
-			" \"transmitted\" %#g \"index\" %#g \n",
-			ka, kd, ks_spec, 1.0/phong_pow, ks, kt, i_of_r);
-		break;
-		
-	case OUTPUT_DXF:
-		break;
-		
-	case OUTPUT_3DMF:
-		/* We need to save the texture characteristics so the table
-		   of contents file can be built */
-		new_surf = (surface_ptr)malloc(sizeof(struct surface_struct));
-		if (new_surf == NULL)
-			/* Quietly fail */
-			return NULL;
-		new_surf->surf_name = create_surface_name(name, gTexture_count);
-		new_surf->surf_index = gTexture_count;
-		COPY_COORD3(new_surf->color, color);
-		new_surf->ka = ka;
-		new_surf->kd = kd;
-		new_surf->ks = ks;
-		new_surf->ks_spec = ks_spec;
-		new_surf->ang = ang;
-		new_surf->kt = kt;
-		new_surf->ior = i_of_r;
-		new_surf->next = gLib_surfaces;
-		gLib_surfaces = new_surf;
-		
-		tab_indent();
-		fprintf(gOutfile, "%s:\nContainer ( AttributeSet ( )\n",
-			new_surf->surf_name);
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "AmbientCoefficient ( %g )\n", ka);
-		tab_indent();
-		fprintf(gOutfile, "DiffuseColor ( %g %g %g )\n",
-			color[X], color[Y], color[Z]);
-		tab_indent();
-		fprintf(gOutfile, "SpecularColor ( %g %g %g )\n", ks, ks, ks);
-		tab_indent();
-		fprintf(gOutfile, "SpecularControl ( %g )\n", phong_pow);
-		tab_indent();
-		fprintf(gOutfile, "TransparencyColor ( %g %g %g)\n",
-			kt * color[X], kt * color[Y], kt * color[Z]);
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, ")\n" ) ;
-		break;
-		
-	case OUTPUT_VRML1:
-		/* example:
-		DEF txt001 Material {
-			ambientColor 0.5 0.5 0.5
-			diffuseColor 1 0.2 0.2
-		}
-		*/
-		txname = create_surface_name(name, gTexture_count);
-		tab_indent();
-		fprintf(gOutfile, "DEF %s Material {\n",txname);
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "ambientColor %g %g %g\n",
-			ka*color[X], ka*color[Y], ka*color[Z]);
-		if (ks_spec != 0) {
-			/* if specular, tone down the color so that the specular does not
-			 * overwhelm everything.
-			 */
-			tab_indent();
-			fprintf(gOutfile, "diffuseColor %g %g %g\n",
-				(float)(color[X]*kd), (float)(color[Y]*kd), (float)(color[Z]*kd));
-			tab_indent();
-			fprintf(gOutfile, "specularColor %g %g %g\n",
-				(float)(color[X]*ks_spec), (float)(color[Y]*ks_spec), (float)(color[Z]*ks_spec));
-			
-			tab_indent();
-			fprintf(gOutfile, "shininess %g\n", (phong_pow > 128.0/4.0) ? 1.0f : (float)(4.0 * phong_pow / 128.0));
-		} else {
-			tab_indent();
-			fprintf(gOutfile, "diffuseColor %g %g %g\n",
-				(float)(color[X]*kd), (float)(color[Y]*kd), (float)(color[Z]*kd));
-		}
-		
-		if (kt != 0) {
-			tab_indent();
-			fprintf(gOutfile, "transparency %g\n", kt);
-		}
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-		break;
-		
-	case OUTPUT_VRML2:
-		/* example:
-		PROTO txt001 [] {
-			Material {
-				ambientIntensity 0
-				diffuseColor 1 0.2 0.2
-			}
-		}
-		*/
-		txname = create_surface_name(name, gTexture_count);
-		tab_indent();
-		fprintf(gOutfile, "PROTO %s [] {\n", txname);
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "Material {\n");
-		tab_inc();
-		tab_indent();
-		fprintf(gOutfile, "ambientIntensity %g\n", ka);
-		
-		if (ks_spec != 0) {
-			/* if specular, tone down the color so that the specular does not
-			 * overwhelm everything.
-			 */
-			tab_indent();
-			fprintf(gOutfile, "diffuseColor %g %g %g\n",
-				(float)(color[X]*kd), (float)(color[Y]*kd), (float)(color[Z]*kd));
-			tab_indent();
-			fprintf(gOutfile, "specularColor %g %g %g\n",
-				(float)(color[X]*ks_spec), (float)(color[Y]*ks_spec), (float)(color[Z]*ks_spec));
-			
-			tab_indent();
-			fprintf(gOutfile, "shininess %g\n", (phong_pow > 128.0/4.0) ? 1.0f : (float)(4.0 * phong_pow / 128.0));
-		} else {
-			tab_indent();
-			fprintf(gOutfile, "diffuseColor %g %g %g\n",
-				(float)(color[X]*kd), (float)(color[Y]*kd), (float)(color[Z]*kd));
-		}
-		
-		if (kt != 0) {
-			tab_indent();
-			fprintf(gOutfile, "transparency %g\n", kt);
-		}
-		
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-		tab_dec();
-		tab_indent();
-		fprintf(gOutfile, "}\n");
-		break;
-		
-	default:
-		fprintf(stderr, "Internal Error: bad file type in libpr1.c\n");
-		exit(1);
-		break;
-    }
+    if (gEmitter->surface != NULL)
+		txname = (*gEmitter->surface)(name, color, ka, kd, ks, ks_spec, ang,
+			kt, i_of_r, phong_pow);
 	
     /* Stash away the current texture name */
     gTexture_name = txname;
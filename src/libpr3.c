@@ -24,35 +24,156 @@
 /*-----------------------------------------------------------------*/
 
 
-static unsigned int hfcount = 0;
+/* Height field files written so far, in the current context */
+#define hfcount        (gContext->hf_count)
 
-/*-----------------------------------------------------------------*/\
-/* data is between -1.0 and 1.0, for y heightfield */
+/*-----------------------------------------------------------------*/
+/*
+ * Make a height field of "height" rows of "width" samples, held in one
+ * block: sample (i,j) is hf->data[i*width+j].  Returns NULL if out of
+ * memory.
+ */
 #ifdef ANSI_FN_DEF
-static char * create_height_file(char *filename, int height, int width, float **data, int type)
+height_ptr lib_height_create (int height, int width)
 #else
-static char * create_height_file(filename, height, width, data, type)
-char *filename;
+height_ptr lib_height_create(height, width)
 int height, width;
-float **data;
+#endif
+{
+    height_ptr hf;
+
+    hf = (height_ptr)malloc(sizeof(struct height_field_struct));
+    if (hf == NULL)
+		return NULL;
+    hf->width = width;
+    hf->height = height;
+    hf->data = (float *)malloc((size_t)width * (size_t)height * sizeof(float));
+    hf->fn = NULL;
+    hf->fn_data = NULL;
+    if (hf->data == NULL) {
+		free(hf);
+		return NULL;
+    }
+    return hf;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Make a height field whose rows are made as they are needed, by calling
+ * fn(fn_data, row, width, values) to fill in "values".  A row may be asked
+ * for more than once.  Returns NULL if out of memory.
+ */
+#ifdef ANSI_FN_DEF
+height_ptr lib_height_create_rows (int height, int width,
+								   height_row_fn fn, void *fn_data)
+#else
+height_ptr lib_height_create_rows(height, width, fn, fn_data)
+int height, width;
+height_row_fn fn;
+void *fn_data;
+#endif
+{
+    height_ptr hf;
+
+    hf = (height_ptr)malloc(sizeof(struct height_field_struct));
+    if (hf == NULL)
+		return NULL;
+    hf->width = width;
+    hf->height = height;
+    hf->data = NULL;
+    hf->fn = fn;
+    hf->fn_data = fn_data;
+    return hf;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void lib_height_free (height_ptr hf)
+#else
+void lib_height_free(hf)
+height_ptr hf;
+#endif
+{
+    if (hf == NULL)
+		return;
+    if (hf->data != NULL)
+		free(hf->data);
+    free(hf);
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Returns the samples of a row.  "buf" has room for a row, and is filled
+ * in if the row has to be made; otherwise the row in the block is
+ * returned directly.
+ */
+#ifdef ANSI_FN_DEF
+float * lib_height_row (height_ptr hf, int row, float *buf)
+#else
+float * lib_height_row(hf, row, buf)
+height_ptr hf;
+int row;
+float *buf;
+#endif
+{
+    if (hf->data != NULL)
+		return &hf->data[(size_t)row * (size_t)hf->width];
+    (*hf->fn)(hf->fn_data, row, hf->width, buf);
+    return buf;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * data is between -1.0 and 1.0, for y heightfield.  The file is written a
+ * row at a time, so only a row of the field is needed at once.
+ */
+#ifdef ANSI_FN_DEF
+static char * create_height_file(char *filename, height_ptr hf, int type)
+#else
+static char * create_height_file(filename, hf, type)
+char *filename;
+height_ptr hf;
 int type;
 #endif
 {
     FILE *file;
     double v;
-    unsigned int i, j;
-    unsigned char r, g, b;
-    unsigned char tgaheader[18];
-	
+    int i, j, height, width;
+    float *buf, *row;
+    unsigned char r, g;
+    unsigned char tgaheader[18], *pix;
+
+    height = hf->height;
+    width = hf->width;
+    if ((type == 0) && ((width > 0xFFFF) || (height > 0xFFFF))) {
+		fprintf(stderr, "Height field is too large for a Targa file\n");
+		return NULL;
+    }
+
+    buf = (float *)malloc(width * sizeof(float));
+    pix = (unsigned char *)malloc(3 * width);
+    if ((buf == NULL) || (pix == NULL)) {
+		if (buf != NULL) free(buf);
+		if (pix != NULL) free(pix);
+		return NULL;
+    }
+
     if (filename == NULL) {
 		/* Need to create a new name for the height file */
 		filename = malloc(10 * sizeof(char));
-		if (filename == NULL) return NULL;
+		if (filename == NULL) {
+			free(pix);
+			free(buf);
+			return NULL;
+		}
 		sprintf_s(filename, 10, "hf%03d.tga", hfcount++);
     }
 	fopen_s(&file, filename, "wb");
-    if (file == NULL)
+    if (file == NULL) {
+		free(pix);
+		free(buf);
 		return NULL;
+    }
 
     if (type == 0) {
 		/* Targa style height field for POV-Ray or Polyray */
@@ -65,21 +186,22 @@ int type;
 		tgaheader[16] = 24;
 		tgaheader[17] = 0x20;
 		fwrite(tgaheader, 18, 1, file);
-		for (i=0;(int)i<height;i++) {
+		for (i=0;i<height;i++) {
 			PLATFORM_MULTITASK();
-			for (j=0;(int)j<width;j++) {
-				v = data[i][j]*128.0;
+			row = lib_height_row(hf, i, buf);
+			for (j=0;j<width;j++) {
+				v = row[j]*128.0;
 				if (v < -128.0) v = -128.0;
 				if (v > 127.0) v = 127.0;
 				v += 128.0;
 				r = (unsigned char)v;
 				v -= (float)r;
 				g = (unsigned char)(256.0 * v);
-				b = 0;
-				fputc(b, file);
-				fputc(g, file);
-				fputc(r, file);
+				pix[3*j] = 0;
+				pix[3*j+1] = g;
+				pix[3*j+2] = r;
 			}
+			fwrite(pix, 3, width, file);
 		}
     } else {
 		/* Only square height fields in RayShade */
@@ -90,27 +212,33 @@ int type;
 		fwrite(&height, sizeof(int), 1, file);
 		
 		/* Now store height values as native floats */
-		for (i=0;(int)i<height;i++) {
+		for (i=0;i<height;i++) {
 			PLATFORM_MULTITASK();
-			for (j=0;(int)j<width;j++)
-				fwrite(&data[i][j], sizeof(float), 1, file);
+			row = lib_height_row(hf, i, buf);
+			fwrite(row, sizeof(float), width, file);
 		}
     }
     fclose(file);
+    free(pix);
+    free(buf);
 	
     return filename;
 }
 
-
 /*-----------------------------------------------------------------*/
+/*
+ * Output a height field over x0..x1, z0..z1, with heights from y0.  In
+ * delayed mode "hf" is kept until the objects are output, so it must not
+ * be freed before lib_close.
+ */
 #ifdef ANSI_FN_DEF
-void lib_output_height(char *filename, float **data, int height, int width,
-					   double x0, double x1, double y0, double y1, double z0, double z1)
+void lib_output_height_field(char *filename, height_ptr hf,
+							 double x0, double x1, double y0, double y1,
+							 double z0, double z1)
 #else
-					   void lib_output_height(filename, data, height, width, x0, x1, y0, y1, z0, z1)
-					   char *filename;
-float **data;
-int height, width;
+void lib_output_height_field(filename, hf, x0, x1, y0, y1, z0, z1)
+char *filename;
+height_ptr hf;
 double x0, x1;
 double y0, y1;
 double z0, z1;
@@ -120,11 +248,11 @@ double z0, z1;
     object_ptr new_object;
 	
     if (gRT_out_format == OUTPUT_DELAYED) {
-		filename = create_height_file(filename, height, width, data, 0);
+		filename = create_height_file(filename, hf, 0);
 		if (filename == NULL) return;
 		
 		/* Save all the pertinent information */
-		new_object = (object_ptr)malloc(sizeof(struct object_struct));
+		new_object = (object_ptr)lib_arena_alloc(sizeof(struct object_struct));
 		if (new_object == NULL)
 			/* Quietly fail */
 			return;
@@ -134,7 +262,7 @@ double z0, z1;
 		new_object->surf_index   = gTexture_count;
 		if (lib_tx_active()) {
 			lib_get_current_tx(txmat);
-			new_object->tx = malloc(sizeof(MATRIX));
+			new_object->tx = lib_arena_alloc(sizeof(MATRIX));
 			if (new_object->tx == NULL)
 				return;
 			else
@@ -143,9 +271,7 @@ double z0, z1;
 		else
 			new_object->tx = NULL;
 
-		new_object->object_data.height.width = width;
-		new_object->object_data.height.height = height;
-		new_object->object_data.height.data = data;
+		new_object->object_data.height.field = hf;
 		new_object->object_data.height.filename = filename;
 		new_object->object_data.height.x0 = (float)x0;
 		new_object->object_data.height.x1 = (float)x1;
@@ -159,6 +285,7 @@ double z0, z1;
 		switch (gRT_out_format) {
 		case OUTPUT_VIDEO:
 		case OUTPUT_NFF:
+		case OUTPUT_BNFF:
 		case OUTPUT_PLG:
 		case OUTPUT_OBJ:
 		case OUTPUT_QRT:
@@ -170,33 +297,33 @@ double z0, z1;
 		case OUTPUT_RWX:
 		case OUTPUT_VRML1:
 		case OUTPUT_VRML2:
-			lib_output_polygon_height(height, width, data,
+			lib_output_polygon_height(hf,
 				x0, x1, y0, y1, z0, z1);
 			break;
 		case OUTPUT_POVRAY_10:
 		case OUTPUT_POVRAY_20:
 		case OUTPUT_POVRAY_30:
-			filename = create_height_file(filename, height, width, data, 0);
+			filename = create_height_file(filename, hf, 0);
 			if (filename == NULL) return;
 			
 			tab_indent();
-			fprintf(gOutfile, "object {\n");
+			lib_printf("object {\n");
 			tab_inc();
 			
 			tab_indent();
-			fprintf(gOutfile, "height_field { tga \"%s\" }", filename);
+			lib_printf("height_field { tga \"%s\" }", filename);
 			if (gRT_out_format == OUTPUT_POVRAY_10) {
 				tab_indent();
-				fprintf(gOutfile, "scale <%g %g %g>\n",
+				lib_printf("scale <%g %g %g>\n",
 					fabs(x1 - x0), fabs(y1 - y0), fabs(z1 - z0));
 				tab_indent();
-				fprintf(gOutfile, "translate <%g %g %g>\n", x0, y0, z0);
+				lib_printf("translate <%g %g %g>\n", x0, y0, z0);
 			} else {
 				tab_indent();
-				fprintf(gOutfile, "scale <%g, %g, %g>\n",
+				lib_printf("scale <%g, %g, %g>\n",
 					fabs(x1 - x0), fabs(y1 - y0), fabs(z1 - z0));
 				tab_indent();
-				fprintf(gOutfile, "translate <%g, %g, %g>\n", x0, y0, z0);
+				lib_printf("translate <%g, %g, %g>\n", x0, y0, z0);
 			}
 			
 			if (lib_tx_active())
@@ -204,77 +331,77 @@ double z0, z1;
 			
 			if (gTexture_name != NULL) {
 				tab_indent();
-				fprintf(gOutfile, "texture { %s }", gTexture_name);
+				lib_printf("texture { %s }", gTexture_name);
 			}
 			
 			tab_dec();
 			tab_indent();
-			fprintf(gOutfile, "} // object - Height Field\n");
-			fprintf(gOutfile, "\n");
+			lib_printf("} // object - Height Field\n");
+			lib_printf("\n");
 			break;
 			
 		case OUTPUT_POLYRAY:
-			filename = create_height_file(filename, height, width, data, 0);
+			filename = create_height_file(filename, hf, 0);
 			if (filename == NULL) return;
 			tab_indent();
-			fprintf(gOutfile, "object { height_field \"%s\" ", filename);
-			fprintf(gOutfile, "scale <%g, %g, %g> ",
+			lib_printf("object { height_field \"%s\" ", filename);
+			lib_printf("scale <%g, %g, %g> ",
 				fabs(x1-x0), fabs(y1-y0), fabs(z1-z0));
-			fprintf(gOutfile, "translate <%g, %g, %g> ", x0, y0, z0);
+			lib_printf("translate <%g, %g, %g> ", x0, y0, z0);
 			if (lib_tx_active())
 				lib_output_tx_sequence();
 			if (gTexture_name != NULL)
-				fprintf(gOutfile, " %s", gTexture_name);
-			fprintf(gOutfile, " }\n");
-			fprintf(gOutfile, "\n");
+				lib_printf(" %s", gTexture_name);
+			lib_printf(" }\n");
+			lib_printf("\n");
 			break;
 			
 		case OUTPUT_RAYSHADE:
-			filename = create_height_file(filename, height, width, data, 1);
+			filename = create_height_file(filename, hf, 1);
 			if (filename == NULL) return;
-			fprintf(gOutfile, "heightfield ");
+			lib_printf("heightfield ");
 			if (gTexture_name != NULL)
-				fprintf(gOutfile, "%s ", gTexture_name);
-			fprintf(gOutfile, "%s ", filename);	/* some versions may need quotes? */
-			fprintf(gOutfile, "rotate 1 0 0 90 ");
-			fprintf(gOutfile, "scale  %g %g %g ",
+				lib_printf("%s ", gTexture_name);
+			lib_printf("%s ", filename);	/* some versions may need quotes? */
+			lib_printf("rotate 1 0 0 90 ");
+			lib_printf("scale  %g %g %g ",
 				fabs(x1 - x0), fabs(y1 - y0), fabs(z1 - z0));
-			fprintf(gOutfile, "translate  %g %g %g ", x0, y0, z0);
+			lib_printf("translate  %g %g %g ", x0, y0, z0);
 			if (lib_tx_active())
 				lib_output_tx_sequence();
-			fprintf(gOutfile, "\n");
+			lib_printf("\n");
 			break;
 			
 		case OUTPUT_ART:
-			filename = create_height_file(filename, height, width, data, 1);
+			filename = create_height_file(filename, hf, 1);
 			if (filename == NULL) return;
 			
 			tab_indent();
-			fprintf(gOutfile, "geometry {\n");
+			lib_printf("geometry {\n");
 			tab_inc();
 			
 			if (lib_tx_active())
 				lib_output_tx_sequence();
 			
 			tab_indent();
-			fprintf(gOutfile, "translate(%g, %g, %g)\n", x0, y0, z0);
+			lib_printf("translate(%g, %g, %g)\n", x0, y0, z0);
 			tab_indent();
-			fprintf(gOutfile, "scale(%g, 1, %g)\n",
+			lib_printf("scale(%g, 1, %g)\n",
 				fabs(x1 - x0), fabs(z1 - z0));
 			tab_indent();
-			fprintf(gOutfile, "rotate(-90, x)\n");
+			lib_printf("rotate(-90, x)\n");
 			tab_indent();
-			fprintf(gOutfile, "heightfield \"%s\"\n ", filename);
+			lib_printf("heightfield \"%s\"\n ", filename);
 			
 			tab_dec();
 			tab_indent();
-			fprintf(gOutfile, "}\n");
-			fprintf(gOutfile, "\n");
+			lib_printf("}\n");
+			lib_printf("\n");
 			break;
 			
 		case OUTPUT_3DMF:
-			fprintf(gOutfile, "# Heightfield - we should use trigrid\n" ) ;
-			lib_output_polygon_height(height, width, data,
+			lib_printf("# Heightfield - we should use trigrid\n" ) ;
+			lib_output_polygon_height(hf,
 				x0, x1, y0, y1, z0, z1);
 			break;
 			
@@ -287,6 +414,58 @@ double z0, z1;
 }
 
 
+/*-----------------------------------------------------------------*/
+/* Fill in a row of a height field held as an array of row pointers */
+#ifdef ANSI_FN_DEF
+static void height_array_row(void *data, int row, int width, float *values)
+#else
+static void height_array_row(data, row, width, values)
+void *data;
+int row, width;
+float *values;
+#endif
+{
+    memcpy(values, ((float **)data)[row], width * sizeof(float));
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Output a height field given as "height" pointers to rows of "width"
+ * samples.  See lib_output_height_field; in delayed mode the rows must be
+ * kept until lib_close.
+ */
+#ifdef ANSI_FN_DEF
+void lib_output_height(char *filename, float **data, int height, int width,
+					   double x0, double x1, double y0, double y1, double z0, double z1)
+#else
+void lib_output_height(filename, data, height, width, x0, x1, y0, y1, z0, z1)
+char *filename;
+float **data;
+int height, width;
+double x0, x1;
+double y0, y1;
+double z0, z1;
+#endif
+{
+    struct height_field_struct field;
+    height_ptr hf;
+
+    if (gRT_out_format == OUTPUT_DELAYED) {
+		/* Kept with the deferred object */
+		hf = (height_ptr)lib_arena_alloc(sizeof(struct height_field_struct));
+		if (hf == NULL)
+			/* Quietly fail */
+			return;
+    } else
+		hf = &field;
+    hf->width = width;
+    hf->height = height;
+    hf->data = NULL;
+    hf->fn = height_array_row;
+    hf->fn_data = (void *)data;
+    lib_output_height_field(filename, hf, x0, x1, y0, y1, z0, z1);
+}
+
 /*-----------------------------------------------------------------*/
 #ifdef ANSI_FN_DEF
 void lib_output_torus (COORD3 center, COORD3 normal,
@@ -306,7 +485,7 @@ int curve_format;
 	
     if (gRT_out_format == OUTPUT_DELAYED) {
 		/* Save all the pertinent information */
-		new_object = (object_ptr)malloc(sizeof(struct object_struct));
+		new_object = (object_ptr)lib_arena_alloc(sizeof(struct object_struct));
 		if (new_object == NULL)
 			/* Quietly fail */
 			return;
@@ -315,7 +494,7 @@ int curve_format;
 		new_object->surf_index   = gTexture_count;
 		if (lib_tx_active()) {
 			lib_get_current_tx(txmat);
-			new_object->tx = malloc(sizeof(MATRIX));
+			new_object->tx = lib_arena_alloc(sizeof(MATRIX));
 			if (new_object->tx == NULL)
 				return;
 			else
@@ -333,6 +512,7 @@ int curve_format;
 		switch (gRT_out_format) {
 		case OUTPUT_VIDEO:
 		case OUTPUT_NFF:
+		case OUTPUT_BNFF:
 		case OUTPUT_VIVID:
 		case OUTPUT_QRT:
 		case OUTPUT_POVRAY_10:
@@ -352,11 +532,11 @@ int curve_format;
 			   the angles of rotation to get it lined up with "normal".
 			 */
 			tab_indent();
-			fprintf(gOutfile, "torus {\n");
+			lib_printf("torus {\n");
 			tab_inc();
 			
 			tab_indent();
-			fprintf(gOutfile, "%g, %g\n", iradius, oradius);
+			lib_printf("%g, %g\n", iradius, oradius);
 			
 			(void)lib_normalize_vector(normal);
 			len = sqrt(normal[X] * normal[X] + normal[Y] * normal[Y]);
@@ -370,14 +550,14 @@ int curve_format;
 			
 			if (ABSOLUTE(xang) > EPSILON || ABSOLUTE(zang) > EPSILON) {
 				tab_indent();
-				fprintf(gOutfile, "rotate <%g, 0, %g>\n", xang, zang);
+				lib_printf("rotate <%g, 0, %g>\n", xang, zang);
 			}
 			
 			if (ABSOLUTE(center[X]) > EPSILON ||
 				ABSOLUTE(center[Y]) > EPSILON ||
 				ABSOLUTE(center[Z]) > EPSILON) {
 				tab_indent();
-				fprintf(gOutfile, "translate <%g, %g, %g>\n",
+				lib_printf("translate <%g, %g, %g>\n",
 					center[X], center[Y], center[Z]);
 			}
 			if (lib_tx_active())
@@ -385,54 +565,54 @@ int curve_format;
 			
 			if (gTexture_name != NULL) {
 				tab_indent();
-				fprintf(gOutfile, "texture { %s }", gTexture_name);
+				lib_printf("texture { %s }", gTexture_name);
 			}
-			fprintf(gOutfile, "\n");
+			lib_printf("\n");
 			
 			tab_dec();
 			tab_indent();
-			fprintf(gOutfile, "} // torus\n");
-			fprintf(gOutfile, "\n");
+			lib_printf("} // torus\n");
+			lib_printf("\n");
 			break;
 			
 		case OUTPUT_POLYRAY:
 			tab_indent();
-			fprintf(gOutfile, "object { torus %g, %g", iradius, oradius);
-			fprintf(gOutfile, ", <%g, %g, %g>, <%g, %g, %g>",
+			lib_printf("object { torus %g, %g", iradius, oradius);
+			lib_printf(", <%g, %g, %g>, <%g, %g, %g>",
 				center[X], center[Y], center[Z],
 				normal[X], normal[Y], normal[Z]);
 			if (lib_tx_active())
 				lib_output_tx_sequence();
 			if (gTexture_name != NULL)
-				fprintf(gOutfile, " %s", gTexture_name);
-			fprintf(gOutfile, " }\n");
-			fprintf(gOutfile, "\n");
+				lib_printf(" %s", gTexture_name);
+			lib_printf(" }\n");
+			lib_printf("\n");
 			break;
 			
 		case OUTPUT_RAYSHADE:
-			fprintf(gOutfile, "torus ");
+			lib_printf("torus ");
 			if (gTexture_name != NULL)
-				fprintf(gOutfile, "%s ", gTexture_name);
-			fprintf(gOutfile, " %g %g %g %g %g %g %g %g ",
+				lib_printf("%s ", gTexture_name);
+			lib_printf(" %g %g %g %g %g %g %g %g ",
 				iradius, oradius,
 				center[X], center[Y], center[Z],
 				normal[X], normal[Y], normal[Z]);
 			if (lib_tx_active())
 				lib_output_tx_sequence();
-			fprintf(gOutfile, "\n");
+			lib_printf("\n");
 			
 			break;
 			
 		case OUTPUT_ART:
 			tab_indent();
-			fprintf(gOutfile, "torus {\n");
+			lib_printf("torus {\n");
 			tab_inc();
 			
 			if (lib_tx_active())
 				lib_output_tx_sequence();
 			
 			tab_indent();
-			fprintf(gOutfile, "center(0, 0, 0)  radius %g radius %g\n",
+			lib_printf("center(0, 0, 0)  radius %g radius %g\n",
 				iradius, oradius);
 			
 			(void)lib_normalize_vector(normal);
@@ -440,11 +620,11 @@ int curve_format;
 			
 			if (ABSOLUTE(xang) > EPSILON) {
 				tab_indent();
-				fprintf(gOutfile, "rotate (%g, x)\n", xang);
+				lib_printf("rotate (%g, x)\n", xang);
 			}
 			if (ABSOLUTE(zang) > EPSILON) {
 				tab_indent();
-				fprintf(gOutfile, "rotate (%g, y)\n", zang);
+				lib_printf("rotate (%g, y)\n", zang);
 			}
 			
 			
@@ -452,67 +632,67 @@ int curve_format;
 				ABSOLUTE(center[Y]) > EPSILON ||
 				ABSOLUTE(center[Z]) > EPSILON) {
 				tab_indent();
-				fprintf(gOutfile, "translate (%g, %g, %g)\n",
+				lib_printf("translate (%g, %g, %g)\n",
 					center[X], center[Y], center[Z]);
 			}
 			
 			tab_dec();
 			tab_indent();
-			fprintf(gOutfile, "}\n");
-			fprintf(gOutfile, "\n");
+			lib_printf("}\n");
+			lib_printf("\n");
 			break;
 			
 		case OUTPUT_3DMF:
 			if (lib_tx_active()) {
-				fprintf(gOutfile, "BeginGroup( OrderedDisplayGroup ( ) )\n");
+				lib_printf("BeginGroup( OrderedDisplayGroup ( ) )\n");
 				tab_inc();
 				lib_output_tx_sequence();
 			}
 			
 			tab_indent();
-			fprintf(gOutfile, "Container (\n");
+			lib_printf("Container (\n");
 			tab_inc();
 			
 			tab_indent();
-			fprintf(gOutfile, "Torus (\n");
+			lib_printf("Torus (\n");
 			
 			/* Find major/minor radius axes */
 			(void)lib_normalize_vector(normal);
 			lib_create_orthogonal_vectors(normal, basis1, basis2);
 			
 			tab_indent();
-			fprintf(gOutfile, "%g %g %g\n",
+			lib_printf("%g %g %g\n",
 				iradius*normal[X], iradius*normal[Y],
 				iradius*normal[Z]);
 			tab_indent();
-			fprintf(gOutfile, "%g %g %g\n",
+			lib_printf("%g %g %g\n",
 				oradius*basis1[X], oradius*basis1[Y],
 				oradius*basis1[Z]);
 			tab_indent();
-			fprintf(gOutfile, "%g %g %g\n",
+			lib_printf("%g %g %g\n",
 				oradius*basis2[X], oradius*basis2[Y],
 				oradius*basis2[Z]);
 			tab_indent();
-			fprintf(gOutfile, "%g %g %g 1.0\n",
+			lib_printf("%g %g %g 1.0\n",
 				center[X], center[Y], center[Z]);
 			tab_dec();
 			tab_indent();
-			fprintf(gOutfile, ")\n");
+			lib_printf(")\n");
 			
 			if (gTexture_count > 0) {
 				/* Write out texturing attributes */
 				tab_indent();
-				fprintf(gOutfile, "Reference ( %d )\n", gTexture_count);
+				lib_printf("Reference ( %d )\n", gTexture_count);
 			}
 			
 			tab_dec();
 			tab_indent();
-			fprintf(gOutfile, ")\n");
+			lib_printf(")\n");
 			
 			if (lib_tx_active()) {
 				tab_dec();
 				tab_indent();
-				fprintf(gOutfile, "EndGroup( )\n");
+				lib_printf("EndGroup( )\n");
 			}
 			break;
 			
@@ -639,95 +819,143 @@ float t, *x, *basis, *dbasis;
 		}
 }
 
-/* Determine the position and normal at a single coordinate
-point (u, v) on a NURB */
+/*-----------------------------------------------------------------*/
+/*
+ * Tabulate the basis functions and their derivatives at "steps"+1 parameter
+ * values from "start" by "delta", "npts" entries per value.  lo[] and hi[] get the
+ * first and last entries of each value that are not both zero.  "basis" and
+ * "dbasis" are scratch space, as long as the knot vector.
+ */
 #ifdef ANSI_FN_DEF
-static void NurbNormal(int norder, int npts,
-					   float *nknotvec, float *nbasis, float *ndbasis,
-					   int morder, int mpts,
-					   float *mknotvec, float *mbasis, float *mdbasis,
-					   COORD4 **ctlpts, int rat_flag,
-					   float u0, float v0, COORD3 P, COORD3 N)
+static void nurb_basis_table(int order, int npts, float *knotvec,
+							 float start, float delta, int steps,
+							 float *basis, float *dbasis,
+							 float *tab, float *dtab, int *lo, int *hi)
 #else
-					   static void NurbNormal(norder, npts,
-					   nknotvec, nbasis, ndbasis,
-					   morder, mpts,
-					   mknotvec, mbasis, mdbasis,
-					   ctlpts, rat_flag,
-					   u0, v0, P, N)
-					   int norder, npts, morder, mpts, rat_flag;
-float *nknotvec, *nbasis, *ndbasis;
-float *mknotvec, *mbasis, *mdbasis;
-float u0, v0;
-COORD4 **ctlpts;
-COORD3 P, N;
+static void nurb_basis_table(order, npts, knotvec, start, delta, steps,
+							 basis, dbasis, tab, dtab, lo, hi)
+int order, npts, steps;
+float *knotvec, start, delta, *basis, *dbasis, *tab, *dtab;
+int *lo, *hi;
 #endif
 {
-    float t, t1, t2, homog;
-    float D, Du, Dv;
-    int i, j, k;
-    COORD3 U, V, Nu, Nv;
-	
-    /* Calculate the basis functions */
-    NurbDBasis(norder, u0, npts, nknotvec, nbasis, ndbasis);
-    NurbDBasis(morder, v0, mpts, mknotvec, mbasis, mdbasis);
-	
-    /* Now evaluate for this point */
-    SET_COORD3(P, 0.0, 0.0, 0.0);
-    SET_COORD3(U, 0.0, 0.0, 0.0);
-    SET_COORD3(V, 0.0, 0.0, 0.0);
-	
-    /* Check for a rational component */
-    if (rat_flag) {
-		SET_COORD3(Nu, 0.0, 0.0, 0.0);
-		SET_COORD3(Nv, 0.0, 0.0, 0.0);
-		
-		D = 0.0; Du = 0.0; Dv = 0.0;
-		for (i=0;i<npts;i++) {
-			if (nbasis[i] != 0.0 || ndbasis[i] != 0.0) {
-				for (j=0;j<mpts;j++) {
-					if (mbasis[j] != 0.0 || mdbasis[j] != 0.0) {
-						/* Calculate denominator of the rational basis functions */
-						homog = (float)ctlpts[i][j][3];
-						t = homog * nbasis[i] * mbasis[j];
-						t1 = homog * ndbasis[i] * mbasis[j];
-						t2 = homog * nbasis[i] * mdbasis[j];
-						
-						D  += t;
-						Du += t1;
-						Dv += t2;
-						
-						/* Calculate the numerators of the rational basis functions */
-						for (k=0;k<3;k++) {
-							P[k]  += t  * ctlpts[i][j][k];
-							Nu[k] += t1 * ctlpts[i][j][k];
-							Nv[k] += t2 * ctlpts[i][j][k];
-						}
-					}
-				}
+    float t;
+    int i, k;
+
+    for (i=0,t=start;i<=steps;i++,t+=delta,tab+=npts,dtab+=npts) {
+		NurbDBasis(order, t, npts, knotvec, basis, dbasis);
+		lo[i] = npts;
+		hi[i] = -1;
+		for (k=0;k<npts;k++) {
+			tab[k] = basis[k];
+			dtab[k] = dbasis[k];
+			if (basis[k] != 0.0 || dbasis[k] != 0.0) {
+				if (lo[i] > k)
+					lo[i] = k;
+				hi[i] = k;
 			}
 		}
-		
-		/* Now perform the final scaling and sums */
-		D = (float)(1.0 / D);
-		for (i=0;i<3;i++) {
-			P[i] *= D;
-			U[i] = D * (Nu[i] - Du * P[i]);
-			V[i] = D * (Nv[i] - Dv * P[i]);
-		}
     }
-    else {
-		for (i=0;i<npts;i++) {
-			for (j=0;j<mpts;j++) {
-				t  = nbasis[i] * mbasis[j];
-				t1 = ndbasis[i] * mbasis[j];
-				t2 = nbasis[i] * mdbasis[j];
-				for (k=0;k<3;k++) {
-					P[k] += t  * ctlpts[i][j][k];
-					U[k] += t1 * ctlpts[i][j][k];
-					V[k] += t2 * ctlpts[i][j][k];
-				}
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Blend the rows of control points with the u basis functions "b" and their
+ * derivatives "db", over the entries lo..hi.  A[j] and Au[j] get the sums
+ * for the j'th column, with the sum of the weights in W.  Without a rational
+ * component every weight is taken to be 1.
+ */
+#ifdef ANSI_FN_DEF
+static void nurb_blend_u(int mpts, COORD4 **ctlpts, int rat_flag,
+						 float *b, float *db, int lo, int hi,
+						 COORD4 *A, COORD4 *Au)
+#else
+static void nurb_blend_u(mpts, ctlpts, rat_flag, b, db, lo, hi, A, Au)
+int mpts, rat_flag, lo, hi;
+COORD4 **ctlpts;
+float *b, *db;
+COORD4 *A, *Au;
+#endif
+{
+    COORD4 *C;
+    double t, t1;
+    int i, j;
+
+    for (j=0;j<mpts;j++) {
+		SET_COORD4(A[j], 0.0, 0.0, 0.0, 0.0);
+		SET_COORD4(Au[j], 0.0, 0.0, 0.0, 0.0);
+    }
+    for (i=lo;i<=hi;i++) {
+		C = ctlpts[i];
+		for (j=0;j<mpts;j++) {
+			t = b[i];
+			t1 = db[i];
+			if (rat_flag) {
+				t *= C[j][W];
+				t1 *= C[j][W];
 			}
+			A[j][X] += t * C[j][X];
+			A[j][Y] += t * C[j][Y];
+			A[j][Z] += t * C[j][Z];
+			A[j][W] += t;
+			Au[j][X] += t1 * C[j][X];
+			Au[j][Y] += t1 * C[j][Y];
+			Au[j][Z] += t1 * C[j][Z];
+			Au[j][W] += t1;
+		}
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Determine the position and normal at a single point on a NURB, from the
+ * control points blended in u (see nurb_blend_u) and the v basis functions
+ * "b" and their derivatives "db", over the entries lo..hi.
+ */
+#ifdef ANSI_FN_DEF
+static void nurb_point(COORD4 *A, COORD4 *Au, int rat_flag,
+					   float *b, float *db, int lo, int hi,
+					   COORD3 P, COORD3 N)
+#else
+static void nurb_point(A, Au, rat_flag, b, db, lo, hi, P, N)
+COORD4 *A, *Au;
+int rat_flag, lo, hi;
+float *b, *db;
+COORD3 P, N;
+#endif
+{
+    COORD4 S, U, V;
+    double t, t2, D;
+    int j;
+
+    SET_COORD4(S, 0.0, 0.0, 0.0, 0.0);
+    SET_COORD4(U, 0.0, 0.0, 0.0, 0.0);
+    SET_COORD4(V, 0.0, 0.0, 0.0, 0.0);
+    for (j=lo;j<=hi;j++) {
+		t = b[j];
+		t2 = db[j];
+		S[X] += t * A[j][X];
+		S[Y] += t * A[j][Y];
+		S[Z] += t * A[j][Z];
+		S[W] += t * A[j][W];
+		U[X] += t * Au[j][X];
+		U[Y] += t * Au[j][Y];
+		U[Z] += t * Au[j][Z];
+		U[W] += t * Au[j][W];
+		V[X] += t2 * A[j][X];
+		V[Y] += t2 * A[j][Y];
+		V[Z] += t2 * A[j][Z];
+		V[W] += t2 * A[j][W];
+    }
+
+    COPY_COORD3(P, S);
+    if (rat_flag) {
+		/* Divide through by the weights, and apply the quotient rule */
+		D = 1.0 / S[W];
+		for (j=0;j<3;j++) {
+			P[j] *= D;
+			U[j] = D * (U[j] - U[W] * P[j]);
+			V[j] = D * (V[j] - V[W] * P[j]);
 		}
     }
     CROSS(N, V, U);
@@ -735,54 +963,75 @@ COORD3 P, N;
 }
 
 
-/* Uniform subdivision of a NURB into triangular patches */
+/*
+ * Uniform subdivision of a NURB into triangular patches.  The u and v basis
+ * functions are tabulated once for the whole patch; each row of control
+ * points is then blended in u once per row of output, and each point is a
+ * short sum over the columns whose v basis is not zero.
+ */
 #ifdef ANSI_FN_DEF
-static void lib_output_polygon_nurb(int norder, int npts, int nknots, float *nknotvec,
-									int morder, int mpts, int mknots, float *mknotvec,
-									COORD4 **ctlpts, int rat_flag)
+static void nurb_polygons(int norder, int npts, int nknots, float *nknotvec,
+						  int morder, int mpts, int mknots, float *mknotvec,
+						  COORD4 **ctlpts, int rat_flag, int usteps, int vsteps)
 #else
-									static void lib_output_polygon_nurb(norder, npts, nknots, nknotvec,
-									morder, mpts, mknots, mknotvec,
-									ctlpts, rat_flag)
-									int norder, npts, nknots, morder, mpts, mknots, rat_flag;
+static void nurb_polygons(norder, npts, nknots, nknotvec,
+						  morder, mpts, mknots, mknotvec,
+						  ctlpts, rat_flag, usteps, vsteps)
+int norder, npts, nknots, morder, mpts, mknots, rat_flag, usteps, vsteps;
 float *nknotvec, *mknotvec;
 COORD4 **ctlpts;
 #endif
 {
-    float *nbasis, *ndbasis, *mbasis, *mdbasis;
-    float ubnd0, ubnd1, vbnd0, vbnd1;
-    float u, v, udelta, vdelta;
-    int i, j, usteps, vsteps;
+    float *basis, *dbasis;
+    float *ntab, *ndtab, *mtab, *mdtab;
+    int *nlo, *nhi, *mlo, *mhi;
+    float udelta, vdelta;
+    int i, j;
+    COORD4 *A, *Au;
     COORD3 *Prow0, *Prow1, *trow;
     COORD3 *Nrow0, *Nrow1;
     COORD3 verts[3], norms[3];
 	
-    ubnd0 = 0.0;
-    vbnd0 = 0.0;
-    ubnd1 = (float)(npts - norder + 1);
-    vbnd1 = (float)(mpts - morder + 1);
-    usteps = npts * gU_resolution;
-    vsteps = mpts * gV_resolution;
-	
-    nbasis  = (float *)malloc(nknots * sizeof(float));
-    ndbasis = (float *)malloc(nknots * sizeof(float));
-    mbasis  = (float *)malloc(mknots * sizeof(float));
-    mdbasis = (float *)malloc(mknots * sizeof(float));
+    i = (nknots > mknots) ? nknots : mknots;
+    basis  = (float *)malloc(i * sizeof(float));
+    dbasis = (float *)malloc(i * sizeof(float));
+    ntab  = (float *)malloc((usteps + 1) * npts * sizeof(float));
+    ndtab = (float *)malloc((usteps + 1) * npts * sizeof(float));
+    mtab  = (float *)malloc((vsteps + 1) * mpts * sizeof(float));
+    mdtab = (float *)malloc((vsteps + 1) * mpts * sizeof(float));
+    nlo = (int *)malloc((usteps + 1) * sizeof(int));
+    nhi = (int *)malloc((usteps + 1) * sizeof(int));
+    mlo = (int *)malloc((vsteps + 1) * sizeof(int));
+    mhi = (int *)malloc((vsteps + 1) * sizeof(int));
+    A  = (COORD4 *)malloc(mpts * sizeof(COORD4));
+    Au = (COORD4 *)malloc(mpts * sizeof(COORD4));
 	
     Prow0 = (COORD3 *)malloc((vsteps + 1) * sizeof(COORD3));
     Prow1 = (COORD3 *)malloc((vsteps + 1) * sizeof(COORD3));
     Nrow0 = (COORD3 *)malloc((vsteps + 1) * sizeof(COORD3));
     Nrow1 = (COORD3 *)malloc((vsteps + 1) * sizeof(COORD3));
+    if (!basis || !dbasis || !ntab || !ndtab || !mtab || !mdtab ||
+		!nlo || !nhi || !mlo || !mhi || !A || !Au ||
+		!Prow0 || !Prow1 || !Nrow0 || !Nrow1) {
+		fprintf(stderr, "Failed to allocate polygon data\n");
+		exit(1);
+    }
+	
+    udelta = (float)(npts - norder + 1) / (float)(usteps);
+    vdelta = (float)(mpts - morder + 1) / (float)(vsteps);
+    nurb_basis_table(norder, npts, nknotvec, 0.0, udelta, usteps,
+		basis, dbasis, ntab, ndtab, nlo, nhi);
+    nurb_basis_table(morder, mpts, mknotvec, 0.0, vdelta, vsteps,
+		basis, dbasis, mtab, mdtab, mlo, mhi);
 	
-    udelta = (ubnd1 - ubnd0) / (float)(usteps);
-    vdelta = (vbnd1 - vbnd0) / (float)(vsteps);
     rat_flag = 0 ;
-    for (i=0,u=ubnd0;i<=usteps;i++,u+=udelta) {
+    for (i=0;i<=usteps;i++) {
 		/* Generate a row of positions/normals */
-		for (j=0,v=vbnd0;j<=vsteps;j++,v+=vdelta)
-			NurbNormal(norder, npts, nknotvec, nbasis, ndbasis,
-			morder, mpts, mknotvec, mbasis, mdbasis,
-			ctlpts, rat_flag, u, v, Prow1[j], Nrow1[j]);
+		nurb_blend_u(mpts, ctlpts, rat_flag, &ntab[i*npts], &ndtab[i*npts],
+			nlo[i], nhi[i], A, Au);
+		for (j=0;j<=vsteps;j++)
+			nurb_point(A, Au, rat_flag, &mtab[j*mpts], &mdtab[j*mpts],
+				mlo[j], mhi[j], Prow1[j], Nrow1[j]);
 		
 		PLATFORM_MULTITASK();
 		
@@ -813,10 +1062,184 @@ COORD4 **ctlpts;
     free(Nrow0);
     free(Prow1);
     free(Prow0);
-    free(mdbasis);
-    free(mbasis);
-    free(ndbasis);
-    free(nbasis);
+    free(Au);
+    free(A);
+    free(mhi);
+    free(mlo);
+    free(nhi);
+    free(nlo);
+    free(mdtab);
+    free(mtab);
+    free(ndtab);
+    free(ntab);
+    free(dbasis);
+    free(basis);
+}
+
+/*-----------------------------------------------------------------*/
+/* A NURB and scratch space for evaluating it at single points */
+typedef struct {
+    int norder, npts, morder, mpts, rat_flag;
+    float *nknotvec, *mknotvec;
+    COORD4 **ctlpts;
+    float *basis, *dbasis, *ntab, *ndtab, *mtab, *mdtab;
+    COORD4 *A, *Au;
+} nurb_eval_data;
+
+/*-----------------------------------------------------------------*/
+/* Point and normal of a NURB at (u,v), for lib_output_adaptive_patch */
+#ifdef ANSI_FN_DEF
+static void nurb_eval(void *data, double u, double v, COORD3 P, COORD3 N)
+#else
+static void nurb_eval(data, u, v, P, N)
+void *data;
+double u, v;
+COORD3 P, N;
+#endif
+{
+    nurb_eval_data *nd;
+    int nlo, nhi, mlo, mhi;
+
+    nd = (nurb_eval_data *)data;
+    nurb_basis_table(nd->norder, nd->npts, nd->nknotvec, (float)u, 0.0, 0,
+		nd->basis, nd->dbasis, nd->ntab, nd->ndtab, &nlo, &nhi);
+    nurb_basis_table(nd->morder, nd->mpts, nd->mknotvec, (float)v, 0.0, 0,
+		nd->basis, nd->dbasis, nd->mtab, nd->mdtab, &mlo, &mhi);
+    nurb_blend_u(nd->mpts, nd->ctlpts, nd->rat_flag, nd->ntab, nd->ndtab,
+		nlo, nhi, nd->A, nd->Au);
+    nurb_point(nd->A, nd->Au, nd->rat_flag, nd->mtab, nd->mdtab,
+		mlo, mhi, P, N);
+}
+
+/*-----------------------------------------------------------------*/
+/* Subdivide a NURB to the patch chord tolerance, returning the number of
+   triangles output */
+#ifdef ANSI_FN_DEF
+static long nurb_adaptive(int norder, int npts, int nknots, float *nknotvec,
+						  int morder, int mpts, int mknots, float *mknotvec,
+						  COORD4 **ctlpts)
+#else
+static long nurb_adaptive(norder, npts, nknots, nknotvec,
+						  morder, mpts, mknots, mknotvec, ctlpts)
+int norder, npts, nknots, morder, mpts, mknots;
+float *nknotvec, *mknotvec;
+COORD4 **ctlpts;
+#endif
+{
+    nurb_eval_data nd;
+    long count;
+    int i;
+
+    nd.norder = norder;
+    nd.npts = npts;
+    nd.morder = morder;
+    nd.mpts = mpts;
+    /* As for uniform steps, the weights are not used */
+    nd.rat_flag = 0;
+    nd.nknotvec = nknotvec;
+    nd.mknotvec = mknotvec;
+    nd.ctlpts = ctlpts;
+    i = (nknots > mknots) ? nknots : mknots;
+    nd.basis  = (float *)malloc(i * sizeof(float));
+    nd.dbasis = (float *)malloc(i * sizeof(float));
+    nd.ntab  = (float *)malloc(npts * sizeof(float));
+    nd.ndtab = (float *)malloc(npts * sizeof(float));
+    nd.mtab  = (float *)malloc(mpts * sizeof(float));
+    nd.mdtab = (float *)malloc(mpts * sizeof(float));
+    nd.A  = (COORD4 *)malloc(mpts * sizeof(COORD4));
+    nd.Au = (COORD4 *)malloc(mpts * sizeof(COORD4));
+    if (!nd.basis || !nd.dbasis || !nd.ntab || !nd.ndtab ||
+		!nd.mtab || !nd.mdtab || !nd.A || !nd.Au) {
+		fprintf(stderr, "Failed to allocate polygon data\n");
+		exit(1);
+    }
+
+    /* Start with a cell per control point, as many as the knot spans
+       could bend */
+    count = lib_output_adaptive_patch(nurb_eval, (void *)&nd,
+		0.0, (double)(npts - norder + 1), 0.0, (double)(mpts - morder + 1),
+		npts, mpts);
+
+    free(nd.Au);
+    free(nd.A);
+    free(nd.mdtab);
+    free(nd.mtab);
+    free(nd.ndtab);
+    free(nd.ntab);
+    free(nd.dbasis);
+    free(nd.basis);
+    return count;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+static void lib_output_polygon_nurb(int norder, int npts, int nknots, float *nknotvec,
+									int morder, int mpts, int mknots, float *mknotvec,
+									COORD4 **ctlpts, int rat_flag)
+#else
+									static void lib_output_polygon_nurb(norder, npts, nknots, nknotvec,
+									morder, mpts, mknots, mknotvec,
+									ctlpts, rat_flag)
+									int norder, npts, nknots, morder, mpts, mknots, rat_flag;
+float *nknotvec, *mknotvec;
+COORD4 **ctlpts;
+#endif
+{
+    int i, j, usteps, vsteps;
+    COORD3 center, diff;
+    double bound, len;
+
+    /* The surface lies inside the hull of the control points */
+    SET_COORD3(center, 0.0, 0.0, 0.0);
+    for (i=0;i<npts;i++) {
+		for (j=0;j<mpts;j++) {
+			ADD2_COORD3(center, ctlpts[i][j]);
+		}
+    }
+    SET_COORD3(center, center[X] / (double)(npts * mpts),
+		center[Y] / (double)(npts * mpts), center[Z] / (double)(npts * mpts));
+    bound = 0.0;
+    for (i=0;i<npts;i++) {
+		for (j=0;j<mpts;j++) {
+			SUB3_COORD3(diff, ctlpts[i][j], center);
+			len = DOT_PRODUCT(diff, diff);
+			if (len > bound)
+				bound = len;
+		}
+    }
+    bound = sqrt(bound);
+
+    lib_lod_begin(center, bound, bound);
+    do {
+		if (gPatch_tolerance > 0.0) {
+			lib_tess_count(2L * npts * gU_resolution * mpts * gV_resolution,
+				nurb_adaptive(norder, npts, nknots, nknotvec,
+					morder, mpts, mknots, mknotvec, ctlpts));
+			continue;
+		}
+		usteps = npts * lib_tess_resolution(center, bound, bound,
+			gU_resolution);
+		vsteps = mpts * lib_tess_resolution(center, bound, bound,
+			gV_resolution);
+		lib_tess_count(2L * npts * gU_resolution * mpts * gV_resolution,
+			2L * usteps * vsteps);
+		nurb_polygons(norder, npts, nknots, nknotvec,
+			morder, mpts, mknots, mknotvec, ctlpts, rat_flag, usteps, vsteps);
+    } while (lib_lod_next());
+}
+
+/*-----------------------------------------------------------------*/
+/* A deferred NURB keeps its copy of the data in the object store, others
+   free it when they are done */
+#ifdef ANSI_FN_DEF
+static void *nurb_alloc(int delayed, unsigned long size)
+#else
+static void *nurb_alloc(delayed, size)
+int delayed;
+unsigned long size;
+#endif
+{
+    return delayed ? lib_arena_alloc(size) : malloc((size_t)size);
 }
 
 
@@ -837,14 +1260,15 @@ int curve_format;
     object_ptr new_object;
     float *nknotvec, *mknotvec;
     COORD4 **points;
-    int rat_flag, nknots, mknots, i, j;
+    int rat_flag, nknots, mknots, i, j, delayed;
 	rat_flag = 0;
+    delayed = (gRT_out_format == OUTPUT_DELAYED);
 	
     /* Copy the data into local structures. Build the knot vectors if
 	   they weren't passed in. */
     nknots = norder + npts;
     mknots = morder + mpts;
-    nknotvec = (float *)malloc(nknots * sizeof(float));
+    nknotvec = (float *)nurb_alloc(delayed, nknots * sizeof(float));
     if (in_nknotvec == NULL) {
 		/* Create an open uniform knot vector in the n direction */
 		nknotvec[0] = 0.0;
@@ -855,7 +1279,7 @@ int curve_format;
 				nknotvec[i] = nknotvec[i-1];
     } else
 		memcpy(nknotvec, in_nknotvec, nknots * sizeof(float));
-    mknotvec = (float *)malloc(mknots * sizeof(float));
+    mknotvec = (float *)nurb_alloc(delayed, mknots * sizeof(float));
     if (in_mknotvec == NULL) {
 		/* Create an open uniform knot vector in the m direction */
 		mknotvec[0] = 0.0;
@@ -866,9 +1290,9 @@ int curve_format;
 				mknotvec[i] = mknotvec[i-1];
     } else
 		memcpy(mknotvec, in_mknotvec, mknots * sizeof(float));
-    points = (COORD4 **)malloc(npts * sizeof(COORD4 *));
+    points = (COORD4 **)nurb_alloc(delayed, npts * sizeof(COORD4 *));
     for (i=0;i<npts;i++) {
-		points[i] = (COORD4 *)malloc(mpts * sizeof(COORD4));
+		points[i] = (COORD4 *)nurb_alloc(delayed, mpts * sizeof(COORD4));
 		memcpy(points[i], ctlpts[i], mpts * sizeof(COORD4));
 		for (j=0;j<mpts;j++)
 			if (!rat_flag && points[i][j][3] != 1.0)
@@ -876,9 +1300,9 @@ int curve_format;
 			
     }
 	
-    if (gRT_out_format == OUTPUT_DELAYED) {
+    if (delayed) {
 		/* Save all the pertinent information */
-		new_object = (object_ptr)malloc(sizeof(struct object_struct));
+		new_object = (object_ptr)lib_arena_alloc(sizeof(struct object_struct));
 		if (new_object == NULL)
 			/* Quietly fail */
 			return;
@@ -887,7 +1311,7 @@ int curve_format;
 		new_object->surf_index   = gTexture_count;
 		if (lib_tx_active()) {
 			lib_get_current_tx(txmat);
-			new_object->tx = malloc(sizeof(MATRIX));
+			new_object->tx = lib_arena_alloc(sizeof(MATRIX));
 			if (new_object->tx == NULL)
 				return;
 			else
@@ -920,10 +1344,12 @@ int curve_format;
 			points, rat_flag);
     }
 	
-    for (i=npts-1;i>=0;i--)
-		free(points[i]);
-    free(points);
-    free(mknotvec);
-    free(nknotvec);
+    if (!delayed) {
+		for (i=npts-1;i>=0;i--)
+			free(points[i]);
+		free(points);
+		free(mknotvec);
+		free(nknotvec);
+    }
 }
 
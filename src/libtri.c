@@ -0,0 +1,974 @@
+/*
+ * libtri.c - library for splitting polygons into triangles.
+ *
+ * Author:  Eric Haines
+ *
+ * The polygon is projected onto the coordinate plane most nearly parallel
+ * to it and handled in 2D.  Convex polygons are split as a fan.  Anything
+ * else is cut into y-monotone pieces by a sweep line, and each piece is
+ * then split with a stack as its two sides are merged from top to bottom.
+ * The sweep keeps the edges it crosses in a treap, so the whole job is
+ * O(n log n) for any simple polygon.  (See "Computational Geometry", de
+ * Berg et al., chapter 3.)
+ *
+ * Vertices are ordered by y, then by x, then by index, so that no two
+ * vertices are level and horizontal edges need no special handling.
+ * Polygons the sweep can't make sense of (self intersecting, or all the
+ * vertices in a line) are split as a fan.
+ */
+
+/*-----------------------------------------------------------------*/
+/* include section */
+/*-----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "lib.h"
+
+
+/*-----------------------------------------------------------------*/
+/* defines/constants section */
+/*-----------------------------------------------------------------*/
+
+#define NIL             (-1)
+
+/* Vertex types found by the sweep */
+#define START_VERTEX    0
+#define END_VERTEX      1
+#define SPLIT_VERTEX    2
+#define MERGE_VERTEX    3
+#define REGULAR_VERTEX  4
+
+/* Edge ids of the two polygon sides leaving a vertex, see split_pieces */
+#define NEXT_SIDE       (-1)
+#define PREV_SIDE       (-2)
+
+/* Which side of a monotone piece a vertex is on */
+#define LEFT_CHAIN      0
+#define RIGHT_CHAIN     1
+
+/*
+ * Scratch storage, grown as needed and kept between calls in the current
+ * context.  Vertices are referred to by their position around the polygon
+ * once it has been put in counterclockwise order; edge k runs from
+ * position k to position k+1.
+ */
+struct tri_scratch_struct {
+    int size;			/* vertices there is room for */
+    double *px;			/* projected position of each vertex */
+    double *py;
+    double *key;		/* pseudo-angle of each adjacency entry */
+    int *map;			/* original index of each position */
+    int *sorted;		/* positions in sweep order */
+    int *temp;			/* merge sort scratch */
+    int *type;			/* vertex type of each position */
+    int *left;			/* treap of edges crossing the sweep line */
+    int *right;
+    int *up;
+    int *helper;		/* lowest vertex seen to the right of an edge */
+    int *in_tree;
+    unsigned long *prio;
+    int *diag_a;		/* diagonals splitting off monotone pieces */
+    int *diag_b;
+    int *start;			/* first adjacency slot of each vertex */
+    int *slot;			/* adjacency entries, sorted by angle */
+    int *nbr;			/* vertex an adjacency entry goes to */
+    int *edge_id;		/* diagonal of an entry, or NEXT/PREV_SIDE */
+    int *seen;
+    int *pos_next;		/* slot of NEXT_SIDE at each vertex */
+    int *pos_prev;		/* slot of PREV_SIDE at each vertex */
+    int *pos_a;			/* slot of each diagonal at each end */
+    int *pos_b;
+    int *face;			/* vertices of one monotone piece */
+    int *merged;		/* ... in sweep order */
+    int *chain;
+    int *stack;
+
+    int verts;			/* vertices in the polygon being split */
+    int diags;			/* diagonals found */
+    int root;			/* top of the treap */
+    unsigned long seed;
+
+    int *tri_out;		/* output triangles, as positions */
+    int tri_count;
+};
+
+#define Scratch         (gContext->tri_scratch)
+#define ScratchSize     (Scratch->size)
+#define Px              (Scratch->px)
+#define Py              (Scratch->py)
+#define Key             (Scratch->key)
+#define Map             (Scratch->map)
+#define Sorted          (Scratch->sorted)
+#define Temp            (Scratch->temp)
+#define Type            (Scratch->type)
+#define Left            (Scratch->left)
+#define Right           (Scratch->right)
+#define Up              (Scratch->up)
+#define Helper          (Scratch->helper)
+#define InTree          (Scratch->in_tree)
+#define Prio            (Scratch->prio)
+#define DiagA           (Scratch->diag_a)
+#define DiagB           (Scratch->diag_b)
+#define Start           (Scratch->start)
+#define Slot            (Scratch->slot)
+#define Nbr             (Scratch->nbr)
+#define EdgeId          (Scratch->edge_id)
+#define Seen            (Scratch->seen)
+#define PosNext         (Scratch->pos_next)
+#define PosPrev         (Scratch->pos_prev)
+#define PosA            (Scratch->pos_a)
+#define PosB            (Scratch->pos_b)
+#define Face            (Scratch->face)
+#define Merged          (Scratch->merged)
+#define Chain           (Scratch->chain)
+#define Stack           (Scratch->stack)
+#define Verts           (Scratch->verts)
+#define Diags           (Scratch->diags)
+#define Root            (Scratch->root)
+#define Seed            (Scratch->seed)
+#define TriOut          (Scratch->tri_out)
+#define TriCount        (Scratch->tri_count)
+
+
+/*-----------------------------------------------------------------*/
+/* Free the scratch arrays, keeping the rest of the scratch state */
+static void scratch_free PARAMS((void))
+{
+    if (Px != NULL) free(Px);
+    if (Map != NULL) free(Map);
+    if (Prio != NULL) free(Prio);
+    Px = NULL;
+    Map = NULL;
+    Prio = NULL;
+    ScratchSize = 0;
+}
+
+/*-----------------------------------------------------------------*/
+/* Free the scratch storage */
+void lib_triangulate_free PARAMS((void))
+{
+    if (Scratch != NULL) {
+		scratch_free();
+		free(Scratch);
+		Scratch = NULL;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* Make room for a polygon of "n" vertices.  Returns FALSE if out of memory. */
+#ifdef ANSI_FN_DEF
+static int scratch_alloc(int n)
+#else
+static int scratch_alloc(n)
+int n;
+#endif
+{
+    double *dbuf;
+    int *ibuf;
+
+    if (Scratch == NULL) {
+		Scratch = (struct tri_scratch_struct *)
+			calloc(1, sizeof(struct tri_scratch_struct));
+		if (Scratch == NULL)
+			return FALSE;
+		Scratch->seed = 1;
+    }
+    if (n <= ScratchSize)
+		return TRUE;
+    scratch_free();
+
+    /* Adjacency lists hold both polygon sides and both ends of up to n
+       diagonals, so they need 4n entries */
+    Px = (double *)malloc(6 * (size_t)n * sizeof(double));
+    Map = (int *)malloc(40 * (size_t)n * sizeof(int));
+    Prio = (unsigned long *)malloc((size_t)n * sizeof(unsigned long));
+    gSplit_allocs += 3;
+    if ((Px == NULL) || (Map == NULL) || (Prio == NULL)) {
+		scratch_free();
+		return FALSE;
+    }
+
+    dbuf = Px;
+    Py = dbuf += n;
+    Key = dbuf += n;
+
+    ibuf = Map;
+    Sorted = ibuf += n;
+    Temp = ibuf += n;
+    Type = ibuf += 4 * n;
+    Left = ibuf += n;
+    Right = ibuf += n;
+    Up = ibuf += n;
+    Helper = ibuf += n;
+    InTree = ibuf += n;
+    DiagA = ibuf += n;
+    DiagB = ibuf += n;
+    Start = ibuf += n;
+    Slot = ibuf += n + 1;
+    Nbr = ibuf += 4 * n;
+    EdgeId = ibuf += 4 * n;
+    Seen = ibuf += 4 * n;
+    PosNext = ibuf += 4 * n;
+    PosPrev = ibuf += n;
+    PosA = ibuf += n;
+    PosB = ibuf += n;
+    Face = ibuf += n;
+    Merged = ibuf += n;
+    Chain = ibuf += n;
+    Stack = ibuf += n;
+
+    ScratchSize = n;
+    return TRUE;
+}
+
+/*-----------------------------------------------------------------*/
+/* TRUE if vertex "a" comes before vertex "b" in the sweep */
+#ifdef ANSI_FN_DEF
+static int above(int a, int b)
+#else
+static int above(a, b)
+int a, b;
+#endif
+{
+    if (Py[a] != Py[b])
+		return Py[a] > Py[b];
+    if (Px[a] != Px[b])
+		return Px[a] < Px[b];
+    return a < b;
+}
+
+/*-----------------------------------------------------------------*/
+/* Twice the signed area of triangle a, b, c; positive if counterclockwise */
+#ifdef ANSI_FN_DEF
+static double orient(int a, int b, int c)
+#else
+static double orient(a, b, c)
+int a, b, c;
+#endif
+{
+    return (Px[b] - Px[a]) * (Py[c] - Py[a]) -
+		(Py[b] - Py[a]) * (Px[c] - Px[a]);
+}
+
+/*-----------------------------------------------------------------*/
+/* TRUE if entry "a" has a smaller angle than entry "b" */
+#ifdef ANSI_FN_DEF
+static int smaller_key(int a, int b)
+#else
+static int smaller_key(a, b)
+int a, b;
+#endif
+{
+    return Key[a] < Key[b];
+}
+
+/*-----------------------------------------------------------------*/
+/* Sort "cnt" ints so that before(a[i], a[i+1]) never fails */
+#ifdef ANSI_FN_DEF
+static void merge_sort(int *a, int cnt, int (*before)(int, int))
+#else
+static void merge_sort(a, cnt, before)
+int *a, cnt;
+int (*before)();
+#endif
+{
+    int width, lo, mid, hi, i, j, k;
+
+    /* Short runs go by insertion, then runs are merged bottom up */
+    for (lo = 0; lo < cnt; lo += 8) {
+		hi = (lo + 8 < cnt) ? lo + 8 : cnt;
+		for (i = lo + 1; i < hi; i++) {
+			k = a[i];
+			for (j = i; (j > lo) && (*before)(k, a[j-1]); j--)
+				a[j] = a[j-1];
+			a[j] = k;
+		}
+    }
+    for (width = 8; width < cnt; width *= 2) {
+		for (lo = 0; lo + width < cnt; lo += 2 * width) {
+			mid = lo + width;
+			hi = (mid + width < cnt) ? mid + width : cnt;
+			i = lo;
+			j = mid;
+			k = 0;
+			while ((i < mid) && (j < hi)) {
+				if ((*before)(a[j], a[i]))
+					Temp[k++] = a[j++];
+				else
+					Temp[k++] = a[i++];
+			}
+			while (i < mid)
+				Temp[k++] = a[i++];
+			while (j < hi)
+				Temp[k++] = a[j++];
+			memcpy(&a[lo], Temp, k * sizeof(int));
+		}
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* Add a triangle of positions to the output, counterclockwise */
+#ifdef ANSI_FN_DEF
+static void add_triangle(int a, int b, int c)
+#else
+static void add_triangle(a, b, c)
+int a, b, c;
+#endif
+{
+    int *t;
+
+    t = &TriOut[3*TriCount++];
+    t[0] = a;
+    if (orient(a, b, c) < 0.0) {
+		t[1] = c;
+		t[2] = b;
+    } else {
+		t[1] = b;
+		t[2] = c;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* TRUE if the polygon is convex and winds around only once */
+static int is_convex PARAMS((void))
+{
+    int i, p, q, xflips, yflips, xdir, ydir;
+    double d;
+
+    xflips = yflips = xdir = ydir = 0;
+    for (i = 0; i < Verts; i++) {
+		p = (i == 0) ? Verts - 1 : i - 1;
+		q = (i == Verts - 1) ? 0 : i + 1;
+		if (orient(p, i, q) < 0.0)
+			return FALSE;
+
+		/* Count the times the edges turn back in x and in y */
+		d = Px[q] - Px[i];
+		if (d != 0.0) {
+			if ((d > 0.0 ? 1 : -1) != xdir) {
+				if (xdir != 0) xflips++;
+				xdir = (d > 0.0) ? 1 : -1;
+			}
+		}
+		d = Py[q] - Py[i];
+		if (d != 0.0) {
+			if ((d > 0.0 ? 1 : -1) != ydir) {
+				if (ydir != 0) yflips++;
+				ydir = (d > 0.0) ? 1 : -1;
+			}
+		}
+    }
+    return (xflips <= 2) && (yflips <= 2);
+}
+
+/*-----------------------------------------------------------------*/
+/* Position of edge "e" where it crosses the sweep line at vertex "v" */
+#ifdef ANSI_FN_DEF
+static double edge_x(int e, int v)
+#else
+static double edge_x(e, v)
+int e, v;
+#endif
+{
+    int f;
+    double lo, hi;
+
+    f = (e == Verts - 1) ? 0 : e + 1;
+    if (Py[e] == Py[f]) {
+		/* Level edges are crossed at the vertex itself */
+		lo = MIN(Px[e], Px[f]);
+		hi = MAX(Px[e], Px[f]);
+		return (Px[v] < lo) ? lo : ((Px[v] > hi) ? hi : Px[v]);
+    }
+    if (Py[v] == Py[e])
+		return Px[e];
+    if (Py[v] == Py[f])
+		return Px[f];
+    return Px[e] + (Py[v] - Py[e]) * (Px[f] - Px[e]) / (Py[f] - Py[e]);
+}
+
+/*-----------------------------------------------------------------*/
+/* Swap node "c" with its parent in the treap */
+#ifdef ANSI_FN_DEF
+static void rotate_up(int c)
+#else
+static void rotate_up(c)
+int c;
+#endif
+{
+    int p, g;
+
+    p = Up[c];
+    g = Up[p];
+    if (Left[p] == c) {
+		Left[p] = Right[c];
+		if (Right[c] != NIL) Up[Right[c]] = p;
+		Right[c] = p;
+    } else {
+		Right[p] = Left[c];
+		if (Left[c] != NIL) Up[Left[c]] = p;
+		Left[c] = p;
+    }
+    Up[p] = c;
+    Up[c] = g;
+    if (g == NIL)
+		Root = c;
+    else if (Left[g] == p)
+		Left[g] = c;
+    else
+		Right[g] = c;
+}
+
+/*-----------------------------------------------------------------*/
+/* Add edge "e", which starts at the sweep line, to the treap */
+#ifdef ANSI_FN_DEF
+static void tree_insert(int e)
+#else
+static void tree_insert(e)
+int e;
+#endif
+{
+    int node, parent;
+    int go_left;
+
+    Seed = Seed * 1103515245L + 12345L;
+    Prio[e] = Seed >> 8;
+    Left[e] = Right[e] = NIL;
+    InTree[e] = TRUE;
+
+    parent = NIL;
+    go_left = FALSE;
+    for (node = Root; node != NIL; ) {
+		parent = node;
+		go_left = (Px[e] < edge_x(node, e));
+		node = go_left ? Left[node] : Right[node];
+    }
+    Up[e] = parent;
+    if (parent == NIL)
+		Root = e;
+    else if (go_left)
+		Left[parent] = e;
+    else
+		Right[parent] = e;
+
+    while ((Up[e] != NIL) && (Prio[e] < Prio[Up[e]]))
+		rotate_up(e);
+}
+
+/*-----------------------------------------------------------------*/
+/* Take edge "e" out of the treap.  Returns FALSE if it isn't there. */
+#ifdef ANSI_FN_DEF
+static int tree_delete(int e)
+#else
+static int tree_delete(e)
+int e;
+#endif
+{
+    int p;
+
+    if (!InTree[e])
+		return FALSE;
+    InTree[e] = FALSE;
+
+    /* Rotate it down to a leaf, then cut it off */
+    while ((Left[e] != NIL) || (Right[e] != NIL)) {
+		if ((Right[e] == NIL) ||
+			((Left[e] != NIL) && (Prio[Left[e]] < Prio[Right[e]])))
+			rotate_up(Left[e]);
+		else
+			rotate_up(Right[e]);
+    }
+    p = Up[e];
+    if (p == NIL)
+		Root = NIL;
+    else if (Left[p] == e)
+		Left[p] = NIL;
+    else
+		Right[p] = NIL;
+    return TRUE;
+}
+
+/*-----------------------------------------------------------------*/
+/* Find the edge directly left of vertex "v", or NIL */
+#ifdef ANSI_FN_DEF
+static int tree_left_of(int v)
+#else
+static int tree_left_of(v)
+int v;
+#endif
+{
+    int node, best;
+
+    best = NIL;
+    for (node = Root; node != NIL; ) {
+		if (edge_x(node, v) <= Px[v]) {
+			best = node;
+			node = Right[node];
+		} else
+			node = Left[node];
+    }
+    return best;
+}
+
+/*-----------------------------------------------------------------*/
+/* Returns FALSE if there is no room for the diagonal */
+#ifdef ANSI_FN_DEF
+static int add_diagonal(int a, int b)
+#else
+static int add_diagonal(a, b)
+int a, b;
+#endif
+{
+    if (Diags >= Verts)
+		return FALSE;
+    DiagA[Diags] = a;
+    DiagB[Diags] = b;
+    Diags++;
+    return TRUE;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Sweep down the polygon, finding diagonals that cut it into monotone
+ * pieces.  Returns FALSE if the polygon turns out not to be simple.
+ */
+static int find_diagonals PARAMS((void))
+{
+    int i, k, v, p, q, e;
+
+    for (v = 0; v < Verts; v++) {
+		p = (v == 0) ? Verts - 1 : v - 1;
+		q = (v == Verts - 1) ? 0 : v + 1;
+		if (above(p, v) && above(q, v))
+			Type[v] = (orient(p, v, q) > 0.0) ? END_VERTEX : MERGE_VERTEX;
+		else if (above(v, p) && above(v, q))
+			Type[v] = (orient(p, v, q) > 0.0) ? START_VERTEX : SPLIT_VERTEX;
+		else
+			Type[v] = REGULAR_VERTEX;
+		InTree[v] = FALSE;
+		Sorted[v] = v;
+    }
+    merge_sort(Sorted, Verts, above);
+
+    Root = NIL;
+    Diags = 0;
+    for (k = 0; k < Verts; k++) {
+		v = Sorted[k];
+		p = (v == 0) ? Verts - 1 : v - 1;
+		switch (Type[v]) {
+		case START_VERTEX:
+			tree_insert(v);
+			Helper[v] = v;
+			break;
+
+		case END_VERTEX:
+			if (!InTree[p])
+				return FALSE;
+			if ((Type[Helper[p]] == MERGE_VERTEX) &&
+				!add_diagonal(v, Helper[p]))
+				return FALSE;
+			tree_delete(p);
+			break;
+
+		case SPLIT_VERTEX:
+			e = tree_left_of(v);
+			if ((e == NIL) || !add_diagonal(v, Helper[e]))
+				return FALSE;
+			Helper[e] = v;
+			tree_insert(v);
+			Helper[v] = v;
+			break;
+
+		case MERGE_VERTEX:
+			if (!InTree[p])
+				return FALSE;
+			if ((Type[Helper[p]] == MERGE_VERTEX) &&
+				!add_diagonal(v, Helper[p]))
+				return FALSE;
+			tree_delete(p);
+			e = tree_left_of(v);
+			if (e == NIL)
+				return FALSE;
+			if ((Type[Helper[e]] == MERGE_VERTEX) &&
+				!add_diagonal(v, Helper[e]))
+				return FALSE;
+			Helper[e] = v;
+			break;
+
+		default:
+			if (above(p, v)) {
+				/* Inside is to the right, the edge above ends here */
+				if (!InTree[p])
+					return FALSE;
+				if ((Type[Helper[p]] == MERGE_VERTEX) &&
+					!add_diagonal(v, Helper[p]))
+					return FALSE;
+				tree_delete(p);
+				tree_insert(v);
+				Helper[v] = v;
+			} else {
+				e = tree_left_of(v);
+				if (e == NIL)
+					return FALSE;
+				if ((Type[Helper[e]] == MERGE_VERTEX) &&
+					!add_diagonal(v, Helper[e]))
+					return FALSE;
+				Helper[e] = v;
+			}
+			break;
+		}
+    }
+
+    /* Every edge should have been closed off */
+    for (i = 0; i < Verts; i++)
+		if (InTree[i])
+			return FALSE;
+    return TRUE;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Split a monotone piece of "cnt" vertices, listed counterclockwise in
+ * Face.  Returns FALSE if the piece isn't monotone after all.
+ */
+#ifdef ANSI_FN_DEF
+static int split_monotone(int cnt)
+#else
+static int split_monotone(cnt)
+int cnt;
+#endif
+{
+    int i, j, k, top, bot, sp, last, v;
+    double turn;
+
+    if (cnt == 3) {
+		add_triangle(Face[0], Face[1], Face[2]);
+		return TRUE;
+    }
+
+    top = bot = 0;
+    for (i = 1; i < cnt; i++) {
+		if (above(Face[i], Face[top])) top = i;
+		if (above(Face[bot], Face[i])) bot = i;
+    }
+
+    /* Merge the two sides into sweep order.  Going counterclockwise from
+       the top runs down the left side. */
+    Merged[0] = Face[top];
+    Chain[0] = LEFT_CHAIN;
+    i = (top == cnt - 1) ? 0 : top + 1;
+    j = (top == 0) ? cnt - 1 : top - 1;
+    for (k = 1; (i != bot) || (j != bot); k++) {
+		if (k >= cnt - 1)
+			return FALSE;
+		if ((j == bot) || ((i != bot) && above(Face[i], Face[j]))) {
+			Merged[k] = Face[i];
+			Chain[k] = LEFT_CHAIN;
+			i = (i == cnt - 1) ? 0 : i + 1;
+		} else {
+			Merged[k] = Face[j];
+			Chain[k] = RIGHT_CHAIN;
+			j = (j == 0) ? cnt - 1 : j - 1;
+		}
+    }
+    if (k != cnt - 1)
+		return FALSE;
+    Merged[k] = Face[bot];
+
+    /* The stack holds the vertices not yet cut off, top to bottom */
+    Stack[0] = 0;
+    Stack[1] = 1;
+    sp = 2;
+    for (k = 2; k < cnt - 1; k++) {
+		if (Chain[k] != Chain[Stack[sp-1]]) {
+			/* Cut off everything on the other side */
+			while (sp > 1) {
+				sp--;
+				add_triangle(Merged[k], Merged[Stack[sp]],
+					Merged[Stack[sp-1]]);
+			}
+			Stack[0] = k - 1;
+			Stack[1] = k;
+			sp = 2;
+		} else {
+			/* Cut off what can be seen on this side */
+			last = Stack[--sp];
+			while (sp > 0) {
+				turn = orient(Merged[Stack[sp-1]], Merged[last], Merged[k]);
+				if ((Chain[k] == LEFT_CHAIN) ? (turn <= 0.0) : (turn >= 0.0))
+					break;
+				add_triangle(Merged[k], Merged[last], Merged[Stack[sp-1]]);
+				last = Stack[--sp];
+			}
+			Stack[sp++] = last;
+			Stack[sp++] = k;
+		}
+    }
+    v = Merged[cnt-1];
+    while (sp > 1) {
+		sp--;
+		add_triangle(v, Merged[Stack[sp]], Merged[Stack[sp-1]]);
+    }
+    return TRUE;
+}
+
+/*-----------------------------------------------------------------*/
+/* Angle of the direction from "a" to "b", increasing counterclockwise */
+#ifdef ANSI_FN_DEF
+static double pseudo_angle(int a, int b)
+#else
+static double pseudo_angle(a, b)
+int a, b;
+#endif
+{
+    double dx, dy, p;
+
+    dx = Px[b] - Px[a];
+    dy = Py[b] - Py[a];
+    if ((dx == 0.0) && (dy == 0.0))
+		return 0.0;
+    p = dy / (fabs(dx) + fabs(dy));
+    if (dx < 0.0)
+		return 2.0 - p;
+    if (dy < 0.0)
+		return 4.0 + p;
+    return p;
+}
+
+/*-----------------------------------------------------------------*/
+/* Add an adjacency entry from "a" to "b" at slot "s" */
+#ifdef ANSI_FN_DEF
+static void add_entry(int s, int a, int b, int id)
+#else
+static void add_entry(s, a, b, id)
+int s, a, b, id;
+#endif
+{
+    Slot[s] = s;
+    Nbr[s] = b;
+    EdgeId[s] = id;
+    Key[s] = pseudo_angle(a, b);
+    Seen[s] = FALSE;
+}
+
+/*-----------------------------------------------------------------*/
+/* Slot at the far end of the edge in slot "s" pointing back at its start */
+#ifdef ANSI_FN_DEF
+static int twin_slot(int s)
+#else
+static int twin_slot(s)
+int s;
+#endif
+{
+    int e, d;
+
+    e = Slot[s];
+    d = EdgeId[e];
+    if (d == NEXT_SIDE)
+		return PosPrev[Nbr[e]];
+    if (d == PREV_SIDE)
+		return PosNext[Nbr[e]];
+    return (Nbr[e] == DiagB[d]) ? PosB[d] : PosA[d];
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Walk around each piece the diagonals cut the polygon into, splitting
+ * each one.  Around each vertex the edges leaving it are sorted by angle;
+ * the edge after arriving along an edge is the next one clockwise from
+ * the way we came.  Returns FALSE if the pieces don't fit together.
+ */
+static int split_pieces PARAMS((void))
+{
+    int v, d, s, t, first, cnt, e;
+
+    /* Count the edges at each vertex and lay out the slots */
+    for (v = 0; v < Verts; v++)
+		Start[v+1] = 2;
+    for (d = 0; d < Diags; d++) {
+		Start[DiagA[d]+1]++;
+		Start[DiagB[d]+1]++;
+    }
+    Start[0] = 0;
+    for (v = 0; v < Verts; v++)
+		Start[v+1] += Start[v];
+
+    /* Fill in the entries, using Temp as the next free slot */
+    for (v = 0; v < Verts; v++) {
+		add_entry(Start[v], v, (v == Verts - 1) ? 0 : v + 1, NEXT_SIDE);
+		add_entry(Start[v] + 1, v, (v == 0) ? Verts - 1 : v - 1, PREV_SIDE);
+		Temp[v] = Start[v] + 2;
+    }
+    for (d = 0; d < Diags; d++) {
+		add_entry(Temp[DiagA[d]]++, DiagA[d], DiagB[d], d);
+		add_entry(Temp[DiagB[d]]++, DiagB[d], DiagA[d], d);
+    }
+
+    /* Sort each vertex's entries and note where each one ended up */
+    for (v = 0; v < Verts; v++) {
+		if (Start[v+1] - Start[v] > 2)
+			merge_sort(&Slot[Start[v]], Start[v+1] - Start[v], smaller_key);
+		for (s = Start[v]; s < Start[v+1]; s++) {
+			e = Slot[s];
+			if (EdgeId[e] == NEXT_SIDE)
+				PosNext[v] = s;
+			else if (EdgeId[e] == PREV_SIDE)
+				PosPrev[v] = s;
+			else if (DiagA[EdgeId[e]] == v)
+				PosA[EdgeId[e]] = s;
+			else
+				PosB[EdgeId[e]] = s;
+		}
+    }
+
+    for (v = 0; v < Verts; v++) {
+		for (first = Start[v]; first < Start[v+1]; first++) {
+			if (Seen[first] || (EdgeId[Slot[first]] == PREV_SIDE))
+				continue;
+			cnt = 0;
+			s = first;
+			d = v;
+			do {
+				if (Seen[s] || (cnt >= Verts))
+					return FALSE;
+				Seen[s] = TRUE;
+				Face[cnt++] = d;
+				t = twin_slot(s);
+				d = Nbr[Slot[s]];
+				s = (t == Start[d]) ? Start[d+1] - 1 : t - 1;
+				if (EdgeId[Slot[s]] == PREV_SIDE)
+					return FALSE;
+			} while (s != first);
+			if ((cnt < 3) || !split_monotone(cnt))
+				return FALSE;
+		}
+    }
+    return TRUE;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Split a polygon into triangles.  The triangles are written to "tri" as
+ * triples of indices into "vert", wound the same way as the polygon, and
+ * the number of them is returned.  There are n-2 of them, fewer if the
+ * polygon repeats vertices; "tri" needs room for 3*(n-2) indices.
+ */
+#ifdef ANSI_FN_DEF
+int lib_triangulate_polygon (int n, COORD3 *vert, int *tri)
+#else
+int lib_triangulate_polygon(n, vert, tri)
+int n;
+COORD3 *vert;
+int *tri;
+#endif
+{
+    COORD3 norm;
+    double area;
+    int axis1, axis2, i, j, k, t, ok;
+
+    if (n < 3)
+		return 0;
+    if (!scratch_alloc(n)) {
+		fprintf(stderr,
+			"Error(lib_triangulate_polygon): Can't allocate memory.\n");
+		exit(1);
+    }
+
+    /* Drop the coordinate the polygon's normal leans on most, using
+       Newell's method so any three vertices in a line don't matter */
+    SET_COORD3(norm, 0.0, 0.0, 0.0);
+    for (i = 0; i < n; i++) {
+		j = (i == n - 1) ? 0 : i + 1;
+		norm[X] += (vert[i][Y] - vert[j][Y]) * (vert[i][Z] + vert[j][Z]);
+		norm[Y] += (vert[i][Z] - vert[j][Z]) * (vert[i][X] + vert[j][X]);
+		norm[Z] += (vert[i][X] - vert[j][X]) * (vert[i][Y] + vert[j][Y]);
+    }
+    norm[X] = fabs(norm[X]);
+    norm[Y] = fabs(norm[Y]);
+    norm[Z] = fabs(norm[Z]);
+    if ((norm[X] >= norm[Y]) && (norm[X] >= norm[Z])) {
+		axis1 = Y;
+		axis2 = Z;
+    } else if (norm[Y] >= norm[Z]) {
+		axis1 = X;
+		axis2 = Z;
+    } else {
+		axis1 = X;
+		axis2 = Y;
+    }
+
+    /* Project, dropping vertices that repeat the one before */
+    Verts = 0;
+    for (i = 0; i < n; i++) {
+		if ((Verts > 0) && SAME_COORD3(vert[i], vert[Map[Verts-1]]))
+			continue;
+		Px[Verts] = vert[i][axis1];
+		Py[Verts] = vert[i][axis2];
+		Map[Verts++] = i;
+    }
+    while ((Verts > 1) && SAME_COORD3(vert[Map[Verts-1]], vert[Map[0]]))
+		Verts--;
+    if (Verts < 3)
+		return 0;
+
+    /* Put the vertices in counterclockwise order */
+    area = 0.0;
+    for (i = 0; i < Verts; i++) {
+		j = (i == Verts - 1) ? 0 : i + 1;
+		area += Px[i] * Py[j] - Px[j] * Py[i];
+    }
+    if (area < 0.0) {
+		for (i = 0, j = Verts - 1; i < j; i++, j--) {
+			t = Map[i]; Map[i] = Map[j]; Map[j] = t;
+			area = Px[i]; Px[i] = Px[j]; Px[j] = area;
+			area = Py[i]; Py[i] = Py[j]; Py[j] = area;
+		}
+		area = -1.0;
+    }
+
+    TriOut = tri;
+    TriCount = 0;
+    if (!is_convex()) {
+		ok = find_diagonals();
+		if (ok && (Diags == 0)) {
+			/* Already monotone */
+			for (i = 0; i < Verts; i++)
+				Face[i] = i;
+			ok = split_monotone(Verts);
+		} else if (ok)
+			ok = split_pieces();
+		if (!ok || (TriCount != Verts - 2))
+			TriCount = 0;
+    }
+    if (TriCount == 0) {
+		/* Convex, or nothing better can be done: use a fan around the
+		   caller's first vertex */
+		for (i = 1; i < Verts - 1; i++) {
+			if (area < 0.0) {
+				tri[3*TriCount] = Verts - 1;
+				tri[3*TriCount+1] = Verts - 2 - i;
+				tri[3*TriCount+2] = Verts - 1 - i;
+			} else {
+				tri[3*TriCount] = 0;
+				tri[3*TriCount+1] = i;
+				tri[3*TriCount+2] = i + 1;
+			}
+			TriCount++;
+		}
+    }
+
+    /* Back to the caller's indices and direction */
+    for (t = 0; t < TriCount; t++) {
+		i = Map[tri[3*t]];
+		j = Map[tri[3*t+1]];
+		k = Map[tri[3*t+2]];
+		tri[3*t] = i;
+		tri[3*t+1] = (area < 0.0) ? k : j;
+		tri[3*t+2] = (area < 0.0) ? j : k;
+    }
+    return TriCount;
+}
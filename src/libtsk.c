@@ -0,0 +1,495 @@
+/*
+ * libtsk.c - run pieces of a scene on several threads.
+ *
+ * Author:  Eric Haines
+ *
+ * A generator hands pieces of its recursion, such as the subtrees below
+ * some level, to lib_task_spawn.  With one thread, or in a build without
+ * SPD_THREADS, a task is simply run then and there.  Otherwise it is
+ * queued with a copy of the current context (format, settings, surface
+ * and transform), and run on a pool of worker threads, each task writing
+ * to an output file of its own.  Whatever the spawning thread writes
+ * between tasks is kept too, and lib_task_wait (called by lib_close)
+ * splices it all together in the order it was spawned.  The output is
+ * the same, byte for byte, as if every task had been run when spawned.
+ *
+ * Tasks are dealt to the workers in turn.  A worker runs its own tasks
+ * oldest first, so output tends to finish in the order it is spliced, and
+ * when it runs out it steals the newest task of the worker with the most
+ * left.  Tasks are large, so one lock for the whole pool is plenty.
+ *
+ * Only formats whose output for a primitive doesn't depend on what came
+ * before it can be split up this way.  OBJ and RWX number their vertices
+ * through the file, RTrace and PLG are saved up for lib_close, and levels of
+ * detail are numbered; for these, and for the screen, tasks are run when
+ * spawned.  A task must not output height fields, since their files are
+ * numbered.
+ */
+
+/*-----------------------------------------------------------------*/
+/* include section */
+/*-----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef SPD_THREADS
+#include <pthread.h>
+#endif /* SPD_THREADS */
+
+#include "lib.h"
+
+
+/*-----------------------------------------------------------------*/
+/* defines/constants section */
+/*-----------------------------------------------------------------*/
+
+/* Bytes copied at a time when splicing */
+#define SPLICE_SIZE    65536
+
+/* Starting room for tasks in a group, grown by doubling as needed */
+#define TASK_START_SIZE 64
+
+
+/*-----------------------------------------------------------------*/
+/*
+ * Run tasks on "threads" threads from now on.  1 runs each task when it
+ * is spawned.
+ */
+#ifdef ANSI_FN_DEF
+void lib_set_task_threads (int threads)
+#else
+void lib_set_task_threads(threads)
+int threads;
+#endif
+{
+    if (threads < 1)
+		threads = 1;
+    else if (threads > TASK_MAX_THREADS)
+		threads = TASK_MAX_THREADS;
+#ifndef SPD_THREADS
+    if (threads > 1) {
+		fprintf(stderr,
+			"Warning: built without SPD_THREADS, so using one thread\n");
+		threads = 1;
+    }
+#endif /* SPD_THREADS */
+    gContext->task_threads = threads;
+}
+
+#ifdef SPD_THREADS
+
+typedef struct {
+    task_fn fn;
+    void *data;                /* copy of what was passed to lib_task_spawn */
+    context_ptr context;       /* carries on from the spawner's context */
+    FILE *out;                 /* output, NULL until the task is run */
+    long main_end;             /* spawner's output before this task */
+    int done;
+} task_info;
+
+typedef struct {
+    struct task_group_struct *group;
+    int index;
+} worker_info;
+
+/*
+ * Tasks spawned from one context and not yet spliced in.  Task t is dealt
+ * to worker t % threads.  The tasks worker w has not yet started are
+ * queue[w][head[w]] up to but not including queue[w][tail[w]], oldest
+ * first.
+ */
+struct task_group_struct {
+    int threads;
+    pthread_t *thread;
+    worker_info *worker;
+    int **queue;
+    int *queue_size;
+    int *head, *tail;
+    pthread_mutex_t lock;
+    pthread_cond_t work;       /* a task was spawned, or no more will be */
+    pthread_cond_t done;       /* a task finished */
+    int ending;                /* no more tasks will be spawned */
+    task_info **task;
+    int count, size;
+    FILE *outfile;             /* where everything is spliced to */
+    FILE *main;                /* spawner's own output meanwhile */
+};
+
+
+/*-----------------------------------------------------------------*/
+/* TRUE if the current format's output can be split among tasks */
+static int task_splits PARAMS((void))
+{
+    switch (gRT_out_format) {
+	case OUTPUT_VIDEO:
+	case OUTPUT_DELAYED:
+	case OUTPUT_OBJ:
+	case OUTPUT_RWX:
+		return FALSE;
+	default:
+		return gLod_levels <= 1;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+static FILE *task_file(void)
+#else
+static FILE *task_file()
+#endif
+{
+    FILE *file;
+
+    if ((file = tmpfile()) == NULL) {
+		fprintf(stderr, "Can't open task output file\n");
+		exit(1);
+    }
+    return file;
+}
+
+/*-----------------------------------------------------------------*/
+/* Copy "file" from where it is to the end, or "len" bytes if len >= 0 */
+#ifdef ANSI_FN_DEF
+static void splice_file(FILE *outfile, FILE *file, long len)
+#else
+static void splice_file(outfile, file, len)
+FILE *outfile, *file;
+long len;
+#endif
+{
+    char buf[SPLICE_SIZE];
+    size_t n, want;
+
+    for (;;) {
+		want = ((len >= 0) && (len < SPLICE_SIZE)) ? (size_t)len : SPLICE_SIZE;
+		if (want == 0)
+			break;
+		n = fread(buf, 1, want, file);
+		if (n == 0)
+			break;
+		fwrite(buf, 1, n, outfile);
+		if (len >= 0)
+			len -= (long)n;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* Take a task for worker "w": its own oldest, or else someone's newest.
+   Call with the lock held.  Returns NULL if there are none. */
+#ifdef ANSI_FN_DEF
+static task_info *take_task(struct task_group_struct *group, int w)
+#else
+static task_info *take_task(group, w)
+struct task_group_struct *group;
+int w;
+#endif
+{
+    int i, victim, most, left;
+
+    if (group->head[w] < group->tail[w])
+		return group->task[group->queue[w][group->head[w]++]];
+    victim = -1;
+    most = 0;
+    for (i = 0; i < group->threads; i++) {
+		left = group->tail[i] - group->head[i];
+		if (left > most) {
+			most = left;
+			victim = i;
+		}
+    }
+    if (victim < 0)
+		return NULL;
+    return group->task[group->queue[victim][--group->tail[victim]]];
+}
+
+/*-----------------------------------------------------------------*/
+/* Add task "t" to the end of worker "w"'s queue.  Call with the lock
+   held. */
+#ifdef ANSI_FN_DEF
+static void queue_task(struct task_group_struct *group, int w, int t)
+#else
+static void queue_task(group, w, t)
+struct task_group_struct *group;
+int w, t;
+#endif
+{
+    int *tqueue, left;
+
+    if (group->tail[w] == group->queue_size[w]) {
+		left = group->tail[w] - group->head[w];
+		if (group->head[w] >= left) {
+			/* Plenty of room at the front, move everything down */
+			memmove(group->queue[w], &group->queue[w][group->head[w]],
+				left * sizeof(int));
+		} else {
+			tqueue = (int *)realloc(group->queue[w],
+				2 * group->queue_size[w] * sizeof(int));
+			if (tqueue == NULL) {
+				fprintf(stderr, "Failed to allocate task data\n");
+				exit(1);
+			}
+			memmove(tqueue, &tqueue[group->head[w]], left * sizeof(int));
+			group->queue[w] = tqueue;
+			group->queue_size[w] *= 2;
+		}
+		group->head[w] = 0;
+		group->tail[w] = left;
+    }
+    group->queue[w][group->tail[w]++] = t;
+}
+
+/*-----------------------------------------------------------------*/
+/* Run a task in its own context, writing to a file of its own */
+#ifdef ANSI_FN_DEF
+static void run_task(task_info *task)
+#else
+static void run_task(task)
+task_info *task;
+#endif
+{
+    lib_context_select(task->context);
+    task->out = task_file();
+    lib_set_output_file(task->out);
+    lib_buffer_output(gOutfile);
+    (*task->fn)(task->data);
+    fflush(gOutfile);
+    lib_context_select(NULL);
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+static void *task_worker(void *arg)
+#else
+static void *task_worker(arg)
+void *arg;
+#endif
+{
+    worker_info *worker;
+    struct task_group_struct *group;
+    task_info *task;
+
+    worker = (worker_info *)arg;
+    group = worker->group;
+    pthread_mutex_lock(&group->lock);
+    for (;;) {
+		task = take_task(group, worker->index);
+		if (task == NULL) {
+			if (group->ending)
+				break;
+			pthread_cond_wait(&group->work, &group->lock);
+			continue;
+		}
+		pthread_mutex_unlock(&group->lock);
+		run_task(task);
+		pthread_mutex_lock(&group->lock);
+		task->done = TRUE;
+		pthread_cond_broadcast(&group->done);
+    }
+    pthread_mutex_unlock(&group->lock);
+    return NULL;
+}
+
+/*-----------------------------------------------------------------*/
+/* Start the workers, and send the current context's output aside until
+   lib_task_wait */
+#ifdef ANSI_FN_DEF
+static struct task_group_struct *task_group_start(void)
+#else
+static struct task_group_struct *task_group_start()
+#endif
+{
+    struct task_group_struct *group;
+    int i, threads;
+
+    threads = gContext->task_threads;
+    group = (struct task_group_struct *)
+		calloc(1, sizeof(struct task_group_struct));
+    if (group != NULL) {
+		group->thread = (pthread_t *)malloc(threads * sizeof(pthread_t));
+		group->worker = (worker_info *)malloc(threads * sizeof(worker_info));
+		group->queue = (int **)calloc(threads, sizeof(int *));
+		group->queue_size = (int *)malloc(threads * sizeof(int));
+		group->head = (int *)calloc(threads, sizeof(int));
+		group->tail = (int *)calloc(threads, sizeof(int));
+		group->task = (task_info **)
+			malloc(TASK_START_SIZE * sizeof(task_info *));
+    }
+    if ((group == NULL) || (group->thread == NULL) ||
+		(group->worker == NULL) || (group->queue == NULL) ||
+		(group->queue_size == NULL) || (group->head == NULL) ||
+		(group->tail == NULL) || (group->task == NULL)) {
+		fprintf(stderr, "Failed to allocate task data\n");
+		exit(1);
+    }
+    for (i = 0; i < threads; i++) {
+		group->queue[i] = (int *)malloc(TASK_START_SIZE * sizeof(int));
+		if (group->queue[i] == NULL) {
+			fprintf(stderr, "Failed to allocate task data\n");
+			exit(1);
+		}
+		group->queue_size[i] = TASK_START_SIZE;
+		group->worker[i].group = group;
+		group->worker[i].index = i;
+    }
+    group->size = TASK_START_SIZE;
+    pthread_mutex_init(&group->lock, NULL);
+    pthread_cond_init(&group->work, NULL);
+    pthread_cond_init(&group->done, NULL);
+
+    group->outfile = gOutfile;
+    group->main = task_file();
+    lib_set_output_file(group->main);
+
+    /* Tasks are dealt only to the workers that start */
+    pthread_mutex_lock(&group->lock);
+    for (group->threads = 0; group->threads < threads; group->threads++) {
+		if (pthread_create(&group->thread[group->threads], NULL,
+			task_worker, &group->worker[group->threads]) != 0)
+			break;
+    }
+    pthread_mutex_unlock(&group->lock);
+    if (group->threads == 0) {
+		fprintf(stderr, "Can't start task threads\n");
+		exit(1);
+    }
+    for (i = group->threads; i < threads; i++)
+		free(group->queue[i]);
+    return group;
+}
+
+#endif /* SPD_THREADS */
+
+/*-----------------------------------------------------------------*/
+/*
+ * Output a piece of the scene by calling "fn" with a copy of the "size"
+ * bytes at "data".  The task may be run at once, or later on another
+ * thread; either way its output ends up here, after everything output
+ * before the call and before everything output after it.  Anything the
+ * task changes in the library (transform, surface, ...) is lost when it
+ * finishes, so it should change them back as it would when run in line.
+ */
+#ifdef ANSI_FN_DEF
+void lib_task_spawn (task_fn fn, void *data, int size)
+#else
+void lib_task_spawn(fn, data, size)
+task_fn fn;
+void *data;
+int size;
+#endif
+{
+#ifdef SPD_THREADS
+    struct task_group_struct *group;
+    task_info *task, **ttask;
+
+    if ((gContext->task_threads > 1) && task_splits()) {
+		if (gContext->task_group == NULL)
+			gContext->task_group = task_group_start();
+		group = gContext->task_group;
+
+		task = (task_info *)malloc(sizeof(task_info));
+		if (task != NULL)
+			task->data = malloc(size > 0 ? size : 1);
+		if ((task == NULL) || (task->data == NULL) ||
+			((task->context = lib_context_fork()) == NULL)) {
+			fprintf(stderr, "Failed to allocate task data\n");
+			exit(1);
+		}
+		memcpy(task->data, data, size);
+		task->fn = fn;
+		task->out = NULL;
+		task->main_end = ftell(gOutfile);
+		task->done = FALSE;
+
+		pthread_mutex_lock(&group->lock);
+		if (group->count == group->size) {
+			ttask = (task_info **)realloc(group->task,
+				2 * group->size * sizeof(task_info *));
+			if (ttask == NULL) {
+				fprintf(stderr, "Failed to allocate task data\n");
+				exit(1);
+			}
+			group->task = ttask;
+			group->size *= 2;
+		}
+		group->task[group->count] = task;
+		queue_task(group, group->count % group->threads, group->count);
+		group->count++;
+		pthread_cond_signal(&group->work);
+		pthread_mutex_unlock(&group->lock);
+		return;
+    }
+#endif /* SPD_THREADS */
+    (*fn)(data);
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Wait for the tasks spawned from the current context to finish, and
+ * splice their output in where they were spawned.
+ */
+void
+lib_task_wait PARAMS((void))
+{
+#ifdef SPD_THREADS
+    struct task_group_struct *group;
+    task_info *task;
+    long main_pos;
+    int t;
+
+    if ((group = gContext->task_group) == NULL)
+		return;
+
+    pthread_mutex_lock(&group->lock);
+    group->ending = TRUE;
+    pthread_cond_broadcast(&group->work);
+    pthread_mutex_unlock(&group->lock);
+
+    fflush(group->main);
+    rewind(group->main);
+    main_pos = 0;
+    for (t = 0; t < group->count; t++) {
+		task = group->task[t];
+		splice_file(group->outfile, group->main, task->main_end - main_pos);
+		main_pos = task->main_end;
+
+		pthread_mutex_lock(&group->lock);
+		while (!task->done)
+			pthread_cond_wait(&group->done, &group->lock);
+		pthread_mutex_unlock(&group->lock);
+
+		rewind(task->out);
+		splice_file(group->outfile, task->out, -1L);
+		fclose(task->out);
+
+		gSplit_polygons += task->context->split_polygons;
+		gSplit_triangles += task->context->split_triangles;
+		gSplit_allocs += task->context->split_allocs;
+		gAdaptive_triangles += task->context->adaptive_triangles;
+		gAdaptive_fixed += task->context->adaptive_fixed;
+		lib_context_free(task->context);
+		free(task->data);
+		free(task);
+    }
+    splice_file(group->outfile, group->main, -1L);
+    fclose(group->main);
+    lib_set_output_file(group->outfile);
+
+    for (t = 0; t < group->threads; t++)
+		pthread_join(group->thread[t], NULL);
+    pthread_cond_destroy(&group->done);
+    pthread_cond_destroy(&group->work);
+    pthread_mutex_destroy(&group->lock);
+    for (t = 0; t < group->threads; t++)
+		free(group->queue[t]);
+    free(group->task);
+    free(group->tail);
+    free(group->head);
+    free(group->queue_size);
+    free(group->queue);
+    free(group->worker);
+    free(group->thread);
+    free(group);
+    gContext->task_group = NULL;
+#endif /* SPD_THREADS */
+}
@@ -23,6 +23,9 @@
 typedef struct tx_struct *tx_ptr;
 struct tx_struct {
    MATRIX tx;
+   int active;                /* TxActive, NormalTx and NormalTxDirty */
+   MATRIX normal_tx;          /*   for tx, so a pop needn't redo them */
+   int normal_dirty;
    tx_ptr next;
    };
 
@@ -33,22 +36,61 @@ MATRIX IdentityTx =
     {0, 1, 0, 0},
     {0, 0, 1, 0},
     {0, 0, 0, 1}};
-static MATRIX CurrentTx =
-   {{1, 0, 0, 0},
-    {0, 1, 0, 0},
-    {0, 0, 1, 0},
-    {0, 0, 0, 1}};
-static tx_ptr TxStack = NULL;
 
-/* Return 1 if there is an active transformation, 0 if not */
-int lib_tx_active()
+/* The transform stack lives in the current context.  CurrentTx is the
+   transform; TxActive tells whether it is something other than the
+   identity, and NormalTx is the inverse of CurrentTx for transforming
+   normals (valid unless NormalTxDirty is set).  TxActive and NormalTx are
+   kept up to date by tx_changed. */
+#define CurrentTx      (gContext->current_tx)
+#define TxStack        (gContext->tx_stack)
+#define TxActive       (gContext->tx_active)
+#define NormalTx       (gContext->normal_tx)
+#define NormalTxDirty  (gContext->normal_tx_dirty)
+
+/* Note a change to CurrentTx */
+static void tx_changed()
 {
 	int i, j;
-	for (i=0;i<4;i++)
+
+	TxActive = 0;
+	for (i=0;i<4 && !TxActive;i++)
 		for (j=0;j<4;j++)
-			if (fabs(CurrentTx[i][j] - (i == j ? 1.0 : 0.0)) > EPSILON)
-				return 1;
-			return 0;
+			if (fabs(CurrentTx[i][j] - (i == j ? 1.0 : 0.0)) > EPSILON) {
+				TxActive = 1;
+				break;
+			}
+	/* The inverse is only worked out when someone asks for it */
+	NormalTxDirty = 1;
+}
+
+/* Apply mx, a rotate, scale or translate, ahead of the current transform */
+#ifdef ANSI_FN_DEF
+static void tx_concat(MATRIX mx)
+#else
+static void tx_concat(mx)
+MATRIX mx;
+#endif
+{
+	MATRIX mx2;
+	AFFINE ax1, ax2, axres;
+
+	if (lib_matrix_is_affine(CurrentTx)) {
+		lib_matrix_to_affine(ax1, mx);
+		lib_matrix_to_affine(ax2, CurrentTx);
+		lib_affine_multiply(axres, ax1, ax2);
+		lib_affine_to_matrix(CurrentTx, axres);
+	} else {
+		lib_copy_matrix(mx2, CurrentTx);
+		lib_matrix_multiply(CurrentTx, mx, mx2);
+	}
+	tx_changed();
+}
+
+/* Return 1 if there is an active transformation, 0 if not */
+int lib_tx_active()
+{
+	return TxActive;
 }
 
 /* Copy the current transform into mat */
@@ -62,6 +104,29 @@ MATRIX mat;
 	memcpy(mat, CurrentTx, sizeof(MATRIX));
 }
 
+/* Copy the matrix for transforming normals by the current transform, for
+   use with lib_transform_normal, into mat */
+#ifdef ANSI_FN_DEF
+void lib_get_current_normal_tx(MATRIX mat)
+#else
+void lib_get_current_normal_tx(mat)
+MATRIX mat;
+#endif
+{
+	AFFINE ax, iax;
+
+	if (NormalTxDirty) {
+		if (lib_matrix_is_affine(CurrentTx)) {
+			lib_matrix_to_affine(ax, CurrentTx);
+			lib_invert_affine(iax, ax);
+			lib_affine_to_matrix(NormalTx, iax);
+		} else
+			lib_invert_matrix(NormalTx, CurrentTx);
+		NormalTxDirty = 0;
+	}
+	memcpy(mat, NormalTx, sizeof(MATRIX));
+}
+
 /* Copy matrix mat into the current transform */
 #ifdef ANSI_FN_DEF
 void lib_set_current_tx(MATRIX mat)
@@ -71,6 +136,7 @@ MATRIX mat;
 #endif
 {
 	memcpy(CurrentTx, mat, sizeof(MATRIX));
+	tx_changed();
 }
 
 #ifdef _DEBUG
@@ -116,6 +182,342 @@ static void lib_tx_status()
 }
 #endif
 
+/*-----------------------------------------------------------------*/
+/* Transform writers for the output emitter tables in libemt.c.  Each gets
+   the current transform both as a matrix and unwound into scale/rotate/
+   translate, with flags telling which of those are not identity. */
+#ifdef ANSI_FN_DEF
+void emit_tx_rtrace(MATRIX txmat, double *trans, int sflag, int rflag,
+					int tflag)
+#else
+void emit_tx_rtrace(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    int i, j;
+
+    lib_printf("65 %ld ", gObject_count+1);
+    for (i=0;i<4;i++)
+		for (j=0;j<4;j++)
+			lib_printf("%g ", txmat[j][i]);
+    lib_printf("\n");
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tx_rwx(MATRIX txmat, double *trans, int sflag, int rflag, int tflag)
+#else
+void emit_tx_rwx(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    /* Transforms are possible in RWX,
+       this code needs to be finished... */
+    if (tflag) {
+		tab_indent();
+		lib_printf("Translate %g %g %g\n",
+			trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
+    }
+    if (rflag) {
+		tab_indent();
+		lib_printf("Rotate 0 0 1 %g\n",
+			trans[U_ROTATEZ]);
+		tab_indent();
+		lib_printf("Rotate 0 1 0 %g\n",
+			trans[U_ROTATEY]);
+		tab_indent();
+		lib_printf("Rotate 1 0 0 %g\n",
+			trans[U_ROTATEX]);
+    }
+    if (sflag) {
+		tab_indent();
+		lib_printf("Scale %g %g %g\n",
+			trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tx_rib(MATRIX txmat, double *trans, int sflag, int rflag, int tflag)
+#else
+void emit_tx_rib(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    if (sflag) {
+		tab_indent();
+		lib_printf("Scale %#g %#g %#g\n",
+			trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
+    }
+    if (rflag) {
+		tab_indent();
+		lib_printf("Rotate %#g 1 0 0\n",
+			trans[U_ROTATEX]);
+		tab_indent();
+		lib_printf("Rotate %#g 0 1 0\n",
+			trans[U_ROTATEY]);
+		tab_indent();
+		lib_printf("Rotate %#g 0 0 1\n",
+			trans[U_ROTATEZ]);
+    }
+    if (tflag) {
+		tab_indent();
+		lib_printf("Translate %#g %#g %#g\n",
+			trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tx_vivid(MATRIX txmat, double *trans, int sflag, int rflag,
+				   int tflag)
+#else
+void emit_tx_vivid(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    tab_inc();
+    if (sflag) {
+		tab_indent();
+		lib_printf("scale %g\n", trans[U_SCALEX]);
+    }
+    tab_dec();
+    if (rflag) {
+		tab_indent();
+		lib_printf("rotate %g %g %g\n",
+			trans[U_ROTATEX], trans[U_ROTATEY], trans[U_ROTATEZ]);
+    }
+    if (tflag) {
+		tab_indent();
+		lib_printf("translate %g %g %g\n",
+			trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tx_rayshade(MATRIX txmat, double *trans, int sflag, int rflag,
+					  int tflag)
+#else
+void emit_tx_rayshade(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    if (sflag) {
+		lib_printf(" scale %g %g %g",
+			trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
+    }
+    if (rflag) {
+		lib_printf(" rotate 1 0 0 %g",
+			trans[U_ROTATEX]);
+		tab_indent();
+		lib_printf(" rotate 0 1 0 %g",
+			trans[U_ROTATEY]);
+		tab_indent();
+		lib_printf(" rotate 0 0 1 %g",
+			trans[U_ROTATEZ]);
+    }
+    if (tflag) {
+		lib_printf(" translate %g %g %g",
+			trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tx_pov10(MATRIX txmat, double *trans, int sflag, int rflag,
+				   int tflag)
+#else
+void emit_tx_pov10(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    if (sflag) {
+		lib_printf(" scale %g %g %g",
+			trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
+    }
+    if (rflag) {
+		lib_printf(" rotate %g %g %g",
+			trans[U_ROTATEX], trans[U_ROTATEY], trans[U_ROTATEZ]);
+    }
+    if (tflag) {
+		lib_printf(" translate %g %g %g",
+			trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tx_pov(MATRIX txmat, double *trans, int sflag, int rflag, int tflag)
+#else
+void emit_tx_pov(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    if (sflag) {
+		lib_printf(" scale <%g, %g, %g>",
+			trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
+    }
+    if (rflag) {
+		tab_indent();
+		lib_printf(" rotate <%g, %g, %g>",
+			trans[U_ROTATEX], trans[U_ROTATEY], trans[U_ROTATEZ]);
+    }
+    if (tflag) {
+		tab_indent();
+		lib_printf(" translate <%g, %g, %g>",
+			trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tx_art(MATRIX txmat, double *trans, int sflag, int rflag, int tflag)
+#else
+void emit_tx_art(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    if (sflag) {
+		tab_indent();
+		lib_printf("scale(%g, %g, %g)\n",
+			trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
+    }
+    if (rflag) {
+		tab_indent();
+		lib_printf("rotate(%g, x)\n",
+			trans[U_ROTATEX]);
+		tab_indent();
+		lib_printf("rotate(%g, y)\n",
+			trans[U_ROTATEY]);
+		tab_indent();
+		lib_printf("rotate(%g, z)\n",
+			trans[U_ROTATEZ]);
+    }
+    if (tflag) {
+		tab_indent();
+		lib_printf("translate(%g, %g, %g)\n",
+			trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tx_3dmf(MATRIX txmat, double *trans, int sflag, int rflag, int tflag)
+#else
+void emit_tx_3dmf(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    if (tflag) {
+		tab_indent();
+		lib_printf("Translate ( %g %g %g )\n",
+			trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
+    }
+    if (rflag) {
+		tab_indent();
+		lib_printf("Rotate ( Z %g )\n",
+			trans[U_ROTATEZ]);
+		tab_indent();
+		lib_printf("Rotate ( Y %g )\n",
+			trans[U_ROTATEY]);
+		tab_indent();
+		lib_printf("Rotate ( X %g )\n",
+			trans[U_ROTATEX]);
+    }
+    if (sflag) {
+		tab_indent();
+		lib_printf("Scale ( %g %g %g )\n",
+			trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tx_vrml1(MATRIX txmat, double *trans, int sflag, int rflag,
+				   int tflag)
+#else
+void emit_tx_vrml1(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    COORD3 rotang;
+    COORD4 axis;
+
+    if (sflag) {
+		tab_indent();
+		lib_printf("scaleFactor %g %g %g\n",
+			trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
+    }
+    if (rflag) {
+		SET_COORD3(rotang, trans[U_ROTATEX], trans[U_ROTATEY],
+			trans[U_ROTATEZ]);
+		lib_calc_rotation_axis(rotang, axis);
+		tab_indent();
+		lib_printf("rotation %g %g %g %g\n",
+			axis[0], axis[1], axis[2], axis[3]);
+    }
+    if (tflag) {
+		tab_indent();
+		lib_printf("translation %g %g %g\n",
+			trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
+    }
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void emit_tx_vrml2(MATRIX txmat, double *trans, int sflag, int rflag,
+				   int tflag)
+#else
+void emit_tx_vrml2(txmat, trans, sflag, rflag, tflag)
+MATRIX txmat;
+double *trans;
+int sflag, rflag, tflag;
+#endif
+{
+    COORD3 rotang;
+    COORD4 axis;
+
+    if (sflag) {
+		tab_indent();
+		lib_printf("scale %g %g %g\n",
+			trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
+    }
+    if (rflag) {
+		SET_COORD3(rotang, trans[U_ROTATEX], trans[U_ROTATEY],
+			trans[U_ROTATEZ]);
+		lib_calc_rotation_axis(rotang, axis);
+		tab_indent();
+		lib_printf("rotation %g %g %g %g\n",
+			axis[0], axis[1], axis[2], axis[3]);
+    }
+    if (tflag) {
+		tab_indent();
+		lib_printf("translation %g %g %g\n",
+			trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
+    }
+}
+
 /* Turn a transformation matrix into the appropriate sequence of
 translate/rotate/scale instructions */
 void
@@ -123,9 +525,7 @@ lib_output_tx_sequence()
 {
 	MATRIX txmat;
 	double trans[16];
-	int i, j, tflag, rflag, sflag;
-	COORD3 rotang;
-	COORD4 axis;
+	int tflag, rflag, sflag;
 	
     lib_get_current_tx(txmat);
 	
@@ -162,247 +562,10 @@ lib_output_tx_sequence()
 		tflag = 0;
     if (!sflag && !rflag && !tflag)
 		return;
-    switch (gRT_out_format) {
-	case OUTPUT_VIDEO:
-	case OUTPUT_DELAYED:
-	case OUTPUT_DXF:
-	case OUTPUT_PLG:
-	case OUTPUT_NFF:
-	case OUTPUT_OBJ:
-	case OUTPUT_QRT:
-	case OUTPUT_RAWTRI:
-	/* Can't do inline transforms in these renderers, the
-	code does the transformations on the shapes
-		themselves. */
-		break;
-		
-	case OUTPUT_RTRACE:
-		fprintf(gOutfile, "65 %ld ", gObject_count+1);
-		for (i=0;i<4;i++)
-			for (j=0;j<4;j++)
-				fprintf(gOutfile, "%g ", txmat[j][i]);
-			fprintf(gOutfile, "\n");
-			break;
-			
-	case OUTPUT_RWX:
-	/* Transforms are possible in RWX,
-	       this code needs to be finished... */
-		if (tflag) {
-			tab_indent();
-			fprintf(gOutfile, "Translate %g %g %g\n",
-				trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
-		}
-		if (rflag) {
-			tab_indent();
-			fprintf(gOutfile, "Rotate 0 0 1 %g\n",
-				trans[U_ROTATEZ]);
-			tab_indent();
-			fprintf(gOutfile, "Rotate 0 1 0 %g\n",
-				trans[U_ROTATEY]);
-			tab_indent();
-			fprintf(gOutfile, "Rotate 1 0 0 %g\n",
-				trans[U_ROTATEX]);
-		}
-		if (sflag) {
-			tab_indent();
-			fprintf(gOutfile, "Scale %g %g %g\n",
-				trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
-		}
-		break;
-		
-	case OUTPUT_RIB:
-		if (sflag) {
-			tab_indent();
-			fprintf(gOutfile, "Scale %#g %#g %#g\n",
-				trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
-		}
-		if (rflag) {
-			tab_indent();
-			fprintf(gOutfile, "Rotate %#g 1 0 0\n",
-				trans[U_ROTATEX]);
-			tab_indent();
-			fprintf(gOutfile, "Rotate %#g 0 1 0\n",
-				trans[U_ROTATEY]);
-			tab_indent();
-			fprintf(gOutfile, "Rotate %#g 0 0 1\n",
-				trans[U_ROTATEZ]);
-		}
-		if (tflag) {
-			tab_indent();
-			fprintf(gOutfile, "Translate %#g %#g %#g\n",
-				trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
-		}
-		break;
-		
-	case OUTPUT_VIVID:
-		tab_inc();
-		if (sflag) {
-			tab_indent();
-			fprintf(gOutfile, "scale %g\n", trans[U_SCALEX]);
-		}
-		tab_dec();
-		if (rflag) {
-			tab_indent();
-			fprintf(gOutfile, "rotate %g %g %g\n",
-				trans[U_ROTATEX], trans[U_ROTATEY], trans[U_ROTATEZ]);
-		}
-		if (tflag) {
-			tab_indent();
-			fprintf(gOutfile, "translate %g %g %g\n",
-				trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
-		}
-		break;
-		
-	case OUTPUT_RAYSHADE:
-		if (sflag) {
-			fprintf(gOutfile, " scale %g %g %g",
-				trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
-		}
-		if (rflag) {
-			fprintf(gOutfile, " rotate 1 0 0 %g",
-				trans[U_ROTATEX]);
-			tab_indent();
-			fprintf(gOutfile, " rotate 0 1 0 %g",
-				trans[U_ROTATEY]);
-			tab_indent();
-			fprintf(gOutfile, " rotate 0 0 1 %g",
-				trans[U_ROTATEZ]);
-		}
-		if (tflag) {
-			fprintf(gOutfile, " translate %g %g %g",
-				trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
-		}
-		break;
-		
-	case OUTPUT_POVRAY_10:
-		if (sflag) {
-			fprintf(gOutfile, " scale %g %g %g",
-				trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
-		}
-		if (rflag) {
-			fprintf(gOutfile, " rotate %g %g %g",
-				trans[U_ROTATEX], trans[U_ROTATEY], trans[U_ROTATEZ]);
-		}
-		if (tflag) {
-			fprintf(gOutfile, " translate %g %g %g",
-				trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
-		}
-		break;
-		
-	case OUTPUT_POVRAY_20:
-	case OUTPUT_POVRAY_30:
-	case OUTPUT_POLYRAY:
-		if (sflag) {
-			fprintf(gOutfile, " scale <%g, %g, %g>",
-				trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
-		}
-		if (rflag) {
-			tab_indent();
-			fprintf(gOutfile, " rotate <%g, %g, %g>",
-				trans[U_ROTATEX], trans[U_ROTATEY], trans[U_ROTATEZ]);
-		}
-		if (tflag) {
-			tab_indent();
-			fprintf(gOutfile, " translate <%g, %g, %g>",
-				trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
-		}
-		break;
-		
-	case OUTPUT_ART:
-		if (sflag) {
-			tab_indent();
-			fprintf(gOutfile, "scale(%g, %g, %g)\n",
-				trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
-		}
-		if (rflag) {
-			tab_indent();
-			fprintf(gOutfile, "rotate(%g, x)\n",
-				trans[U_ROTATEX]);
-			tab_indent();
-			fprintf(gOutfile, "rotate(%g, y)\n",
-				trans[U_ROTATEY]);
-			tab_indent();
-			fprintf(gOutfile, "rotate(%g, z)\n",
-				trans[U_ROTATEZ]);
-		}
-		if (tflag) {
-			tab_indent();
-			fprintf(gOutfile, "translate(%g, %g, %g)\n",
-				trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
-		}
-		break;
-		
-	case OUTPUT_3DMF:
-		if (tflag) {
-			tab_indent();
-			fprintf(gOutfile, "Translate ( %g %g %g )\n",
-				trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
-		}
-		if (rflag) {
-			tab_indent();
-			fprintf(gOutfile, "Rotate ( Z %g )\n",
-				trans[U_ROTATEZ]);
-			tab_indent();
-			fprintf(gOutfile, "Rotate ( Y %g )\n",
-				trans[U_ROTATEY]);
-			tab_indent();
-			fprintf(gOutfile, "Rotate ( X %g )\n",
-				trans[U_ROTATEX]);
-		}
-		if (sflag) {
-			tab_indent();
-			fprintf(gOutfile, "Scale ( %g %g %g )\n",
-				trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
-		}
-		break;
-		
-	case OUTPUT_VRML1:
-		if (sflag) {
-			tab_indent();
-			fprintf(gOutfile, "scaleFactor %g %g %g\n",
-				trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
-		}
-		if (rflag) {
-			SET_COORD3(rotang, trans[U_ROTATEX], trans[U_ROTATEY],
-				trans[U_ROTATEZ]);
-			lib_calc_rotation_axis(rotang, axis);
-			tab_indent();
-			fprintf(gOutfile, "rotation %g %g %g %g\n",
-				axis[0], axis[1], axis[2], axis[3]);
-		}
-		if (tflag) {
-			tab_indent();
-			fprintf(gOutfile, "translation %g %g %g\n",
-				trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
-		}
-		break;
-		
-	case OUTPUT_VRML2:
-		if (sflag) {
-			tab_indent();
-			fprintf(gOutfile, "scale %g %g %g\n",
-				trans[U_SCALEX], trans[U_SCALEY], trans[U_SCALEZ]);
-		}
-		if (rflag) {
-			SET_COORD3(rotang, trans[U_ROTATEX], trans[U_ROTATEY],
-				trans[U_ROTATEZ]);
-			lib_calc_rotation_axis(rotang, axis);
-			tab_indent();
-			fprintf(gOutfile, "rotation %g %g %g %g\n",
-				axis[0], axis[1], axis[2], axis[3]);
-		}
-		if (tflag) {
-			tab_indent();
-			fprintf(gOutfile, "translation %g %g %g\n",
-				trans[U_TRANSX], trans[U_TRANSY], trans[U_TRANSZ]);
-		}
-		break;
-		
-	default:
-		fprintf(stderr, "Internal Error: bad file type in libtx.c\n");
-		exit(1);
-		break;
-    }
+    /* Renderers that can't do inline transforms have no transform writer,
+       the code does the transformations on the shapes themselves. */
+    if (gEmitter->transform != NULL)
+		(*gEmitter->transform)(txmat, trans, sflag, rflag, tflag);
 } /* lib_output_tx_sequence */
 
 void
@@ -416,6 +579,10 @@ lib_tx_pop()
 	else {
 		last_tx = TxStack;
 		lib_copy_matrix(CurrentTx, last_tx->tx);
+		TxActive = last_tx->active;
+		NormalTxDirty = last_tx->normal_dirty;
+		if (!NormalTxDirty)
+			lib_copy_matrix(NormalTx, last_tx->normal_tx);
 		TxStack = TxStack->next;
 		free(last_tx);
 	}
@@ -431,6 +598,10 @@ lib_tx_push()
 		exit(EXIT_FAIL);
 	}
     lib_copy_matrix(new_tx->tx, CurrentTx);
+    new_tx->active = TxActive;
+    new_tx->normal_dirty = NormalTxDirty;
+    if (!NormalTxDirty)
+		lib_copy_matrix(new_tx->normal_tx, NormalTx);
     new_tx->next = TxStack;
     TxStack = new_tx;
 }
@@ -443,11 +614,10 @@ int axis;
 double angle;
 #endif
 {
-    MATRIX mx1, mx2;
+    MATRIX mx1;
 	
     lib_create_rotate_matrix(mx1, axis, angle);
-    lib_copy_matrix(mx2, CurrentTx);
-    lib_matrix_multiply(CurrentTx, mx1, mx2);
+    tx_concat(mx1);
 }
 
 #ifdef ANSI_FN_DEF
@@ -457,11 +627,10 @@ void lib_tx_scale(vec)
 COORD3 vec;
 #endif
 {
-    MATRIX mx1, mx2;
+    MATRIX mx1;
 	
     lib_create_scale_matrix(mx1, vec);
-    lib_copy_matrix(mx2, CurrentTx);
-    lib_matrix_multiply(CurrentTx, mx1, mx2);
+    tx_concat(mx1);
 }
 
 /*-----------------------------------------------------------------*/
@@ -472,11 +641,10 @@ void lib_tx_translate(vec)
 COORD3 vec;
 #endif
 {
-    MATRIX mx1, mx2;
+    MATRIX mx1;
 	
     lib_create_translate_matrix(mx1, vec);
-    lib_copy_matrix(mx2, CurrentTx);
-    lib_matrix_multiply(CurrentTx, mx1, mx2);
+    tx_concat(mx1);
 }
 
 /*-----------------------------------------------------------------*/
@@ -744,6 +744,121 @@ MATRIX mx;
     COPY_COORD4(vres, vtemp);
 }
 
+/*
+ * Batch versions of the above, for "n" points (vectors, normals, coords)
+ * in a row.  The results are the same as calling the single versions one
+ * at a time, vres may be the same array as vec.  The matrix is loaded once
+ * and each loop is simple enough for the compiler to unroll or vectorize.
+ */
+#ifdef ANSI_FN_DEF
+void lib_transform_points(COORD3 *vres, COORD3 *vec, long n, MATRIX mx)
+#else
+void lib_transform_points(vres, vec, n, mx)
+COORD3 *vres, *vec;
+long n;
+MATRIX mx;
+#endif
+{
+    double m00 = mx[0][0], m01 = mx[0][1], m02 = mx[0][2];
+    double m10 = mx[1][0], m11 = mx[1][1], m12 = mx[1][2];
+    double m20 = mx[2][0], m21 = mx[2][1], m22 = mx[2][2];
+    double m30 = mx[3][0], m31 = mx[3][1], m32 = mx[3][2];
+    double x, y, z;
+    long i;
+
+    for (i=0;i<n;i++) {
+		x = vec[i][X]; y = vec[i][Y]; z = vec[i][Z];
+		vres[i][X] = x*m00 + y*m10 + z*m20 + m30;
+		vres[i][Y] = x*m01 + y*m11 + z*m21 + m31;
+		vres[i][Z] = x*m02 + y*m12 + z*m22 + m32;
+    }
+}
+
+#ifdef ANSI_FN_DEF
+void lib_transform_vectors(COORD3 *vres, COORD3 *vec, long n, MATRIX mx)
+#else
+void lib_transform_vectors(vres, vec, n, mx)
+COORD3 *vres, *vec;
+long n;
+MATRIX mx;
+#endif
+{
+    double m00 = mx[0][0], m01 = mx[0][1], m02 = mx[0][2];
+    double m10 = mx[1][0], m11 = mx[1][1], m12 = mx[1][2];
+    double m20 = mx[2][0], m21 = mx[2][1], m22 = mx[2][2];
+    double x, y, z;
+    long i;
+
+    for (i=0;i<n;i++) {
+		x = vec[i][X]; y = vec[i][Y]; z = vec[i][Z];
+		vres[i][X] = x*m00 + y*m10 + z*m20;
+		vres[i][Y] = x*m01 + y*m11 + z*m21;
+		vres[i][Z] = x*m02 + y*m12 + z*m22;
+    }
+}
+
+#ifdef ANSI_FN_DEF
+void lib_transform_normals(COORD3 *vres, COORD3 *vec, long n, MATRIX mx)
+#else
+void lib_transform_normals(vres, vec, n, mx)
+COORD3 *vres, *vec;
+long n;
+MATRIX mx;
+#endif
+{
+    double m00 = mx[0][0], m01 = mx[0][1], m02 = mx[0][2];
+    double m10 = mx[1][0], m11 = mx[1][1], m12 = mx[1][2];
+    double m20 = mx[2][0], m21 = mx[2][1], m22 = mx[2][2];
+    double x, y, z;
+    long i;
+
+    for (i=0;i<n;i++) {
+		x = vec[i][X]; y = vec[i][Y]; z = vec[i][Z];
+		vres[i][X] = x*m00 + y*m01 + z*m02;
+		vres[i][Y] = x*m10 + y*m11 + z*m12;
+		vres[i][Z] = x*m20 + y*m21 + z*m22;
+    }
+}
+
+/*
+ * Batch lib_transform_coord.  If the matrix is affine (last column 0 0 0 1)
+ * the W of each result is just the W it started with.
+ */
+#ifdef ANSI_FN_DEF
+void lib_transform_coords(COORD4 *vres, COORD4 *vec, long n, MATRIX mx)
+#else
+void lib_transform_coords(vres, vec, n, mx)
+COORD4 *vres, *vec;
+long n;
+MATRIX mx;
+#endif
+{
+    double m00 = mx[0][0], m01 = mx[0][1], m02 = mx[0][2], m03 = mx[0][3];
+    double m10 = mx[1][0], m11 = mx[1][1], m12 = mx[1][2], m13 = mx[1][3];
+    double m20 = mx[2][0], m21 = mx[2][1], m22 = mx[2][2], m23 = mx[2][3];
+    double m30 = mx[3][0], m31 = mx[3][1], m32 = mx[3][2], m33 = mx[3][3];
+    double x, y, z, w;
+    long i;
+
+    if ((m03 == 0.0) && (m13 == 0.0) && (m23 == 0.0) && (m33 == 1.0)) {
+		for (i=0;i<n;i++) {
+			x = vec[i][X]; y = vec[i][Y]; z = vec[i][Z]; w = vec[i][W];
+			vres[i][X] = x*m00 + y*m10 + z*m20 + w*m30;
+			vres[i][Y] = x*m01 + y*m11 + z*m21 + w*m31;
+			vres[i][Z] = x*m02 + y*m12 + z*m22 + w*m32;
+			vres[i][W] = w;
+		}
+    } else {
+		for (i=0;i<n;i++) {
+			x = vec[i][X]; y = vec[i][Y]; z = vec[i][Z]; w = vec[i][W];
+			vres[i][X] = x*m00 + y*m10 + z*m20 + w*m30;
+			vres[i][Y] = x*m01 + y*m11 + z*m21 + w*m31;
+			vres[i][Z] = x*m02 + y*m12 + z*m22 + w*m32;
+			vres[i][W] = x*m03 + y*m13 + z*m23 + w*m33;
+		}
+    }
+}
+
 /* Determinant of a 3x3 matrix */
 #ifdef ANSI_FN_DEF
 static double det3x3(double a1, double a2, double a3,
@@ -889,6 +1004,173 @@ MATRIX mxres, mx1, mx2;
 			mx1[i][2]*mx2[2][j] + mx1[i][3]*mx2[3][j];
 }
 
+/*
+ * Affine matrices.  An AFFINE is a MATRIX whose last column is 0 0 0 1,
+ * which is true of every rotate, scale and translate, and of any product
+ * of them.  Leaving the column off saves work: a multiply takes 36
+ * multiplies instead of 64, and the inverse is a 3x3 inverse plus a
+ * translation instead of a 4x4 adjoint.  Products, transforms and the
+ * 3x3 part of inverses are the same, to the bit, as the MATRIX routines
+ * give.
+ */
+
+/* Returns TRUE if the last column of mx is 0 0 0 1 */
+#ifdef ANSI_FN_DEF
+int lib_matrix_is_affine(MATRIX mx)
+#else
+int lib_matrix_is_affine(mx)
+MATRIX mx;
+#endif
+{
+    return (mx[0][3] == 0.0) && (mx[1][3] == 0.0) && (mx[2][3] == 0.0) &&
+		(mx[3][3] == 1.0);
+}
+
+#ifdef ANSI_FN_DEF
+void lib_create_identity_affine(AFFINE ax)
+#else
+void lib_create_identity_affine(ax)
+AFFINE ax;
+#endif
+{
+    int i, j;
+	
+    for (i=0;i<4;i++)
+		for (j=0;j<3;j++)
+			ax[i][j] = (i == j) ? 1.0 : 0.0;
+}
+
+/* Copy the affine part of mx, dropping its last column */
+#ifdef ANSI_FN_DEF
+void lib_matrix_to_affine(AFFINE ax, MATRIX mx)
+#else
+void lib_matrix_to_affine(ax, mx)
+AFFINE ax;
+MATRIX mx;
+#endif
+{
+    int i, j;
+	
+    for (i=0;i<4;i++)
+		for (j=0;j<3;j++)
+			ax[i][j] = mx[i][j];
+}
+
+#ifdef ANSI_FN_DEF
+void lib_affine_to_matrix(MATRIX mx, AFFINE ax)
+#else
+void lib_affine_to_matrix(mx, ax)
+MATRIX mx;
+AFFINE ax;
+#endif
+{
+    int i, j;
+	
+    for (i=0;i<4;i++) {
+		for (j=0;j<3;j++)
+			mx[i][j] = ax[i][j];
+		mx[i][3] = (i == 3) ? 1.0 : 0.0;
+    }
+}
+
+/*
+ * Multiply a point by an affine matrix.
+ */
+#ifdef ANSI_FN_DEF
+void lib_transform_affine_point(COORD3 vres, COORD3 vec, AFFINE ax)
+#else
+void lib_transform_affine_point(vres, vec, ax)
+COORD3 vres, vec;
+AFFINE ax;
+#endif
+{
+    COORD3 vtemp;
+    vtemp[X] = vec[X]*ax[0][0] + vec[Y]*ax[1][0] + vec[Z]*ax[2][0] + ax[3][0];
+    vtemp[Y] = vec[X]*ax[0][1] + vec[Y]*ax[1][1] + vec[Z]*ax[2][1] + ax[3][1];
+    vtemp[Z] = vec[X]*ax[0][2] + vec[Y]*ax[1][2] + vec[Z]*ax[2][2] + ax[3][2];
+    COPY_COORD3(vres, vtemp);
+}
+
+/*
+ * Multiply a vector by an affine matrix (no translation).
+ */
+#ifdef ANSI_FN_DEF
+void lib_transform_affine_vector(COORD3 vres, COORD3 vec, AFFINE ax)
+#else
+void lib_transform_affine_vector(vres, vec, ax)
+COORD3 vres, vec;
+AFFINE ax;
+#endif
+{
+    COORD3 vtemp;
+    vtemp[X] = vec[X]*ax[0][0] + vec[Y]*ax[1][0] + vec[Z]*ax[2][0];
+    vtemp[Y] = vec[X]*ax[0][1] + vec[Y]*ax[1][1] + vec[Z]*ax[2][1];
+    vtemp[Z] = vec[X]*ax[0][2] + vec[Y]*ax[1][2] + vec[Z]*ax[2][2];
+    COPY_COORD3(vres, vtemp);
+}
+
+/*
+ * Multiply two affine matrices, ax1 then ax2, as lib_matrix_multiply does.
+ * axres may not be the same as either ax1 or ax2.
+ */
+#ifdef ANSI_FN_DEF
+void lib_affine_multiply(AFFINE axres, AFFINE ax1, AFFINE ax2)
+#else
+void lib_affine_multiply(axres, ax1, ax2)
+AFFINE axres, ax1, ax2;
+#endif
+{
+    int i, j;
+	
+    for (i=0;i<3;i++)
+		for (j=0;j<3;j++)
+			axres[i][j] = ax1[i][0]*ax2[0][j] + ax1[i][1]*ax2[1][j] +
+			ax1[i][2]*ax2[2][j];
+    for (j=0;j<3;j++)
+		axres[3][j] = ax1[3][0]*ax2[0][j] + ax1[3][1]*ax2[1][j] +
+			ax1[3][2]*ax2[2][j] + ax2[3][j];
+}
+
+/*
+ * Find the inverse of an affine matrix: the inverse of the 3x3 part, and
+ * the translation taken back through it.  Like lib_invert_matrix, a
+ * singular matrix gives the identity.  axres may not be the same as ax.
+ */
+#ifdef ANSI_FN_DEF
+void lib_invert_affine(AFFINE axres, AFFINE ax)
+#else
+void lib_invert_affine(axres, ax)
+AFFINE axres, ax;
+#endif
+{
+    double det;
+    int i, j;
+	
+    /* Cofactors, transposed, in the same order and signs as adjoint */
+    axres[0][0] =   (ax[1][1]*ax[2][2] - ax[1][2]*ax[2][1]);
+    axres[1][0] = - (ax[1][0]*ax[2][2] - ax[1][2]*ax[2][0]);
+    axres[2][0] =   (ax[1][0]*ax[2][1] - ax[1][1]*ax[2][0]);
+    axres[0][1] = - (ax[0][1]*ax[2][2] - ax[0][2]*ax[2][1]);
+    axres[1][1] =   (ax[0][0]*ax[2][2] - ax[0][2]*ax[2][0]);
+    axres[2][1] = - (ax[0][0]*ax[2][1] - ax[0][1]*ax[2][0]);
+    axres[0][2] =   (ax[0][1]*ax[1][2] - ax[0][2]*ax[1][1]);
+    axres[1][2] = - (ax[0][0]*ax[1][2] - ax[0][2]*ax[1][0]);
+    axres[2][2] =   (ax[0][0]*ax[1][1] - ax[0][1]*ax[1][0]);
+	
+    det = ax[0][0]*axres[0][0] + ax[0][1]*axres[1][0] + ax[0][2]*axres[2][0];
+    if (fabs(det) < EPSILON) {
+		lib_create_identity_affine(axres);
+		return;
+    }
+    for (i=0;i<3;i++)
+		for (j=0;j<3;j++)
+			axres[i][j] /= det;
+	
+    for (j=0;j<3;j++)
+		axres[3][j] = -(ax[3][0]*axres[0][j] + ax[3][1]*axres[1][j] +
+			ax[3][2]*axres[2][j]);
+}
+
 /* Performs a 3D clip of a line segment from start to end against the
     box defined by bounds.  The actual values of start and end are modified. */
 #ifdef ANSI_FN_DEF
@@ -43,10 +43,22 @@ void lib_transform_coord PARAMS((COORD4 vres, COORD4 vec, MATRIX mx));
 void lib_transform_point PARAMS((COORD3 vres, COORD3 vec, MATRIX mx));
 void lib_transform_vector PARAMS((COORD3 vres, COORD3 vec, MATRIX mx));
 void lib_transform_normal PARAMS((COORD3 vres, COORD3 vec, MATRIX mx));
+void lib_transform_points PARAMS((COORD3 *vres, COORD3 *vec, long n, MATRIX mx));
+void lib_transform_vectors PARAMS((COORD3 *vres, COORD3 *vec, long n, MATRIX mx));
+void lib_transform_normals PARAMS((COORD3 *vres, COORD3 *vec, long n, MATRIX mx));
+void lib_transform_coords PARAMS((COORD4 *vres, COORD4 *vec, long n, MATRIX mx));
 void lib_transpose_matrix PARAMS((MATRIX mxres, MATRIX mx));
 void lib_matrix_multiply PARAMS((MATRIX mxres, MATRIX mx1, MATRIX mx2));
 double lib_matrix_det4x4 PARAMS((MATRIX));
 void lib_invert_matrix PARAMS((MATRIX, MATRIX));
+int lib_matrix_is_affine PARAMS((MATRIX mx));
+void lib_create_identity_affine PARAMS((AFFINE ax));
+void lib_matrix_to_affine PARAMS((AFFINE ax, MATRIX mx));
+void lib_affine_to_matrix PARAMS((MATRIX mx, AFFINE ax));
+void lib_transform_affine_point PARAMS((COORD3 vres, COORD3 vec, AFFINE ax));
+void lib_transform_affine_vector PARAMS((COORD3 vres, COORD3 vec, AFFINE ax));
+void lib_affine_multiply PARAMS((AFFINE axres, AFFINE ax1, AFFINE ax2));
+void lib_invert_affine PARAMS((AFFINE axres, AFFINE ax));
 void lib_rotate_cube_face PARAMS((COORD3 vec, int major_axis, int mod_face));
 int lib_clip_to_box PARAMS((COORD3 start, COORD3 end,  double bounds[2][3]));
 double lib_normalize_vector PARAMS((COORD3 cvec));
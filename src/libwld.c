@@ -0,0 +1,236 @@
+/*
+ * libwld.c - library of vertex welding routines.
+ *
+ * Author:  Eric Haines
+ *
+ * A weld table is a pool of shared vertices.  Each vertex added is snapped
+ * to a grid of gWeld_tolerance spacing and looked up in a hash table; if a
+ * vertex already in the pool snaps to the same grid point, its index is
+ * returned instead of adding a new one.  The pool keeps the first position
+ * seen for each vertex.
+ */
+
+/*-----------------------------------------------------------------*/
+/* include section */
+/*-----------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "lib.h"
+
+
+/*-----------------------------------------------------------------*/
+/* defines/constants section */
+/*-----------------------------------------------------------------*/
+
+/* Starting size of a table, grown by doubling as needed */
+#define WELD_START_SIZE   1024
+
+struct weld_struct {
+    double  tolerance;	/* grid spacing vertices are snapped to */
+    long    count;	/* vertices in the pool */
+    long    size;	/* room in the pool and in the hash table */
+    long    *bucket;	/* first vertex in each hash chain, -1 if empty */
+    long    *next;	/* next vertex in the same chain, -1 at the end */
+    COORD3  *key;	/* grid point of each vertex */
+    COORD3  *vert;	/* position of each vertex */
+};
+
+
+/*-----------------------------------------------------------------*/
+/*
+ * Turn welding of OBJ and PLG output on, with the given grid spacing, or
+ * off if tolerance is 0.
+ */
+#ifdef ANSI_FN_DEF
+void lib_set_weld_tolerance (double tolerance)
+#else
+void lib_set_weld_tolerance(tolerance)
+double tolerance;
+#endif
+{
+    gWeld_tolerance = (tolerance > 0.0) ? tolerance : 0.0;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+static unsigned long weld_hash(COORD3 key, long size)
+#else
+static unsigned long weld_hash(key, size)
+COORD3 key;
+long size;
+#endif
+{
+    unsigned long h;
+
+    h = (unsigned long)(long)fmod(key[X], 1048576.0) * 73856093L;
+    h ^= (unsigned long)(long)fmod(key[Y], 1048576.0) * 19349663L;
+    h ^= (unsigned long)(long)fmod(key[Z], 1048576.0) * 83492791L;
+    return h & (unsigned long)(size - 1);
+}
+
+/*-----------------------------------------------------------------*/
+/* Allocate the pool and hash table arrays, "size" entries each */
+#ifdef ANSI_FN_DEF
+static int weld_alloc(weld_ptr weld, long size)
+#else
+static int weld_alloc(weld, size)
+weld_ptr weld;
+long size;
+#endif
+{
+    long *bucket, *next;
+    COORD3 *key, *vert;
+    long i;
+
+    bucket = (long *)malloc(size * sizeof(long));
+    next = (long *)realloc(weld->next, size * sizeof(long));
+    if (next != NULL)
+		weld->next = next;
+    key = (COORD3 *)realloc(weld->key, size * sizeof(COORD3));
+    if (key != NULL)
+		weld->key = key;
+    vert = (COORD3 *)realloc(weld->vert, size * sizeof(COORD3));
+    if (vert != NULL)
+		weld->vert = vert;
+    if ((bucket == NULL) || (next == NULL) || (key == NULL) ||
+		(vert == NULL)) {
+		if (bucket != NULL)
+			free(bucket);
+		return FALSE;
+    }
+
+    /* Rehash what is already in the pool */
+    for (i = 0; i < size; i++)
+		bucket[i] = -1;
+    for (i = 0; i < weld->count; i++) {
+		next[i] = bucket[weld_hash(key[i], size)];
+		bucket[weld_hash(key[i], size)] = i;
+    }
+    if (weld->bucket != NULL)
+		free(weld->bucket);
+    weld->bucket = bucket;
+    weld->size = size;
+    return TRUE;
+}
+
+/*-----------------------------------------------------------------*/
+/* Make an empty weld table.  Returns NULL if out of memory. */
+#ifdef ANSI_FN_DEF
+weld_ptr lib_weld_create (double tolerance)
+#else
+weld_ptr lib_weld_create(tolerance)
+double tolerance;
+#endif
+{
+    weld_ptr weld;
+
+    weld = (weld_ptr)malloc(sizeof(struct weld_struct));
+    if (weld == NULL)
+		return NULL;
+    weld->tolerance = tolerance;
+    weld->count = 0;
+    weld->size = 0;
+    weld->bucket = NULL;
+    weld->next = NULL;
+    weld->key = NULL;
+    weld->vert = NULL;
+    if (!weld_alloc(weld, (long)WELD_START_SIZE)) {
+		lib_weld_free(weld);
+		return NULL;
+    }
+    return weld;
+}
+
+/*-----------------------------------------------------------------*/
+#ifdef ANSI_FN_DEF
+void lib_weld_free (weld_ptr weld)
+#else
+void lib_weld_free(weld)
+weld_ptr weld;
+#endif
+{
+    if (weld == NULL)
+		return;
+    if (weld->bucket != NULL) free(weld->bucket);
+    if (weld->next != NULL) free(weld->next);
+    if (weld->key != NULL) free(weld->key);
+    if (weld->vert != NULL) free(weld->vert);
+    free(weld);
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Find or add a vertex, returning its index in the pool (starting at 0).
+ * *is_new is set TRUE if the vertex was added.
+ */
+#ifdef ANSI_FN_DEF
+long lib_weld_vertex (weld_ptr weld, COORD3 vert, int *is_new)
+#else
+long lib_weld_vertex(weld, vert, is_new)
+weld_ptr weld;
+COORD3 vert;
+int *is_new;
+#endif
+{
+    COORD3 key;
+    long i;
+    unsigned long h;
+
+    SET_COORD3(key,
+		floor(vert[X] / weld->tolerance + 0.5),
+		floor(vert[Y] / weld->tolerance + 0.5),
+		floor(vert[Z] / weld->tolerance + 0.5));
+
+    h = weld_hash(key, weld->size);
+    for (i = weld->bucket[h]; i >= 0; i = weld->next[i]) {
+		if ((weld->key[i][X] == key[X]) && (weld->key[i][Y] == key[Y]) &&
+			(weld->key[i][Z] == key[Z])) {
+			*is_new = FALSE;
+			return i;
+		}
+    }
+
+    if (weld->count == weld->size) {
+		if (!weld_alloc(weld, 2 * weld->size)) {
+			fprintf(stderr, "Error(lib_weld_vertex): Can't allocate memory.\n");
+			exit(1);
+		}
+		h = weld_hash(key, weld->size);
+    }
+    i = weld->count++;
+    COPY_COORD3(weld->key[i], key);
+    COPY_COORD3(weld->vert[i], vert);
+    weld->next[i] = weld->bucket[h];
+    weld->bucket[h] = i;
+    *is_new = TRUE;
+    return i;
+}
+
+/*-----------------------------------------------------------------*/
+/* Number of vertices in the pool */
+#ifdef ANSI_FN_DEF
+long lib_weld_count (weld_ptr weld)
+#else
+long lib_weld_count(weld)
+weld_ptr weld;
+#endif
+{
+    return weld->count;
+}
+
+/*-----------------------------------------------------------------*/
+/* Position of a vertex in the pool */
+#ifdef ANSI_FN_DEF
+double * lib_weld_get_vertex (weld_ptr weld, long index)
+#else
+double * lib_weld_get_vertex(weld, index)
+weld_ptr weld;
+long index;
+#endif
+{
+    return weld->vert[index];
+}
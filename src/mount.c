@@ -98,6 +98,23 @@ hash_rand(int A, int B, int C)
 
 static  double  Roughness ;
 
+/* Sections this many levels down are each grown as a task, which may run
+   on a thread of its own with "-j", as long as they are at least
+   TASK_MIN_WIDTH across.  Every height comes from hash_rand of its grid
+   position, so the sections don't depend on each other. */
+#define TASK_LEVEL      3
+#define TASK_MIN_WIDTH  32
+
+static  int     task_width ;
+
+/* A mountain section for grow_section */
+typedef struct {
+    double fnum_pts;
+    int width;
+    int ll_x, ll_y;
+    double ll_fz, lr_fz, ur_fz, ul_fz;
+} section;
+
 /* create a pyramid of crystal spheres */
 static void
 create_spheres(center)
@@ -131,6 +148,49 @@ COORD4 center;
 	}
 }
 
+static void grow_mountain();
+
+/* Grow a mountain section, as a task */
+static void
+grow_section(data)
+void *data;
+{
+    section *sec = (section *)data;
+
+    grow_mountain(sec->fnum_pts, sec->width, sec->ll_x, sec->ll_y,
+		sec->ll_fz, sec->lr_fz, sec->ur_fz, sec->ul_fz);
+}
+
+/* Grow a mountain section now, or spawn it as a task if it is that size */
+static void
+grow_quarter(fnum_pts, width, ll_x, ll_y, ll_fz, lr_fz, ur_fz, ul_fz)
+double fnum_pts;
+int width;
+int ll_x;
+int ll_y ;
+double ll_fz;
+double lr_fz;
+double ur_fz;
+double ul_fz;
+{
+    section sec;
+
+    if (width == task_width) {
+		sec.fnum_pts = fnum_pts;
+		sec.width = width;
+		sec.ll_x = ll_x;
+		sec.ll_y = ll_y;
+		sec.ll_fz = ll_fz;
+		sec.lr_fz = lr_fz;
+		sec.ur_fz = ur_fz;
+		sec.ul_fz = ul_fz;
+		lib_task_spawn(grow_section, &sec, sizeof(section));
+    } else {
+		grow_mountain(fnum_pts, width, ll_x, ll_y,
+			ll_fz, lr_fz, ur_fz, ul_fz);
+    }
+}
+
 /*
  * Build mountain section.  If at width > 1, split quadrilateral into four
  * parts.  Else if at width == 1, output quadrilateral as two triangles.
@@ -207,19 +267,19 @@ double ul_fz;
 		PLATFORM_MULTITASK();
 		if (width == 1<<size_factor)
 			PLATFORM_PROGRESS(0, 0, 3);
-		grow_mountain(fnum_pts, half_width, ll_x, ll_y,
+		grow_quarter(fnum_pts, half_width, ll_x, ll_y,
 			ll_fz, lower_fz, middle_fz, left_fz);
 		if (width == 1<<size_factor)
 			PLATFORM_PROGRESS(0, 1, 3);
-		grow_mountain(fnum_pts, half_width, ll_x+half_width, ll_y,
+		grow_quarter(fnum_pts, half_width, ll_x+half_width, ll_y,
 			lower_fz, lr_fz, right_fz, middle_fz);
 		if (width == 1<<size_factor)
 			PLATFORM_PROGRESS(0, 2, 3);
-		grow_mountain(fnum_pts, half_width, ll_x+half_width, ll_y+half_width,
+		grow_quarter(fnum_pts, half_width, ll_x+half_width, ll_y+half_width,
 			middle_fz, right_fz, ur_fz, upper_fz);
 		if (width == 1<<size_factor)
 			PLATFORM_PROGRESS(0, 3, 3);
-		grow_mountain(fnum_pts, half_width, ll_x, ll_y+half_width,
+		grow_quarter(fnum_pts, half_width, ll_x, ll_y+half_width,
 			left_fz, middle_fz, upper_fz, ul_fz);
     }
 }
@@ -286,6 +346,9 @@ char *argv[];
     num_pts = 1<<size_factor;
     ratio = 2.0 / exp((double)(log((double)2.0) / (FRACTAL_DIMENSION-1.0)));
     Roughness = sqrt((double)(SQR(ratio) - 1.0));
+    task_width = num_pts >> TASK_LEVEL;
+    if (task_width < TASK_MIN_WIDTH)
+		task_width = 0;
     grow_mountain((double)num_pts, num_pts, 0, 0, 0.0, 0.0, 0.0, 0.0);
 	
     lib_close();
@@ -103,7 +103,9 @@ char *argv[];
 		return EXIT_FAIL;
     }
 	
-    lib_set_polygonalization(5, 5);
+    /* Finer than the usual default, unless "-t #" asked for something else */
+    if (gU_resolution == OUTPUT_RESOLUTION)
+		lib_set_polygonalization(5, 5);
 	
     /* output background color */
     /* NOTE: Do this BEFORE lib_output_viewpoint(), for display_init() */
@@ -1,6 +1,7 @@
 /*
  * ReadNFF.c - Simple NFF file importer.  Uses lib to output to
- * many different raytracer formats.
+ * many different raytracer formats.  Also reads binary NFF (BNFF) files,
+ * as written by the library's OUTPUT_BNFF format.
  *
  * Author:  Eduard [esp] Schwan
  *
@@ -15,6 +16,17 @@
 #include "drv.h"	/* display_close() */
 #include "lib.h"
 
+#if defined(unix) || defined(__unix) || defined(__unix__) || \
+	(defined(__APPLE__) && defined(__MACH__))
+/* Memory-map BNFF files rather than reading them in */
+#define MAP_BNFF_FILE
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 /* These may be read from the command line */
 static int raytracer_format = OUTPUT_RT_DEFAULT;
 static int output_format    = OUTPUT_CURVES;
@@ -220,11 +232,29 @@ Format:
     The fill color is used to color the objects following it until a new color
     is assigned.
 ----------------------------------------------------------------------*/
+static void
+output_fill(acolor, kd, ks, phong_pow, t, ior)
+COORD3 acolor;
+double kd, ks, phong_pow, t, ior;
+{
+    float    ka, ks_spec, ang;
+	
+    /* some parms not input in NFF, so hard-coded. */
+    ka = (float)0.1;
+    ks_spec = (float)ks;
+    /* convert phong_pow back into phong hilight angle. */
+    /* reciprocal of formula in libpr1.c, lib_output_color() */
+	if ( phong_pow < 1.0 )
+		phong_pow = 1.0 ;
+    ang = (float)((180.0/PI) * acos( exp(log(0.5)/phong_pow) ));
+    lib_output_color(NULL, acolor, ka, kd, ks, ks_spec, ang, t, ior);
+}
+
 static void
 do_fill(fp)
 FILE *fp;
 {
-    float    r, g, b, ka, kd, ks, ks_spec, phong_pow, ang, t, ior;
+    float    r, g, b, kd, ks, phong_pow, t, ior;
     COORD3 acolor;
 	
     if (fscanf(fp, "%f %f %f",&r, &g, &b) != 3) {
@@ -238,16 +268,7 @@ FILE *fp;
 		exit(1);
     }
 	
-    /* some parms not input in NFF, so hard-coded. */
-    ka = (float)0.1;
-    ks_spec = ks;
-    /* convert phong_pow back into phong hilight angle. */
-    /* reciprocal of formula in libpr1.c, lib_output_color() */
-	if ( phong_pow < 1.0 )
-		phong_pow = 1.0 ;
-    ang = (float)((180.0/PI) * acos( exp(log(0.5)/phong_pow) ));
-    lib_output_color(NULL, acolor, ka, kd, ks, ks_spec, ang, t, ior);
-	
+    output_fill(acolor, kd, ks, phong_pow, t, ior);
 }
 
 
@@ -466,6 +487,231 @@ FILE *fp;
 } /* parse_nff */
 
 
+/*----------------------------------------------------------------------
+Binary NFF.  See libbnf.c and lib.h for the layout.
+
+    The whole file is mapped into memory (or, where mapping isn't available,
+    read in with one fread) and the records are walked in place.  When the
+    file holds doubles in this machine's byte order the vertex arrays are
+    handed straight to the library, otherwise they are converted into a
+    scratch array that is reused from record to record.
+----------------------------------------------------------------------*/
+static int     bnff_real_size;		/* 4 or 8, from the header */
+static int     bnff_in_place;		/* reals can be used where they are */
+static double  *bnff_scratch = NULL;	/* converted reals */
+static long    bnff_scratch_size = 0;
+
+static unsigned long
+get_u32(p)
+unsigned char *p;
+{
+    return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+		((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+/* Return the "n" reals starting at p as doubles */
+static double *
+get_reals(p, n)
+unsigned char *p;
+long n;
+{
+    unsigned char buf[8];
+    float    fval;
+    long    i;
+    int    j;
+	
+    if (bnff_in_place)
+		return (double *)p;
+	
+    if (n > bnff_scratch_size) {
+		if (bnff_scratch != NULL)
+			free(bnff_scratch);
+		bnff_scratch_size = (n < 256) ? 256 : n;
+		bnff_scratch = (double *)malloc(bnff_scratch_size * sizeof(double));
+		if (bnff_scratch == NULL) {
+			show_error("can't allocate memory for BNFF record");
+			exit(1);
+		}
+    }
+    for (i = 0; i < n; i++, p += bnff_real_size) {
+		for (j = 0; j < bnff_real_size; j++)
+			buf[j] = lib_bnff_little_endian() ? p[j] : p[bnff_real_size-1-j];
+		if (bnff_real_size == 4) {
+			memcpy(&fval, buf, 4);
+			bnff_scratch[i] = (double)fval;
+		} else
+			memcpy(&bnff_scratch[i], buf, 8);
+    }
+    return bnff_scratch;
+}
+
+static void
+parse_bnff(buf, size)
+unsigned char *buf;
+long size;
+{
+    unsigned char *p, *end;
+    unsigned long type, len, nverts;
+    double    *v;
+    COORD4    pt1, pt2;
+	
+    if ((size < BNFF_HEADER_SIZE) || (strncmp((char *)buf, BNFF_MAGIC, 4) != 0))
+		goto fmterr;
+    if (get_u32(buf + 4) != BNFF_VERSION) {
+		show_error("unknown BNFF version");
+		exit(1);
+    }
+    bnff_real_size = (int)get_u32(buf + 8);
+    if ((bnff_real_size != 4) && (bnff_real_size != 8))
+		goto fmterr;
+    bnff_in_place = (bnff_real_size == sizeof(double)) &&
+		lib_bnff_little_endian() &&
+		(((unsigned long)buf % sizeof(double)) == 0);
+	
+    p = buf + BNFF_HEADER_SIZE;
+    end = buf + size;
+    while (end - p >= 8) {
+		type = get_u32(p);
+		len = get_u32(p + 4);
+		p += 8;
+		if (len > (unsigned long)(end - p))
+			goto fmterr;
+		
+		switch (type) {
+		case BNFF_VIEW:
+			if (len < 8 + 11 * (unsigned long)bnff_real_size)
+				goto fmterr;
+			v = get_reals(p + 8, 11L);
+			lib_output_viewpoint(&v[0], &v[3], &v[6], v[9], 1.0, v[10],
+				(int)get_u32(p), (int)get_u32(p + 4));
+			break;
+		case BNFF_LIGHT:
+			if (len < 3 * (unsigned long)bnff_real_size)
+				goto fmterr;
+			v = get_reals(p, 3L);
+			SET_COORD4(pt1, v[X], v[Y], v[Z], 0.0); /* intensity=0 */
+			lib_output_light(pt1);
+			break;
+		case BNFF_BACKGROUND:
+			if (len < 3 * (unsigned long)bnff_real_size)
+				goto fmterr;
+			v = get_reals(p, 3L);
+			lib_output_background_color(v);
+			break;
+		case BNFF_FILL:
+			if (len < 8 * (unsigned long)bnff_real_size)
+				goto fmterr;
+			v = get_reals(p, 8L);
+			output_fill(v, v[3], v[4], v[5], v[6], v[7]);
+			break;
+		case BNFF_CONE:
+			if (len < 8 * (unsigned long)bnff_real_size)
+				goto fmterr;
+			v = get_reals(p, 8L);
+			COPY_COORD4(pt1, &v[0]);
+			COPY_COORD4(pt2, &v[4]);
+			if (pt1[W] < 0.0) {
+				pt1[W] = -pt1[W];
+				pt2[W] = -pt2[W];
+			}
+			lib_output_cylcone(pt1, pt2, output_format);
+			break;
+		case BNFF_SPHERE:
+			if (len < 4 * (unsigned long)bnff_real_size)
+				goto fmterr;
+			v = get_reals(p, 4L);
+			COPY_COORD4(pt1, v);
+			lib_output_sphere(pt1, output_format);
+			break;
+		case BNFF_POLYGON:
+			if (len < 8)
+				goto fmterr;
+			nverts = get_u32(p);
+			if ((len - 8) / (3 * (unsigned long)bnff_real_size) < nverts)
+				goto fmterr;
+			v = get_reals(p + 8, (long)(3 * nverts));
+			lib_output_polygon((int)nverts, (COORD3 *)v);
+			break;
+		case BNFF_PATCH:
+			if (len < 8)
+				goto fmterr;
+			nverts = get_u32(p);
+			if ((len - 8) / (6 * (unsigned long)bnff_real_size) < nverts)
+				goto fmterr;
+			v = get_reals(p + 8, (long)(6 * nverts));
+			lib_output_polypatch((int)nverts, (COORD3 *)v,
+				(COORD3 *)&v[3 * nverts]);
+			break;
+		default:
+			/* unknown record, skip it */
+			break;
+		}
+		p += len;
+    }
+    if (p != end)
+		goto fmterr;
+    return;
+fmterr:
+    show_error("BNFF file format error");
+    exit(1);
+} /* parse_bnff */
+
+/*----------------------------------------------------------------------
+Map or read in a BNFF file and parse it.
+----------------------------------------------------------------------*/
+static void
+read_bnff(file_name)
+char *file_name;
+{
+    unsigned char *buf;
+    long    size;
+    FILE    *fp;
+#ifdef MAP_BNFF_FILE
+    struct stat st;
+    int    fd;
+	
+    /* Map the file privately and writable: the library may transform
+       vertices in place, which must not reach the file. */
+    fd = open(file_name, O_RDONLY);
+    if ((fd >= 0) && (fstat(fd, &st) == 0) && (st.st_size > 0)) {
+		size = (long)st.st_size;
+		buf = (unsigned char *)mmap(NULL, (size_t)size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (buf != (unsigned char *)MAP_FAILED) {
+			parse_bnff(buf, size);
+			munmap((void *)buf, (size_t)size);
+			return;
+		}
+    } else if (fd >= 0)
+		close(fd);
+    /* mapping failed, so fall back to reading the file */
+#endif /* MAP_BNFF_FILE */
+	
+    fp = fopen(file_name, "rb");
+    if (fp == NULL) {
+		fprintf(stderr, "Cannot open nff file: '%s'\n", file_name);
+		exit(1);
+    }
+    fseek(fp, 0L, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0L, SEEK_SET);
+    buf = (unsigned char *)malloc((size > 0) ? (size_t)size : 1);
+    if (buf == NULL) {
+		show_error("can't allocate memory for BNFF file");
+		exit(1);
+    }
+    if (fread(buf, 1, (size_t)size, fp) != (size_t)size) {
+		show_error("can't read BNFF file");
+		exit(1);
+    }
+    fclose(fp);
+	
+    parse_bnff(buf, size);
+    free(buf);
+} /* read_bnff */
+
+
 /*----------------------------------------------------------------------
 ----------------------------------------------------------------------*/
 int
@@ -474,6 +720,7 @@ int argc ;
 char *argv[] ;
 {
     char file_name[256];
+    char magic[4];
     FILE *fp;
 	
     PLATFORM_INIT(SPD_READNFF);
@@ -496,9 +743,15 @@ char *argv[] ;
 	
     /*lib_set_polygonalization(3, 3);*/
 	
-    parse_nff(fp);
-	
-    fclose(fp);
+    if ((fread(magic, 1, 4, fp) == 4) &&
+		(strncmp(magic, BNFF_MAGIC, 4) == 0)) {
+		fclose(fp);
+		read_bnff(file_name);
+    } else {
+		rewind(fp);
+		parse_nff(fp);
+		fclose(fp);
+    }
 	
     lib_close();
 	
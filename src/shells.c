@@ -142,6 +142,59 @@ int     *p_size, *p_rdr, *p_curve ;
 			case 't':       /* tessellated curve output */
 				*p_curve = OUTPUT_PATCHES ;
 				break ;
+			case 'w':       /* welded OBJ/PLG output */
+				lib_set_weld_tolerance( WELD_TOLERANCE ) ;
+				if ( num_arg < argc-1 ) {
+					if ( argv[num_arg+1][0] != '-' ) {
+						num_arg++ ;
+						sscanf( argv[num_arg], "%lf", &fval ) ;
+						if ( fval <= 0.0 ) {
+							fprintf( stderr,
+								"bad weld spacing %s given\n",
+								argv[num_arg]);
+							shells_show_usage();
+							return( TRUE ) ;
+						}
+						lib_set_weld_tolerance( fval ) ;
+					}
+				} /* else use the default spacing */
+				break ;
+			case 'p':       /* adaptive tessellation to a pixel error */
+				lib_set_adaptive_tessellation( ADAPTIVE_ERROR ) ;
+				if ( num_arg < argc-1 ) {
+					if ( argv[num_arg+1][0] != '-' ) {
+						num_arg++ ;
+						sscanf( argv[num_arg], "%lf", &fval ) ;
+						if ( fval <= 0.0 ) {
+							fprintf( stderr,
+								"bad pixel error %s given\n",
+								argv[num_arg]);
+							shells_show_usage();
+							return( TRUE ) ;
+						}
+						lib_set_adaptive_tessellation( fval ) ;
+					}
+				} /* else use the default error */
+				break ;
+			case 'l':       /* levels of detail */
+				if ( ++num_arg < argc ) {
+					sscanf( argv[num_arg], "%d", &val ) ;
+					if ( val < 1 || val > LOD_MAX_LEVELS ) {
+						fprintf( stderr,
+							"bad level of detail count %d given\n",val);
+						shells_show_usage();
+						return( TRUE ) ;
+					}
+					lib_set_lod_levels( val ) ;
+				} else {
+					fprintf( stderr, "not enough args for -l option\n" ) ;
+					shells_show_usage();
+					return( TRUE ) ;
+				}
+				break ;
+			case 'v':       /* statistics */
+				gShow_stats = TRUE ;
+				break ;
 			case 'r':       /* renderer selection */
 				if ( ++num_arg < argc ) {
 					sscanf( argv[num_arg], "%d", &val ) ;
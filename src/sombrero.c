@@ -7,7 +7,9 @@
  *	     2		    64x64
  *	     3		   128x128
  *	     4		   256x256
-   
+ *
+ *	The height field is made a row at a time as it is output, so even
+ *	large sizes run in a small, fixed amount of memory.
 */
 
 #include <stdio.h>
@@ -25,48 +27,62 @@ static int output_format    = OUTPUT_CURVES;
 /* Define constants for the sombrero function */
 static double a_const, b_const, c_const, two_pi_a;
 
-static float **
+/* Extent of the height field, and its spacing */
+static double x_start, x_delta, y_start, y_delta;
+static unsigned hf_height;
+
+/* Fill in a row of the height field, as the library asks for it, so the
+ * whole field never has to be held in memory
+ */
+static void
+sombrero_row(data, i, width, values)
+void *data;
+int i, width;
+float *values;
+{
+	double x, y;
+	int j;
+	
+	PLATFORM_PROGRESS(0, i, hf_height-1);
+	y = y_start + (double)i * y_delta;
+	for (j=0,x=x_start;j<width;j++,x+=x_delta) {
+		/* your function here...
+		 * For the conversion to work for POV-Ray, Polyray, or any other
+		 * format which converts fixed range heightfield data to an image,
+		 * make sure the function produces values between -1 and 1. */
+		values[j] = (float)(c_const * cos(two_pi_a * sqrt(x * x + y * y)) *
+			exp(-b_const * sqrt(x * x + y * y))/3.0);
+		
+		/* here's a simple sine wave function:
+		values[j] = (float)(((cos(two_pi_a * x / 2.0) + sin(two_pi_a * y / 2.0)/2.0))/1.5) ;
+		 */
+	}
+}
+
+static height_ptr
 create_sombrero(width, height, x0, x1, y0, y1)
 unsigned width, height;
 double x0, x1, y0, y1;
 {
-	float **data;
-	double x, deltax, y, deltay;
-	unsigned i, j;
+	height_ptr hf;
 	
 	a_const = 1.0;
 	b_const = 1.0;
 	c_const = 3.0;
 	two_pi_a = 2.0 * 3.14159265358 * a_const;
 	
-	deltax = (x1 - x0) / (double)width;
-	deltay = (y1 - y0) / (double)height;
+	x_start = x0;
+	y_start = y0;
+	x_delta = (x1 - x0) / (double)width;
+	y_delta = (y1 - y0) / (double)height;
+	hf_height = height;
 	
-	if ((data = malloc(height * sizeof(float *))) == NULL) {
+	if ((hf = lib_height_create_rows((int)height, (int)width,
+		sombrero_row, NULL)) == NULL) {
 		fprintf(stderr, "HF allocation failed\n");
 		exit(1);
 	}
-	for (i=0,y=y0;i<height;i++,y+=deltay) {
-		if ((data[i] = malloc(width * sizeof(float ))) == NULL) {
-			fprintf(stderr, "HF allocation failed\n");
-			exit(1);
-		}
-		for (j=0,x=x0;j<width;j++,x+=deltax) {
-			PLATFORM_PROGRESS(0, i*width+j, height*width-1);
-			
-			/* your function here...
-			 * For the conversion to work for POV-Ray, Polyray, or any other
-			 * format which converts fixed range heightfield data to an image,
-			 * make sure the function produces values between -1 and 1. */
-			data[i][j] = (float)(c_const * cos(two_pi_a * sqrt(x * x + y * y)) *
-				exp(-b_const * sqrt(x * x + y * y))/3.0);
-			
-			/* here's a simple sine wave function:
-			data[i][j] = (float)(((cos(two_pi_a * x / 2.0) + sin(two_pi_a * y / 2.0)/2.0))/1.5) ;
-			 */
-		}
-	}
-	return data;
+	return hf;
 }
 
 int
@@ -78,7 +94,7 @@ char *argv[];
 	COORD4 from, at, up, light;
 	double lscale;
 	unsigned width = 64, height = 64;
-	float **data;
+	height_ptr hf;
 	
     PLATFORM_INIT(SPD_SOMBRERO);
 	
@@ -121,10 +137,11 @@ char *argv[];
 	/* Create the height field */
 	width = 32*(1 << (size_factor-1) ); /* 32, 64, 128, 256... */
 	height = width;
-	data = create_sombrero(width, height, -4.0, 4.0, -4.0, 4.0);
-	lib_output_height(NULL, data, width, height, -4.0, 4.0, -3.0, 3.0, -4.0, 4.0);
+	hf = create_sombrero(width, height, -4.0, 4.0, -4.0, 4.0);
+	lib_output_height_field(NULL, hf, -4.0, 4.0, -3.0, 3.0, -4.0, 4.0);
 	
 	lib_close();
+	lib_height_free(hf);
 	
     PLATFORM_SHUTDOWN();
 	return EXIT_SUCCESS;
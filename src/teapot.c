@@ -25,6 +25,10 @@
  *	     3		   552		     9
  *
  *	    12		  9120		   144
+ *
+ *	Given a patch chord tolerance, e.g. "-t 0.01", each patch is instead
+ *	subdivided until its triangles are no further than that from the
+ *	surface; the checkerboard is still meshed by size_factor.
  */
 
 #include <stdio.h>
@@ -49,6 +53,11 @@ static FILE * stdout_file = NULL;
  */
 #define BOTTOM
 
+/* values carried by forward differencing: x,y,z of the point and of its
+ * s and t tangents
+ */
+#define	FD_VALUES	9
+
 #ifdef	BOTTOM
 #define	NUM_PATCHES	32
 #else
@@ -429,6 +438,51 @@ COORD3	norm[] ;
 	return( TRUE ) ;
 }
 
+/* get the point and its s and t tangents at (s,t), as x,y,z of each */
+static void
+patch_point( s, t, mgm, val )
+double	s ;
+double	t ;
+MATRIX	mgm[3] ;
+double	val[FD_VALUES] ;
+{
+	int	i, p ;
+	double	sval, tval, dsval, dtval ;
+	COORD4	sp, tp, dsp, dtp, tcoord ;
+	
+	/* get power vectors and their derivatives */
+	for ( p = 4, sval = tval = 1.0 ; p-- ; ) {
+		sp[p] = sval ;
+		tp[p] = tval ;
+		sval *= s ;
+		tval *= t ;
+		
+		if ( p == 3 ) {
+			dsp[p] = dtp[p] = 0.0 ;
+			dsval = dtval = 1.0 ;
+		} else {
+			dsp[p] = dsval * (double)(3-p) ;
+			dtp[p] = dtval * (double)(3-p) ;
+			dsval *= s ;
+			dtval *= t ;
+		}
+	}
+	
+	/* do for x,y,z */
+	for ( i = 0 ; i < 3 ; i++ ) {
+		/* multiply power vectors times matrix to get value */
+		lib_transform_coord( tcoord, sp, mgm[i] ) ;
+		val[i] = DOT4( tcoord, tp ) ;
+		
+		/* get s and t tangent vectors */
+		lib_transform_coord( tcoord, dsp, mgm[i] ) ;
+		val[3+i] = DOT4( tcoord, tp ) ;
+		
+		lib_transform_coord( tcoord, sp, mgm[i] ) ;
+		val[6+i] = DOT4( tcoord, dtp ) ;
+	}
+}
+
 static void
 points_from_basis( tot_vert, s, t, mgm, vert, norm )
 int	tot_vert ;
@@ -438,56 +492,117 @@ MATRIX	mgm[3] ;
 COORD3	vert[] ;
 COORD3	norm[] ;
 {
-	int	i, num_vert, p ;
-	double	sval, tval, dsval, dtval, sxyz, txyz ;
-	COORD3	sdir, tdir ;
-	COORD4	sp, tp, dsp, dtp, tcoord ;
+	int	num_vert ;
+	double	val[FD_VALUES] ;
 	
 	for ( num_vert = 0 ; num_vert < tot_vert ; num_vert++ ) {
+		patch_point( s[num_vert], t[num_vert], mgm, val ) ;
+		COPY_COORD3( vert[num_vert], &val[0] ) ;
 		
-		sxyz = s[num_vert] ;
-		txyz = t[num_vert] ;
+		/* find normal */
+		CROSS( norm[num_vert], &val[6], &val[3] ) ;
+		(void)lib_normalize_vector( norm[num_vert] ) ;
+	}
+}
+
+/* Set forward differences for stepping t by h in row[0..3][q], for the cubic
+ * c[0] t^3 + c[1] t^2 + c[2] t + c[3].  Taken from the coefficients rather
+ * than by differencing samples, so the error stays near the round-off of
+ * the coefficients however many steps are taken.
+ */
+static void
+fd_deltas( c, h, row, q )
+COORD4	c ;
+double	h ;
+double	row[4][FD_VALUES] ;
+int	q ;
+{
+	double	h2, h3 ;
+	
+	h2 = h * h ;
+	h3 = h2 * h ;
+	row[0][q] = c[3] ;
+	row[1][q] = c[0] * h3 + c[1] * h2 + c[2] * h ;
+	row[2][q] = 6.0 * c[0] * h3 + 2.0 * c[1] * h2 ;
+	row[3][q] = 6.0 * c[0] * h3 ;
+}
+
+/* Generate the n+1 points and normals of the patch at s, for t from 0 to 1
+ * in n steps.  The point and tangents are cubics in t, so after setting up
+ * their differences each point takes only adds; all the values are stepped
+ * together, in loops the compiler can vectorize.
+ */
+static void
+fd_row( n, s, mgm, vert, norm )
+int	n ;
+double	s ;
+MATRIX	mgm[3] ;
+COORD3	vert[] ;
+COORD3	norm[] ;
+{
+	int	i, j, l, q ;
+	double	h ;
+	double	row[4][FD_VALUES] ;
+	COORD4	sp, dsp, tcoord, dtcoord ;
+	
+	SET_COORD4( sp, s * s * s, s * s, s, 1.0 ) ;
+	SET_COORD4( dsp, 3.0 * s * s, 2.0 * s, 1.0, 0.0 ) ;
+	h = 1.0 / (double)n ;
+	for ( i = 0 ; i < 3 ; i++ ) {
+		/* the point, and its t tangent */
+		lib_transform_coord( tcoord, sp, mgm[i] ) ;
+		fd_deltas( tcoord, h, row, i ) ;
+		SET_COORD4( dtcoord, 0.0, 3.0 * tcoord[0], 2.0 * tcoord[1],
+			tcoord[2] ) ;
+		fd_deltas( dtcoord, h, row, 6+i ) ;
 		
-		/* get power vectors and their derivatives */
-		for ( p = 4, sval = tval = 1.0 ; p-- ; ) {
-			sp[p] = sval ;
-			tp[p] = tval ;
-			sval *= sxyz ;
-			tval *= txyz ;
-			
-			if ( p == 3 ) {
-				dsp[p] = dtp[p] = 0.0 ;
-				dsval = dtval = 1.0 ;
-			} else {
-				dsp[p] = dsval * (double)(3-p) ;
-				dtp[p] = dtval * (double)(3-p) ;
-				dsval *= sxyz ;
-				dtval *= txyz ;
+		/* the s tangent */
+		lib_transform_coord( tcoord, dsp, mgm[i] ) ;
+		fd_deltas( tcoord, h, row, 3+i ) ;
+	}
+	
+	for ( j = 0 ; j <= n ; j++ ) {
+		COPY_COORD3( vert[j], &row[0][0] ) ;
+		CROSS( norm[j], &row[0][6], &row[0][3] ) ;
+		(void)lib_normalize_vector( norm[j] ) ;
+		for ( l = 0 ; l < 3 ; l++ ) {
+			for ( q = 0 ; q < FD_VALUES ; q++ ) {
+				row[l][q] += row[l+1][q] ;
 			}
 		}
-		
-		/* do for x,y,z */
-		for ( i = 0 ; i < 3 ; i++ ) {
-			/* multiply power vectors times matrix to get value */
-			lib_transform_coord( tcoord, sp, mgm[i] ) ;
-			vert[num_vert][i] = DOT4( tcoord, tp ) ;
-			
-			/* get s and t tangent vectors */
-			lib_transform_coord( tcoord, dsp, mgm[i] ) ;
-			sdir[i] = DOT4( tcoord, tp ) ;
-			
-			lib_transform_coord( tcoord, sp, mgm[i] ) ;
-			tdir[i] = DOT4( tcoord, dtp ) ;
+	}
+}
+
+/* Point and normal at (s,t) on the patch whose M * G * M matrices are
+ * "data", for lib_output_adaptive_patch.  The normal at a cusp is set as
+ * in check_for_cusp.
+ */
+static void
+teapot_eval( data, s, t, vert, norm )
+void	*data ;
+double	s ;
+double	t ;
+COORD3	vert ;
+COORD3	norm ;
+{
+	COORD3	pt[1], nrm[1] ;
+	
+	points_from_basis( 1, &s, &t, (MATRIX *)data, pt, nrm ) ;
+	COPY_COORD3( vert, pt[0] ) ;
+	COPY_COORD3( norm, nrm[0] ) ;
+	if ( IS_VAL_ALMOST_ZERO( vert[X], 0.0001 ) &&
+		IS_VAL_ALMOST_ZERO( vert[Y], 0.0001 ) ) {
+		if ( vert[Z] > 1.5 ) {
+			SET_COORD3( norm, 0.0, 0.0, 1.0 ) ;
+		} else {
+			SET_COORD3( norm, 0.0, 0.0, -1.0 ) ;
 		}
-		
-		/* find normal */
-		CROSS( norm[num_vert], tdir, sdir ) ;
-		(void)lib_normalize_vector( norm[num_vert] ) ;
 	}
 }
 
-/* Compute points on each spline surface of teapot by brute force.
- * Forward differencing would be faster, but this is compact & simple.
+/* Compute points on each spline surface of teapot a row at a time, by
+ * forward differencing along t, each point shared by the triangles around
+ * it.
  */
 static void
 output_teapot()
@@ -498,11 +613,22 @@ static MATRIX ms = { -1.0,  3.0, -3.0,  1.0,
 		     -3.0,  3.0,  0.0,  0.0,
 		      1.0,  0.0,  0.0,  0.0 } ;
 int	surf, i, r, c, sstep, tstep, num_tri, num_vert, num_tri_vert ;
-double	s[3], t[3] ;
+long	tri_count ;
 COORD3	vert[4], norm[4] ;
+COORD3	*vrow[2], *nrow[2], *trow ;
 COORD3	obj_color ;
 MATRIX	mst, g, mgm[3], tmtx ;
 
+/* two rows of the grid, points and normals */
+for ( i = 0 ; i < 2 ; i++ ) {
+	vrow[i] = (COORD3 *)malloc( (size_factor+1) * sizeof(COORD3) ) ;
+	nrow[i] = (COORD3 *)malloc( (size_factor+1) * sizeof(COORD3) ) ;
+	if ( vrow[i] == NULL || nrow[i] == NULL ) {
+		fprintf( stderr, "Error(teapot): Can't allocate memory.\n" ) ;
+		exit(1) ;
+	}
+}
+
 SET_COORD3( obj_color, 1.0, 0.5, 0.1 ) ;
 lib_output_color(NULL, obj_color, 0.0, 0.75, 0.25, 0.25, 37.0, 0.0, 0.0 ) ;
 
@@ -523,21 +649,33 @@ for ( surf = 0 ; surf < NUM_PATCHES ; surf++ ) {
 		lib_matrix_multiply( mgm[i], tmtx, mst ) ;
 	}
 	
-	/* step along, get points, and output */
+	if ( gPatch_tolerance > 0.0 ) {
+		/* subdivide to the chord tolerance, from 2 by 2 cells */
+		PLATFORM_PROGRESS(0, surf, NUM_PATCHES-1);
+		tri_count = lib_output_adaptive_patch( teapot_eval, (void *)mgm,
+			0.0, 1.0, 0.0, 1.0, 2, 2 ) ;
+		lib_tess_count( 2L * size_factor * size_factor, tri_count ) ;
+		continue ;
+	}
+	
+	/* step along a grid of points made by forward differencing, and
+	 * output */
+	fd_row( size_factor, 0.0, mgm, vrow[0], nrow[0] ) ;
 	for ( sstep = 0 ; sstep < size_factor ; sstep++ ) {
 		PLATFORM_PROGRESS(0, surf*size_factor+sstep, NUM_PATCHES*size_factor-1);
+		fd_row( size_factor, (double)(sstep+1) / (double)size_factor,
+			mgm, vrow[1], nrow[1] ) ;
 		for ( tstep = 0 ; tstep < size_factor ; tstep++ ) {
 			for ( num_tri = 0 ; num_tri < 2 ; num_tri++ ) {
 				for ( num_vert = 0 ; num_vert < 3 ; num_vert++ ) {
 					num_tri_vert = ( num_vert + num_tri * 2 ) % 4 ;
-					/* trickiness: add 1 to sstep if 1 or 2 */
-					s[num_vert] = (double)(sstep + (num_tri_vert/2 ? 1:0) )
-						/ (double)size_factor ;
-					/* trickiness: add 1 to tstep if 2 or 3 */
-					t[num_vert] = (double)(tstep + (num_tri_vert%3 ? 1:0) )
-						/ (double)size_factor ;
+					/* trickiness: use the next row if 2 or 3 */
+					r = num_tri_vert/2 ? 1:0 ;
+					/* trickiness: add 1 to tstep if 1 or 2 */
+					c = tstep + (num_tri_vert%3 ? 1:0) ;
+					COPY_COORD3( vert[num_vert], vrow[r][c] ) ;
+					COPY_COORD3( norm[num_vert], nrow[r][c] ) ;
 				}
-				points_from_basis( 3, s, t, mgm, vert, norm ) ;
 				/* don't output degenerate polygons */
 				if ( check_for_cusp( 3, vert, norm ) ) {
 					lib_output_polypatch( 3, vert, norm ) ;
@@ -545,8 +683,16 @@ for ( surf = 0 ; surf < NUM_PATCHES ; surf++ ) {
 				}
 			}
 		}
+		/* roll the rows */
+		trow = vrow[0] ; vrow[0] = vrow[1] ; vrow[1] = trow ;
+		trow = nrow[0] ; nrow[0] = nrow[1] ; nrow[1] = trow ;
 	}
 }
+
+free( nrow[1] ) ;
+free( nrow[0] ) ;
+free( vrow[1] ) ;
+free( vrow[0] ) ;
 }
 
 static void
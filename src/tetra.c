@@ -40,6 +40,32 @@ static FILE * stdout_file = NULL;
 #define stdout_file stdout
 #endif /* OUTPUT_TO_FILE */
 
+/* Sub-tetrahedra this many levels down (64 of them) are each created as a
+   task, which may run on a thread of its own with "-j", as long as they are
+   at least TASK_MIN_DEPTH levels deep */
+#define TASK_LEVEL      3
+#define TASK_MIN_DEPTH  4
+
+static  int     task_depth ;
+
+/* A sub-tetrahedron for create_subtetra */
+typedef struct {
+    int depth ;
+    COORD4 center ;
+} subtetra ;
+
+static void create_tetra() ;
+
+/* Create a sub-tetrahedron, as a task */
+static void
+create_subtetra( data )
+void *data ;
+{
+    subtetra *st = (subtetra *)data ;
+
+    create_tetra( st->depth, st->center ) ;
+}
+
 
 /* Create tetrahedrons recursively */
 static void
@@ -51,6 +77,7 @@ COORD4 center ;
     int x_dir, y_dir, z_dir ;
     COORD3 face_pt[3], obj_pt[4] ;
     COORD4 sub_center ;
+    subtetra st ;
 	
     if ( depth <= 1 ) {
 		/* Output tetrahedron */
@@ -116,7 +143,14 @@ COORD4 center ;
 							center[Z] + (double)z_dir * center[W] / 2.0 ;
 						sub_center[W] = center[W] / 2.0 ;
 						
-						create_tetra( depth-1, sub_center ) ;
+						if ( depth-1 == task_depth ) {
+							st.depth = depth-1 ;
+							COPY_COORD4( st.center, sub_center ) ;
+							lib_task_spawn( create_subtetra, &st,
+								sizeof(subtetra) ) ;
+						} else {
+							create_tetra( depth-1, sub_center ) ;
+						}
 					}
 				}
 			}
@@ -124,6 +158,56 @@ COORD4 center ;
     }
 }
 
+/*
+ * Output the tetrahedral pyramid with each level defined once, as four
+ * instances of the level below, and the pyramid an instance of the top.
+ */
+static void
+instance_tetra( depth, center )
+int depth ;
+COORD4 center ;
+{
+    int level ;
+    int x_dir, y_dir, z_dir ;
+    long level_obj, sub_obj ;
+    COORD3 vec ;
+    COORD4 unit_center ;
+	
+    SET_COORD4( unit_center, 0.0, 0.0, 0.0, 1.0 ) ;
+    level_obj = lib_object_begin() ;
+    create_tetra( 1, unit_center ) ;
+    lib_object_end() ;
+	
+    for ( level = 2 ; level <= depth ; ++level ) {
+		sub_obj = level_obj ;
+		level_obj = lib_object_begin() ;
+		for ( x_dir = -1 ; x_dir <= 1 ; x_dir += 2 ) {
+			for ( y_dir = -1 ; y_dir <= 1 ; y_dir += 2 ) {
+				for ( z_dir = -1 ; z_dir <= 1 ; z_dir += 2 ) {
+					if ( x_dir*y_dir*z_dir == 1 ) {
+						lib_tx_push() ;
+						SET_COORD3( vec, (double)x_dir / 2.0,
+							(double)y_dir / 2.0, (double)z_dir / 2.0 ) ;
+						lib_tx_translate( vec ) ;
+						SET_COORD3( vec, 0.5, 0.5, 0.5 ) ;
+						lib_tx_scale( vec ) ;
+						lib_output_instance( sub_obj ) ;
+						lib_tx_pop() ;
+					}
+				}
+			}
+		}
+		lib_object_end() ;
+    }
+	
+    lib_tx_push() ;
+    lib_tx_translate( center ) ;
+    SET_COORD3( vec, center[W], center[W], center[W] ) ;
+    lib_tx_scale( vec ) ;
+    lib_output_instance( level_obj ) ;
+    lib_tx_pop() ;
+}
+
 int
 main(argc,argv)
 int argc ;
@@ -174,7 +258,14 @@ char *argv[] ;
 	
     /* compute and output tetrahedral object */
     SET_COORD4( center_pt, 0.0, 0.0, 0.0, 1.0 ) ;
-    create_tetra( size_factor, center_pt ) ;
+    if ( lib_use_instances() ) {
+		instance_tetra( size_factor, center_pt ) ;
+    } else {
+		task_depth = size_factor - TASK_LEVEL ;
+		if ( task_depth < TASK_MIN_DEPTH )
+			task_depth = -1 ;
+		create_tetra( size_factor, center_pt ) ;
+    }
 	
     lib_close();
 	
@@ -43,33 +43,70 @@ static FILE * stdout_file = NULL;
 #define DIV_ANGLE               140.0
 #define WIDTH_HEIGHTH_RATIO     0.15
 
-static  MATRIX  Rst_mx[2] ;
+static  AFFINE  Rst_mx[2] ;
 
-/* grow tree branches recursively */
+/* Branches this many levels up (32 of them) are each grown as a task, which
+   may run on a thread of its own with "-j", as long as they have at least
+   TASK_MIN_DEPTH levels of branches above them */
+#define TASK_LEVEL              5
+#define TASK_MIN_DEPTH          4
+
+static  int     Task_depth ;
+
+/* A branch for grow_branch */
+typedef struct {
+    AFFINE mx;
+    double scale;
+    int depth;
+} branch;
+
+static void grow_tree();
+
+/* grow a branch and the branches above it, as a task */
 static void
-grow_tree(cur_mx, scale, depth)
-MATRIX cur_mx;
+grow_branch(data)
+void *data;
+{
+    branch *br = (branch *)data;
+
+    grow_tree( br->mx, br->scale, br->depth ) ;
+}
+
+/* output a branch, from 0,0,0 to 0,0,1 transformed by cur_mx */
+static void
+output_branch(cur_mx, scale)
+AFFINE cur_mx;
 double scale;
-int depth;
 {
-    int i;
     COORD3 vec;
     COORD4 apex, base;
-    MATRIX new_mx;
 	
-    PLATFORM_MULTITASK();
-	
-    /* output branch */
     SET_COORD3( vec, 0.0, 0.0, 0.0 ) ;
-    lib_transform_point( base, vec, cur_mx ) ;
+    lib_transform_affine_point( base, vec, cur_mx ) ;
     base[W] = scale * WIDTH_HEIGHTH_RATIO ;
 	
     SET_COORD3( vec, 0.0, 0.0, 1.0 ) ;
-    lib_transform_point( apex, vec, cur_mx ) ;
+    lib_transform_affine_point( apex, vec, cur_mx ) ;
     apex[W] = base[W] * BR_DIAMETER ;
 	
     lib_output_cylcone( base, apex, output_format ) ;
     lib_output_sphere( apex, output_format ) ;
+}
+
+/* grow tree branches recursively */
+static void
+grow_tree(cur_mx, scale, depth)
+AFFINE cur_mx;
+double scale;
+int depth;
+{
+    int i;
+    AFFINE new_mx;
+    branch br;
+	
+    PLATFORM_MULTITASK();
+	
+    output_branch( cur_mx, scale ) ;
 	
     if ( depth > 0 ) {
 		--depth ;
@@ -77,10 +114,73 @@ int depth;
 		for ( i = 0 ; i < 2 ; ++i ) {
 			if (depth==size_factor-1)
 				PLATFORM_PROGRESS(0, i, 1);
-			lib_matrix_multiply( new_mx, Rst_mx[i], cur_mx ) ;
-			grow_tree( new_mx, scale * BR_DIAMETER, depth ) ;
+			if ( depth == Task_depth ) {
+				lib_affine_multiply( br.mx, Rst_mx[i], cur_mx ) ;
+				br.scale = scale * BR_DIAMETER ;
+				br.depth = depth ;
+				lib_task_spawn( grow_branch, &br, sizeof(branch) ) ;
+			} else {
+				lib_affine_multiply( new_mx, Rst_mx[i], cur_mx ) ;
+				grow_tree( new_mx, scale * BR_DIAMETER, depth ) ;
+			}
+		}
+    }
+}
+
+/*
+ * Output the tree with its branches defined once for each level and
+ * number of BR_CONTR_0 contractions below them, as instances: a branch,
+ * with its two branches above it instanced from the level above, and the
+ * tree itself an instance of the trunk.  A branch's length depends on its
+ * contractions, but its thickness only on its level, so branches with the
+ * same level and contractions are the same shape.  There are
+ * (size_factor+1)*(size_factor+2)/2 definitions.
+ */
+static void
+instance_tree()
+{
+    int i, depth, num_contr ;
+    long obj, *level_obj ;
+    double thickness ;
+    MATRIX mx ;
+    AFFINE ident_mx ;
+	
+    level_obj = (long *)malloc( (size_factor + 1) * sizeof(long) ) ;
+    if ( level_obj == NULL ) {
+		fprintf( stderr, "Error(tree): Can't allocate memory.\n" ) ;
+		exit( EXIT_FAIL ) ;
+    }
+	
+    lib_create_identity_affine( ident_mx ) ;
+    for ( depth = size_factor ; depth >= 0 ; --depth ) {
+		/* level_obj[num_contr] is replaced by this level's branch after its
+		   own branches, num_contr and num_contr+1, are instanced */
+		for ( num_contr = 0 ; num_contr <= depth ; ++num_contr ) {
+			/* in the branch's own units, where its length is 1 */
+			thickness = 1.0 ;
+			for ( i = 0 ; i < depth ; ++i ) {
+				thickness *= BR_DIAMETER /
+					( ( i < num_contr ) ? BR_CONTR_0 : BR_CONTR_1 ) ;
+			}
+			
+			obj = lib_object_begin() ;
+			output_branch( ident_mx, thickness ) ;
+			if ( depth < size_factor ) {
+				for ( i = 0 ; i < 2 ; ++i ) {
+					lib_tx_push() ;
+					lib_affine_to_matrix( mx, Rst_mx[i] ) ;
+					lib_set_current_tx( mx ) ;
+					lib_output_instance( level_obj[num_contr + 1 - i] ) ;
+					lib_tx_pop() ;
+				}
+			}
+			lib_object_end() ;
+			level_obj[num_contr] = obj ;
 		}
     }
+    lib_output_instance( level_obj[0] ) ;
+	
+    free( level_obj ) ;
 }
 
 /*
@@ -92,7 +192,8 @@ create_tree()
 {
     int i;
     double branch_angle, branch_contraction, divergence;
-    MATRIX ident_mx, temp1_mx, temp2_mx, tempr_mx, tempst_mx;
+    MATRIX temp1_mx, temp2_mx, tempr_mx, tempst_mx, rst_mx;
+    AFFINE ident_mx;
 	
     for ( i = 0 ; i < 2 ; ++i ) {
 		if ( i == 0 ) {
@@ -121,11 +222,22 @@ create_tree()
 		tempst_mx[3][2] = 1.0;
 		
 		/* concatenate */
-		lib_matrix_multiply( Rst_mx[i], tempr_mx, tempst_mx ) ;
+		lib_matrix_multiply( rst_mx, tempr_mx, tempst_mx ) ;
+		lib_matrix_to_affine( Rst_mx[i], rst_mx ) ;
+    }
+	
+    /* Tessellated branches are made along their directions in the world,
+       which instances can't reproduce */
+    if ( lib_use_instances() && ( output_format != OUTPUT_PATCHES ) ) {
+		instance_tree() ;
+		return ;
     }
 	
     /* set up initial matrix */
-    lib_create_identity_matrix( ident_mx ) ;
+    lib_create_identity_affine( ident_mx ) ;
+    Task_depth = size_factor - TASK_LEVEL ;
+    if ( Task_depth < TASK_MIN_DEPTH )
+		Task_depth = -1 ;
     grow_tree( ident_mx, 1.0, size_factor ) ;
 }
 
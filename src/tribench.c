@@ -0,0 +1,228 @@
+/*
+ * tribench.c - Check and time the polygon triangulator.
+ *
+ * Author:  Eric Haines
+ *
+ * Usage:  tribench [count]
+ *
+ * count is the number of times the gear face is split (default 100000);
+ * the large polygons are split count/1000 times.  Each polygon's triangles
+ * are checked to cover exactly the polygon's area, all wound the same way
+ * as the polygon.  Returns EXIT_FAIL if any polygon fails the check.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>	/* atol */
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "def.h"
+#include "lib.h"
+
+
+/* Same as in gears.c */
+#define TEETH                   36
+#define INNER_EDGE_RATIO        0.9
+
+static unsigned long seed = 1;
+
+/*-----------------------------------------------------------------*/
+/* Small LCG so every platform tries the same values */
+static double
+rand_unit()
+{
+    seed = seed * 1103515245L + 12345L;
+    return (double)((seed >> 8) & 0xffffff) / (double)0x1000000;
+}
+
+/*-----------------------------------------------------------------*/
+/* Point at a radius and angle around the origin, in the z=0 plane */
+static void
+polar_point(pt, radius, angle)
+COORD3 pt;
+double radius, angle;
+{
+    SET_COORD3(pt, radius * cos(angle), radius * sin(angle), 0.0);
+}
+
+/*-----------------------------------------------------------------*/
+/* The top face of a gear, as made by gears.c; clockwise if "flip" */
+static int
+gear_face(verts, flip)
+COORD3 *verts;
+int flip;
+{
+    double angle, tooth;
+    int i;
+
+    tooth = (flip ? -2.0 : 2.0) * PI / (double)TEETH;
+    for (i = 0; i < TEETH; i++) {
+		angle = (double)i * tooth;
+		polar_point(verts[4*i], 1.0, angle - 0.19 * tooth);
+		polar_point(verts[4*i+1], 1.0, angle + 0.19 * tooth);
+		polar_point(verts[4*i+2], INNER_EDGE_RATIO, angle + 0.3 * tooth);
+		polar_point(verts[4*i+3], INNER_EDGE_RATIO, angle + 0.7 * tooth);
+    }
+    return 4 * TEETH;
+}
+
+/*-----------------------------------------------------------------*/
+/* A star shaped polygon with "n" vertices at random radii */
+static int
+star_face(verts, n)
+COORD3 *verts;
+int n;
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+		polar_point(verts[i], 0.1 + rand_unit(),
+			2.0 * PI * (double)i / (double)n);
+    return n;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * A comb of teeth of random length standing on a bar, about "n" vertices,
+ * so the sweep meets many merge vertices.  It goes around clockwise.
+ */
+static int
+comb_face(verts, n)
+COORD3 *verts;
+int n;
+{
+    int i, teeth;
+
+    teeth = (n - 2) / 4;
+    for (i = 0; i < teeth; i++) {
+		SET_COORD3(verts[4*i], (double)i, 0.0, 0.0);
+		SET_COORD3(verts[4*i+1], (double)i, 1.0 + rand_unit(), 0.0);
+		SET_COORD3(verts[4*i+2], (double)i + 0.5, 1.0 + rand_unit(), 0.0);
+		SET_COORD3(verts[4*i+3], (double)i + 0.5, 0.0, 0.0);
+    }
+    SET_COORD3(verts[4*teeth], (double)teeth, -1.0, 0.0);
+    SET_COORD3(verts[4*teeth+1], 0.0, -1.0, 0.0);
+    return 4 * teeth + 2;
+}
+
+/*-----------------------------------------------------------------*/
+/* Twice the signed area of a polygon in the z=0 plane */
+static double
+poly_area(verts, n)
+COORD3 *verts;
+int n;
+{
+    double area;
+    int i, j;
+
+    area = 0.0;
+    for (i = 0; i < n; i++) {
+		j = (i == n - 1) ? 0 : i + 1;
+		area += verts[i][X] * verts[j][Y] - verts[j][X] * verts[i][Y];
+    }
+    return area;
+}
+
+/*-----------------------------------------------------------------*/
+/* Returns TRUE if the triangles tile the polygon */
+static int
+check_triangles(verts, n, tri, cnt)
+COORD3 *verts;
+int n, *tri, cnt;
+{
+    COORD3 t[3];
+    double area, sum, a;
+    int i, j;
+
+    if (cnt != n - 2)
+		return FALSE;
+    area = poly_area(verts, n);
+    sum = 0.0;
+    for (i = 0; i < cnt; i++) {
+		for (j = 0; j < 3; j++) {
+			if ((tri[3*i+j] < 0) || (tri[3*i+j] >= n))
+				return FALSE;
+			COPY_COORD3(t[j], verts[tri[3*i+j]]);
+		}
+		a = poly_area(t, 3);
+		/* Every triangle must face the same way as the polygon */
+		if (a * area < -1e-12 * fabs(area))
+			return FALSE;
+		sum += a;
+    }
+    return fabs(sum - area) <= 1e-9 * fabs(area);
+}
+
+/*-----------------------------------------------------------------*/
+/* Split a polygon "reps" times, print the rate and check the result */
+static long
+time_test(name, verts, n, tri, reps)
+char *name;
+COORD3 *verts;
+int n, *tri;
+long reps;
+{
+    clock_t start;
+    double secs;
+    long i;
+    int cnt, ok;
+
+    cnt = 0;
+    start = clock();
+    for (i = 0; i < reps; i++)
+		cnt = lib_triangulate_polygon(n, verts, tri);
+    secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+    ok = check_triangles(verts, n, tri, cnt);
+
+    printf("%-16s %7d verts %8ld times %8.3f s %12.0f verts/s  %s\n",
+		name, n, reps, secs,
+		(secs > 0.0) ? (double)n * (double)reps / secs : 0.0,
+		ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+/*-----------------------------------------------------------------*/
+main(argc, argv)
+int argc;
+char *argv[];
+{
+    COORD3 *verts;
+    int *tri, n, size;
+    long count, big, bad;
+
+    count = 100000L;
+    if (argc > 1) {
+		count = atol(argv[1]);
+		if (count <= 0) {
+			fprintf(stderr, "usage: tribench [count]\n");
+			return EXIT_FAIL;
+		}
+    }
+    big = (count >= 1000L) ? count / 1000L : 1L;
+
+    size = 100000;
+    verts = (COORD3 *)malloc(size * sizeof(COORD3));
+    tri = (int *)malloc(3 * size * sizeof(int));
+    if ((verts == NULL) || (tri == NULL)) {
+		fprintf(stderr, "Error(tribench): Can't allocate memory.\n");
+		return EXIT_FAIL;
+    }
+
+    n = gear_face(verts, FALSE);
+    bad = time_test("gear top", verts, n, tri, count);
+    n = gear_face(verts, TRUE);
+    bad += time_test("gear bottom", verts, n, tri, count);
+    n = star_face(verts, 10000);
+    bad += time_test("star", verts, n, tri, 10 * big);
+    n = comb_face(verts, 10000);
+    bad += time_test("comb", verts, n, tri, 10 * big);
+    n = star_face(verts, size);
+    bad += time_test("star", verts, n, tri, big);
+    n = comb_face(verts, size);
+    bad += time_test("comb", verts, n, tri, big);
+
+    free(tri);
+    free(verts);
+
+    return bad ? EXIT_FAIL : EXIT_SUCCESS;
+}
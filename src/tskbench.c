@@ -0,0 +1,152 @@
+/*
+ * tskbench.c - Time a generator run with -j 1, 2, 4, ... threads, and
+ *              check its output is the same for each.
+ *
+ * Author:  Eric Haines
+ *
+ * Usage:  tskbench [size [threads [generator]]]
+ *
+ * The generator (default balls, the sphereflake) is run from the current
+ * directory as "generator -s size -t -j threads", writing NFF to a file,
+ * for size (default 4) and 1, 2, 4, ... up to threads (default 8).  Times
+ * are on the wall clock, to the second only in a build without
+ * SPD_THREADS, and include writing the file.  Returns EXIT_FAIL if any
+ * run fails or its output differs from the one thread run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>	/* atoi, system */
+#include <string.h>
+#include <time.h>
+#ifdef SPD_THREADS
+#include <sys/time.h>	/* gettimeofday */
+#endif
+#include "def.h"
+#include "lib.h"
+
+
+/* Bytes compared at a time */
+#define COMPARE_SIZE   65536
+
+/* Longest generator name */
+#define NAME_SIZE      64
+
+/* Output of the one thread run, and of the others */
+#define REF_FILE       "tskbench.1"
+#define OUT_FILE       "tskbench.2"
+
+/*-----------------------------------------------------------------*/
+/* Seconds from some fixed time, on the wall clock */
+static double
+wall_time()
+{
+#ifdef SPD_THREADS
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + 1.0e-6 * (double)tv.tv_usec;
+#else
+    return (double)time(NULL);
+#endif
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Run "program" at "size" on "threads" threads into "file", returning the
+ * time taken.
+ */
+static double
+time_run(program, size, threads, file)
+char *program;
+int size, threads;
+char *file;
+{
+    static char command[4*NAME_SIZE];
+    double start;
+
+    sprintf(command, "./%s -s %d -t -j %d > %s", program, size, threads,
+		file);
+    start = wall_time();
+    if (system(command) != 0) {
+		fprintf(stderr, "Error(tskbench): Can't run %s.\n", command);
+		exit(EXIT_FAIL);
+    }
+    return wall_time() - start;
+}
+
+/*-----------------------------------------------------------------*/
+/* TRUE if two files have the same contents, and put the size in *p_size */
+static int
+same_files(name1, name2, p_size)
+char *name1, *name2;
+long *p_size;
+{
+    static char buf1[COMPARE_SIZE], buf2[COMPARE_SIZE];
+    FILE *f1, *f2;
+    size_t n1, n2;
+    int same;
+
+    f1 = fopen(name1, "rb");
+    f2 = fopen(name2, "rb");
+    if ((f1 == NULL) || (f2 == NULL)) {
+		fprintf(stderr, "Error(tskbench): Can't open %s.\n",
+			(f1 == NULL) ? name1 : name2);
+		exit(EXIT_FAIL);
+    }
+    *p_size = 0;
+    do {
+		n1 = fread(buf1, 1, COMPARE_SIZE, f1);
+		n2 = fread(buf2, 1, COMPARE_SIZE, f2);
+		same = (n1 == n2) && (memcmp(buf1, buf2, n1) == 0);
+		*p_size += (long)n1;
+    } while (same && (n1 > 0));
+    fclose(f1);
+    fclose(f2);
+    return same;
+}
+
+/*-----------------------------------------------------------------*/
+main(argc, argv)
+int argc;
+char *argv[];
+{
+    char *program;
+    double serial_time, t;
+    long size;
+    int size_factor, max_threads, threads, bad, same;
+
+    size_factor = 4;
+    max_threads = 8;
+    program = "balls";
+    if (argc > 1)
+		size_factor = atoi(argv[1]);
+    if (argc > 2)
+		max_threads = atoi(argv[2]);
+    if (argc > 3)
+		program = argv[3];
+    if ((argc > 4) || (size_factor < 1) || (max_threads < 1) ||
+		(max_threads > TASK_MAX_THREADS) ||
+		(strlen(program) >= NAME_SIZE)) {
+		fprintf(stderr, "usage: tskbench [size [threads [generator]]]\n");
+		return EXIT_FAIL;
+    }
+
+    serial_time = time_run(program, size_factor, 1, REF_FILE);
+    (void)same_files(REF_FILE, REF_FILE, &size);
+    printf("%s -s %d\n", program, size_factor);
+    printf("%3d thread  %8.3f s  %ld bytes\n", 1, serial_time, size);
+
+    bad = 0;
+    for (threads = 2; threads <= max_threads; threads *= 2) {
+		t = time_run(program, size_factor, threads, OUT_FILE);
+		same = same_files(REF_FILE, OUT_FILE, &size);
+		printf("%3d threads %8.3f s  speedup %5.2f  %s\n", threads, t,
+			(t > 0.0) ? serial_time / t : 0.0, same ? "same" : "DIFFERENT");
+		if (!same)
+			bad++;
+    }
+
+    remove(REF_FILE);
+    remove(OUT_FILE);
+    return bad ? EXIT_FAIL : EXIT_SUCCESS;
+}
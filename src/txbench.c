@@ -0,0 +1,344 @@
+/*
+ * txbench.c - Check the batch transform routines against the single point
+ *             ones, and time the two.
+ *
+ * Author:  Eric Haines
+ *
+ * Usage:  txbench [count]
+ *
+ * count is the number of points transformed for each test (default
+ * 1000000), and of matrices multiplied and inverted.  Returns EXIT_FAIL if
+ * any batch or affine result differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>	/* atol */
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "def.h"
+#include "lib.h"
+
+
+#define POINT_TEST     0
+#define VECTOR_TEST    1
+#define NORMAL_TEST    2
+#define COORD_TEST     3
+
+/* Each test is timed this many times, and the best time kept */
+#define PASSES         3
+
+/* Matrix products are chained this deep before starting again, like the
+   recursion in tree.c */
+#define CHAIN_DEPTH    16
+
+static unsigned long seed = 1;
+
+/*-----------------------------------------------------------------*/
+/* Small LCG so every platform tries the same values */
+static double
+rand_unit()
+{
+    seed = seed * 1103515245L + 12345L;
+    return (double)((seed >> 8) & 0xffffff) / (double)0x1000000;
+}
+
+/*-----------------------------------------------------------------*/
+/* Points per second, or 0 if the clock didn't tick */
+static double
+rate(count, seconds)
+long count;
+double seconds;
+{
+    return (seconds > 0.0) ? (double)count / seconds : 0.0;
+}
+
+/*-----------------------------------------------------------------*/
+/* Transform the points one at a time, "in4" or "in3" to "out4" */
+static void
+single_pass(test, in4, in3, out4, count, mx)
+int test;
+COORD4 *in4;
+COORD3 *in3;
+COORD4 *out4;
+long count;
+MATRIX mx;
+{
+    long i;
+
+    for (i = 0; i < count; i++) {
+		switch (test) {
+		case POINT_TEST:
+			lib_transform_point(out4[i], in3[i], mx);
+			break;
+		case VECTOR_TEST:
+			lib_transform_vector(out4[i], in3[i], mx);
+			break;
+		case NORMAL_TEST:
+			lib_transform_normal(out4[i], in3[i], mx);
+			break;
+		default:
+			lib_transform_coord(out4[i], in4[i], mx);
+			break;
+		}
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/* Transform the points as a batch, to "out3" or (for coords) "out4" */
+static void
+batch_pass(test, in4, in3, out4, out3, count, mx)
+int test;
+COORD4 *in4;
+COORD3 *in3;
+COORD4 *out4;
+COORD3 *out3;
+long count;
+MATRIX mx;
+{
+    switch (test) {
+	case POINT_TEST:
+		lib_transform_points(out3, in3, count, mx);
+		break;
+	case VECTOR_TEST:
+		lib_transform_vectors(out3, in3, count, mx);
+		break;
+	case NORMAL_TEST:
+		lib_transform_normals(out3, in3, count, mx);
+		break;
+	default:
+		lib_transform_coords(out4, in4, count, mx);
+		break;
+    }
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Transform the points one at a time and as a batch, print the best rates
+ * of a few passes and return the number of results that differ.
+ */
+static long
+time_test(name, test, in4, in3, out1, out2, count, mx)
+char *name;
+int test;
+COORD4 *in4;
+COORD3 *in3;
+COORD4 *out1, *out2;
+long count;
+MATRIX mx;
+{
+    COORD3 *out3;
+    clock_t start;
+    double single_time, batch_time, t;
+    long i, bad;
+    int pass;
+
+    /* The 3 element results are packed into the same storage */
+    out3 = (COORD3 *)out2;
+
+    single_time = batch_time = -1.0;
+    for (pass = 0; pass < PASSES; pass++) {
+		start = clock();
+		single_pass(test, in4, in3, out1, count, mx);
+		t = (double)(clock() - start) / CLOCKS_PER_SEC;
+		if ((single_time < 0.0) || (t < single_time))
+			single_time = t;
+
+		start = clock();
+		batch_pass(test, in4, in3, out2, out3, count, mx);
+		t = (double)(clock() - start) / CLOCKS_PER_SEC;
+		if ((batch_time < 0.0) || (t < batch_time))
+			batch_time = t;
+    }
+
+    bad = 0;
+    for (i = 0; i < count; i++) {
+		if (test == COORD_TEST) {
+			if ((out1[i][X] != out2[i][X]) || (out1[i][Y] != out2[i][Y]) ||
+				(out1[i][Z] != out2[i][Z]) || (out1[i][W] != out2[i][W]))
+				bad++;
+		} else {
+			if ((out1[i][X] != out3[i][X]) || (out1[i][Y] != out3[i][Y]) ||
+				(out1[i][Z] != out3[i][Z]))
+				bad++;
+		}
+    }
+
+    printf("%-18s single %12.0f/s  batch %12.0f/s  %ld mismatches\n",
+		name, rate(count, single_time), rate(count, batch_time), bad);
+    return bad;
+}
+
+/*-----------------------------------------------------------------*/
+/*
+ * Multiply and invert "count" affine matrices as MATRIX and as AFFINE,
+ * print the best rates of a few passes and return the number of results
+ * that differ.  Products must match exactly, and so must the 3x3 part of
+ * the inverses (their translations are worked out differently).
+ */
+static long
+affine_test(mx, count)
+MATRIX *mx;
+long count;
+{
+    MATRIX prod, mres;
+    AFFINE *ax, aprod, ares;
+    clock_t start;
+    double mult_time, amult_time, inv_time, ainv_time, t;
+    long i, bad;
+    int pass, j, k;
+
+    ax = (AFFINE *)malloc(count * sizeof(AFFINE));
+    if (ax == NULL) {
+		fprintf(stderr, "Error(txbench): Can't allocate memory.\n");
+		exit(EXIT_FAIL);
+    }
+    for (i = 0; i < count; i++)
+		lib_matrix_to_affine(ax[i], mx[i]);
+
+    mult_time = amult_time = inv_time = ainv_time = -1.0;
+    bad = 0;
+    for (pass = 0; pass < PASSES; pass++) {
+		/* Chain the products, as a recursive generator does */
+		start = clock();
+		for (i = 0; i < count; i++) {
+			if (i % CHAIN_DEPTH == 0)
+				lib_create_identity_matrix(prod);
+			lib_matrix_multiply(mres, mx[i], prod);
+			lib_copy_matrix(prod, mres);
+		}
+		t = (double)(clock() - start) / CLOCKS_PER_SEC;
+		if ((mult_time < 0.0) || (t < mult_time))
+			mult_time = t;
+
+		start = clock();
+		for (i = 0; i < count; i++) {
+			if (i % CHAIN_DEPTH == 0)
+				lib_create_identity_affine(aprod);
+			lib_affine_multiply(ares, ax[i], aprod);
+			memcpy(aprod, ares, sizeof(AFFINE));
+		}
+		t = (double)(clock() - start) / CLOCKS_PER_SEC;
+		if ((amult_time < 0.0) || (t < amult_time))
+			amult_time = t;
+
+		start = clock();
+		for (i = 0; i < count; i++)
+			lib_invert_matrix(mres, mx[i]);
+		t = (double)(clock() - start) / CLOCKS_PER_SEC;
+		if ((inv_time < 0.0) || (t < inv_time))
+			inv_time = t;
+
+		start = clock();
+		for (i = 0; i < count; i++)
+			lib_invert_affine(ares, ax[i]);
+		t = (double)(clock() - start) / CLOCKS_PER_SEC;
+		if ((ainv_time < 0.0) || (t < ainv_time))
+			ainv_time = t;
+    }
+
+    /* Check every product and inverse once, outside the timing */
+    for (i = 0; i < count; i++) {
+		lib_matrix_multiply(mres, mx[i], mx[(i + 1) % count]);
+		lib_affine_multiply(ares, ax[i], ax[(i + 1) % count]);
+		for (j = 0; j < 4; j++)
+			for (k = 0; k < 3; k++)
+				if (mres[j][k] != ares[j][k])
+					bad++;
+		lib_invert_matrix(mres, mx[i]);
+		lib_invert_affine(ares, ax[i]);
+		for (j = 0; j < 3; j++)
+			for (k = 0; k < 3; k++)
+				if (mres[j][k] != ares[j][k])
+					bad++;
+    }
+
+    printf("%-18s matrix %12.0f/s  affine %11.0f/s\n", "multiply",
+		rate(count, mult_time), rate(count, amult_time));
+    printf("%-18s matrix %12.0f/s  affine %11.0f/s  %ld mismatches\n",
+		"invert", rate(count, inv_time), rate(count, ainv_time), bad);
+
+    free(ax);
+    return bad;
+}
+
+/*-----------------------------------------------------------------*/
+main(argc, argv)
+int argc;
+char *argv[];
+{
+    COORD4 *in, *out1, *out2;
+    COORD3 *in3;
+    COORD3 from, at, up, axis;
+    MATRIX affine, view, *mx;
+    long count, i, bad;
+    int j;
+
+    count = 1000000L;
+    if (argc > 1) {
+		count = atol(argv[1]);
+		if (count <= 0) {
+			fprintf(stderr, "usage: txbench [count]\n");
+			return EXIT_FAIL;
+		}
+    }
+
+    in = (COORD4 *)malloc(count * sizeof(COORD4));
+    out1 = (COORD4 *)malloc(count * sizeof(COORD4));
+    out2 = (COORD4 *)malloc(count * sizeof(COORD4));
+    in3 = (COORD3 *)malloc(count * sizeof(COORD3));
+    if ((in == NULL) || (out1 == NULL) || (out2 == NULL) || (in3 == NULL)) {
+		fprintf(stderr, "Error(txbench): Can't allocate memory.\n");
+		return EXIT_FAIL;
+    }
+    for (i = 0; i < count; i++) {
+		SET_COORD4(in[i], 10.0 * rand_unit() - 5.0, 10.0 * rand_unit() - 5.0,
+			10.0 * rand_unit() - 5.0, 1.0);
+		COPY_COORD3(in3[i], in[i]);
+    }
+
+    /* An affine transform like the generators make, and a projection */
+    SET_COORD3(axis, 1.0, 2.0, 3.0);
+    lib_normalize_vector(axis);
+    lib_create_axis_rotate_matrix(affine, axis, 0.7);
+    affine[3][X] = 1.5;
+    affine[3][Y] = -2.0;
+    affine[3][Z] = 0.25;
+    SET_COORD3(from, 0.0, -20.0, 5.0);
+    SET_COORD3(at, 0.0, 0.0, 0.0);
+    SET_COORD3(up, 0.0, 0.0, 1.0);
+    lib_create_view_matrix(view, from, at, up, 512, 512, 45.0, 1.0);
+
+    bad = time_test("point", POINT_TEST, in, in3, out1, out2, count, affine);
+    bad += time_test("vector", VECTOR_TEST, in, in3, out1, out2, count, affine);
+    bad += time_test("normal", NORMAL_TEST, in, in3, out1, out2, count, affine);
+    bad += time_test("coord (affine)", COORD_TEST, in, in3, out1, out2,
+		count, affine);
+    bad += time_test("coord (projective)", COORD_TEST, in, in3, out1, out2,
+		count, view);
+
+    /* Rotations about random axes, scaled and moved a little */
+    mx = (MATRIX *)malloc(count * sizeof(MATRIX));
+    if (mx == NULL) {
+		fprintf(stderr, "Error(txbench): Can't allocate memory.\n");
+		return EXIT_FAIL;
+    }
+    for (i = 0; i < count; i++) {
+		SET_COORD3(axis, in[i][X], in[i][Y], in[i][Z] + 0.01);
+		lib_normalize_vector(axis);
+		lib_create_axis_rotate_matrix(mx[i], axis, 6.0 * rand_unit());
+		for (j = 0; j < 3; j++) {
+			mx[i][0][j] *= 0.5 + rand_unit();
+			mx[i][3][j] = 0.2 * rand_unit() - 0.1;
+		}
+    }
+    bad += affine_test(mx, count);
+    free(mx);
+
+    free(in3);
+    free(out2);
+    free(out1);
+    free(in);
+
+    return bad ? EXIT_FAIL : EXIT_SUCCESS;
+}